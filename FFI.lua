@@ -115,4 +115,232 @@ typedef __half half;
       )
    end
 
+
+   -- Direct bindings of hot THC entry points, for code making many calls on
+   -- small tensors: cutorch.ffi['torch.CudaTensor'].cadd(r, a, 1, b) calls
+   -- THCudaTensor_cadd without going through the luaT wrappers. The state
+   -- and the C functions are resolved once; the THCTensor pointer of a
+   -- tensor is read straight from its userdata. Errors raised inside the C
+   -- functions cannot be caught reliably once a call is JIT-compiled, so the
+   -- arguments are checked here: tensors of the table's type, matching
+   -- element counts, dimensions and indices in range (1-based, as in Lua).
+   local function loadTHC()
+      local path = package.searchpath and package.searchpath('libTHC', package.cpath)
+      local ok, lib = pcall(ffi.load, path or 'THC')
+      if ok and pcall(function() return lib.THCudaTensor_fill end) then
+         return lib
+      end
+      if pcall(function() return ffi.C.THCudaTensor_fill end) then
+         return ffi.C
+      end
+   end
+
+   local fdefs = [[
+void THCTensor_copy(THCState *state, THCTensor *self, THCTensor *src);
+void THCTensor_fill(THCState *state, THCTensor *self, real value);
+void THCTensor_add(THCState *state, THCTensor *self, THCTensor *src, real value);
+void THCTensor_mul(THCState *state, THCTensor *self, THCTensor *src, real value);
+void THCTensor_cadd(THCState *state, THCTensor *self, THCTensor *src1, real value, THCTensor *src2);
+void THCTensor_csub(THCState *state, THCTensor *self, THCTensor *src1, real value, THCTensor *src2);
+void THCTensor_cmul(THCState *state, THCTensor *self, THCTensor *src1, THCTensor *src2);
+void THCTensor_cdiv(THCState *state, THCTensor *self, THCTensor *src1, THCTensor *src2);
+void THCTensor_narrow(THCState *state, THCTensor *self, THCTensor *src, int dimension, long firstIndex, long size);
+void THCTensor_select(THCState *state, THCTensor *self, THCTensor *src, int dimension, long sliceIndex);
+void THCTensor_setStorage(THCState *state, THCTensor *self, THCStorage *storage, ptrdiff_t storageOffset, struct THLongStorage *size, struct THLongStorage *stride);
+int THCTensor_isContiguous(THCState *state, const THCTensor *self);
+]]
+   local floatdefs = [[
+void THCTensor_addmm(THCState *state, THCTensor *self, real beta, THCTensor *t, real alpha, THCTensor *mat1, THCTensor *mat2);
+void THCTensor_sigmoid(THCState *state, THCTensor *self, THCTensor *src);
+void THCTensor_tanh(THCState *state, THCTensor *self, THCTensor *src);
+]]
+
+   local THC = torch.LongStorage.cdata and loadTHC()
+   if THC then
+      local state = ffi.cast('THCState*', cutorch._state)
+      if cutorch.hasHalf then
+         ffi.cdef('half THC_float2half(float a);')
+      end
+      cutorch.ffi = {}
+
+      for _, typedata in ipairs(CudaTypes) do
+         local real, Real = unpack(typedata)
+         local isFloat = Real == '' or Real == 'Double' or Real == 'Half'
+         local prefix = 'THCuda' .. Real .. 'Tensor_'
+         local defs = fdefs .. (isFloat and floatdefs or '')
+         ffi.cdef((defs:gsub('real', real)
+                       :gsub('THCStorage', 'THCuda' .. Real .. 'Storage')
+                       :gsub('THCTensor_', prefix)
+                       :gsub('THCTensor', 'THCuda' .. Real .. 'Tensor')))
+         local function f(name) return THC[prefix .. name] end
+
+         local typename = 'torch.Cuda' .. Real .. 'Tensor'
+         local Tensor = torch.getmetatable(typename)
+         local Tensor_tt = ffi.typeof('THCuda' .. Real .. 'Tensor**')
+         local scalar = Real == 'Half' and THC.THC_float2half or function(v) return v end
+
+         local function ptr(t)
+            if getmetatable(t) ~= Tensor then
+               error(typename .. ' expected, got ' .. torch.type(t), 3)
+            end
+            return Tensor_tt(t)[0]
+         end
+
+         local function nElement(p)
+            if p.nDimension == 0 then
+               return 0
+            end
+            local n = 1
+            for d = 0, p.nDimension - 1 do
+               n = n * p.size[d]
+            end
+            return n
+         end
+
+         local function sameElements(a, b)
+            if nElement(a) ~= nElement(b) then
+               error('sizes do not match', 3)
+            end
+         end
+
+         local function checkDim(p, dim)
+            if dim < 1 or dim > p.nDimension then
+               error('dimension ' .. dim .. ' out of range', 3)
+            end
+         end
+
+         local C = {
+            copy = f'copy', fill = f'fill', add = f'add', mul = f'mul',
+            cadd = f'cadd', csub = f'csub', cmul = f'cmul', cdiv = f'cdiv',
+            narrow = f'narrow', select = f'select', setStorage = f'setStorage',
+            isContiguous = f'isContiguous',
+         }
+         local fast = {}
+
+         -- dst:copy(src), with src of the same type
+         function fast.copy(dst, src)
+            local d, s = ptr(dst), ptr(src)
+            sameElements(d, s)
+            C.copy(state, d, s)
+            return dst
+         end
+
+         function fast.fill(t, value)
+            C.fill(state, ptr(t), scalar(value))
+            return t
+         end
+
+         -- r = t + value, r = t * value (r is resized as t)
+         for _, name in ipairs{'add', 'mul'} do
+            local fn = C[name]
+            fast[name] = function(r, t, value)
+               fn(state, ptr(r), ptr(t), scalar(value))
+               return r
+            end
+         end
+
+         -- r = a + value * b, r = a - value * b
+         for _, name in ipairs{'cadd', 'csub'} do
+            local fn = C[name]
+            fast[name] = function(r, a, value, b)
+               local pr, pa, pb = ptr(r), ptr(a), ptr(b)
+               sameElements(pa, pb)
+               fn(state, pr, pa, scalar(value), pb)
+               return r
+            end
+         end
+
+         -- r = a * b, r = a / b, element-wise
+         for _, name in ipairs{'cmul', 'cdiv'} do
+            local fn = C[name]
+            fast[name] = function(r, a, b)
+               local pr, pa, pb = ptr(r), ptr(a), ptr(b)
+               sameElements(pa, pb)
+               fn(state, pr, pa, pb)
+               return r
+            end
+         end
+
+         -- dst becomes src:narrow(dim, first, size), without a new tensor
+         function fast.narrow(dst, src, dim, first, size)
+            local pd, ps = ptr(dst), ptr(src)
+            checkDim(ps, dim)
+            if first < 1 or size < 1 or first + size - 1 > ps.size[dim - 1] then
+               error('narrow out of range', 2)
+            end
+            C.narrow(state, pd, ps, dim - 1, first - 1, size)
+            return dst
+         end
+
+         -- dst becomes src:select(dim, index)
+         function fast.select(dst, src, dim, index)
+            local pd, ps = ptr(dst), ptr(src)
+            if ps.nDimension < 2 then
+               error('cannot select on a vector', 2)
+            end
+            checkDim(ps, dim)
+            if index < 1 or index > ps.size[dim - 1] then
+               error('index ' .. index .. ' out of range', 2)
+            end
+            C.select(state, pd, ps, dim - 1, index - 1)
+            return dst
+         end
+
+         -- dst becomes src:view(size), for a contiguous src and a
+         -- torch.LongStorage size (reused by the caller)
+         local stride = torch.LongStorage()
+         function fast.view(dst, src, size)
+            local pd, ps = ptr(dst), ptr(src)
+            if C.isContiguous(state, ps) == 0 then
+               error('input is not contiguous', 2)
+            end
+            local psize = size:cdata()
+            local n = tonumber(psize.size)
+            if n == 0 then
+               error('empty size', 2)
+            end
+            if stride:size() ~= n then
+               stride:resize(n)
+            end
+            local pstride = stride:cdata()
+            local elements = 1
+            for d = n - 1, 0, -1 do
+               pstride.data[d] = elements
+               elements = elements * psize.data[d]
+            end
+            if elements ~= nElement(ps) then
+               error('size does not match the number of elements', 2)
+            end
+            C.setStorage(state, pd, ps.storage, ps.storageOffset, psize, pstride)
+            return dst
+         end
+
+         if isFloat then
+            local addmm, sigmoid, tanh = f'addmm', f'sigmoid', f'tanh'
+
+            -- r = beta * t + alpha * m1 * m2
+            function fast.addmm(r, beta, t, alpha, m1, m2)
+               local pr, pt, p1, p2 = ptr(r), ptr(t), ptr(m1), ptr(m2)
+               if p1.nDimension ~= 2 or p2.nDimension ~= 2 or p1.size[1] ~= p2.size[0] then
+                  error('matrices expected, with matching inner dimensions', 2)
+               end
+               if pt.nDimension ~= 2 or pt.size[0] ~= p1.size[0] or pt.size[1] ~= p2.size[1] then
+                  error('size mismatch between t and m1 * m2', 2)
+               end
+               addmm(state, pr, scalar(beta), pt, scalar(alpha), p1, p2)
+               return r
+            end
+
+            for name, fn in pairs{sigmoid = sigmoid, tanh = tanh} do
+               fast[name] = function(r, t)
+                  fn(state, ptr(r), ptr(t))
+                  return r
+               end
+            end
+         end
+
+         cutorch.ffi[typename] = fast
+      end
+   end
+
 end
@@ -1,10 +1,3 @@
-function torch.CudaTensor.apply(self, func)
-   local x = torch.FloatTensor(self:size()):copy(self)
-   x:apply(func)
-   self:copy(x)
-   return self
-end
-
 local function Tensor__type(self,type)
    local current = torch.typename(self)
    if not type then return current end
@@ -93,3 +86,30 @@ if cutorch.hasHalf then
       rawset(torch.getmetatable('torch.CudaHalfTensor'), 'totable', Tensor__totable)
    end
 end
+
+-- Like split and chunk, but the pieces are contiguous copies, all made by
+-- one kernel launch through splitArray
+local function Tensor__splitCopy(self, size, dim)
+   dim = dim or 1
+   local results = {}
+   for i = 1, math.ceil(self:size(dim) / size) do
+      results[i] = self.new()
+   end
+   if #results > 0 then
+      torch.getmetatable(torch.typename(self)).splitArray(results, self, size, dim)
+   end
+   return results
+end
+
+local function Tensor__chunkCopy(self, n, dim)
+   dim = dim or 1
+   return Tensor__splitCopy(self, math.ceil(self:size(dim) / n), dim)
+end
+
+for _, CudaTensorType in pairs(TensorTypes) do
+   if CudaTensorType:find('Cuda') then
+      local metatable = torch.getmetatable(CudaTensorType)
+      rawset(metatable, 'splitCopy', Tensor__splitCopy)
+      rawset(metatable, 'chunkCopy', Tensor__chunkCopy)
+   end
+end
@@ -0,0 +1,217 @@
+-- Tensor archives: a header indexing named tensors, followed by their data,
+-- each contiguous and page-aligned, so that any subset of the tensors, or a
+-- range of rows of one of them, can be loaded by a direct copy from a
+-- memory mapping of the file, without parsing the rest.
+--
+-- Layout, in the native byte order:
+--   magic (16 bytes) | header length (long) | header | padding | data
+-- with a header of
+--   count (int), then per tensor: name (int length, chars), type name
+--   (int length, chars), nDimension (int), sizes (longs), data offset from
+--   the start of the file (long), data length in bytes (long)
+
+local archiveMagic = 'CUTORCHARCHIVE01'
+local archiveAlign = 4096
+
+-- the tensor types an archive may hold; the header names one per tensor
+local archiveTypes = {
+   ['torch.CudaTensor'] = true,
+   ['torch.CudaDoubleTensor'] = true,
+   ['torch.CudaByteTensor'] = true,
+   ['torch.CudaCharTensor'] = true,
+   ['torch.CudaShortTensor'] = true,
+   ['torch.CudaIntTensor'] = true,
+   ['torch.CudaLongTensor'] = true,
+}
+if cutorch.hasHalf then
+   archiveTypes['torch.CudaHalfTensor'] = true
+end
+
+local function alignUp(n)
+   return math.ceil(n / archiveAlign) * archiveAlign
+end
+
+local function writeString(file, s)
+   file:writeInt(#s)
+   if #s > 0 then
+      file:writeChar(torch.CharStorage():string(s))
+   end
+end
+
+local function readString(file)
+   local n = file:readInt()
+   if n == 0 then
+      return ''
+   end
+   return file:readChar(n):string()
+end
+
+local function encodeHeader(entries)
+   local file = torch.MemoryFile()
+   file:binary()
+   file:writeInt(#entries)
+   for _, e in ipairs(entries) do
+      writeString(file, e.name)
+      writeString(file, e.type)
+      file:writeInt(e.size:size())
+      for d = 1, e.size:size() do
+         file:writeLong(e.size[d])
+      end
+      file:writeLong(e.offset)
+      file:writeLong(e.bytes)
+   end
+   local storage = file:storage()
+   local header = storage:string():sub(1, storage:size() - 1)
+   file:close()
+   return header
+end
+
+-- Writes the CUDA tensors of the table `tensors` (name -> tensor) to an
+-- archive. The data is written in the background, as by cutorch.saveAsync;
+-- returns the writer.
+function cutorch.saveTensors(filename, tensors)
+   local names = {}
+   for name, t in pairs(tensors) do
+      assert(type(name) == 'string', 'tensor names should be strings')
+      assert(archiveTypes[torch.type(t)], 'CUDA tensor expected for ' .. name)
+      table.insert(names, name)
+   end
+   table.sort(names)
+
+   local entries = {}
+   for _, name in ipairs(names) do
+      local t = tensors[name]:contiguous()
+      table.insert(entries, {name = name, type = torch.type(t), size = t:size(),
+                             bytes = t:nElement() * t:elementSize(), tensor = t,
+                             offset = 0})
+   end
+
+   -- the header has the same length whatever the offsets
+   local headerEnd = #archiveMagic + 8 + #encodeHeader(entries)
+   local offset = alignUp(headerEnd)
+   for _, e in ipairs(entries) do
+      e.offset = offset
+      offset = alignUp(offset + e.bytes)
+   end
+   local header = encodeHeader(entries)
+
+   local lengthFile = torch.MemoryFile()
+   lengthFile:binary()
+   lengthFile:writeLong(#header)
+   local length = lengthFile:storage():string():sub(1, 8)
+   lengthFile:close()
+
+   local writer = cutorch._newCheckpointWriter(filename)
+   writer:writeBytes(archiveMagic .. length .. header)
+   local position = headerEnd
+   for _, e in ipairs(entries) do
+      writer:writeBytes(string.rep('\0', e.offset - position))
+      if e.bytes > 0 then
+         writer:writeStorage(e.tensor:storage(), e.tensor:storageOffset(), e.tensor:nElement())
+      end
+      position = e.offset + e.bytes
+   end
+   writer:close()
+   return writer
+end
+
+local function readIndex(file)
+   local magic = file:readChar(#archiveMagic):string()
+   assert(magic == archiveMagic, 'not a tensor archive')
+   local length = file:readLong()
+   local bytes = file:readChar(length)
+   bytes:resize(length + 1)
+   bytes[length + 1] = 0
+   local header = torch.MemoryFile(bytes, 'r')
+   header:binary()
+
+   local index = {}
+   for i = 1, header:readInt() do
+      local name = readString(header)
+      local e = {type = readString(header)}
+      assert(archiveTypes[e.type], 'unknown tensor type ' .. e.type .. ' for ' .. name)
+      local size = {}
+      for d = 1, header:readInt() do
+         size[d] = header:readLong()
+      end
+      e.size = torch.LongStorage(size)
+      e.offset = header:readLong()
+      e.bytes = header:readLong()
+      index[name] = e
+   end
+   header:close()
+   return index
+end
+
+-- Opens an archive and reads its index; the file is closed if that fails
+local function openArchive(filename)
+   local file = torch.DiskFile(filename, 'r')
+   file:binary()
+   local ok, index = pcall(readIndex, file)
+   if not ok then
+      file:close()
+      error(index, 0)
+   end
+   return file, index
+end
+
+-- Returns the index of an archive: name -> {type, size, offset, bytes}
+function cutorch.tensorArchiveIndex(filename)
+   local file, index = openArchive(filename)
+   file:close()
+   return index
+end
+
+-- Loads tensors of an archive onto `device` (the current device by
+-- default). `selection` is nil for every tensor, a list of names, or a
+-- table name -> true | {first, last}, where {first, last} loads only those
+-- rows (along the first dimension) of the tensor.
+function cutorch.loadTensors(filename, selection, device)
+   local file, index = openArchive(filename)
+
+   local wanted = {}
+   if selection == nil then
+      for name in pairs(index) do
+         wanted[name] = true
+      end
+   else
+      for k, v in pairs(selection) do
+         if type(k) == 'number' then
+            wanted[v] = true
+         else
+            wanted[k] = v
+         end
+      end
+   end
+
+   local result = {}
+   cutorch._mapFile(file, filename)
+   local ok, err = pcall(cutorch.withDevice, device or cutorch.getDevice(), function()
+      for name, rows in pairs(wanted) do
+         local e = index[name]
+         assert(e, 'no tensor named ' .. tostring(name) .. ' in the archive')
+         local size = torch.LongStorage():copy(e.size)
+         local offset = e.offset
+         if type(rows) == 'table' then
+            assert(size:size() > 0, name .. ' has no rows')
+            local first, last = rows[1], rows[2] or rows[1]
+            assert(first >= 1 and last <= size[1] and first <= last + 1,
+                   'rows out of range for ' .. name)
+            local rowBytes = size[1] > 0 and e.bytes / size[1] or 0
+            offset = offset + (first - 1) * rowBytes
+            size[1] = last - first + 1
+         end
+         local t = torch[e.type:sub(7)](size)
+         if t:nElement() > 0 then
+            cutorch._readMapped(file, t:storage(), offset)
+         end
+         result[name] = t
+      end
+   end)
+   cutorch._unmapFile(file)
+   file:close()
+   if not ok then
+      error(err)
+   end
+   return result
+end
@@ -0,0 +1,295 @@
+-- Elementwise expressions on the device. t:apply(expr), t:map(u, expr) and
+-- t:map2(u, v, expr), with expr a string such as 'x > 0 ? log(x) : 0' or
+-- '(x - y) * z', set every element of t to the value of expr, with x, y and
+-- z the elements of t, u and v. Expressions are compiled once into a program
+-- of the stack machine of THCTensorMathExpr.cu and cached.
+--
+-- Grammar, by increasing precedence:
+--   c ? a : b
+--   a or b, a || b
+--   a and b, a && b
+--   a < b, a <= b, a > b, a >= b, a == b, a ~= b, a != b
+--   a + b, a - b
+--   a * b, a / b, a % b
+--   -a, not a, !a
+--   a ^ b (right associative)
+--   numbers, x, y, z, pi, (a) and the functions abs, exp, log, log1p, sqrt,
+--   rsqrt, sin, cos, tan, tanh, sigmoid, floor, ceil, round, trunc (of one
+--   argument) and min, max, pow (of two)
+-- Comparisons and logic give 1 or 0; any non-zero value is true.
+
+local expr = cutorch._expr
+local ops = expr.opcodes
+
+local unaryFunctions = {
+   abs = ops.ABS, exp = ops.EXP, log = ops.LOG, log1p = ops.LOG1P,
+   sqrt = ops.SQRT, rsqrt = ops.RSQRT, sin = ops.SIN, cos = ops.COS,
+   tan = ops.TAN, tanh = ops.TANH, sigmoid = ops.SIGMOID, floor = ops.FLOOR,
+   ceil = ops.CEIL, round = ops.ROUND, trunc = ops.TRUNC,
+}
+local binaryFunctions = {min = ops.MIN, max = ops.MAX, pow = ops.POW}
+local inputs = {x = {ops.X, 1}, y = {ops.Y, 2}, z = {ops.Z, 3}}
+local comparisons = {
+   ['<'] = ops.LT, ['<='] = ops.LE, ['>'] = ops.GT, ['>='] = ops.GE,
+   ['=='] = ops.EQ, ['~='] = ops.NE, ['!='] = ops.NE,
+}
+
+local function tokenize(source)
+   local tokens = {}
+   local i = 1
+   while i <= #source do
+      local s, e = source:find('^%s+', i)
+      if s then
+         i = e + 1
+      else
+         local token, kind
+         for _, pattern in ipairs{'^%d+%.?%d*[eE][%+%-]?%d+', '^%.%d+[eE][%+%-]?%d+',
+                                  '^%d+%.?%d*', '^%.%d+'} do
+            token = source:match(pattern, i)
+            if token then
+               kind = 'number'
+               break
+            end
+         end
+         if not token then
+            token = source:match('^[%a_][%w_]*', i)
+            kind = 'name'
+         end
+         if not token then
+            token = source:match('^[<>=~!]=', i) or source:match('^&&', i)
+               or source:match('^||', i) or source:match('^[%+%-%*/%%%^%(%),%?:<>!]', i)
+            kind = 'symbol'
+         end
+         if not token then
+            error(string.format("unexpected '%s' at position %d of expression '%s'",
+                                source:sub(i, i), i, source), 0)
+         end
+         if kind == 'name' and (token == 'and' or token == 'or' or token == 'not') then
+            kind = 'symbol'
+         end
+         table.insert(tokens, {kind = kind, value = token, position = i})
+         i = i + #token
+      end
+   end
+   table.insert(tokens, {kind = 'end', value = '<end>', position = #source + 1})
+   return tokens
+end
+
+local function compile(source)
+   local tokens = tokenize(source)
+   local pos = 1
+   local code, constants, constantIndex = {}, {}, {}
+   local depth, maxDepth, used = 0, 0, 0
+
+   local function fail(message)
+      error(string.format("%s at position %d of expression '%s'",
+                          message, tokens[pos].position, source), 0)
+   end
+   local function peek(value)
+      return tokens[pos].kind ~= 'number' and tokens[pos].value == value
+   end
+   local function accept(value)
+      if peek(value) then
+         pos = pos + 1
+         return true
+      end
+   end
+   local function expect(value)
+      if not accept(value) then
+         fail("'" .. value .. "' expected near '" .. tokens[pos].value .. "'")
+      end
+   end
+   local function emit(op, pops, arg)
+      table.insert(code, op + (arg or 0) * 256)
+      depth = depth - pops + 1
+      maxDepth = math.max(maxDepth, depth)
+   end
+   local function constant(value)
+      if not constantIndex[value] then
+         table.insert(constants, value)
+         constantIndex[value] = #constants - 1
+      end
+      emit(ops.CONST, 0, constantIndex[value])
+   end
+
+   local ternary
+
+   local function primary()
+      local token = tokens[pos]
+      if token.kind == 'number' then
+         pos = pos + 1
+         constant(tonumber(token.value))
+      elseif token.kind == 'name' then
+         pos = pos + 1
+         local name = token.value
+         if inputs[name] then
+            emit(inputs[name][1], 0)
+            used = math.max(used, inputs[name][2])
+         elseif name == 'pi' then
+            constant(math.pi)
+         elseif unaryFunctions[name] then
+            expect('(')
+            ternary()
+            expect(')')
+            emit(unaryFunctions[name], 1)
+         elseif binaryFunctions[name] then
+            expect('(')
+            ternary()
+            expect(',')
+            ternary()
+            expect(')')
+            emit(binaryFunctions[name], 2)
+         else
+            pos = pos - 1
+            fail("unknown name '" .. name .. "'")
+         end
+      elseif accept('(') then
+         ternary()
+         expect(')')
+      else
+         fail("unexpected '" .. token.value .. "'")
+      end
+   end
+
+   local unary
+
+   local function power()
+      primary()
+      if accept('^') then
+         unary()
+         emit(ops.POW, 2)
+      end
+   end
+
+   function unary()
+      if accept('-') then
+         local token = tokens[pos]
+         if token.kind == 'number' and not (tokens[pos + 1].value == '^') then
+            pos = pos + 1
+            constant(-tonumber(token.value))
+         else
+            unary()
+            emit(ops.NEG, 1)
+         end
+      elseif accept('not') or accept('!') then
+         unary()
+         emit(ops.NOT, 1)
+      else
+         power()
+      end
+   end
+
+   local function binary(operand, operators)
+      return function()
+         operand()
+         while true do
+            local op = operators[tokens[pos].value]
+            if tokens[pos].kind ~= 'symbol' or not op then
+               break
+            end
+            pos = pos + 1
+            operand()
+            emit(op, 2)
+         end
+      end
+   end
+
+   local multiplicative = binary(unary, {['*'] = ops.MUL, ['/'] = ops.DIV, ['%'] = ops.MOD})
+   local additive = binary(multiplicative, {['+'] = ops.ADD, ['-'] = ops.SUB})
+   local comparison = binary(additive, comparisons)
+   local conjunction = binary(comparison, {['and'] = ops.AND, ['&&'] = ops.AND})
+   local disjunction = binary(conjunction, {['or'] = ops.OR, ['||'] = ops.OR})
+
+   function ternary()
+      disjunction()
+      if accept('?') then
+         ternary()
+         expect(':')
+         ternary()
+         emit(ops.SELECT, 3)
+      end
+   end
+
+   ternary()
+   if tokens[pos].kind ~= 'end' then
+      fail("unexpected '" .. tokens[pos].value .. "'")
+   end
+   if #code > expr.maxCode then
+      error(string.format("expression '%s' is too long (%d instructions, at most %d)",
+                          source, #code, expr.maxCode), 0)
+   end
+   if #constants > expr.maxConstants then
+      error(string.format("expression '%s' has too many constants (%d, at most %d)",
+                          source, #constants, expr.maxConstants), 0)
+   end
+   if maxDepth > expr.maxStack then
+      error(string.format("expression '%s' is nested too deeply", source), 0)
+   end
+   return {code = torch.IntStorage(code), constants = torch.DoubleStorage(constants),
+           inputs = used}
+end
+
+local programs = {}
+
+-- Returns the program of an expression, compiling it on first use
+function cutorch.compileExpression(source, operands)
+   local program = programs[source]
+   if not program then
+      program = compile(source)
+      programs[source] = program
+   end
+   if operands and program.inputs > operands then
+      error(string.format("expression '%s' uses %s, but only %s given", source,
+                          ({'x', 'y', 'z'})[program.inputs],
+                          ({'x is', 'x and y are'})[operands]), 3)
+   end
+   return program
+end
+
+local hostTypes = {
+   ['torch.CudaTensor'] = 'torch.FloatTensor',
+   ['torch.CudaDoubleTensor'] = 'torch.DoubleTensor',
+   ['torch.CudaByteTensor'] = 'torch.ByteTensor',
+   ['torch.CudaCharTensor'] = 'torch.CharTensor',
+   ['torch.CudaShortTensor'] = 'torch.ShortTensor',
+   ['torch.CudaIntTensor'] = 'torch.IntTensor',
+   ['torch.CudaLongTensor'] = 'torch.LongTensor',
+}
+if cutorch.hasHalf then
+   hostTypes['torch.CudaHalfTensor'] = 'torch.FloatTensor'
+end
+
+for typename, hostType in pairs(hostTypes) do
+   local Tensor = torch.getmetatable(typename)
+
+   -- Lua functions still run on the host, on a copy of the tensors
+   rawset(Tensor, 'apply', function(self, f)
+      if type(f) == 'string' then
+         local program = cutorch.compileExpression(f, 1)
+         return self:_pointwiseExpr(nil, nil, program.code, program.constants)
+      end
+      local x = self:type(hostType)
+      x:apply(f)
+      return self:copy(x)
+   end)
+
+   rawset(Tensor, 'map', function(self, t, f)
+      if type(f) == 'string' then
+         local program = cutorch.compileExpression(f, 2)
+         return self:_pointwiseExpr(t, nil, program.code, program.constants)
+      end
+      local x = self:type(hostType)
+      x:map(t:type(hostType), f)
+      return self:copy(x)
+   end)
+
+   rawset(Tensor, 'map2', function(self, t1, t2, f)
+      if type(f) == 'string' then
+         local program = cutorch.compileExpression(f, 3)
+         return self:_pointwiseExpr(t1, t2, program.code, program.constants)
+      end
+      local x = self:type(hostType)
+      x:map2(t1:type(hostType), t2:type(hostType), f)
+      return self:copy(x)
+   end)
+end
@@ -55,6 +55,105 @@ argtypes['ptrdiff_t'] = {
              end
 }
 
+-- GEMM epilogue activation, given by name and passed on as THC_ACTIVATION_*
+argtypes['activation'] = {
+
+  helpname = function(arg)
+                return "'none'|'sigmoid'|'tanh'|'relu'"
+             end,
+
+  declare = function(arg)
+               return string.format("int arg%d = THC_ACTIVATION_NONE;", arg.i)
+            end,
+
+  check = function(arg, idx)
+             return string.format("(lua_type(L, %d) == LUA_TSTRING)", idx)
+          end,
+
+  read = function(arg, idx)
+            return string.format("arg%d = cutorch_checkActivation(L, %d);", arg.i, idx)
+         end,
+
+  init = function(arg)
+            return string.format("arg%d = THC_ACTIVATION_NONE;", arg.i)
+         end,
+
+  carg = function(arg)
+            return string.format('arg%d', arg.i)
+         end,
+
+  creturn = function(arg)
+               return string.format('arg%d', arg.i)
+            end
+}
+
+-- tensor left out of an overload and passed on as NULL, such as the bias of
+-- addmmFused
+argtypes['nulltensor'] = {
+
+  helpname = function(arg)
+                return 'nil'
+             end,
+
+  declare = function(arg)
+               return ''
+            end,
+
+  check = function(arg, idx)
+             return '1'
+          end,
+
+  read = function(arg, idx)
+         end,
+
+  init = function(arg)
+         end,
+
+  carg = function(arg)
+            return 'NULL'
+         end,
+
+  creturn = function(arg)
+               error('a NULL tensor cannot be returned')
+            end
+}
+
+-- 'V' (valid) or 'F' (full) convolution, passed on with the conv2 ('c') or
+-- xcorr2 ('x') flag as the two-character type of conv2Dmv/conv2Dmm
+argtypes['convtype'] = {
+
+  helpname = function(arg)
+                return "'V'|'F'"
+             end,
+
+  declare = function(arg)
+               return string.format("char arg%d[3] = {'v', '%s', 0};", arg.i, arg.op)
+            end,
+
+  check = function(arg, idx)
+             return string.format("(lua_type(L, %d) == LUA_TSTRING && "
+                                     .. "(lua_tostring(L, %d)[0] == 'V' || lua_tostring(L, %d)[0] == 'v' || "
+                                     .. "lua_tostring(L, %d)[0] == 'F' || lua_tostring(L, %d)[0] == 'f'))",
+                                  idx, idx, idx, idx, idx)
+          end,
+
+  read = function(arg, idx)
+            return string.format("arg%d[0] = (lua_tostring(L, %d)[0] == 'F' || lua_tostring(L, %d)[0] == 'f') ? 'f' : 'v';",
+                                 arg.i, idx, idx)
+         end,
+
+  init = function(arg)
+         end,
+
+  carg = function(arg)
+            return string.format('arg%d', arg.i)
+         end,
+
+  creturn = function(arg)
+               return string.format('arg%d', arg.i)
+            end
+}
+
 interface:print('/* WARNING: autogenerated file */')
 interface:print('')
 interface:print('#include "THC.h"')
@@ -76,6 +175,18 @@ static int torch_isnonemptytable(lua_State *L, int idx)
 }
 ]])
 
+interface:print([[
+static int cutorch_checkActivation(lua_State *L, int idx)
+{
+  const char *name = lua_tostring(L, idx);
+  if (strcmp(name, "none") == 0) return THC_ACTIVATION_NONE;
+  if (strcmp(name, "sigmoid") == 0) return THC_ACTIVATION_SIGMOID;
+  if (strcmp(name, "tanh") == 0) return THC_ACTIVATION_TANH;
+  if (strcmp(name, "relu") == 0) return THC_ACTIVATION_RELU;
+  return luaL_error(L, "unknown activation '%s' (expected none, sigmoid, tanh or relu)", name);
+}
+]])
+
 -- Lua 5.2 compatibility
 local unpack = unpack or table.unpack
 
@@ -499,22 +610,26 @@ local function TensorToCudaLong_postcall(arg)
    return "if (indexLongTensor != NULL) THCudaLongTensor_free(default_arg1, indexLongTensor);\n"
 end
 
--- function to initialize the gather call
-local function gatherInit(arg)
-   return table.concat(
-      {
-	 arg.__metatable.init(arg),
-	 string.format("TH%s_checkGPU(cutorch_getstate(L), 1, %s);",
-		       Tensor, arg.args[4]:carg()),
-	 string.format(
-	    [[
-		  THCState *state = cutorch_getstate(L);
-		  THLongStorage *indicesSize = THCudaLongTensor_newSizeOf(state, %s);
-		  TH%s_resize(state, %s, indicesSize, NULL);
-		  THLongStorage_free(indicesSize);
-	    ]], arg.args[4]:carg(), Tensor, arg:carg()),
-      }, '\n')
+-- function to initialize the gather call, for a given type of index tensor
+local function gatherInitWith(indexTypename)
+   return function(arg)
+      return table.concat(
+         {
+	    arg.__metatable.init(arg),
+	    string.format("TH%s_checkGPU(cutorch_getstate(L), 1, %s);",
+			  Tensor, arg.args[4]:carg()),
+	    string.format(
+	       [[
+		     THCState *state = cutorch_getstate(L);
+		     THLongStorage *indicesSize = TH%s_newSizeOf(state, %s);
+		     TH%s_resize(state, %s, indicesSize, NULL);
+		     THLongStorage_free(indicesSize);
+	       ]], indexTypename, arg.args[4]:carg(), Tensor, arg:carg()),
+         }, '\n')
+   end
 end
+local gatherInit = gatherInitWith('CudaLongTensor')
+local gatherIntInit = gatherInitWith('CudaIntTensor')
 
 --
 -- Non-CudaTensor type math, since these are less fully implemented than
@@ -783,12 +898,29 @@ for k, Tensor_ in pairs(handledTypenames) do
             {name=Tensor},
             {name='CudaByteTensor'}})
 
+    wrap("maskedSelectBounded",
+         cname("maskedSelectBounded"),
+         {{name=Tensor, returned=true, default=true},
+            {name='CudaLongTensor', returned=true, default=true},
+            {name=Tensor},
+            {name='CudaByteTensor'}})
+
+    wrap("nonzero",
+         cname("nonzero"),
+         {{name="CudaLongTensor", default=true, returned=true},
+            {name=Tensor}})
+
     wrap("gather",
 	 cname("gather"),
 	 {{name=Tensor, default=true, returned=true, init=gatherInit},
 	    {name=Tensor},
 	    {name="index"},
 	    {name='CudaLongTensor'}},
+	 cname("gatherInt"),
+	 {{name=Tensor, default=true, returned=true, init=gatherIntInit},
+	    {name=Tensor},
+	    {name="index"},
+	    {name='CudaIntTensor'}},
 	 cname("gather"), -- this is for backward-compatibility, and takes in "Tensor" as the indexing tensor
 	 {{name=Tensor, default=true, returned=true, init=gatherInit},
 	    {name=Tensor},
@@ -801,6 +933,11 @@ for k, Tensor_ in pairs(handledTypenames) do
 	    {name="index"},
 	    {name='CudaLongTensor'},
 	    {name=Tensor}},
+	 cname("scatterInt"),
+	 {{name=Tensor, returned=true},
+	    {name="index"},
+	    {name='CudaIntTensor'},
+	    {name=Tensor}},
 	 cname("scatter"), -- this is for backward-compatibility, and takes in "Tensor" as the indexing tensor
 	 {{name=Tensor, returned=true},
 	    {name="index"},
@@ -811,6 +948,11 @@ for k, Tensor_ in pairs(handledTypenames) do
 	    {name="index"},
 	    {name='CudaLongTensor'},
 	    {name=real}},
+	 cname("scatterFillInt"),
+	 {{name=Tensor, returned=true},
+	    {name="index"},
+	    {name='CudaIntTensor'},
+	    {name=real}},
 	 cname("scatterFill"), -- this is for backward-compatibility, and takes in "Tensor" as the indexing tensor
 	 {{name=Tensor, returned=true},
 	    {name="index"},
@@ -818,6 +960,21 @@ for k, Tensor_ in pairs(handledTypenames) do
 	    {name=real}}
     )
 
+    wrap("scatterAdd",
+	 cname("scatterAdd"),
+	 {{name=Tensor, returned=true},
+	    {name="index"},
+	    {name='CudaLongTensor'},
+	    {name=Tensor}})
+
+    wrap("embeddingBag",
+	 cname("embeddingBag"),
+	 {{name=Tensor, default=true, returned=true},
+	    {name=Tensor},
+	    {name='CudaLongTensor'},
+	    {name='CudaLongTensor'},
+	    {name="boolean", default=0}})
+
     wrap("sort",
          cname("sort"),
          {{name=Tensor, default=true, returned=true},
@@ -886,6 +1043,15 @@ for k, Tensor_ in pairs(handledTypenames) do
 	    {name=Tensor .. "Array"},
 	    {name="index", default=lastdimarray(2)}})
 
+    -- contiguous copies of the pieces of split(size, dim), in one launch;
+    -- see splitCopy and chunkCopy in Tensor.lua
+    wrap("splitArray",
+	 cname("splitArray"),
+	 {{name=Tensor .. "Array"},
+	    {name=Tensor},
+	    {name="long"},
+	    {name="index", default=1}})
+
     if real == 'float' or real == 'double' or real == 'half' then
        for _,name in ipairs({"log", "log1p", "exp",
                              "cos", "acos", "cosh",
@@ -1072,6 +1238,136 @@ for k, Tensor_ in pairs(handledTypenames) do
                          {name=Tensor, dim=f.dim2},
                          {name=Tensor, dim=f.dim3}})
        end
+
+       -- r = activation(alpha * m1 * m2 + bias), with bias broadcast along
+       -- dimension biasDim of the result, in a single GEMM launch when possible;
+       -- without bias and biasDim, r = activation(alpha * m1 * m2)
+       wrap("addmmFused",
+            cname("addmmFused"),
+            {{name=Tensor, default=true, returned=true},
+             {name=real, default=1},
+             {name=Tensor, dim=2},
+             {name=Tensor, dim=2},
+             {name=Tensor, dim=1},
+             {name="index"},
+             {name="activation", default="none"}},
+            cname("addmmFused"),
+            {{name=Tensor, default=true, returned=true},
+             {name=real, default=1},
+             {name=Tensor, dim=2},
+             {name=Tensor, dim=2},
+             {name="nulltensor", default=true, invisible=true},
+             {name="int", default=0, invisible=true},
+             {name="activation", default="none"}})
+
+       -- 3D input with 4D kernel, or a batch of them
+       for _,f in ipairs({{name="conv2", op="c"}, {name="xcorr2", op="x"}}) do
+          wrap(f.name,
+               cname("conv2Dmv"),
+               {{name=Tensor, default=true, returned=true},
+                {name=real, default=0, invisible=true},
+                {name=Tensor, dim=3},
+                {name=Tensor, dim=4},
+                {name="long", default=1, invisible=true},
+                {name="long", default=1, invisible=true},
+                {name="convtype", op=f.op, default="V"}},
+               cname("conv2Dmm"),
+               {{name=Tensor, default=true, returned=true},
+                {name=real, default=0, invisible=true},
+                {name=Tensor, dim=4},
+                {name=Tensor, dim=4},
+                {name="long", default=1, invisible=true},
+                {name="long", default=1, invisible=true},
+                {name="convtype", op=f.op, default="V"}})
+       end
+
+       -- random generators take their parameters as double for every type
+       for _,f in ipairs({{name='geometric'},
+                          {name='bernoulli', a=0.5},
+                          {name='exponential'}}) do
+          wrap(f.name,
+               cname(f.name),
+               {{name=Tensor, returned=true},
+                {name='double', default=f.a}})
+       end
+
+       for _,f in ipairs({{name='uniform', a=0, b=1},
+                          {name='normal', a=0, b=1},
+                          {name='cauchy', a=0, b=1},
+                          {name='logNormal', a=1, b=2}}) do
+          wrap(f.name,
+               cname(f.name),
+               {{name=Tensor, returned=true},
+                {name='double', default=f.a},
+                {name='double', default=f.b}})
+       end
+
+       -- batched LU, Cholesky and triangular solves of small matrices
+       if real == 'float' or real == 'double' then
+          wrap("btrifact",
+               cname("btrifact"),
+               {{name=Tensor, returned=true},
+                {name="CudaIntTensor", returned=true},
+                {name="CudaIntTensor", returned=true},
+                {name=Tensor, dim=3}},
+               cname("btrifact"),
+               {{name=Tensor, default=true, returned=true, invisible=true},
+                {name="CudaIntTensor", default=true, returned=true, invisible=true},
+                {name="CudaIntTensor", default=true, returned=true, invisible=true},
+                {name=Tensor, dim=3}})
+
+          wrap("btrisolve",
+               cname("btrisolve"),
+               {{name=Tensor, returned=true},
+                {name=Tensor},
+                {name=Tensor, dim=3},
+                {name="CudaIntTensor"}},
+               cname("btrisolve"),
+               {{name=Tensor, default=true, returned=true, invisible=true},
+                {name=Tensor},
+                {name=Tensor, dim=3},
+                {name="CudaIntTensor"}})
+
+          wrap("bpotrf",
+               cname("bpotrf"),
+               {{name=Tensor, returned=true},
+                {name="CudaIntTensor", returned=true},
+                {name=Tensor, dim=3},
+                {name='charoption', values={'U', 'L'}, default='U'}},
+               cname("bpotrf"),
+               {{name=Tensor, default=true, returned=true, invisible=true},
+                {name="CudaIntTensor", default=true, returned=true, invisible=true},
+                {name=Tensor, dim=3},
+                {name='charoption', values={'U', 'L'}, default='U'}})
+
+          wrap("bpotrs",
+               cname("bpotrs"),
+               {{name=Tensor, returned=true},
+                {name=Tensor},
+                {name=Tensor, dim=3},
+                {name='charoption', values={'U', 'L'}, default='U'}},
+               cname("bpotrs"),
+               {{name=Tensor, default=true, returned=true, invisible=true},
+                {name=Tensor},
+                {name=Tensor, dim=3},
+                {name='charoption', values={'U', 'L'}, default='U'}})
+
+          wrap("btrtrs",
+               cname("btrtrs"),
+               {{name=Tensor, returned=true},
+                {name=Tensor},
+                {name=Tensor, dim=3},
+                {name='charoption', values={'U', 'L'}, default='U'},
+                {name='charoption', values={'N', 'T'}, default='N'},
+                {name='charoption', values={'N', 'U'}, default='N'}},
+               cname("btrtrs"),
+               {{name=Tensor, default=true, returned=true, invisible=true},
+                {name=Tensor},
+                {name=Tensor, dim=3},
+                {name='charoption', values={'U', 'L'}, default='U'},
+                {name='charoption', values={'N', 'T'}, default='N'},
+                {name='charoption', values={'N', 'U'}, default='N'}})
+       end
     end
 
     wrap("dot",
@@ -1249,12 +1545,29 @@ wrap("maskedSelect",
       {name=Tensor},
       {name='CudaByteTensor'}})
 
+wrap("maskedSelectBounded",
+     cname("maskedSelectBounded"),
+     {{name=Tensor, returned=true, default=true},
+      {name='CudaLongTensor', returned=true, default=true},
+      {name=Tensor},
+      {name='CudaByteTensor'}})
+
+wrap("nonzero",
+     cname("nonzero"),
+     {{name="CudaLongTensor", default=true, returned=true},
+      {name=Tensor}})
+
 wrap("gather",
      cname("gather"),
      {{name=Tensor, default=true, returned=true, init=gatherInit},
 	{name=Tensor},
 	{name="index"},
 	{name='CudaLongTensor'}},
+     cname("gatherInt"),
+     {{name=Tensor, default=true, returned=true, init=gatherIntInit},
+	{name=Tensor},
+	{name="index"},
+	{name='CudaIntTensor'}},
      cname("gather"), -- this is for backward-compatibility, and takes in "Tensor" as the indexing tensor
      {{name=Tensor, default=true, returned=true, init=gatherInit},
 	{name=Tensor},
@@ -1267,6 +1580,11 @@ wrap("scatter",
 	{name="index"},
 	{name='CudaLongTensor'},
 	{name=Tensor}},
+     cname("scatterInt"),
+     {{name=Tensor, returned=true},
+	{name="index"},
+	{name='CudaIntTensor'},
+	{name=Tensor}},
      cname("scatter"), -- this is for backward-compatibility, and takes in "Tensor" as the indexing tensor
      {{name=Tensor, returned=true},
 	{name="index"},
@@ -1277,6 +1595,11 @@ wrap("scatter",
 	{name="index"},
 	{name='CudaLongTensor'},
 	{name=real}},
+     cname("scatterFillInt"),
+     {{name=Tensor, returned=true},
+	{name="index"},
+	{name='CudaIntTensor'},
+	{name=real}},
      cname("scatterFill"), -- this is for backward-compatibility, and takes in "Tensor" as the indexing tensor
      {{name=Tensor, returned=true},
 	{name="index"},
@@ -1284,6 +1607,21 @@ wrap("scatter",
 	{name=real}}
 )
 
+wrap("scatterAdd",
+     cname("scatterAdd"),
+     {{name=Tensor, returned=true},
+	{name="index"},
+	{name='CudaLongTensor'},
+	{name=Tensor}})
+
+wrap("embeddingBag",
+     cname("embeddingBag"),
+     {{name=Tensor, default=true, returned=true},
+	{name=Tensor},
+	{name='CudaLongTensor'},
+	{name='CudaLongTensor'},
+	{name="boolean", default=0}})
+
 wrap("sort",
      cname("sort"),
      {{name=Tensor, default=true, returned=true},
@@ -1444,6 +1782,44 @@ wrap("dot",
       {name=Tensor},
       {name=real, creturned=true}})
 
+wrap("addmmFused",
+     cname("addmmFused"),
+     {{name=Tensor, default=true, returned=true},
+      {name=real, default=1},
+      {name=Tensor, dim=2},
+      {name=Tensor, dim=2},
+      {name=Tensor, dim=1},
+      {name="index"},
+      {name="activation", default="none"}},
+     cname("addmmFused"),
+     {{name=Tensor, default=true, returned=true},
+      {name=real, default=1},
+      {name=Tensor, dim=2},
+      {name=Tensor, dim=2},
+      {name="nulltensor", default=true, invisible=true},
+      {name="int", default=0, invisible=true},
+      {name="activation", default="none"}})
+
+for _,f in ipairs({{name="conv2", op="c"}, {name="xcorr2", op="x"}}) do
+   wrap(f.name,
+        cname("conv2Dmv"),
+        {{name=Tensor, default=true, returned=true},
+         {name=real, default=0, invisible=true},
+         {name=Tensor, dim=3},
+         {name=Tensor, dim=4},
+         {name="long", default=1, invisible=true},
+         {name="long", default=1, invisible=true},
+         {name="convtype", op=f.op, default="V"}},
+        cname("conv2Dmm"),
+        {{name=Tensor, default=true, returned=true},
+         {name=real, default=0, invisible=true},
+         {name=Tensor, dim=4},
+         {name=Tensor, dim=4},
+         {name="long", default=1, invisible=true},
+         {name="long", default=1, invisible=true},
+         {name="convtype", op=f.op, default="V"}})
+end
+
 wrap("sum",
      cname("sumall"),
      {{name=Tensor},
@@ -1577,7 +1953,7 @@ wrap("randn",
 
 wrap("multinomial",
      cname("multinomial"),
-     {{name=Tensor, default=true, returned=true, method={default='nil'}},
+     {{name='CudaLongTensor', default=true, returned=true, method={default='nil'}},
         {name=Tensor},
         {name="int"},
         {name="boolean", default=false}})
@@ -1620,6 +1996,15 @@ wrap("cat",
       {name=Tensor .. "Array"},
       {name="index", default=lastdimarray(2)}})
 
+-- contiguous copies of the pieces of split(size, dim), in one launch;
+-- see splitCopy and chunkCopy in Tensor.lua
+wrap("splitArray",
+     cname("splitArray"),
+     {{name=Tensor .. "Array"},
+      {name=Tensor},
+      {name="long"},
+      {name="index", default=1}})
+
 for _,f in ipairs({{name='geometric'},
                    {name='bernoulli', a=0.5}}) do
 
@@ -1747,6 +2132,71 @@ wrap("qr",
       {name=Tensor, default=true, returned=true, invisible=true},
       {name=Tensor}})
 
+-- batched LU, Cholesky and triangular solves of small matrices
+wrap("btrifact",
+     cname("btrifact"),
+     {{name=Tensor, returned=true},
+      {name="CudaIntTensor", returned=true},
+      {name="CudaIntTensor", returned=true},
+      {name=Tensor, dim=3}},
+     cname("btrifact"),
+     {{name=Tensor, default=true, returned=true, invisible=true},
+      {name="CudaIntTensor", default=true, returned=true, invisible=true},
+      {name="CudaIntTensor", default=true, returned=true, invisible=true},
+      {name=Tensor, dim=3}})
+
+wrap("btrisolve",
+     cname("btrisolve"),
+     {{name=Tensor, returned=true},
+      {name=Tensor},
+      {name=Tensor, dim=3},
+      {name="CudaIntTensor"}},
+     cname("btrisolve"),
+     {{name=Tensor, default=true, returned=true, invisible=true},
+      {name=Tensor},
+      {name=Tensor, dim=3},
+      {name="CudaIntTensor"}})
+
+wrap("bpotrf",
+     cname("bpotrf"),
+     {{name=Tensor, returned=true},
+      {name="CudaIntTensor", returned=true},
+      {name=Tensor, dim=3},
+      {name='charoption', values={'U', 'L'}, default='U'}},
+     cname("bpotrf"),
+     {{name=Tensor, default=true, returned=true, invisible=true},
+      {name="CudaIntTensor", default=true, returned=true, invisible=true},
+      {name=Tensor, dim=3},
+      {name='charoption', values={'U', 'L'}, default='U'}})
+
+wrap("bpotrs",
+     cname("bpotrs"),
+     {{name=Tensor, returned=true},
+      {name=Tensor},
+      {name=Tensor, dim=3},
+      {name='charoption', values={'U', 'L'}, default='U'}},
+     cname("bpotrs"),
+     {{name=Tensor, default=true, returned=true, invisible=true},
+      {name=Tensor},
+      {name=Tensor, dim=3},
+      {name='charoption', values={'U', 'L'}, default='U'}})
+
+wrap("btrtrs",
+     cname("btrtrs"),
+     {{name=Tensor, returned=true},
+      {name=Tensor},
+      {name=Tensor, dim=3},
+      {name='charoption', values={'U', 'L'}, default='U'},
+      {name='charoption', values={'N', 'T'}, default='N'},
+      {name='charoption', values={'N', 'U'}, default='N'}},
+     cname("btrtrs"),
+     {{name=Tensor, default=true, returned=true, invisible=true},
+      {name=Tensor},
+      {name=Tensor, dim=3},
+      {name='charoption', values={'U', 'L'}, default='U'},
+      {name='charoption', values={'N', 'T'}, default='N'},
+      {name='charoption', values={'N', 'U'}, default='N'}})
+
 wrap("mean",
      cname("meanall"),
      {{name=Tensor},
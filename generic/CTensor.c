@@ -56,6 +56,57 @@ static int cutorch_Tensor_(copy)(lua_State *L)
   return 1;
 }
 
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE) || defined(THC_REAL_IS_HALF)
+/* tensor:copyScaled(src, scale [, shift]): tensor = src * scale + shift,
+   converted on the device */
+static int cutorch_Tensor_(copyScaled)(lua_State *L)
+{
+  THCState *state = cutorch_getstate(L);
+  THCTensor *tensor = (THCTensor *)luaT_checkudata(L, 1, torch_Tensor);
+  accreal scale = (accreal) luaL_checknumber(L, 3);
+  accreal shift = (accreal) luaL_optnumber(L, 4, 0);
+  void *src;
+  if( (src = luaT_toudata(L, 2, "torch.CudaTensor")) )
+    THCTensor_(copyScaledCudaFloat)(state, tensor, (THCudaTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.CudaByteTensor")) )
+    THCTensor_(copyScaledCudaByte)(state, tensor, (THCudaByteTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.CudaCharTensor")) )
+    THCTensor_(copyScaledCudaChar)(state, tensor, (THCudaCharTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.CudaShortTensor")) )
+    THCTensor_(copyScaledCudaShort)(state, tensor, (THCudaShortTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.CudaIntTensor")) )
+    THCTensor_(copyScaledCudaInt)(state, tensor, (THCudaIntTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.CudaLongTensor")) )
+    THCTensor_(copyScaledCudaLong)(state, tensor, (THCudaLongTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.CudaDoubleTensor")) )
+    THCTensor_(copyScaledCudaDouble)(state, tensor, (THCudaDoubleTensor *)src, scale, shift);
+#ifdef CUDA_HALF_TENSOR
+  else if( (src = luaT_toudata(L, 2, "torch.CudaHalfTensor")) )
+    THCTensor_(copyScaledCudaHalf)(state, tensor, (THCudaHalfTensor *)src, scale, shift);
+#endif
+
+  else if( (src = luaT_toudata(L, 2, "torch.ByteTensor")) )
+    THCTensor_(copyScaledByte)(state, tensor, (THByteTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.CharTensor")) )
+    THCTensor_(copyScaledChar)(state, tensor, (THCharTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.ShortTensor")) )
+    THCTensor_(copyScaledShort)(state, tensor, (THShortTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.IntTensor")) )
+    THCTensor_(copyScaledInt)(state, tensor, (THIntTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.LongTensor")) )
+    THCTensor_(copyScaledLong)(state, tensor, (THLongTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.FloatTensor")) )
+    THCTensor_(copyScaledFloat)(state, tensor, (THFloatTensor *)src, scale, shift);
+  else if( (src = luaT_toudata(L, 2, "torch.DoubleTensor")) )
+    THCTensor_(copyScaledDouble)(state, tensor, (THDoubleTensor *)src, scale, shift);
+  else
+    luaL_typerror(L, 2, "torch.*Tensor");
+
+  lua_settop(L, 1);
+  return 1;
+}
+#endif
+
 #ifndef THC_REAL_IS_HALF
 static int cutorch_Tensor_(copyAsyncCPU)(lua_State *L)
 {
@@ -229,6 +280,22 @@ static int cuda_FloatTensor_fakecopy(lua_State *L)
 }
 #endif
 
+/* tensor:_pointwiseExpr(src1 | nil, src2 | nil, code, constants), with the
+   program of an expression compiled by TensorExpression.lua */
+static int cutorch_Tensor_(pointwiseExpr)(lua_State *L)
+{
+  THCState *state = cutorch_getstate(L);
+  THCTensor *self = (THCTensor *)luaT_checkudata(L, 1, torch_Tensor);
+  THCTensor *src1 = lua_isnoneornil(L, 2) ? NULL : (THCTensor *)luaT_checkudata(L, 2, torch_Tensor);
+  THCTensor *src2 = lua_isnoneornil(L, 3) ? NULL : (THCTensor *)luaT_checkudata(L, 3, torch_Tensor);
+  THIntStorage *code = (THIntStorage *)luaT_checkudata(L, 4, "torch.IntStorage");
+  THDoubleStorage *constants = (THDoubleStorage *)luaT_checkudata(L, 5, "torch.DoubleStorage");
+  THCTensor_(pointwiseExpr)(state, self, src1, src2, code->data, (int) code->size,
+                            constants->data, (int) constants->size);
+  lua_settop(L, 1);
+  return 1;
+}
+
 static int cutorch_Tensor_(getDevice)(lua_State *L) {
   THCTensor *tensor = (THCTensor *)luaT_checkudata(L, 1, torch_Tensor);
   lua_pushinteger(L, THCTensor_(getDevice)(cutorch_getstate(L), tensor) + 1);
@@ -271,6 +338,18 @@ void cutorch_Tensor_(init)(lua_State* L)
   lua_setfield(L, -2, "copy");
   lua_pop(L, 1);
 
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE) || defined(THC_REAL_IS_HALF)
+  luaT_pushmetatable(L, torch_Tensor);
+  lua_pushcfunction(L, cutorch_Tensor_(copyScaled));
+  lua_setfield(L, -2, "copyScaled");
+  lua_pop(L, 1);
+#endif
+
+  luaT_pushmetatable(L, torch_Tensor);
+  lua_pushcfunction(L, cutorch_Tensor_(pointwiseExpr));
+  lua_setfield(L, -2, "_pointwiseExpr");
+  lua_pop(L, 1);
+
   luaT_pushmetatable(L, torch_Tensor);
   lua_pushcfunction(L, cutorch_Tensor_(getDevice));
   lua_setfield(L, -2, "getDevice");
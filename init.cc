@@ -3,7 +3,10 @@
 #include "luaT.h"
 #include "THCGeneral.h"
 #include "THCCachingAllocator.h"
+#include "THCCheckpointWriter.h"
+#include "THMemoryFile.h"
 #include "THCTensorRandom.h"
+#include "THCTensorMath.h"
 #include "THCHalf.h" // for CUDA_HALF_TENSOR
 
 extern void cutorch_CudaByteStorage_init(lua_State* L);
@@ -694,6 +697,100 @@ static int cutorch_setKernelPeerToPeerAccess(lua_State *L)
   return 0;
 }
 
+static int cutorch_setBlasMathMode(lua_State *L)
+{
+  const char *name = luaL_checkstring(L, 1);
+  int mode;
+  if (strcmp(name, "float") == 0) {
+    mode = THC_BLAS_MATH_FLOAT;
+  } else if (strcmp(name, "half") == 0) {
+    mode = THC_BLAS_MATH_HALF;
+  } else {
+    return luaL_error(L, "unknown BLAS math mode '%s' (expected 'float' or 'half')", name);
+  }
+  THCState_setBlasMathMode(cutorch_getstate(L), mode);
+  return 0;
+}
+
+static int cutorch_getBlasMathMode(lua_State *L)
+{
+  int mode = THCState_getBlasMathMode(cutorch_getstate(L));
+  lua_pushstring(L, mode == THC_BLAS_MATH_HALF ? "half" : "float");
+  return 1;
+}
+
+static int cutorch_getBlasForceLibrary(lua_State *L)
+{
+  THCState *state = cutorch_getstate(L);
+  lua_pushboolean(L, THCState_getBlasForceLibrary(state));
+
+  return 1;
+}
+
+static int cutorch_setBlasForceLibrary(lua_State *L)
+{
+  THCState *state = cutorch_getstate(L);
+
+  int val = lua_toboolean(L, -1);
+  THCState_setBlasForceLibrary(state, val);
+
+  return 0;
+}
+
+static int cutorch_getDeterministic(lua_State *L)
+{
+  THCState *state = cutorch_getstate(L);
+  lua_pushboolean(L, THCState_getDeterministic(state));
+
+  return 1;
+}
+
+static int cutorch_setDeterministic(lua_State *L)
+{
+  THCState *state = cutorch_getstate(L);
+
+  int val = lua_toboolean(L, -1);
+  THCState_setDeterministic(state, val);
+
+  return 0;
+}
+
+static int cutorch_setStorageGrowthFactor(lua_State *L)
+{
+  double factor = luaL_checknumber(L, 1);
+  luaL_argcheck(L, factor >= 1, 1, "growth factor should be at least 1");
+  THCCachingAllocator_setGrowthFactor(factor);
+  return 0;
+}
+
+static int cutorch_getStorageGrowthFactor(lua_State *L)
+{
+  lua_pushnumber(L, THCCachingAllocator_getGrowthFactor());
+  return 1;
+}
+
+static const char *cutorch_convAlgorithmNames[] = {"auto", "direct", "im2col", "winograd", "fft"};
+
+static int cutorch_setConvAlgorithm(lua_State *L)
+{
+  const char *name = luaL_checkstring(L, 1);
+  for (int algorithm = THC_CONV_ALGO_AUTO; algorithm <= THC_CONV_ALGO_FFT; ++algorithm) {
+    if (strcmp(name, cutorch_convAlgorithmNames[algorithm]) == 0) {
+      THCState_setConvAlgorithm(cutorch_getstate(L), algorithm);
+      return 0;
+    }
+  }
+  return luaL_error(L, "unknown convolution algorithm '%s' "
+                    "(expected 'auto', 'direct', 'im2col', 'winograd' or 'fft')", name);
+}
+
+static int cutorch_getConvAlgorithm(lua_State *L)
+{
+  int algorithm = THCState_getConvAlgorithm(cutorch_getstate(L));
+  lua_pushstring(L, cutorch_convAlgorithmNames[algorithm]);
+  return 1;
+}
+
 static int cutorch_getMemoryUsage(lua_State *L) {
   size_t freeBytes = 0;
   size_t totalBytes = 0;
@@ -824,6 +921,48 @@ static int cutorch_setRNGState(lua_State *L)
   return 0;
 }
 
+static int cutorch_setRNGType(lua_State *L)
+{
+  const char *name = luaL_checkstring(L, 1);
+  int type;
+  if (strcmp(name, "mtgp32") == 0) {
+    type = THC_RNG_MTGP32;
+  } else if (strcmp(name, "philox") == 0) {
+    type = THC_RNG_PHILOX;
+  } else {
+    return luaL_error(L, "unknown RNG type '%s' (expected 'mtgp32' or 'philox')", name);
+  }
+  THCRandom_setGeneratorType(cutorch_getstate(L), type);
+  return 0;
+}
+
+static int cutorch_getRNGType(lua_State *L)
+{
+  int type = THCRandom_getGeneratorType(cutorch_getstate(L));
+  lua_pushstring(L, type == THC_RNG_PHILOX ? "philox" : "mtgp32");
+  return 1;
+}
+
+static int cutorch_philoxUniform(lua_State *L)
+{
+  THFloatTensor* t = (THFloatTensor*)luaT_checkudata(L, 1, "torch.FloatTensor");
+  unsigned long seed = luaL_checknumber(L, 2);
+  unsigned long offset = luaL_optnumber(L, 3, 0);
+  THCRandom_philoxUniformHost(t, seed, offset);
+  lua_settop(L, 1);
+  return 1;
+}
+
+static int cutorch_philoxNormal(lua_State *L)
+{
+  THFloatTensor* t = (THFloatTensor*)luaT_checkudata(L, 1, "torch.FloatTensor");
+  unsigned long seed = luaL_checknumber(L, 2);
+  unsigned long offset = luaL_optnumber(L, 3, 0);
+  THCRandom_philoxNormalHost(t, seed, offset);
+  lua_settop(L, 1);
+  return 1;
+}
+
 static int cutorch_getState(lua_State *L)
 {
   lua_getglobal(L, "cutorch");
@@ -920,6 +1059,247 @@ static int cutorch_hasFastHalfInstructions(lua_State *L) {
   return 1;
 }
 
+/* Device bytes of a CUDA storage of any type; 0 if `index` is not one */
+static int cutorch_storageBytes(lua_State *L, int index, char **data, size_t *bytes,
+                                size_t *elementSize, int *device)
+{
+  void *storage;
+#define CUTORCH_STORAGE_BYTES(STORAGE, NAME)                            \
+  if ((storage = luaT_toudata(L, index, NAME))) {                       \
+    *data = (char *) ((STORAGE *) storage)->data;                       \
+    *elementSize = sizeof(*((STORAGE *) storage)->data);                \
+    *bytes = ((STORAGE *) storage)->size * *elementSize;                \
+    *device = ((STORAGE *) storage)->device;                            \
+    return 1;                                                           \
+  }
+  CUTORCH_STORAGE_BYTES(THCudaByteStorage, "torch.CudaByteStorage")
+  CUTORCH_STORAGE_BYTES(THCudaCharStorage, "torch.CudaCharStorage")
+  CUTORCH_STORAGE_BYTES(THCudaShortStorage, "torch.CudaShortStorage")
+  CUTORCH_STORAGE_BYTES(THCudaIntStorage, "torch.CudaIntStorage")
+  CUTORCH_STORAGE_BYTES(THCudaLongStorage, "torch.CudaLongStorage")
+  CUTORCH_STORAGE_BYTES(THCudaStorage, "torch.CudaStorage")
+  CUTORCH_STORAGE_BYTES(THCudaDoubleStorage, "torch.CudaDoubleStorage")
+#ifdef CUDA_HALF_TENSOR
+  CUTORCH_STORAGE_BYTES(THCudaHalfStorage, "torch.CudaHalfStorage")
+#endif
+#undef CUTORCH_STORAGE_BYTES
+  return 0;
+}
+
+/* cutorch._readMapped(file, storage, offset): fills `storage` with the bytes
+   at `offset` (0-based) of the file mapped by cutorch._mapFile */
+static int cutorch_readMapped(lua_State *L)
+{
+  THCState *state = cutorch_getstate(L);
+  size_t mappedSize;
+  const char *mapped = cutorch_getFileMapping(L, 1, &mappedSize);
+  luaL_argcheck(L, mapped != NULL, 1, "file is not mapped");
+  char *data;
+  size_t bytes, elementSize;
+  int device;
+  luaL_argcheck(L, cutorch_storageBytes(L, 2, &data, &bytes, &elementSize, &device), 2,
+                "CUDA storage expected");
+  double offset = luaL_checknumber(L, 3);
+  luaL_argcheck(L, offset >= 0 && (size_t) offset <= mappedSize &&
+                bytes <= mappedSize - (size_t) offset, 3, "data runs past the end of the file");
+
+  int currentDevice;
+  THCudaCheck(hipGetDevice(&currentDevice));
+  if (currentDevice != device) {
+    THCudaCheck(hipSetDevice(device));
+  }
+  THCudaCopyFromHostStaged(state, data, mapped + (size_t) offset, bytes);
+  if (currentDevice != device) {
+    THCudaCheck(hipSetDevice(currentDevice));
+  }
+  return 0;
+}
+
+static THCCheckpointWriter *cutorch_checkCheckpointWriter(lua_State *L, int index)
+{
+  THCCheckpointWriter **writer =
+    (THCCheckpointWriter **)luaL_checkudata(L, index, "cutorch.CheckpointWriter");
+  luaL_argcheck(L, *writer != NULL, index, "checkpoint writer already freed");
+  return *writer;
+}
+
+static int cutorch_CheckpointWriter_wait(lua_State *L)
+{
+  THCCheckpointWriter *writer = cutorch_checkCheckpointWriter(L, 1);
+  THCCheckpointWriter_wait(cutorch_getstate(L), writer);
+  return 0;
+}
+
+static int cutorch_CheckpointWriter_close(lua_State *L)
+{
+  THCCheckpointWriter *writer = cutorch_checkCheckpointWriter(L, 1);
+  THCCheckpointWriter_close(cutorch_getstate(L), writer);
+  return 0;
+}
+
+static int cutorch_CheckpointWriter_isDone(lua_State *L)
+{
+  THCCheckpointWriter *writer = cutorch_checkCheckpointWriter(L, 1);
+  lua_pushboolean(L, THCCheckpointWriter_isDone(cutorch_getstate(L), writer));
+  return 1;
+}
+
+/* writer:writeBytes(string) */
+static int cutorch_CheckpointWriter_writeBytes(lua_State *L)
+{
+  THCCheckpointWriter *writer = cutorch_checkCheckpointWriter(L, 1);
+  size_t size;
+  const char *bytes = luaL_checklstring(L, 2, &size);
+  THCCheckpointWriter_writeHost(cutorch_getstate(L), writer, bytes, size);
+  return 0;
+}
+
+/* writer:writeStorage(storage [, offset, count]): `count` elements of a
+   CUDA storage from the 1-based `offset`, the whole storage by default */
+static int cutorch_CheckpointWriter_writeStorage(lua_State *L)
+{
+  THCCheckpointWriter *writer = cutorch_checkCheckpointWriter(L, 1);
+  char *data;
+  size_t bytes, elementSize;
+  int device;
+  luaL_argcheck(L, cutorch_storageBytes(L, 2, &data, &bytes, &elementSize, &device), 2,
+                "CUDA storage expected");
+  size_t size = bytes / elementSize;
+  long offset = luaL_optlong(L, 3, 1) - 1;
+  long count = luaL_optlong(L, 4, (long) size - offset);
+  luaL_argcheck(L, offset >= 0 && (size_t) offset <= size, 3, "out of range");
+  luaL_argcheck(L, count >= 0 && (size_t) count <= size - offset, 4, "out of range");
+
+  THCCheckpointWriter_writeDevice(cutorch_getstate(L), writer, device,
+                                  data + offset * elementSize, count * elementSize);
+  return 0;
+}
+
+static int cutorch_CheckpointWriter_free(lua_State *L)
+{
+  THCCheckpointWriter **writer =
+    (THCCheckpointWriter **)luaL_checkudata(L, 1, "cutorch.CheckpointWriter");
+  if (*writer) {
+    THCCheckpointWriter_free(cutorch_getstate(L), *writer);
+  }
+  *writer = NULL;
+  return 0;
+}
+
+int cutorch_newCheckpointWriter(lua_State *L)
+{
+  const char *name = luaL_checkstring(L, 1);
+  THCCheckpointWriter **writer =
+    (THCCheckpointWriter **)lua_newuserdata(L, sizeof(THCCheckpointWriter *));
+  *writer = NULL;
+  if (luaL_newmetatable(L, "cutorch.CheckpointWriter")) {
+    lua_newtable(L);
+    lua_pushcfunction(L, cutorch_CheckpointWriter_wait);
+    lua_setfield(L, -2, "wait");
+    lua_pushcfunction(L, cutorch_CheckpointWriter_isDone);
+    lua_setfield(L, -2, "isDone");
+    lua_pushcfunction(L, cutorch_CheckpointWriter_writeBytes);
+    lua_setfield(L, -2, "writeBytes");
+    lua_pushcfunction(L, cutorch_CheckpointWriter_writeStorage);
+    lua_setfield(L, -2, "writeStorage");
+    lua_pushcfunction(L, cutorch_CheckpointWriter_close);
+    lua_setfield(L, -2, "close");
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, cutorch_CheckpointWriter_free);
+    lua_setfield(L, -2, "__gc");
+  }
+  lua_setmetatable(L, -2);
+  *writer = THCCheckpointWriter_new(cutorch_getstate(L), name);
+  return 1;
+}
+
+/* Pushes the table of attached writers, keyed by file; a value is
+   {writer, number of bytes of the file already handed over} */
+static void cutorch_pushFileWriters(lua_State *L)
+{
+  lua_getfield(L, LUA_REGISTRYINDEX, "cutorch.fileWriters");
+  if (lua_isnil(L, -1)) {
+    lua_pop(L, 1);
+    lua_newtable(L);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, "cutorch.fileWriters");
+  }
+}
+
+int cutorch_attachFileWriter(lua_State *L)
+{
+  luaT_checkudata(L, 1, "torch.MemoryFile");
+  cutorch_checkCheckpointWriter(L, 2);
+  cutorch_pushFileWriters(L);
+  lua_pushvalue(L, 1);
+  lua_createtable(L, 2, 0);
+  lua_pushvalue(L, 2);
+  lua_rawseti(L, -2, 1);
+  lua_pushnumber(L, 0);
+  lua_rawseti(L, -2, 2);
+  lua_settable(L, -3);
+  lua_pop(L, 1);
+  return 0;
+}
+
+/* Hands the bytes of `file` written since the last call to the writer of
+   the record on the top of the stack */
+static THCCheckpointWriter *cutorch_flushFileWriter(lua_State *L, THFile *file)
+{
+  lua_rawgeti(L, -1, 1);
+  THCCheckpointWriter *writer = cutorch_checkCheckpointWriter(L, lua_gettop(L));
+  lua_pop(L, 1);
+  lua_rawgeti(L, -1, 2);
+  size_t flushed = (size_t) lua_tonumber(L, -1);
+  lua_pop(L, 1);
+
+  size_t position = THFile_position(file);
+  THCharStorage *bytes = THMemoryFile_storage(file);
+  THCCheckpointWriter_writeHost(cutorch_getstate(L), writer, bytes->data + flushed,
+                                position - flushed);
+  lua_pushnumber(L, (lua_Number) position);
+  lua_rawseti(L, -2, 2);
+  return writer;
+}
+
+int cutorch_detachFileWriter(lua_State *L)
+{
+  THFile *file = (THFile *)luaT_checkudata(L, 1, "torch.MemoryFile");
+  cutorch_pushFileWriters(L);
+  lua_pushvalue(L, 1);
+  lua_gettable(L, -2);
+  if (!lua_isnil(L, -1)) {
+    THCCheckpointWriter *writer = cutorch_flushFileWriter(L, file);
+    THCCheckpointWriter_close(cutorch_getstate(L), writer);
+  }
+  lua_pop(L, 1);
+  lua_pushvalue(L, 1);
+  lua_pushnil(L);
+  lua_settable(L, -3);
+  lua_pop(L, 1);
+  return 0;
+}
+
+int cutorch_writeStorageAsync(lua_State *L, int index, int device, const void *data, size_t size)
+{
+  THFile *file = (THFile *)luaT_toudata(L, index, "torch.MemoryFile");
+  if (!file) {
+    return 0;
+  }
+  index = index < 0 && index > LUA_REGISTRYINDEX ? lua_gettop(L) + index + 1 : index;
+  cutorch_pushFileWriters(L);
+  lua_pushvalue(L, index);
+  lua_gettable(L, -2);
+  if (lua_isnil(L, -1)) {
+    lua_pop(L, 2);
+    return 0;
+  }
+  THCCheckpointWriter *writer = cutorch_flushFileWriter(L, file);
+  THCCheckpointWriter_writeDevice(cutorch_getstate(L), writer, device, data, size);
+  lua_pop(L, 2);
+  return 1;
+}
+
 static const struct luaL_Reg cutorch_stuff__ [] = {
   {"synchronize", cutorch_synchronize},
   {"synchronizeAll", cutorch_synchronizeAll},
@@ -948,6 +1328,16 @@ static const struct luaL_Reg cutorch_stuff__ [] = {
   {"getMemoryUsage", cutorch_getMemoryUsage},
   {"hasHalfInstructions", cutorch_hasHalfInstructions},
   {"hasFastHalfInstructions", cutorch_hasFastHalfInstructions},
+  {"setBlasMathMode", cutorch_setBlasMathMode},
+  {"getBlasMathMode", cutorch_getBlasMathMode},
+  {"setBlasForceLibrary", cutorch_setBlasForceLibrary},
+  {"getBlasForceLibrary", cutorch_getBlasForceLibrary},
+  {"setConvAlgorithm", cutorch_setConvAlgorithm},
+  {"getConvAlgorithm", cutorch_getConvAlgorithm},
+  {"setDeterministic", cutorch_setDeterministic},
+  {"getDeterministic", cutorch_getDeterministic},
+  {"setStorageGrowthFactor", cutorch_setStorageGrowthFactor},
+  {"getStorageGrowthFactor", cutorch_getStorageGrowthFactor},
   {"setDevice", cutorch_setDevice},
   {"seed", cutorch_seed},
   {"seedAll", cutorch_seedAll},
@@ -956,8 +1346,18 @@ static const struct luaL_Reg cutorch_stuff__ [] = {
   {"manualSeedAll", cutorch_manualSeedAll},
   {"getRNGState", cutorch_getRNGState},
   {"setRNGState", cutorch_setRNGState},
+  {"setRNGType", cutorch_setRNGType},
+  {"getRNGType", cutorch_getRNGType},
+  {"philoxUniform", cutorch_philoxUniform},
+  {"philoxNormal", cutorch_philoxNormal},
   {"getState", cutorch_getState},
   {"setHeapTracking", cutorch_setHeapTracking},
+  {"_mapFile", cutorch_mapFile},
+  {"_unmapFile", cutorch_unmapFile},
+  {"_readMapped", cutorch_readMapped},
+  {"_newCheckpointWriter", cutorch_newCheckpointWriter},
+  {"_attachFileWriter", cutorch_attachFileWriter},
+  {"_detachFileWriter", cutorch_detachFileWriter},
   {NULL, NULL}
 };
 
@@ -1046,6 +1446,23 @@ int luaopen_libcutorch(lua_State *L)
 #endif
   lua_setfield(L, -2, "hasHalf");
 
+  /* opcodes and limits of the elementwise expression programs */
+  lua_newtable(L);
+  lua_newtable(L);
+#define THC_EXPR_PUSH(name)                     \
+  lua_pushinteger(L, THC_EXPR_##name);          \
+  lua_setfield(L, -2, #name);
+  THC_EXPR_OPCODES(THC_EXPR_PUSH)
+#undef THC_EXPR_PUSH
+  lua_setfield(L, -2, "opcodes");
+  lua_pushinteger(L, THC_EXPR_MAX_CODE);
+  lua_setfield(L, -2, "maxCode");
+  lua_pushinteger(L, THC_EXPR_MAX_CONSTANTS);
+  lua_setfield(L, -2, "maxConstants");
+  lua_pushinteger(L, THC_EXPR_MAX_STACK);
+  lua_setfield(L, -2, "maxStack");
+  lua_setfield(L, -2, "_expr");
+
   /* store gpu driver version in field */
   int driverVersion;
   THCudaCheck(hipDriverGetVersion(&driverVersion));
@@ -22,6 +22,8 @@ end
 
 require('cutorch.Tensor')
 require('cutorch.FFI')
+require('cutorch.TensorArchive')
+require('cutorch.TensorExpression')
 require('cutorch.test')
 
 local unpack = unpack or table.unpack
@@ -53,6 +55,84 @@ function cutorch.createCudaHostTensor(...)
    return torch.FloatTensor(storage, 1, size:storage())
 end
 
+-- Loads an object written by torch.save in binary mode. The data of CUDA
+-- storages is copied to the device straight from a memory mapping of the
+-- file, in chunks whose transfers overlap the reading of the next ones.
+-- Storages shared by several tensors are loaded once, as with torch.load.
+function cutorch.loadMapped(filename)
+   local file = torch.DiskFile(filename, 'r')
+   file:binary()
+   cutorch._mapFile(file, filename)
+   local ok, object = pcall(file.readObject, file)
+   cutorch._unmapFile(file)
+   file:close()
+   if not ok then
+      error(object)
+   end
+   return object
+end
+
+local halfSources = {
+   ['torch.CudaStorage'] = 'CudaTensor',
+   ['torch.CudaDoubleStorage'] = 'CudaDoubleTensor',
+}
+
+-- Half-precision copy of the float and double CUDA tensors and storages of
+-- `object`, made on the device; views keep sharing a converted storage
+local function halfCopy(object, memo)
+   if memo[object] then
+      return memo[object]
+   end
+   local typename = torch.type(object)
+   local result = object
+   if halfSources[typename] then
+      local source = torch[halfSources[typename]](object)
+      result = torch.CudaHalfTensor(object:size()):copy(source):storage()
+   elseif typename == 'torch.CudaTensor' or typename == 'torch.CudaDoubleTensor' then
+      if object:storage() then
+         result = torch.CudaHalfTensor(halfCopy(object:storage(), memo), object:storageOffset(),
+                                       object:size(), object:stride())
+      else
+         result = torch.CudaHalfTensor()
+      end
+   elseif type(object) == 'table' then
+      result = {}
+      memo[object] = result
+      for k, v in pairs(object) do
+         result[halfCopy(k, memo)] = halfCopy(v, memo)
+      end
+      setmetatable(result, getmetatable(object))
+   end
+   memo[object] = result
+   return result
+end
+
+-- Writes `object` as torch.save(filename, object) does, in the background:
+-- the data of CUDA storages is snapshotted on the device and drained to
+-- the file by a worker thread, so the caller can go on modifying the
+-- tensors. With options.half, float and double CUDA tensors are converted
+-- to half on the device first. Returns a writer, with writer:isDone() and
+-- writer:wait(), which raises the error met while writing, if any.
+function cutorch.saveAsync(filename, object, options)
+   options = options or {}
+   if options.half then
+      assert(cutorch.hasHalf, 'half tensors are not supported')
+      object = halfCopy(object, {})
+   end
+   local writer = cutorch._newCheckpointWriter(filename)
+   local file = torch.MemoryFile()
+   file:binary()
+   cutorch._attachFileWriter(file, writer)
+   local ok, err = pcall(file.writeObject, file, object)
+   cutorch._detachFileWriter(file)
+   file:close()
+   if not ok then
+      pcall(writer.wait, writer)
+      error(err)
+   end
+   return writer
+end
+
 -- remove this line to disable automatic cutorch heap-tracking
 -- for garbage collection
 cutorch.setHeapTracking(true)
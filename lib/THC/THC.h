@@ -12,6 +12,7 @@
 #include "THCTensorRandom.h"
 #include "THCTensorMath.h"
 #include "THCTensorConv.h"
+#include "THCFFT.h"
 #include "THCTensorTopK.h"
 
 #endif
@@ -126,6 +126,19 @@ inline bool getApplyGrid(THCState* state, ptrdiff_t totalElements, dim3& grid) {
   return true;
 }
 
+#define THC_APPLY_ROW_THREADS 256
+
+// Block shape for kernels that walk rows of `rowLength` contiguous
+// elements: a power-of-two number of threads along the row, up to the
+// whole block, and as many rows per block as fit
+inline dim3 getApplyRowBlock(long rowLength) {
+  int threadsPerRow = 1;
+  while (threadsPerRow < rowLength && threadsPerRow < THC_APPLY_ROW_THREADS) {
+    threadsPerRow *= 2;
+  }
+  return dim3(threadsPerRow, THC_APPLY_ROW_THREADS / threadsPerRow);
+}
+
 template <typename TensorTypeA,
           typename Op>
 bool THC_pointwiseApply1(THCState* state,
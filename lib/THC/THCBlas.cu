@@ -1,7 +1,613 @@
+#include "hip/hip_runtime.h"
 #include "THCBlas.h"
 #include "THCGeneral.h"
 #include "THCHalf.h"
+#include "THCDeviceUtils.cuh"
+#include "THCNumerics.cuh"
+#include "THCReduceApplyUtils.cuh"
+#include "THCTensorMathPointwise.cuh"
 
+/* Built-in kernels, for what the BLAS library does not provide or where its
+   dispatch costs more than the arithmetic */
+
+#define THC_GEMV_THREADS 256
+
+template <typename T>
+struct THCBlasAdd {
+  __device__ __forceinline__ T operator()(T a, T b) const {
+    return THCNumerics<T>::add(a, b);
+  }
+};
+
+template <typename T, typename AccT>
+__device__ __forceinline__ void
+gemvStore(T *y, AccT alpha, AccT sum, AccT beta)
+{
+  AccT r = THCNumerics<AccT>::mul(alpha, sum);
+  if (!THCNumerics<AccT>::eq(beta, ScalarConvert<int, AccT>::to(0))) {
+    r = THCNumerics<AccT>::add(r, THCNumerics<AccT>::mul(beta, ScalarConvert<T, AccT>::to(*y)));
+  }
+  *y = ScalarConvert<AccT, T>::to(r);
+}
+
+// y = alpha * A * x + beta * y for a column-major m x n A; one thread per
+// row, so consecutive threads read consecutive elements of each column
+template <typename T, typename AccT>
+__global__ void
+gemvNKernel(int m, int n, AccT alpha, const T *a, long lda,
+            const T *x, long incx, AccT beta, T *y, long incy)
+{
+  for (int i = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       i < m;
+       i += hipGridDim_x * hipBlockDim_x) {
+    AccT sum = ScalarConvert<int, AccT>::to(0);
+    for (int j = 0; j < n; ++j) {
+      sum = THCNumerics<AccT>::add(
+        sum, THCNumerics<AccT>::mul(ScalarConvert<T, AccT>::to(a[i + j * lda]),
+                                    ScalarConvert<T, AccT>::to(x[j * incx])));
+    }
+    gemvStore(&y[i * incy], alpha, sum, beta);
+  }
+}
+
+// y = alpha * A^T * x + beta * y for a column-major m x n A; one block
+// reduces each column
+template <typename T, typename AccT>
+__global__ void
+gemvTKernel(int m, int n, AccT alpha, const T *a, long lda,
+            const T *x, long incx, AccT beta, T *y, long incy)
+{
+  __shared__ AccT smem[THC_GEMV_THREADS];
+  const AccT zero = ScalarConvert<int, AccT>::to(0);
+
+  for (int j = hipBlockIdx_x; j < n; j += hipGridDim_x) {
+    AccT sum = zero;
+    for (int i = hipThreadIdx_x; i < m; i += hipBlockDim_x) {
+      sum = THCNumerics<AccT>::add(
+        sum, THCNumerics<AccT>::mul(ScalarConvert<T, AccT>::to(a[i + j * lda]),
+                                    ScalarConvert<T, AccT>::to(x[i * incx])));
+    }
+    sum = reduceBlock<AccT, THCBlasAdd<AccT> >(smem, hipBlockDim_x, sum,
+                                               THCBlasAdd<AccT>(), zero);
+    if (hipThreadIdx_x == 0) {
+      gemvStore(&y[j * incy], alpha, sum, beta);
+    }
+    // smem is reused by the next column
+    __syncthreads();
+  }
+}
+
+// A = alpha * x * y^T + A for a column-major m x n A
+template <typename T, typename AccT>
+__global__ void
+gerKernel(int m, int n, AccT alpha, const T *x, long incx,
+          const T *y, long incy, T *a, long lda)
+{
+  for (int j = hipBlockIdx_y * hipBlockDim_y + hipThreadIdx_y;
+       j < n;
+       j += hipGridDim_y * hipBlockDim_y) {
+    AccT ay = THCNumerics<AccT>::mul(alpha, ScalarConvert<T, AccT>::to(y[j * incy]));
+    for (int i = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+         i < m;
+         i += hipGridDim_x * hipBlockDim_x) {
+      T *out = &a[i + j * lda];
+      *out = ScalarConvert<AccT, T>::to(
+        THCNumerics<AccT>::add(ScalarConvert<T, AccT>::to(*out),
+                               THCNumerics<AccT>::mul(ay, ScalarConvert<T, AccT>::to(x[i * incx]))));
+    }
+  }
+}
+
+template <typename T, typename AccT>
+static void THCudaBlas_gemvKernels(THCState *state, char trans, int m, int n,
+                                   AccT alpha, const T *a, long lda,
+                                   const T *x, long incx, AccT beta, T *y, long incy)
+{
+  hipStream_t stream = THCState_getCurrentStream(state);
+  if (trans == 'n' || trans == 'N') {
+    if (m == 0) {
+      return;
+    }
+    int blocks = THCCeilDiv(m, THC_GEMV_THREADS);
+    hipLaunchKernelGGL(
+      (gemvNKernel<T, AccT>),
+      dim3(blocks < 1024 ? blocks : 1024),
+      dim3(THC_GEMV_THREADS),
+      0,
+      stream,
+      m, n, alpha, a, lda, x, incx, beta, y, incy);
+  } else {
+    if (n == 0) {
+      return;
+    }
+    hipLaunchKernelGGL(
+      (gemvTKernel<T, AccT>),
+      dim3(n < 65535 ? n : 65535),
+      dim3(THC_GEMV_THREADS),
+      0,
+      stream,
+      m, n, alpha, a, lda, x, incx, beta, y, incy);
+  }
+}
+
+template <typename T, typename AccT>
+static void THCudaBlas_gerKernel(THCState *state, int m, int n, AccT alpha,
+                                 const T *x, long incx, const T *y, long incy,
+                                 T *a, long lda)
+{
+  if (m == 0 || n == 0) {
+    return;
+  }
+  dim3 block(32, 8);
+  int gridX = THCCeilDiv(m, 32);
+  int gridY = THCCeilDiv(n, 8);
+  dim3 grid(gridX < 1024 ? gridX : 1024, gridY < 65535 ? gridY : 65535);
+  hipLaunchKernelGGL(
+    (gerKernel<T, AccT>),
+    grid,
+    block,
+    0,
+    THCState_getCurrentStream(state),
+    m, n, alpha, x, incx, y, incy, a, lda);
+}
+
+// Tile edge of the built-in batched GEMM kernel
+#define THC_GEMM_TILE 16
+// Largest m, n and k handed to the built-in kernel rather than the BLAS
+#define THC_GEMM_SMALL_DIM 32
+
+// Matrix i of a batch sits a fixed stride after matrix i - 1
+template <typename T>
+struct THCGemmStridedBatch {
+  const T *a;
+  long strideA;
+  const T *b;
+  long strideB;
+  T *c;
+  long strideC;
+
+  __device__ __forceinline__ const T *A(long i) const { return a + i * strideA; }
+  __device__ __forceinline__ const T *B(long i) const { return b + i * strideB; }
+  __device__ __forceinline__ T *C(long i) const { return c + i * strideC; }
+};
+
+// Matrix i of a batch is found through device arrays of pointers
+template <typename T>
+struct THCGemmPointerBatch {
+  const T **a;
+  const T **b;
+  T **c;
+
+  __device__ __forceinline__ const T *A(long i) const { return a[i]; }
+  __device__ __forceinline__ const T *B(long i) const { return b[i]; }
+  __device__ __forceinline__ T *C(long i) const { return c[i]; }
+};
+
+// Column-major C = alpha * op(A) * op(B) + beta * C for every matrix of a
+// batch. Matrices are stored as T and products accumulate in AccT, so half
+// matrices can be multiplied with float accumulation.
+template <typename T, typename AccT, typename Batch>
+__global__ void
+gemmTiledKernel(bool transa, bool transb, int m, int n, int k,
+                AccT alpha, long lda, long ldb, AccT beta, long ldc,
+                Batch batch, long batchCount)
+{
+  __shared__ AccT tileA[THC_GEMM_TILE][THC_GEMM_TILE + 1];
+  __shared__ AccT tileB[THC_GEMM_TILE][THC_GEMM_TILE + 1];
+
+  const AccT zero = ScalarConvert<int, AccT>::to(0);
+  int tx = hipThreadIdx_x;
+  int ty = hipThreadIdx_y;
+  int row = hipBlockIdx_x * THC_GEMM_TILE + tx;
+  int colBlocks = (n + THC_GEMM_TILE - 1) / THC_GEMM_TILE;
+
+  // grid.y is capped, so a block may take several tiles of columns
+  for (int colBlock = hipBlockIdx_y; colBlock < colBlocks; colBlock += hipGridDim_y) {
+    int col = colBlock * THC_GEMM_TILE + ty;
+    for (long i = hipBlockIdx_z; i < batchCount; i += hipGridDim_z) {
+      const T *a = batch.A(i);
+      const T *b = batch.B(i);
+      AccT sum = zero;
+
+      for (int l0 = 0; l0 < k; l0 += THC_GEMM_TILE) {
+        int la = l0 + ty;
+        int lb = l0 + tx;
+        tileA[tx][ty] = (row < m && la < k) ?
+          ScalarConvert<T, AccT>::to(transa ? a[la + row * lda] : a[row + la * lda]) : zero;
+        tileB[tx][ty] = (lb < k && col < n) ?
+          ScalarConvert<T, AccT>::to(transb ? b[col + lb * ldb] : b[lb + col * ldb]) : zero;
+        __syncthreads();
+
+        for (int l = 0; l < THC_GEMM_TILE; ++l) {
+          sum = THCNumerics<AccT>::add(sum, THCNumerics<AccT>::mul(tileA[tx][l], tileB[l][ty]));
+        }
+        __syncthreads();
+      }
+
+      if (row < m && col < n) {
+        T *out = batch.C(i) + row + col * ldc;
+        AccT r = THCNumerics<AccT>::mul(alpha, sum);
+        // As in BLAS, C is not read when beta is zero
+        if (!THCNumerics<AccT>::eq(beta, zero)) {
+          r = THCNumerics<AccT>::add(r, THCNumerics<AccT>::mul(beta, ScalarConvert<T, AccT>::to(*out)));
+        }
+        *out = ScalarConvert<AccT, T>::to(r);
+      }
+    }
+  }
+}
+
+template <typename T, typename AccT, typename Batch>
+static void THCudaBlas_gemmTiled(THCState *state, char transa, char transb,
+                                 long m, long n, long k,
+                                 AccT alpha, long lda, long ldb, AccT beta, long ldc,
+                                 Batch batch, long batchCount)
+{
+  if (m == 0 || n == 0 || batchCount == 0) {
+    return;
+  }
+
+  dim3 block(THC_GEMM_TILE, THC_GEMM_TILE);
+  long colBlocks = THCCeilDiv(n, (long) THC_GEMM_TILE);
+  dim3 grid(THCCeilDiv(m, (long) THC_GEMM_TILE),
+            colBlocks < 65535 ? colBlocks : 65535,
+            batchCount < 65535 ? batchCount : 65535);
+  hipLaunchKernelGGL(
+    (gemmTiledKernel<T, AccT, Batch>),
+    grid,
+    block,
+    0,
+    THCState_getCurrentStream(state),
+    transa == 't' || transa == 'T', transb == 't' || transb == 'T',
+    (int) m, (int) n, (int) k,
+    alpha, lda, ldb, beta, ldc, batch, batchCount);
+}
+
+// Stores of the built-in GEMM kernels, which receive alpha * op(A) * op(B)
+// for element (i, j) of C and return the value to write.
+
+// Plain GEMM: C = v + beta * C, not reading C when beta is zero as in BLAS
+template <typename T>
+struct THCGemmBetaStore {
+  T beta;
+
+  __device__ __forceinline__ T operator()(T v, const T *out, int i, int j) const {
+    return beta == (T) 0 ? v : v + beta * *out;
+  }
+};
+
+// Fused epilogue: C = act(v + bias), computed in AccT
+template <typename T, typename AccT>
+struct THCGemmEpilogue {
+  const T *bias;
+  long biasStride;
+  int biasDim;
+  int activation;
+
+  __device__ __forceinline__ T apply(AccT v, int i, int j) const {
+    if (bias) {
+      v = THCNumerics<AccT>::add(
+        v, ScalarConvert<T, AccT>::to(bias[(biasDim == 0 ? i : j) * biasStride]));
+    }
+    switch (activation) {
+      case THC_ACTIVATION_SIGMOID:
+        TensorSigmoidOp<AccT>()(&v);
+        break;
+      case THC_ACTIVATION_TANH:
+        v = THCNumerics<AccT>::tanh(v);
+        break;
+      case THC_ACTIVATION_RELU:
+        if (!THCNumerics<AccT>::gt(v, ScalarConvert<int, AccT>::to(0))) {
+          v = ScalarConvert<int, AccT>::to(0);
+        }
+        break;
+      default:
+        break;
+    }
+    return ScalarConvert<AccT, T>::to(v);
+  }
+
+  __device__ __forceinline__ T operator()(AccT v, const T *out, int i, int j) const {
+    return apply(v, i, j);
+  }
+};
+
+// Applies the epilogue over C, for GEMMs the library computed
+template <typename T, typename AccT>
+__global__ void
+gemmEpilogueKernel(int m, int n, T *c, long ldc, THCGemmEpilogue<T, AccT> epilogue)
+{
+  for (int j = hipBlockIdx_y * hipBlockDim_y + hipThreadIdx_y;
+       j < n;
+       j += hipGridDim_y * hipBlockDim_y) {
+    for (int i = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+         i < m;
+         i += hipGridDim_x * hipBlockDim_x) {
+      T *out = &c[i + j * ldc];
+      *out = epilogue.apply(ScalarConvert<T, AccT>::to(*out), i, j);
+    }
+  }
+}
+
+template <typename T, typename AccT>
+static void THCudaBlas_gemmEpiloguePass(THCState *state, long m, long n, T *c, long ldc,
+                                        THCGemmEpilogue<T, AccT> epilogue)
+{
+  if (m == 0 || n == 0) {
+    return;
+  }
+  dim3 block(32, 8);
+  long gridX = THCCeilDiv(m, 32L);
+  long gridY = THCCeilDiv(n, 8L);
+  dim3 grid(gridX < 1024 ? gridX : 1024, gridY < 65535 ? gridY : 65535);
+  hipLaunchKernelGGL(
+    (gemmEpilogueKernel<T, AccT>),
+    grid,
+    block,
+    0,
+    THCState_getCurrentStream(state),
+    (int) m, (int) n, c, ldc, epilogue);
+  THCudaCheck(hipGetLastError());
+}
+
+// Register-blocked tile of the small-matrix GEMM kernel: each block computes
+// a BM x BN tile of C, each thread a TM x TN sub-tile held in registers
+#define THC_GEMM_RB_BM 32
+#define THC_GEMM_RB_BN 32
+#define THC_GEMM_RB_BK 8
+#define THC_GEMM_RB_TM 2
+#define THC_GEMM_RB_TN 2
+
+template <typename T, int BM, int BN, int BK, int TM, int TN, typename Store>
+__global__ void
+gemmRegisterBlockedKernel(bool transa, bool transb, int m, int n, int k,
+                          T alpha, const T *a, long lda, const T *b, long ldb,
+                          T *c, long ldc, Store store)
+{
+  __shared__ T tileA[BK][BM + 1];
+  __shared__ T tileB[BK][BN + 1];
+
+  const int threadsM = BM / TM;
+  const int threadsN = BN / TN;
+  int tx = hipThreadIdx_x;
+  int ty = hipThreadIdx_y;
+  int tid = ty * threadsM + tx;
+  int row0 = hipBlockIdx_x * BM;
+  int col0 = hipBlockIdx_y * BN;
+
+  T acc[TM][TN];
+#pragma unroll
+  for (int ti = 0; ti < TM; ++ti) {
+#pragma unroll
+    for (int tj = 0; tj < TN; ++tj) {
+      acc[ti][tj] = (T) 0;
+    }
+  }
+
+  for (int l0 = 0; l0 < k; l0 += BK) {
+    // Consecutive threads load consecutive rows of A and of B, which are
+    // contiguous unless the operand is transposed
+    for (int e = tid; e < BM * BK; e += threadsM * threadsN) {
+      int i = row0 + e % BM;
+      int l = l0 + e / BM;
+      tileA[e / BM][e % BM] = (i < m && l < k) ?
+        (transa ? a[l + i * lda] : a[i + l * lda]) : (T) 0;
+    }
+    for (int e = tid; e < BK * BN; e += threadsM * threadsN) {
+      int l = l0 + e % BK;
+      int j = col0 + e / BK;
+      tileB[e % BK][e / BK] = (l < k && j < n) ?
+        (transb ? b[j + l * ldb] : b[l + j * ldb]) : (T) 0;
+    }
+    __syncthreads();
+
+#pragma unroll
+    for (int l = 0; l < BK; ++l) {
+      T ra[TM];
+      T rb[TN];
+#pragma unroll
+      for (int ti = 0; ti < TM; ++ti) {
+        ra[ti] = tileA[l][tx + ti * threadsM];
+      }
+#pragma unroll
+      for (int tj = 0; tj < TN; ++tj) {
+        rb[tj] = tileB[l][ty + tj * threadsN];
+      }
+#pragma unroll
+      for (int ti = 0; ti < TM; ++ti) {
+#pragma unroll
+        for (int tj = 0; tj < TN; ++tj) {
+          acc[ti][tj] += ra[ti] * rb[tj];
+        }
+      }
+    }
+    __syncthreads();
+  }
+
+#pragma unroll
+  for (int ti = 0; ti < TM; ++ti) {
+#pragma unroll
+    for (int tj = 0; tj < TN; ++tj) {
+      int i = row0 + tx + ti * threadsM;
+      int j = col0 + ty + tj * threadsN;
+      if (i < m && j < n) {
+        T *out = &c[i + j * ldc];
+        *out = store(alpha * acc[ti][tj], out, i, j);
+      }
+    }
+  }
+}
+
+// C = alpha * A * op(B) + beta * C for a C of at most N columns; one thread
+// per row of C keeps all of its outputs in registers while walking k
+template <typename T, int N, typename Store>
+__global__ void
+gemmSkinnyNKernel(bool transb, int m, int n, int k,
+                  T alpha, const T *a, long lda, const T *b, long ldb,
+                  T *c, long ldc, Store store)
+{
+  for (int i = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       i < m;
+       i += hipGridDim_x * hipBlockDim_x) {
+    T acc[N];
+#pragma unroll
+    for (int j = 0; j < N; ++j) {
+      acc[j] = (T) 0;
+    }
+    for (int l = 0; l < k; ++l) {
+      T ail = a[i + l * lda];
+#pragma unroll
+      for (int j = 0; j < N; ++j) {
+        if (j < n) {
+          acc[j] += ail * (transb ? b[j + l * ldb] : b[l + j * ldb]);
+        }
+      }
+    }
+#pragma unroll
+    for (int j = 0; j < N; ++j) {
+      if (j < n) {
+        T *out = &c[i + j * ldc];
+        *out = store(alpha * acc[j], out, i, j);
+      }
+    }
+  }
+}
+
+// C = alpha * A^T * op(B) + beta * C for a C of at most N columns; rows of
+// A^T are contiguous, so one block reduces each row of C
+template <typename T, int N, typename Store>
+__global__ void
+gemmSkinnyTKernel(bool transb, int m, int n, int k,
+                  T alpha, const T *a, long lda, const T *b, long ldb,
+                  T *c, long ldc, Store store)
+{
+  __shared__ T smem[THC_GEMV_THREADS];
+
+  for (int i = hipBlockIdx_x; i < m; i += hipGridDim_x) {
+    T acc[N];
+#pragma unroll
+    for (int j = 0; j < N; ++j) {
+      acc[j] = (T) 0;
+    }
+    for (int l = hipThreadIdx_x; l < k; l += hipBlockDim_x) {
+      T ail = a[l + i * lda];
+#pragma unroll
+      for (int j = 0; j < N; ++j) {
+        if (j < n) {
+          acc[j] += ail * (transb ? b[j + l * ldb] : b[l + j * ldb]);
+        }
+      }
+    }
+#pragma unroll
+    for (int j = 0; j < N; ++j) {
+      if (j < n) {
+        T sum = reduceBlock<T, THCBlasAdd<T> >(smem, hipBlockDim_x, acc[j],
+                                               THCBlasAdd<T>(), (T) 0);
+        if (hipThreadIdx_x == 0) {
+          T *out = &c[i + j * ldc];
+          *out = store(alpha * sum, out, i, j);
+        }
+        // smem is reused by the next reduction
+        __syncthreads();
+      }
+    }
+  }
+}
+
+// Shapes below which library dispatch costs more than the arithmetic. They
+// are tuned with test/benchmark_blas.lua.
+#define THC_GEMM_BUILTIN_MAX_DIM 64
+#define THC_GEMM_SKINNY_MAX_N 8
+#define THC_GEMM_SKINNY_MAX_ELEMENTS (1L << 20)
+#define THC_GEMV_BUILTIN_MAX_ELEMENTS (64L * 64L)
+
+template <typename T, int N, typename Store>
+static void THCudaBlas_gemmSkinny(THCState *state, bool transa, bool transb,
+                                  int m, int n, int k, T alpha,
+                                  const T *a, long lda, const T *b, long ldb,
+                                  T *c, long ldc, Store store)
+{
+  hipStream_t stream = THCState_getCurrentStream(state);
+  if (transa) {
+    hipLaunchKernelGGL(
+      (gemmSkinnyTKernel<T, N, Store>),
+      dim3(m < 65535 ? m : 65535),
+      dim3(THC_GEMV_THREADS),
+      0,
+      stream,
+      transb, m, n, k, alpha, a, lda, b, ldb, c, ldc, store);
+  } else {
+    int blocks = THCCeilDiv(m, THC_GEMV_THREADS);
+    hipLaunchKernelGGL(
+      (gemmSkinnyNKernel<T, N, Store>),
+      dim3(blocks < 1024 ? blocks : 1024),
+      dim3(THC_GEMV_THREADS),
+      0,
+      stream,
+      transb, m, n, k, alpha, a, lda, b, ldb, c, ldc, store);
+  }
+}
+
+// Runs a GEMM on the built-in kernels when its shape is one they serve
+// better than the library; returns false to defer to the library
+template <typename T, typename Store>
+static bool THCudaBlas_gemmBuiltin(THCState *state, char transa, char transb,
+                                   long m, long n, long k, T alpha,
+                                   const T *a, long lda, const T *b, long ldb,
+                                   T *c, long ldc, Store store)
+{
+  if (THCState_getBlasForceLibrary(state) || m == 0 || n == 0) {
+    return false;
+  }
+
+  bool ta = (transa == 't' || transa == 'T' || transa == 'c' || transa == 'C');
+  bool tb = (transb == 't' || transb == 'T' || transb == 'c' || transb == 'C');
+
+  if (m <= THC_GEMM_BUILTIN_MAX_DIM && n <= THC_GEMM_BUILTIN_MAX_DIM &&
+      k <= THC_GEMM_BUILTIN_MAX_DIM) {
+    dim3 block(THC_GEMM_RB_BM / THC_GEMM_RB_TM, THC_GEMM_RB_BN / THC_GEMM_RB_TN);
+    dim3 grid(THCCeilDiv(m, (long) THC_GEMM_RB_BM), THCCeilDiv(n, (long) THC_GEMM_RB_BN));
+    hipLaunchKernelGGL(
+      (gemmRegisterBlockedKernel<T, THC_GEMM_RB_BM, THC_GEMM_RB_BN, THC_GEMM_RB_BK,
+                                 THC_GEMM_RB_TM, THC_GEMM_RB_TN, Store>),
+      grid,
+      block,
+      0,
+      THCState_getCurrentStream(state),
+      ta, tb, (int) m, (int) n, (int) k, alpha, a, lda, b, ldb, c, ldc, store);
+  } else if (n <= THC_GEMM_SKINNY_MAX_N && m * k <= THC_GEMM_SKINNY_MAX_ELEMENTS) {
+    if (n == 1) {
+      THCudaBlas_gemmSkinny<T, 1>(state, ta, tb, m, n, k, alpha, a, lda, b, ldb, c, ldc, store);
+    } else if (n == 2) {
+      THCudaBlas_gemmSkinny<T, 2>(state, ta, tb, m, n, k, alpha, a, lda, b, ldb, c, ldc, store);
+    } else if (n <= 4) {
+      THCudaBlas_gemmSkinny<T, 4>(state, ta, tb, m, n, k, alpha, a, lda, b, ldb, c, ldc, store);
+    } else {
+      THCudaBlas_gemmSkinny<T, 8>(state, ta, tb, m, n, k, alpha, a, lda, b, ldb, c, ldc, store);
+    }
+  } else {
+    return false;
+  }
+
+  THCudaCheck(hipGetLastError());
+  return true;
+}
+
+// As THCudaBlas_gemmBuiltin, for GEMV
+template <typename T>
+static bool THCudaBlas_gemvBuiltin(THCState *state, char trans, long m, long n,
+                                   T alpha, const T *a, long lda,
+                                   const T *x, long incx, T beta, T *y, long incy)
+{
+  if (THCState_getBlasForceLibrary(state) || m * n > THC_GEMV_BUILTIN_MAX_ELEMENTS) {
+    return false;
+  }
+
+  THCudaBlas_gemvKernels<T, T>(state, trans, (int) m, (int) n,
+                               alpha, a, lda, x, incx, beta, y, incy);
+  THCudaCheck(hipGetLastError());
+  return true;
+}
 
 float THCudaBlas_Sdot(THCState *state, long n, float *x, long incx, float *y, long incy)
 {
@@ -109,6 +715,11 @@ void THCudaBlas_Sgemv(THCState *state, char trans, long m, long n, float alpha,
     int i_incx = (int)incx;
     int i_incy = (int)incy;
 
+    if (THCudaBlas_gemvBuiltin<float>(state, trans, m, n, alpha, a, lda,
+                                       x, incx, beta, y, incy)) {
+      return;
+    }
+
     hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
     hipblasSetStream(handle, THCState_getCurrentStream(state));
     THCublasCheck(hipblasSgemv(handle, op, i_m, i_n, &alpha, a, i_lda, x, i_incx, &beta, y, i_incy));
@@ -140,6 +751,11 @@ void THCudaBlas_Dgemv(THCState *state, char trans, long m, long n, double alpha,
     int i_incx = (int)incx;
     int i_incy = (int)incy;
 
+    if (THCudaBlas_gemvBuiltin<double>(state, trans, m, n, alpha, a, lda,
+                                       x, incx, beta, y, incy)) {
+      return;
+    }
+
     hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
     hipblasSetStream(handle, THCState_getCurrentStream(state));
     THCublasCheck(hipblasDgemv(handle, op, i_m, i_n, &alpha, a, i_lda, x, i_incx, &beta, y, i_incy));
@@ -199,6 +815,157 @@ void THCudaBlas_Dger(THCState *state, long m, long n, double alpha, double *x, l
           "with the bound [val] <= %d", INT_MAX);
 }
 
+#ifdef CUDA_HALF_TENSOR
+// Whether half BLAS routines may compute in half instead of accumulating in
+// float, per the THCState math mode and the device
+static bool THCudaBlas_halfMathIsNative(THCState *state)
+{
+  if (THCState_getBlasMathMode(state) != THC_BLAS_MATH_HALF) {
+    return false;
+  }
+#ifdef __NVCC__
+  return THC_fastHalfInstructions(state);
+#else
+  return true;
+#endif
+}
+
+// Whether a half GEMM is small or skinny enough for the tiled kernel; larger
+// ones go to the library
+static bool THCudaBlas_halfGemmIsTiled(long m, long n, long k)
+{
+  return (m <= THC_GEMM_BUILTIN_MAX_DIM && n <= THC_GEMM_BUILTIN_MAX_DIM &&
+          k <= THC_GEMM_BUILTIN_MAX_DIM) ||
+         (n <= THC_GEMM_SKINNY_MAX_N && m * k <= THC_GEMM_SKINNY_MAX_ELEMENTS);
+}
+
+// Converts the rows x cols column-major matrices (leading dimension ld) of a
+// strided batch between storage types
+template <typename Src, typename Dst>
+__global__ void
+gemmConvertKernel(const Src *src, long srcStride, Dst *dst, long dstStride,
+                  long rows, long cols, long ld, long batchCount)
+{
+  long total = rows * cols * batchCount;
+  for (long idx = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       idx < total;
+       idx += hipGridDim_x * hipBlockDim_x) {
+    long i = idx % rows;
+    long j = (idx / rows) % cols;
+    long batch = idx / (rows * cols);
+    dst[batch * dstStride + i + j * ld] =
+      ScalarConvert<Src, Dst>::to(src[batch * srcStride + i + j * ld]);
+  }
+}
+
+template <typename Src, typename Dst>
+static void THCudaBlas_gemmConvert(THCState *state, const Src *src, long srcStride,
+                                   Dst *dst, long dstStride,
+                                   long rows, long cols, long ld, long batchCount)
+{
+  long blocks = THCCeilDiv(rows * cols * batchCount, 256L);
+  hipLaunchKernelGGL(
+    (gemmConvertKernel<Src, Dst>),
+    dim3(blocks < 65535 ? blocks : 65535),
+    dim3(256),
+    0,
+    THCState_getCurrentStream(state),
+    src, srcStride, dst, dstStride, rows, cols, ld, batchCount);
+  THCudaCheck(hipGetLastError());
+}
+
+// Half GEMM with float accumulation through the library's float GEMM, for
+// when it has no float-accumulating half GEMM: the operands are widened to
+// float copies, which take twice the memory of the half ones, and the
+// result is narrowed back into c.
+static void THCudaBlas_halfGemmViaFloat(THCState *state, char transa, char transb,
+                                        long m, long n, long k,
+                                        float alpha, const half *a, long lda, long strideA,
+                                        const half *b, long ldb, long strideB,
+                                        float beta, half *c, long ldc, long strideC,
+                                        long batchCount)
+{
+  if (m == 0 || n == 0 || batchCount == 0) {
+    return;
+  }
+
+  int transa_ = transa != 'n' && transa != 'N';
+  int transb_ = transb != 'n' && transb != 'N';
+  long rowsA = transa_ ? k : m, colsA = transa_ ? m : k;
+  long rowsB = transb_ ? n : k, colsB = transb_ ? k : n;
+  long sizeA = lda * colsA, sizeB = ldb * colsB, sizeC = ldc * n;
+
+  float *fa;
+  THCudaCheck(THCudaMalloc(state, (void**) &fa,
+                           (sizeA + sizeB + sizeC) * batchCount * sizeof(float)));
+  float *fb = fa + sizeA * batchCount;
+  float *fc = fb + sizeB * batchCount;
+
+  THCudaBlas_gemmConvert<half, float>(state, a, strideA, fa, sizeA, rowsA, colsA, lda, batchCount);
+  THCudaBlas_gemmConvert<half, float>(state, b, strideB, fb, sizeB, rowsB, colsB, ldb, batchCount);
+  // As in BLAS, C is not read when beta is zero
+  if (beta != 0.0f) {
+    THCudaBlas_gemmConvert<half, float>(state, c, strideC, fc, sizeC, m, n, ldc, batchCount);
+  }
+
+  if (batchCount == 1) {
+    THCudaBlas_Sgemm(state, transa, transb, m, n, k, alpha, fa, lda, fb, ldb, beta, fc, ldc);
+  } else {
+    THCudaBlas_SgemmStridedBatched(state, transa, transb, m, n, k, alpha, fa, lda, sizeA,
+                                   fb, ldb, sizeB, beta, fc, ldc, sizeC, batchCount);
+  }
+
+  THCudaBlas_gemmConvert<float, half>(state, fc, sizeC, c, strideC, m, n, ldc, batchCount);
+  THCudaCheck(THCudaFree(state, fa));
+}
+
+void THCudaBlas_Hgemv(THCState *state, char trans, long m, long n, half alpha, half *a, long lda, half *x, long incx, half beta, half *y, long incy)
+{
+  if(n == 1)
+    lda = m;
+
+  if( (m <= INT_MAX) && (n <= INT_MAX) &&
+      (lda > 0) && (lda <= INT_MAX) &&
+      (incx > 0) && (incx <= INT_MAX) &&
+      (incy > 0) && (incy <= INT_MAX) )
+  {
+    if (THCudaBlas_halfMathIsNative(state)) {
+      THCudaBlas_gemvKernels<half, half>(state, trans, (int)m, (int)n,
+                                         alpha, a, lda, x, incx, beta, y, incy);
+    } else {
+      THCudaBlas_gemvKernels<half, float>(state, trans, (int)m, (int)n,
+                                          THC_half2float(alpha), a, lda, x, incx,
+                                          THC_half2float(beta), y, incy);
+    }
+    THCudaCheck(hipGetLastError());
+    return;
+  }
+  THError("Cublas_Hgemv only supports m, n, lda, incx, incy"
+          "in the range 0 < [val] <= %d", INT_MAX);
+}
+
+void THCudaBlas_Hger(THCState *state, long m, long n, half alpha, half *x, long incx, half *y, long incy, half *a, long lda)
+{
+  if(n == 1)
+    lda = m;
+
+  if( (m <= INT_MAX) && (n <= INT_MAX) && (lda <= INT_MAX)  && (incx <= INT_MAX) && (incy <= INT_MAX) )
+    {
+      if (THCudaBlas_halfMathIsNative(state)) {
+        THCudaBlas_gerKernel<half, half>(state, (int)m, (int)n, alpha,
+                                         x, incx, y, incy, a, lda);
+      } else {
+        THCudaBlas_gerKernel<half, float>(state, (int)m, (int)n, THC_half2float(alpha),
+                                          x, incx, y, incy, a, lda);
+      }
+      THCudaCheck(hipGetLastError());
+      return;
+    }
+  THError("Cublas_Hger only supports m, n, lda, incx, incy"
+          "with the bound [val] <= %d", INT_MAX);
+}
+#endif
+
 hipblasOperation_t convertTransToHipblasOperation(char trans) {
   if (trans == 't') return HIPBLAS_OP_T;
   else if (trans == 'n') return HIPBLAS_OP_N;
@@ -266,6 +1033,12 @@ void THCudaBlas_Sgemm(THCState *state, char transa, char transb, long m, long n,
     int i_ldb = (int)ldb;
     int i_ldc = (int)ldc;
 
+    THCGemmBetaStore<float> store = {beta};
+    if (THCudaBlas_gemmBuiltin(state, transa, transb, m, n, k,
+                               alpha, a, lda, b, ldb, c, ldc, store)) {
+      return;
+    }
+
     hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
     hipblasSetStream(handle, THCState_getCurrentStream(state));
     THCublasCheck(hipblasSgemm(handle, opa, opb, i_m, i_n, i_k, &alpha, a, i_lda, b, i_ldb, &beta, c, i_ldc));
@@ -299,26 +1072,40 @@ void THCudaBlas_Hgemm(THCState *state, char transa, char transb, long m, long n,
     hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
     hipblasSetStream(handle, THCState_getCurrentStream(state));
 
-    // Check for native Hgemm support
-#ifdef __NVCC__
-    if (THC_fastHalfInstructions(state)) {
+    if (THCudaBlas_halfMathIsNative(state)) {
       THCublasCheck(hipblasHgemm(handle, opa, opb,
-				i_m, i_n, i_k, &alpha, a, i_lda, b, i_ldb,
-				&beta, c, i_ldc));
+                                 i_m, i_n, i_k, &alpha, a, i_lda, b, i_ldb,
+                                 &beta, c, i_ldc));
+      return;
+    }
+
+    // Half storage, float accumulation
+    float fAlpha = THC_half2float(alpha);
+    float fBeta = THC_half2float(beta);
+#ifdef HIPBLAS_TODO
+    THCublasCheck(hipblasGemmEx(handle, opa, opb,
+                                i_m, i_n, i_k, &fAlpha,
+                                a, HIPBLAS_R_16F, i_lda, b, HIPBLAS_R_16F, i_ldb,
+                                &fBeta, c, HIPBLAS_R_16F, i_ldc,
+                                HIPBLAS_R_32F, HIPBLAS_GEMM_DEFAULT));
+#elif defined(__NVCC__)
+    cublasSetStream((cublasHandle_t)handle, THCState_getCurrentStream(state));
+    cublasSgemmEx((cublasHandle_t)handle,
+                  convertTransToCublasOperation(transa),
+                  convertTransToCublasOperation(transb),
+                  i_m, i_n, i_k, &fAlpha,
+                  a, CUDA_R_16F, i_lda, b, CUDA_R_16F, i_ldb,
+                  &fBeta, c, CUDA_R_16F, i_ldc);
+#else
+    if (THCudaBlas_halfGemmIsTiled(m, n, k)) {
+      THCGemmStridedBatch<half> batch = {a, 0, b, 0, c, 0};
+      THCudaBlas_gemmTiled<half, float>(state, transa, transb, m, n, k,
+                                        fAlpha, lda, ldb, fBeta, ldc, batch, 1);
+      THCudaCheck(hipGetLastError());
     } else {
-      // Simulated Hgemm
-      float fAlpha = THC_half2float(alpha);
-      float fBeta = THC_half2float(beta);
-
-      /*THCublasCheck(cublasSgemmEx(handle, opa, opb,
-				  i_m, i_n, i_k, &fAlpha,
-                                  a, CUDA_R_16F, i_lda, b, CUDA_R_16F,
-				  i_ldb, &fBeta, c, CUDA_R_16F, i_ldc));*/
-    }
-#elif __HCC__
-      hipblasHgemm(handle, opa, opb,
-				i_m, i_n, i_k, &alpha, a, i_lda, b, i_ldb,
-				&beta, c, i_ldc);
+      THCudaBlas_halfGemmViaFloat(state, transa, transb, m, n, k,
+                                  fAlpha, a, lda, 0, b, ldb, 0, fBeta, c, ldc, 0, 1);
+    }
 #endif
     return;
   }
@@ -343,6 +1130,12 @@ void THCudaBlas_Dgemm(THCState *state, char transa, char transb, long m, long n,
     int i_ldb = (int)ldb;
     int i_ldc = (int)ldc;
 
+    THCGemmBetaStore<double> store = {beta};
+    if (THCudaBlas_gemmBuiltin(state, transa, transb, m, n, k,
+                               alpha, a, lda, b, ldb, c, ldc, store)) {
+      return;
+    }
+
     hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
     hipblasSetStream(handle, THCState_getCurrentStream(state));
     THCublasCheck(hipblasDgemm(handle, opa, opb, i_m, i_n, i_k, &alpha, a, i_lda, b, i_ldb, &beta, c, i_ldc));
@@ -397,6 +1190,309 @@ void THCudaBlas_DgemmBatched(THCState *state, char transa, char transb, long m,
                                    (int)batchCount));
 }
 
+/* Strided batched */
+
+// Expands uniform batch strides into the pointer arrays of gemmBatched
+template <typename T>
+__global__ void
+gemmBatchedPointers(const T **aPtrs, const T **bPtrs, T **cPtrs,
+                    const T *a, long strideA, const T *b, long strideB,
+                    T *c, long strideC, long batchCount)
+{
+  for (long i = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       i < batchCount;
+       i += hipGridDim_x * hipBlockDim_x) {
+    aPtrs[i] = a + i * strideA;
+    bPtrs[i] = b + i * strideB;
+    cPtrs[i] = c + i * strideC;
+  }
+}
+
+template <typename T>
+static void THCudaBlas_gemmStridedBatchedFallback(
+    THCState *state, char transa, char transb, long m, long n, long k,
+    T alpha, const T *a, long lda, long strideA, const T *b, long ldb, long strideB,
+    T beta, T *c, long ldc, long strideC, long batchCount,
+    void (*gemmBatched)(THCState*, char, char, long, long, long,
+                        T, const T**, long, const T**, long,
+                        T, T**, long, long))
+{
+  if (m == 0 || n == 0 || batchCount == 0) {
+    return;
+  }
+
+  if (m <= THC_GEMM_SMALL_DIM && n <= THC_GEMM_SMALL_DIM && k <= THC_GEMM_SMALL_DIM) {
+    THCGemmStridedBatch<T> batch = {a, strideA, b, strideB, c, strideC};
+    THCudaBlas_gemmTiled<T, T>(state, transa, transb, m, n, k,
+                               alpha, lda, ldb, beta, ldc, batch, batchCount);
+    return;
+  }
+
+  // Build the pointer arrays on the device; no host arrays or copies
+  void **ptrs;
+  THCudaCheck(THCudaMalloc(state, (void**) &ptrs, 3 * batchCount * sizeof(void*)));
+  const T **aPtrs = (const T **) ptrs;
+  const T **bPtrs = (const T **) (ptrs + batchCount);
+  T **cPtrs = (T **) (ptrs + 2 * batchCount);
+
+  long blocks = THCCeilDiv(batchCount, 256L);
+  hipLaunchKernelGGL(
+    (gemmBatchedPointers<T>),
+    dim3(blocks < 1024 ? blocks : 1024),
+    dim3(256),
+    0,
+    THCState_getCurrentStream(state),
+    aPtrs, bPtrs, cPtrs, a, strideA, b, strideB, c, strideC, batchCount);
+
+  gemmBatched(state, transa, transb, m, n, k, alpha, aPtrs, lda, bPtrs, ldb,
+              beta, cPtrs, ldc, batchCount);
+
+  THCudaCheck(THCudaFree(state, ptrs));
+}
+
+void THCudaBlas_SgemmStridedBatched(THCState *state, char transa, char transb, long m, long n, long k,
+                                    float alpha, const float *a, long lda, long strideA,
+                                    const float *b, long ldb, long strideB,
+                                    float beta, float *c, long ldc, long strideC, long batchCount)
+{
+  if( (m >= INT_MAX) || (n >= INT_MAX) || (k >= INT_MAX) || (lda >= INT_MAX)  || (ldb >= INT_MAX) || (ldc >= INT_MAX) || (batchCount >= INT_MAX) )
+  {
+    THError("Cublas_SgemmStridedBatched only supports m, n, k, lda, ldb, ldc, batchCount"
+            "with the bound [val] <= %d", INT_MAX);
+  }
+
+  adjustLd(transa, transb, m, n, k, &lda, &ldb, &ldc);
+
+#ifdef HIPBLAS_TODO
+  hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
+  hipblasSetStream(handle, THCState_getCurrentStream(state));
+  THCublasCheck(hipblasSgemmStridedBatched(handle,
+                                           convertTransToHipblasOperation(transa),
+                                           convertTransToHipblasOperation(transb),
+                                           (int)m, (int)n, (int)k,
+                                           &alpha, a, (int)lda, strideA, b, (int)ldb, strideB,
+                                           &beta, c, (int)ldc, strideC, (int)batchCount));
+#elif defined(__NVCC__) && CUDA_VERSION >= 8000
+  hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
+  cublasSetStream((cublasHandle_t)handle, THCState_getCurrentStream(state));
+  cublasSgemmStridedBatched((cublasHandle_t)handle,
+                            convertTransToCublasOperation(transa),
+                            convertTransToCublasOperation(transb),
+                            (int)m, (int)n, (int)k,
+                            &alpha, a, (int)lda, strideA, b, (int)ldb, strideB,
+                            &beta, c, (int)ldc, strideC, (int)batchCount);
+#else
+  THCudaBlas_gemmStridedBatchedFallback<float>(
+    state, transa, transb, m, n, k, alpha, a, lda, strideA, b, ldb, strideB,
+    beta, c, ldc, strideC, batchCount, THCudaBlas_SgemmBatched);
+#endif
+}
+
+void THCudaBlas_DgemmStridedBatched(THCState *state, char transa, char transb, long m, long n, long k,
+                                    double alpha, const double *a, long lda, long strideA,
+                                    const double *b, long ldb, long strideB,
+                                    double beta, double *c, long ldc, long strideC, long batchCount)
+{
+  if( (m >= INT_MAX) || (n >= INT_MAX) || (k >= INT_MAX) || (lda >= INT_MAX)  || (ldb >= INT_MAX) || (ldc >= INT_MAX) || (batchCount >= INT_MAX) )
+  {
+    THError("Cublas_DgemmStridedBatched only supports m, n, k, lda, ldb, ldc, batchCount"
+            "with the bound [val] <= %d", INT_MAX);
+  }
+
+  adjustLd(transa, transb, m, n, k, &lda, &ldb, &ldc);
+
+#ifdef HIPBLAS_TODO
+  hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
+  hipblasSetStream(handle, THCState_getCurrentStream(state));
+  THCublasCheck(hipblasDgemmStridedBatched(handle,
+                                           convertTransToHipblasOperation(transa),
+                                           convertTransToHipblasOperation(transb),
+                                           (int)m, (int)n, (int)k,
+                                           &alpha, a, (int)lda, strideA, b, (int)ldb, strideB,
+                                           &beta, c, (int)ldc, strideC, (int)batchCount));
+#elif defined(__NVCC__) && CUDA_VERSION >= 8000
+  hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
+  cublasSetStream((cublasHandle_t)handle, THCState_getCurrentStream(state));
+  cublasDgemmStridedBatched((cublasHandle_t)handle,
+                            convertTransToCublasOperation(transa),
+                            convertTransToCublasOperation(transb),
+                            (int)m, (int)n, (int)k,
+                            &alpha, a, (int)lda, strideA, b, (int)ldb, strideB,
+                            &beta, c, (int)ldc, strideC, (int)batchCount);
+#else
+  THCudaBlas_gemmStridedBatchedFallback<double>(
+    state, transa, transb, m, n, k, alpha, a, lda, strideA, b, ldb, strideB,
+    beta, c, ldc, strideC, batchCount, THCudaBlas_DgemmBatched);
+#endif
+}
+
+#ifdef CUDA_HALF_TENSOR
+void THCudaBlas_HgemmBatched(THCState *state, char transa, char transb, long m, long n, long k,
+                             half alpha, const half *a[], long lda, const half *b[], long ldb,
+                             half beta, half *c[], long ldc, long batchCount)
+{
+  if( (m >= INT_MAX) || (n >= INT_MAX) || (k >= INT_MAX) || (lda >= INT_MAX)  || (ldb >= INT_MAX) || (ldc >= INT_MAX) || (batchCount >= INT_MAX) )
+  {
+    THError("Cublas_HgemmBatched only supports m, n, k, lda, ldb, ldc, batchCount"
+            "with the bound [val] <= %d", INT_MAX);
+  }
+
+  adjustLd(transa, transb, m, n, k, &lda, &ldb, &ldc);
+
+  // The library's batched half GEMM accumulates in half, so it only serves
+  // the 'half' math mode; with float accumulation, the batches of pointers
+  // run on the tiled kernel whatever their shape
+  if (THCudaBlas_halfMathIsNative(state) && !THCudaBlas_halfGemmIsTiled(m, n, k)) {
+    hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
+    hipblasSetStream(handle, THCState_getCurrentStream(state));
+    THCublasCheck(hipblasHgemmBatched(handle,
+                                      convertTransToHipblasOperation(transa),
+                                      convertTransToHipblasOperation(transb),
+                                      (int)m, (int)n, (int)k,
+                                      &alpha, a, (int)lda, b, (int)ldb, &beta, c, (int)ldc,
+                                      (int)batchCount));
+    return;
+  }
+
+  THCGemmPointerBatch<half> batch = {a, b, c};
+  if (THCudaBlas_halfMathIsNative(state)) {
+    THCudaBlas_gemmTiled<half, half>(state, transa, transb, m, n, k,
+                                     alpha, lda, ldb, beta, ldc, batch, batchCount);
+  } else {
+    THCudaBlas_gemmTiled<half, float>(state, transa, transb, m, n, k,
+                                      THC_half2float(alpha), lda, ldb,
+                                      THC_half2float(beta), ldc, batch, batchCount);
+  }
+  THCudaCheck(hipGetLastError());
+}
+
+void THCudaBlas_HgemmStridedBatched(THCState *state, char transa, char transb, long m, long n, long k,
+                                    half alpha, const half *a, long lda, long strideA,
+                                    const half *b, long ldb, long strideB,
+                                    half beta, half *c, long ldc, long strideC, long batchCount)
+{
+  if( (m >= INT_MAX) || (n >= INT_MAX) || (k >= INT_MAX) || (lda >= INT_MAX)  || (ldb >= INT_MAX) || (ldc >= INT_MAX) || (batchCount >= INT_MAX) )
+  {
+    THError("Cublas_HgemmStridedBatched only supports m, n, k, lda, ldb, ldc, batchCount"
+            "with the bound [val] <= %d", INT_MAX);
+  }
+
+  adjustLd(transa, transb, m, n, k, &lda, &ldb, &ldc);
+
+  if (THCudaBlas_halfMathIsNative(state)) {
+#ifdef HIPBLAS_TODO
+    hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
+    hipblasSetStream(handle, THCState_getCurrentStream(state));
+    THCublasCheck(hipblasHgemmStridedBatched(handle,
+                                             convertTransToHipblasOperation(transa),
+                                             convertTransToHipblasOperation(transb),
+                                             (int)m, (int)n, (int)k,
+                                             &alpha, a, (int)lda, strideA, b, (int)ldb, strideB,
+                                             &beta, c, (int)ldc, strideC, (int)batchCount));
+    return;
+#elif defined(__NVCC__) && CUDA_VERSION >= 8000
+    hipblasHandle_t handle = THCState_getCurrentBlasHandle(state);
+    cublasSetStream((cublasHandle_t)handle, THCState_getCurrentStream(state));
+    cublasHgemmStridedBatched((cublasHandle_t)handle,
+                              convertTransToCublasOperation(transa),
+                              convertTransToCublasOperation(transb),
+                              (int)m, (int)n, (int)k,
+                              &alpha, a, (int)lda, strideA, b, (int)ldb, strideB,
+                              &beta, c, (int)ldc, strideC, (int)batchCount);
+    return;
+#endif
+  }
+
+  if (!THCudaBlas_halfGemmIsTiled(m, n, k)) {
+    if (THCudaBlas_halfMathIsNative(state)) {
+      // through device arrays of pointers to the library's batched GEMM
+      THCudaBlas_gemmStridedBatchedFallback<half>(
+        state, transa, transb, m, n, k, alpha, a, lda, strideA, b, ldb, strideB,
+        beta, c, ldc, strideC, batchCount, THCudaBlas_HgemmBatched);
+    } else {
+      THCudaBlas_halfGemmViaFloat(state, transa, transb, m, n, k,
+                                  THC_half2float(alpha), a, lda, strideA, b, ldb, strideB,
+                                  THC_half2float(beta), c, ldc, strideC, batchCount);
+    }
+    return;
+  }
+
+  THCGemmStridedBatch<half> batch = {a, strideA, b, strideB, c, strideC};
+  if (THCudaBlas_halfMathIsNative(state)) {
+    THCudaBlas_gemmTiled<half, half>(state, transa, transb, m, n, k,
+                                     alpha, lda, ldb, beta, ldc, batch, batchCount);
+  } else {
+    THCudaBlas_gemmTiled<half, float>(state, transa, transb, m, n, k,
+                                      THC_half2float(alpha), lda, ldb,
+                                      THC_half2float(beta), ldc, batch, batchCount);
+  }
+  THCudaCheck(hipGetLastError());
+}
+#endif
+
+/* Fused epilogue */
+
+static void THCudaBlas_checkEpilogue(const char *name, long m, long n, long k,
+                                     long lda, long ldb, long ldc, int biasDim, int activation)
+{
+  if( (m > INT_MAX) || (n > INT_MAX) || (k > INT_MAX) || (lda > INT_MAX)  || (ldb > INT_MAX) || (ldc > INT_MAX) )
+  {
+    THError("%s only supports m, n, k, lda, ldb, ldc"
+            "with the bound [val] <= %d", name, INT_MAX);
+  }
+  THArgCheck(biasDim == 0 || biasDim == 1, 16, "bias dimension must be 0 (rows) or 1 (columns)");
+  THArgCheck(activation >= THC_ACTIVATION_NONE && activation <= THC_ACTIVATION_RELU, 17,
+             "unknown activation %d", activation);
+}
+
+void THCudaBlas_SgemmEpilogue(THCState *state, char transa, char transb, long m, long n, long k,
+                              float alpha, float *a, long lda, float *b, long ldb,
+                              float *c, long ldc, float *bias, long biasStride, int biasDim, int activation)
+{
+  THCudaBlas_checkEpilogue("Cublas_SgemmEpilogue", m, n, k, lda, ldb, ldc, biasDim, activation);
+  adjustLd(transa, transb, m, n, k, &lda, &ldb, &ldc);
+
+  THCGemmEpilogue<float, float> epilogue = {bias, biasStride, biasDim, activation};
+  if (THCudaBlas_gemmBuiltin(state, transa, transb, m, n, k,
+                             alpha, a, lda, b, ldb, c, ldc, epilogue)) {
+    return;
+  }
+  THCudaBlas_Sgemm(state, transa, transb, m, n, k, alpha, a, lda, b, ldb, 0, c, ldc);
+  THCudaBlas_gemmEpiloguePass(state, m, n, c, ldc, epilogue);
+}
+
+void THCudaBlas_DgemmEpilogue(THCState *state, char transa, char transb, long m, long n, long k,
+                              double alpha, double *a, long lda, double *b, long ldb,
+                              double *c, long ldc, double *bias, long biasStride, int biasDim, int activation)
+{
+  THCudaBlas_checkEpilogue("Cublas_DgemmEpilogue", m, n, k, lda, ldb, ldc, biasDim, activation);
+  adjustLd(transa, transb, m, n, k, &lda, &ldb, &ldc);
+
+  THCGemmEpilogue<double, double> epilogue = {bias, biasStride, biasDim, activation};
+  if (THCudaBlas_gemmBuiltin(state, transa, transb, m, n, k,
+                             alpha, a, lda, b, ldb, c, ldc, epilogue)) {
+    return;
+  }
+  THCudaBlas_Dgemm(state, transa, transb, m, n, k, alpha, a, lda, b, ldb, 0, c, ldc);
+  THCudaBlas_gemmEpiloguePass(state, m, n, c, ldc, epilogue);
+}
+
+#ifdef CUDA_HALF_TENSOR
+void THCudaBlas_HgemmEpilogue(THCState *state, char transa, char transb, long m, long n, long k,
+                              half alpha, half *a, long lda, half *b, long ldb,
+                              half *c, long ldc, half *bias, long biasStride, int biasDim, int activation)
+{
+  THCudaBlas_checkEpilogue("Cublas_HgemmEpilogue", m, n, k, lda, ldb, ldc, biasDim, activation);
+
+  // The built-in register-blocked kernels are float/double only; the half
+  // epilogue always follows Hgemm, with bias and activation in float
+  THCudaBlas_Hgemm(state, transa, transb, m, n, k, alpha, a, lda, b, ldb,
+                   THC_float2half(0), c, ldc);
+  THCGemmEpilogue<half, float> epilogue = {bias, biasStride, biasDim, activation};
+  THCudaBlas_gemmEpiloguePass(state, m, n, c, ldc, epilogue);
+}
+#endif
+
 /* Inverse */
 void THCudaBlas_Sgetrf(THCState *state, int n, float **a, int lda, int *pivot, int *info, int batchSize) {
   if( (n >= INT_MAX) || (lda >= INT_MAX) || (batchSize >= INT_MAX) )
@@ -4,6 +4,9 @@
 #include "THCGeneral.h"
 #include "THCHalf.h"
 
+/* Half-precision routines follow the THCState BLAS math mode: with
+   THC_BLAS_MATH_FLOAT (the default) they accumulate in float. */
+
 /* Level 1 */
 THC_API float THCudaBlas_Sdot(THCState *state, long n, float *x, long incx, float *y, long incy);
 THC_API double THCudaBlas_Ddot(THCState *state, long n, double *x, long incx, double *y, long incy);
@@ -16,6 +19,10 @@ THC_API void THCudaBlas_Sgemv(THCState *state, char trans, long m, long n, float
 THC_API void THCudaBlas_Dgemv(THCState *state, char trans, long m, long n, double alpha, double *a, long lda, double *x, long incx, double beta, double *y, long incy);
 THC_API void THCudaBlas_Sger(THCState *state, long m, long n, float alpha, float *x, long incx, float *y, long incy, float *a, long lda);
 THC_API void THCudaBlas_Dger(THCState *state, long m, long n, double alpha, double *x, long incx, double *y, long incy, double *a, long lda);
+#ifdef CUDA_HALF_TENSOR
+THC_API void THCudaBlas_Hgemv(THCState *state, char trans, long m, long n, half alpha, half *a, long lda, half *x, long incx, half beta, half *y, long incy);
+THC_API void THCudaBlas_Hger(THCState *state, long m, long n, half alpha, half *x, long incx, half *y, long incy, half *a, long lda);
+#endif
 
 /* Level 3 */
 THC_API void THCudaBlas_Sgemm(THCState *state, char transa, char transb, long m, long n, long k, float alpha, float *a, long lda, float *b, long ldb, float beta, float *c, long ldc);
@@ -31,6 +38,45 @@ THC_API void THCudaBlas_SgemmBatched(THCState *state, char transa, char transb,
 THC_API void THCudaBlas_DgemmBatched(THCState *state, char transa, char transb, long m, long n, long k,
                                      double alpha, const double *a[], long lda, const double *b[], long ldb,
                                      double beta, double *c[], long ldc, long batchCount);
+/* Batch i uses a + i * strideA, b + i * strideB and c + i * strideC */
+THC_API void THCudaBlas_SgemmStridedBatched(THCState *state, char transa, char transb, long m, long n, long k,
+                                            float alpha, const float *a, long lda, long strideA,
+                                            const float *b, long ldb, long strideB,
+                                            float beta, float *c, long ldc, long strideC, long batchCount);
+THC_API void THCudaBlas_DgemmStridedBatched(THCState *state, char transa, char transb, long m, long n, long k,
+                                            double alpha, const double *a, long lda, long strideA,
+                                            const double *b, long ldb, long strideB,
+                                            double beta, double *c, long ldc, long strideC, long batchCount);
+#ifdef CUDA_HALF_TENSOR
+THC_API void THCudaBlas_HgemmBatched(THCState *state, char transa, char transb, long m, long n, long k,
+                                     half alpha, const half *a[], long lda, const half *b[], long ldb,
+                                     half beta, half *c[], long ldc, long batchCount);
+THC_API void THCudaBlas_HgemmStridedBatched(THCState *state, char transa, char transb, long m, long n, long k,
+                                            half alpha, const half *a, long lda, long strideA,
+                                            const half *b, long ldb, long strideB,
+                                            half beta, half *c, long ldc, long strideC, long batchCount);
+#endif
+
+/* Fused epilogue: C = act(alpha * op(A) * op(B) + bias), where bias is
+   indexed by the row (biasDim 0) or the column (biasDim 1) of C and may be
+   NULL. When THC's own kernels serve the shape, the epilogue is applied as C
+   is stored; otherwise it is one pass after the library GEMM. */
+#define THC_ACTIVATION_NONE 0
+#define THC_ACTIVATION_SIGMOID 1
+#define THC_ACTIVATION_TANH 2
+#define THC_ACTIVATION_RELU 3
+
+THC_API void THCudaBlas_SgemmEpilogue(THCState *state, char transa, char transb, long m, long n, long k,
+                                      float alpha, float *a, long lda, float *b, long ldb,
+                                      float *c, long ldc, float *bias, long biasStride, int biasDim, int activation);
+THC_API void THCudaBlas_DgemmEpilogue(THCState *state, char transa, char transb, long m, long n, long k,
+                                      double alpha, double *a, long lda, double *b, long ldb,
+                                      double *c, long ldc, double *bias, long biasStride, int biasDim, int activation);
+#ifdef CUDA_HALF_TENSOR
+THC_API void THCudaBlas_HgemmEpilogue(THCState *state, char transa, char transb, long m, long n, long k,
+                                      half alpha, half *a, long lda, half *b, long ldb,
+                                      half *c, long ldc, half *bias, long biasStride, int biasDim, int activation);
+#endif
 
 /* Inverse */
 THC_API void THCudaBlas_Sgetrf(THCState *state, int n, float **a, int lda, int *pivot, int *info, int batchSize);
@@ -1,6 +1,7 @@
 #include "THCCachingAllocator.h"
 
 #include <hip/hip_runtime_api.h>
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -21,6 +22,13 @@
 //   allocation requests can be filled by a hipMalloc call of the exact size.
 //   Small requests will allocate and split a 1MB buffer, if necessary.
 //
+// - A reallocation first tries to grow the block into the free block that
+//   follows it in the same hipMalloc segment, or to shrink it in place.
+//   Otherwise it allocates a new block and copies the contents on the stream.
+//   With a growth factor above 1, growing takes at least that multiple of the
+//   current block, so that a buffer grown step by step is copied
+//   O(log n) times.
+//
 // With this allocator, allocations and frees should logically be considered
 // "usages" of the memory segment associated with streams, just like kernel
 // launches. The programmer must insert the proper synchronization if memory
@@ -81,9 +89,13 @@ struct THCCachingAllocator
   // allocated blocks by device pointer
   std::unordered_map<void*, Block*> allocated_blocks;
 
+  // minimum growth of a reallocated block, as a multiple of its size
+  double growth_factor;
+
   THCCachingAllocator() :
       large_blocks(BlockComparator),
-      small_blocks(BlockComparator) {}
+      small_blocks(BlockComparator),
+      growth_factor(1.0) {}
 
   /** allocates a block which is safe to use from the provided stream */
   hipError_t malloc(void** devPtr, size_t size, hipStream_t stream)
@@ -168,6 +180,128 @@ struct THCCachingAllocator
     return hipSuccess;
   }
 
+  /** resizes the allocation at *devPtr to `size` bytes, keeping its first
+      `old_size` bytes */
+  hipError_t realloc(void** devPtr, size_t old_size, size_t size, hipStream_t stream)
+  {
+    if (!*devPtr) {
+      return malloc(devPtr, size, stream);
+    }
+    if (size == 0) {
+      hipError_t err = free(*devPtr);
+      if (err != hipSuccess) {
+        return err;
+      }
+      *devPtr = NULL;
+      return hipSuccess;
+    }
+
+    size_t new_size;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      int device;
+      hipError_t err = hipGetDevice(&device);
+      if (err != hipSuccess) {
+        return err;
+      }
+
+      auto it = allocated_blocks.find(*devPtr);
+      if (it == allocated_blocks.end()) {
+        return hipErrorInvalidDevicePointer;
+      }
+      Block* block = it->second;
+      if (block->device == device && resize_in_place(block, size, stream)) {
+        return hipSuccess;
+      }
+      // growth_factor is written under the mutex
+      new_size = grown_size(block->size, size);
+    }
+
+    void* ptr;
+    hipError_t err = malloc(&ptr, new_size, stream);
+    if (err != hipSuccess) {
+      return err;
+    }
+    size_t keep = std::min(old_size, size);
+    if (keep > 0) {
+      err = hipMemcpyAsync(ptr, *devPtr, keep, hipMemcpyDeviceToDevice, stream);
+      if (err != hipSuccess) {
+        free(ptr);
+        return err;
+      }
+    }
+    err = free(*devPtr);
+    if (err != hipSuccess) {
+      return err;
+    }
+    *devPtr = ptr;
+    return hipSuccess;
+  }
+
+  /** resizes an allocated block without moving it, if possible */
+  bool resize_in_place(Block* block, size_t size, hipStream_t stream)
+  {
+    bool small = block->size <= kSmallAlloc;
+    auto& free_blocks = small ? large_blocks : small_blocks;
+    size_t min_split = small ? kRoundSmall : kSmallAlloc + 1;
+    size_t needed = round_size(size);
+
+    if (needed <= block->size) {
+      // give the tail back once the block is less than half used, if both
+      // pieces stay in the block's pool
+      size_t tail = block->size - needed;
+      if (needed <= block->size / 2 && tail >= min_split && (small || needed > kSmallAlloc)) {
+        Block* remaining = new Block(block->device, block->stream, tail, block->ptr + needed);
+        remaining->prev = block;
+        remaining->next = block->next;
+        if (remaining->next) {
+          remaining->next->prev = remaining;
+        }
+        block->next = remaining;
+        block->size = needed;
+        try_merge_blocks(remaining, remaining->next, free_blocks);
+        free_blocks.insert(remaining);
+      }
+      return true;
+    }
+
+    // the free space after the block was last used on the block's stream
+    Block* next = block->next;
+    if ((needed <= kSmallAlloc) != small || stream != block->stream ||
+        !next || next->allocated || block->size + next->size < needed) {
+      return false;
+    }
+
+    size_t target = std::max(needed, round_size(grown_size(block->size, size)));
+    size_t extra = std::min(target, block->size + next->size) - block->size;
+    free_blocks.erase(next);
+    if (next->size - extra >= min_split) {
+      next->ptr += extra;
+      next->size -= extra;
+      block->size += extra;
+      free_blocks.insert(next);
+    } else {
+      block->size += next->size;
+      block->next = next->next;
+      if (block->next) {
+        block->next->prev = block;
+      }
+      delete next;
+    }
+    return true;
+  }
+
+  /** size to allocate when a block of `block_size` bytes must hold `size`;
+      reads growth_factor, so the mutex must be held */
+  size_t grown_size(size_t block_size, size_t size)
+  {
+    if (size <= block_size || growth_factor <= 1.0) {
+      return size;
+    }
+    return std::max(size, (size_t) (block_size * growth_factor));
+  }
+
   /** returns cached blocks to the system allocator */
   hipError_t emptyCache()
   {
@@ -285,6 +419,12 @@ static hipError_t THCCachingAllocator_malloc(void* ctx, void** ptr, size_t size,
   return a->malloc(ptr, size, stream);
 }
 
+static hipError_t THCCachingAllocator_realloc(void* ctx, void** ptr, size_t old_size, size_t size, hipStream_t stream)
+{
+  THCCachingAllocator* a = (THCCachingAllocator*) ctx;
+  return a->realloc(ptr, old_size, size, stream);
+}
+
 static hipError_t THCCachingAllocator_free(void* ctx, void* ptr)
 {
   THCCachingAllocator* a = (THCCachingAllocator*) ctx;
@@ -300,7 +440,7 @@ static hipError_t THCCachingAllocator_emptyCache(void* ctx)
 static THCCachingAllocator caching_allocator;
 static THCDeviceAllocator device_allocator = {
   &THCCachingAllocator_malloc,
-  NULL,
+  &THCCachingAllocator_realloc,
   &THCCachingAllocator_free,
   &THCCachingAllocator_emptyCache,
   &caching_allocator
@@ -310,3 +450,15 @@ THC_API THCDeviceAllocator* THCCachingAllocator_get(void)
 {
   return &device_allocator;
 }
+
+THC_API void THCCachingAllocator_setGrowthFactor(double factor)
+{
+  std::lock_guard<std::mutex> lock(caching_allocator.mutex);
+  caching_allocator.growth_factor = factor;
+}
+
+THC_API double THCCachingAllocator_getGrowthFactor(void)
+{
+  std::lock_guard<std::mutex> lock(caching_allocator.mutex);
+  return caching_allocator.growth_factor;
+}
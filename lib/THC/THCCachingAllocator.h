@@ -5,4 +5,10 @@
 
 THC_API THCDeviceAllocator* THCCachingAllocator_get(void);
 
+/* A storage growing by reallocation takes a block at least `factor` times
+   as large as its current one, when it moves and when the free space after
+   it allows; 1 (the default) takes just the requested size. */
+THC_API void THCCachingAllocator_setGrowthFactor(double factor);
+THC_API double THCCachingAllocator_getGrowthFactor(void);
+
 #endif
@@ -0,0 +1,338 @@
+#include "THCCheckpointWriter.h"
+
+#include <hip/hip_runtime_api.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+//
+// Background writer for checkpoints.
+//
+// - The thread that queues the pieces only copies host bytes and enqueues a
+//   device-to-device snapshot of device bytes on its current stream,
+//   followed by an event.
+// - The worker thread takes the pieces in order. A snapshot is copied to the
+//   host in chunks on a non-blocking stream of the worker, after waiting for
+//   its event; up to kRingSlots chunks are in flight while the oldest one is
+//   written to the file.
+// - Snapshots are released by the queueing thread (isDone, wait or free),
+//   so that the device allocator is only used from there. It waits for the
+//   worker to write some of them before taking more than
+//   THC_CHECKPOINT_MAX_SNAPSHOT_BYTES.
+//
+
+namespace {
+
+const size_t kChunkSize = 8 * 1024 * 1024;  // bytes per slot of the ring
+const int kRingSlots = 4;
+
+struct Piece {
+  std::vector<char> host;  // host bytes, when device is NULL
+  char*       device;      // snapshot of device bytes
+  size_t      size;
+  int         deviceId;
+  hipEvent_t  ready;       // the snapshot is complete
+
+  Piece() : device(NULL), size(0), deviceId(-1), ready(NULL) { }
+};
+
+struct WorkerStream {
+  hipStream_t stream;
+  hipEvent_t  copied[kRingSlots];
+};
+
+} // namespace
+
+struct THCCheckpointWriter
+{
+  FILE* file;
+  THCDeviceAllocator* allocator;
+
+  std::mutex mutex;
+  std::condition_variable queued;
+  std::condition_variable progressed;
+  std::deque<Piece*> pending;
+  std::vector<Piece*> written;
+  size_t snapshotBytes;  // held by snapshots; only used by the queueing thread
+  bool closed;
+  bool finished;
+  std::string error;
+
+  std::thread worker;
+
+  THCCheckpointWriter(FILE* file, THCDeviceAllocator* allocator) :
+      file(file), allocator(allocator), snapshotBytes(0), closed(false), finished(false) {}
+
+  void push(Piece* piece)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(piece);
+    queued.notify_one();
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    queued.notify_one();
+  }
+
+  void fail(const std::string& message)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error.empty()) {
+      error = message;
+    }
+  }
+
+  bool failed()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !error.empty();
+  }
+
+  void run()
+  {
+    char* ring = NULL;
+    std::map<int, WorkerStream> streams;
+
+    for (;;) {
+      Piece* piece;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        queued.wait(lock, [this] { return !pending.empty() || closed; });
+        if (pending.empty()) {
+          break;
+        }
+        piece = pending.front();
+        pending.pop_front();
+      }
+
+      if (!failed()) {
+        if (piece->device) {
+          write_snapshot(piece, ring, streams);
+        } else if (piece->size > 0 &&
+                   fwrite(piece->host.data(), 1, piece->size, file) != piece->size) {
+          fail("write error");
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      written.push_back(piece);
+      progressed.notify_one();
+    }
+
+    for (auto& it : streams) {
+      hipSetDevice(it.first);
+      for (int slot = 0; slot < kRingSlots; ++slot) {
+        hipEventDestroy(it.second.copied[slot]);
+      }
+      hipStreamDestroy(it.second.stream);
+    }
+    if (ring) {
+      hipHostFree(ring);
+    }
+    if (fclose(file) != 0) {
+      fail("write error when closing the file");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+  }
+
+  void write_snapshot(Piece* piece, char*& ring, std::map<int, WorkerStream>& streams)
+  {
+    hipError_t err = hipSetDevice(piece->deviceId);
+    if (err == hipSuccess && !ring) {
+      err = hipHostMalloc((void**) &ring, kRingSlots * kChunkSize);
+    }
+    if (err == hipSuccess && streams.find(piece->deviceId) == streams.end()) {
+      WorkerStream ws;
+      err = hipStreamCreateWithFlags(&ws.stream, hipStreamNonBlocking);
+      for (int slot = 0; err == hipSuccess && slot < kRingSlots; ++slot) {
+        err = hipEventCreateWithFlags(&ws.copied[slot], hipEventDisableTiming);
+      }
+      if (err == hipSuccess) {
+        streams[piece->deviceId] = ws;
+      }
+    }
+    if (err != hipSuccess) {
+      fail(hipGetErrorString(err));
+      return;
+    }
+
+    WorkerStream& ws = streams[piece->deviceId];
+    err = hipStreamWaitEvent(ws.stream, piece->ready, 0);
+
+    size_t chunks = (piece->size + kChunkSize - 1) / kChunkSize;
+    size_t issued = 0;
+    for (size_t done = 0; err == hipSuccess && done < chunks; ++done) {
+      while (err == hipSuccess && issued < chunks && issued - done < (size_t) kRingSlots) {
+        int slot = issued % kRingSlots;
+        size_t offset = issued * kChunkSize;
+        err = hipMemcpyAsync(ring + slot * kChunkSize, piece->device + offset,
+                             std::min(kChunkSize, piece->size - offset),
+                             hipMemcpyDeviceToHost, ws.stream);
+        if (err == hipSuccess) {
+          err = hipEventRecord(ws.copied[slot], ws.stream);
+        }
+        ++issued;
+      }
+      if (err != hipSuccess) {
+        break;
+      }
+
+      int slot = done % kRingSlots;
+      size_t offset = done * kChunkSize;
+      size_t n = std::min(kChunkSize, piece->size - offset);
+      err = hipEventSynchronize(ws.copied[slot]);
+      if (err == hipSuccess && fwrite(ring + slot * kChunkSize, 1, n, file) != n) {
+        fail("write error");
+        hipStreamSynchronize(ws.stream);
+        return;
+      }
+    }
+
+    if (err != hipSuccess) {
+      fail(hipGetErrorString(err));
+      hipStreamSynchronize(ws.stream);
+    }
+  }
+
+  /** frees the pieces the worker is done with; called by the queueing thread */
+  void release_written()
+  {
+    std::vector<Piece*> pieces;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pieces.swap(written);
+    }
+    for (Piece* piece : pieces) {
+      if (piece->device) {
+        snapshotBytes -= piece->size;
+        THCudaCheck(allocator->free(allocator->state, piece->device));
+        THCudaCheck(hipEventDestroy(piece->ready));
+      }
+      delete piece;
+    }
+  }
+
+  /** releases written snapshots until `size` more bytes fit in the bound,
+      or none are left */
+  void reserve(size_t size)
+  {
+    for (;;) {
+      release_written();
+      std::unique_lock<std::mutex> lock(mutex);
+      if (snapshotBytes == 0 || snapshotBytes + size <= THC_CHECKPOINT_MAX_SNAPSHOT_BYTES) {
+        return;
+      }
+      progressed.wait(lock, [this] { return !written.empty(); });
+    }
+  }
+
+  /** closes, waits for the worker and returns its error */
+  std::string finish()
+  {
+    close();
+    if (worker.joinable()) {
+      worker.join();
+    }
+    release_written();
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+  }
+};
+
+THCCheckpointWriter* THCCheckpointWriter_new(THCState *state, const char *filename)
+{
+  FILE* file = fopen(filename, "wb");
+  if (!file) {
+    THError("cannot open <%s> for writing", filename);
+  }
+  THCCheckpointWriter* writer = new THCCheckpointWriter(file, state->cudaDeviceAllocator);
+  writer->worker = std::thread(&THCCheckpointWriter::run, writer);
+  return writer;
+}
+
+void THCCheckpointWriter_writeHost(THCState *state, THCCheckpointWriter *writer,
+                                   const void *data, size_t size)
+{
+  THArgCheck(!writer->closed, 1, "checkpoint writer is closed");
+  Piece* piece = new Piece();
+  piece->host.assign((const char*) data, (const char*) data + size);
+  piece->size = size;
+  writer->push(piece);
+}
+
+void THCCheckpointWriter_writeDevice(THCState *state, THCCheckpointWriter *writer,
+                                     int device, const void *data, size_t size)
+{
+  THArgCheck(!writer->closed, 1, "checkpoint writer is closed");
+  if (size == 0) {
+    return;
+  }
+  writer->reserve(size);
+
+  int curDev;
+  THCudaCheck(hipGetDevice(&curDev));
+  if (curDev != device) {
+    THCudaCheck(hipSetDevice(device));
+  }
+  hipStream_t stream = THCState_getCurrentStream(state);
+
+  Piece* piece = new Piece();
+  piece->size = size;
+  piece->deviceId = device;
+  hipError_t err = writer->allocator->malloc(writer->allocator->state,
+                                             (void**) &piece->device, size, stream);
+  if (err != hipSuccess) {
+    delete piece;
+    if (curDev != device) {
+      THCudaCheck(hipSetDevice(curDev));
+    }
+    THCudaCheck(err);
+  }
+  writer->snapshotBytes += size;
+  THCudaCheck(hipMemcpyAsync(piece->device, data, size, hipMemcpyDeviceToDevice, stream));
+  THCudaCheck(hipEventCreateWithFlags(&piece->ready, hipEventDisableTiming));
+  THCudaCheck(hipEventRecord(piece->ready, stream));
+  writer->push(piece);
+  if (curDev != device) {
+    THCudaCheck(hipSetDevice(curDev));
+  }
+  writer->release_written();
+}
+
+void THCCheckpointWriter_close(THCState *state, THCCheckpointWriter *writer)
+{
+  writer->close();
+}
+
+int THCCheckpointWriter_isDone(THCState *state, THCCheckpointWriter *writer)
+{
+  writer->release_written();
+  std::lock_guard<std::mutex> lock(writer->mutex);
+  return writer->finished;
+}
+
+void THCCheckpointWriter_wait(THCState *state, THCCheckpointWriter *writer)
+{
+  std::string error = writer->finish();
+  if (!error.empty()) {
+    THError("checkpoint writer failed: %s", error.c_str());
+  }
+}
+
+void THCCheckpointWriter_free(THCState *state, THCCheckpointWriter *writer)
+{
+  writer->finish();
+  delete writer;
+}
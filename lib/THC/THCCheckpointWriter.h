@@ -0,0 +1,34 @@
+#ifndef THC_CHECKPOINT_WRITER_INC
+#define THC_CHECKPOINT_WRITER_INC
+
+#include "THCGeneral.h"
+
+/* Writes a file in the background, as a sequence of pieces appended in
+   order. Host bytes are copied when queued. Device bytes are snapshotted by
+   a copy on the current stream of their device, so the source may be
+   modified as soon as the call returns; a worker thread copies the
+   snapshots to the host through a pinned ring buffer, on a stream of its
+   own, and writes them to the file while the next chunks transfer.
+   Snapshots hold device memory until they are written: writeDevice blocks
+   while more than THC_CHECKPOINT_MAX_SNAPSHOT_BYTES of them are pending, so
+   a checkpoint costs at most that much (or one piece, if larger) on top of
+   the data it saves. */
+typedef struct THCCheckpointWriter THCCheckpointWriter;
+
+#define THC_CHECKPOINT_MAX_SNAPSHOT_BYTES (256L * 1024 * 1024)
+
+THC_API THCCheckpointWriter* THCCheckpointWriter_new(THCState *state, const char *filename);
+THC_API void THCCheckpointWriter_writeHost(THCState *state, THCCheckpointWriter *writer, const void *data, size_t size);
+/* `data` is device memory of `device` */
+THC_API void THCCheckpointWriter_writeDevice(THCState *state, THCCheckpointWriter *writer, int device, const void *data, size_t size);
+/* No more pieces: the file is closed once they are written */
+THC_API void THCCheckpointWriter_close(THCState *state, THCCheckpointWriter *writer);
+/* 1 once the writer is closed and every piece is on disk (or was skipped
+   after an error); releases the snapshots already written */
+THC_API int THCCheckpointWriter_isDone(THCState *state, THCCheckpointWriter *writer);
+/* Closes the writer, waits for the worker and raises the error it met, if any */
+THC_API void THCCheckpointWriter_wait(THCState *state, THCCheckpointWriter *writer);
+/* Closes the writer and waits for the worker, without raising, then frees it */
+THC_API void THCCheckpointWriter_free(THCState *state, THCCheckpointWriter *writer);
+
+#endif
@@ -0,0 +1,84 @@
+#include "hip/hip_runtime.h"
+#include "THCFFT.h"
+#include "THCGeneral.h"
+
+#include <math.h>
+#include <mutex>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* A cached twiddle table; plans of all devices share one list */
+struct THCFFTPlan {
+  int device;
+  long n;
+  int isDouble;
+  void *twiddles;
+  struct THCFFTPlan *next;
+};
+
+static std::mutex THCFFT_planMutex;
+
+static void *THCFFT_twiddles(THCState *state, long n, int isDouble)
+{
+  THArgCheck(n > 0 && (n & (n - 1)) == 0, 2, "FFT size must be a power of two, got %ld", n);
+
+  int device;
+  THCudaCheck(hipGetDevice(&device));
+
+  std::lock_guard<std::mutex> lock(THCFFT_planMutex);
+  for (THCFFTPlan *plan = state->fftPlans; plan != NULL; plan = plan->next) {
+    if (plan->device == device && plan->n == n && plan->isDouble == isDouble) {
+      return plan->twiddles;
+    }
+  }
+
+  size_t bytes = 2 * n * (isDouble ? sizeof(double) : sizeof(float));
+  void *host = THAlloc(bytes);
+  for (long k = 0; k < n; ++k) {
+    double angle = -2.0 * M_PI * (double) k / (double) n;
+    if (isDouble) {
+      ((double *) host)[2 * k] = cos(angle);
+      ((double *) host)[2 * k + 1] = sin(angle);
+    } else {
+      ((float *) host)[2 * k] = (float) cos(angle);
+      ((float *) host)[2 * k + 1] = (float) sin(angle);
+    }
+  }
+
+  THCFFTPlan *plan = (THCFFTPlan *) THAlloc(sizeof(THCFFTPlan));
+  plan->device = device;
+  plan->n = n;
+  plan->isDouble = isDouble;
+  THCudaCheck(THCudaMalloc(state, &plan->twiddles, bytes));
+  THCudaCheck(hipMemcpy(plan->twiddles, host, bytes, hipMemcpyHostToDevice));
+  THFree(host);
+
+  plan->next = state->fftPlans;
+  state->fftPlans = plan;
+  return plan->twiddles;
+}
+
+const float *THCFFT_twiddlesFloat(THCState *state, long n)
+{
+  return (const float *) THCFFT_twiddles(state, n, 0);
+}
+
+const double *THCFFT_twiddlesDouble(THCState *state, long n)
+{
+  return (const double *) THCFFT_twiddles(state, n, 1);
+}
+
+void THCFFT_freePlans(THCState *state)
+{
+  std::lock_guard<std::mutex> lock(THCFFT_planMutex);
+  THCFFTPlan *plan = state->fftPlans;
+  while (plan != NULL) {
+    THCFFTPlan *next = plan->next;
+    THCudaCheck(THCudaFree(state, plan->twiddles));
+    THFree(plan);
+    plan = next;
+  }
+  state->fftPlans = NULL;
+}
@@ -0,0 +1,216 @@
+#ifndef THC_FFT_CUH
+#define THC_FFT_CUH
+
+#include "THCFFT.h"
+#include "THCDeviceUtils.cuh"
+
+// Self-contained batched FFT for power-of-two sizes. A transform of size n
+// is a sequence of Stockham autosort passes (Govindaraju et al., "High
+// Performance Discrete Fourier Transforms on Graphics Processors"), radix 4
+// where possible and radix 2 for an odd power of two. Each pass reads one
+// buffer and writes the other, in natural order, so no bit reversal is
+// needed.
+//
+// A batch is addressed as: transform k starts at
+//   (k / innerCount) * outerStride + (k % innerCount) * innerStride
+// and its elements are `stride` apart, which covers both the rows
+// (stride 1) and the columns (stride = row length) of a batch of matrices.
+
+#define THC_FFT_THREADS 256
+
+template <typename T>
+struct THCComplex {
+  T re;
+  T im;
+};
+
+template <typename T>
+__device__ __forceinline__ THCComplex<T> THCComplex_add(THCComplex<T> a, THCComplex<T> b) {
+  THCComplex<T> r = {a.re + b.re, a.im + b.im};
+  return r;
+}
+
+template <typename T>
+__device__ __forceinline__ THCComplex<T> THCComplex_sub(THCComplex<T> a, THCComplex<T> b) {
+  THCComplex<T> r = {a.re - b.re, a.im - b.im};
+  return r;
+}
+
+template <typename T>
+__device__ __forceinline__ THCComplex<T> THCComplex_mul(THCComplex<T> a, THCComplex<T> b) {
+  THCComplex<T> r = {a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re};
+  return r;
+}
+
+// DFT of size R in registers; the inverse transform is unscaled
+template <typename T, int R>
+struct THCFFTButterfly;
+
+template <typename T>
+struct THCFFTButterfly<T, 2> {
+  static __device__ __forceinline__ void apply(THCComplex<T> (&v)[2], bool inverse) {
+    THCComplex<T> a = v[0];
+    v[0] = THCComplex_add(a, v[1]);
+    v[1] = THCComplex_sub(a, v[1]);
+  }
+};
+
+template <typename T>
+struct THCFFTButterfly<T, 4> {
+  static __device__ __forceinline__ void apply(THCComplex<T> (&v)[4], bool inverse) {
+    THCComplex<T> a0 = THCComplex_add(v[0], v[2]);
+    THCComplex<T> a1 = THCComplex_sub(v[0], v[2]);
+    THCComplex<T> a2 = THCComplex_add(v[1], v[3]);
+    THCComplex<T> d = THCComplex_sub(v[1], v[3]);
+    // (v1 - v3) times -i forward, +i inverse
+    THCComplex<T> a3;
+    if (inverse) {
+      a3.re = -d.im;
+      a3.im = d.re;
+    } else {
+      a3.re = d.im;
+      a3.im = -d.re;
+    }
+    v[0] = THCComplex_add(a0, a2);
+    v[1] = THCComplex_add(a1, a3);
+    v[2] = THCComplex_sub(a0, a2);
+    v[3] = THCComplex_sub(a1, a3);
+  }
+};
+
+// One radix-R pass over subsequences of length ns already transformed
+template <typename T, int R>
+__global__ void
+fftStockhamPass(const THCComplex<T> *in, THCComplex<T> *out, const THCComplex<T> *twiddles,
+                long n, long ns, long stride, long nbatch,
+                long innerCount, long innerStride, long outerStride, bool inverse)
+{
+  long butterflies = n / R;
+  long twiddleStep = n / (ns * R);
+  long total = butterflies * nbatch;
+
+  for (long linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < total;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    // neighbouring threads take neighbouring elements: along the transform
+    // for rows, across transforms for columns
+    long j, k;
+    if (stride == 1) {
+      j = linearIndex % butterflies;
+      k = linearIndex / butterflies;
+    } else {
+      k = linearIndex % nbatch;
+      j = linearIndex / nbatch;
+    }
+    long base = (k / innerCount) * outerStride + (k % innerCount) * innerStride;
+    long jm = j % ns;
+
+    THCComplex<T> v[R];
+    for (int r = 0; r < R; ++r) {
+      v[r] = in[base + (j + r * butterflies) * stride];
+      if (r > 0) {
+        THCComplex<T> w = twiddles[r * jm * twiddleStep];
+        if (inverse) {
+          w.im = -w.im;
+        }
+        v[r] = THCComplex_mul(v[r], w);
+      }
+    }
+
+    THCFFTButterfly<T, R>::apply(v, inverse);
+
+    long idxD = (j / ns) * ns * R + jm;
+    for (int r = 0; r < R; ++r) {
+      out[base + (idxD + r * ns) * stride] = v[r];
+    }
+  }
+}
+
+template <typename T>
+const THCComplex<T> *THCFFT_twiddles(THCState *state, long n);
+
+template <>
+inline const THCComplex<float> *THCFFT_twiddles<float>(THCState *state, long n) {
+  return (const THCComplex<float> *) THCFFT_twiddlesFloat(state, n);
+}
+
+template <>
+inline const THCComplex<double> *THCFFT_twiddles<double>(THCState *state, long n) {
+  return (const THCComplex<double> *) THCFFT_twiddlesDouble(state, n);
+}
+
+// Transforms `nbatch` sequences of length n in place; `scratch` must span
+// the same elements as `data`, `total` of them
+template <typename T>
+void THCFFT_transform(THCState *state, THCComplex<T> *data, THCComplex<T> *scratch, long total,
+                      long n, long stride, long nbatch,
+                      long innerCount, long innerStride, long outerStride, bool inverse)
+{
+  THArgCheck(n > 0 && (n & (n - 1)) == 0, 5, "FFT size must be a power of two, got %ld", n);
+  if (n == 1) {
+    return;
+  }
+
+  int log2n = 0;
+  while ((1L << log2n) < n) {
+    ++log2n;
+  }
+  // radix 4 passes, one radix 2 pass for odd powers; when that makes an odd
+  // number of passes, one radix 4 pass becomes two radix 2 passes so that the
+  // result ends in `data` without a copy
+  int radix4 = log2n / 2;
+  int radix2 = log2n % 2;
+  if ((radix4 + radix2) % 2 == 1 && radix4 > 0) {
+    --radix4;
+    radix2 += 2;
+  }
+
+  const THCComplex<T> *twiddles = THCFFT_twiddles<T>(state, n);
+  hipStream_t stream = THCState_getCurrentStream(state);
+  THCComplex<T> *in = data;
+  THCComplex<T> *out = scratch;
+
+  long ns = 1;
+  for (int pass = 0; pass < radix4 + radix2; ++pass) {
+    int radix = pass < radix4 ? 4 : 2;
+    long threads = n / radix * nbatch;
+    long blocks = THCCeilDiv(threads, (long) THC_FFT_THREADS);
+    dim3 grid(blocks < 65535 ? blocks : 65535);
+    if (radix == 4) {
+      hipLaunchKernelGGL(
+        (fftStockhamPass<T, 4>), grid, dim3(THC_FFT_THREADS), 0, stream,
+        in, out, twiddles, n, ns, stride, nbatch, innerCount, innerStride, outerStride, inverse);
+    } else {
+      hipLaunchKernelGGL(
+        (fftStockhamPass<T, 2>), grid, dim3(THC_FFT_THREADS), 0, stream,
+        in, out, twiddles, n, ns, stride, nbatch, innerCount, innerStride, outerStride, inverse);
+    }
+    THCudaCheck(hipGetLastError());
+    ns *= radix;
+    THCComplex<T> *tmp = in;
+    in = out;
+    out = tmp;
+  }
+
+  // only a single radix 2 pass is left odd
+  if (in != data) {
+    THCudaCheck(hipMemcpyAsync(data, in, total * sizeof(THCComplex<T>),
+                               hipMemcpyDeviceToDevice, stream));
+  }
+}
+
+// 2D transform of `nbatch` contiguous rows x cols matrices, in place
+template <typename T>
+void THCFFT_transform2d(THCState *state, THCComplex<T> *data, THCComplex<T> *scratch,
+                        long nbatch, long rows, long cols, bool inverse)
+{
+  long total = nbatch * rows * cols;
+  // rows
+  THCFFT_transform<T>(state, data, scratch, total, cols, 1, nbatch * rows,
+                      1, 0, cols, inverse);
+  // columns
+  THCFFT_transform<T>(state, data, scratch, total, rows, cols, nbatch * cols,
+                      cols, 1, rows * cols, inverse);
+}
+
+#endif // THC_FFT_CUH
@@ -0,0 +1,15 @@
+#ifndef THC_FFT_INC
+#define THC_FFT_INC
+
+#include "THCGeneral.h"
+
+/* Batched complex FFTs of power-of-two sizes, built from radix-4 and radix-2
+   Stockham passes (see THCFFT.cuh). The twiddle factors exp(-2 pi i k / n),
+   k < n, of each size are computed in double on the host the first time the
+   size is used on a device, and cached in the THCState until THCudaShutdown.
+   They are stored as interleaved (re, im) pairs. */
+THC_API const float *THCFFT_twiddlesFloat(THCState *state, long n);
+THC_API const double *THCFFT_twiddlesDouble(THCState *state, long n);
+THC_API void THCFFT_freePlans(THCState *state);
+
+#endif
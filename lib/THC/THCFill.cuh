@@ -0,0 +1,75 @@
+#ifndef THC_FILL_CUH
+#define THC_FILL_CUH
+
+#include "THCGeneral.h"
+#include "THCDeviceUtils.cuh"
+#include <algorithm>
+#include <cstring>
+
+// Fills of contiguous memory on the current stream. A value whose bytes are
+// all equal (zero for every type, -1 for the integer types, any byte) is a
+// hipMemsetAsync; any other value is written 16 bytes per store, with the
+// unaligned head and the tail written element by element.
+
+#define THC_FILL_THREADS 256
+
+template <typename T>
+__global__ void
+fillContiguousKernel(T *data, ptrdiff_t n, T value, uint4 pattern,
+                     ptrdiff_t head, ptrdiff_t vectors)
+{
+  const ptrdiff_t perVector = sizeof(uint4) / sizeof(T);
+  ptrdiff_t stride = (ptrdiff_t) hipGridDim_x * hipBlockDim_x;
+  ptrdiff_t tid = (ptrdiff_t) hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+
+  uint4 *body = (uint4*) (data + head);
+  for (ptrdiff_t i = tid; i < vectors; i += stride) {
+    body[i] = pattern;
+  }
+  for (ptrdiff_t i = tid; i < head; i += stride) {
+    data[i] = value;
+  }
+  for (ptrdiff_t i = head + vectors * perVector + tid; i < n; i += stride) {
+    data[i] = value;
+  }
+}
+
+template <typename T>
+void THC_fillContiguous(THCState *state, T *data, ptrdiff_t n, T value)
+{
+  if (n == 0) {
+    return;
+  }
+  hipStream_t stream = THCState_getCurrentStream(state);
+
+  unsigned char bytes[sizeof(T)];
+  memcpy(bytes, &value, sizeof(T));
+  bool uniformBytes = true;
+  for (size_t i = 1; i < sizeof(T); ++i) {
+    uniformBytes = uniformBytes && bytes[i] == bytes[0];
+  }
+  if (uniformBytes) {
+    THCudaCheck(hipMemsetAsync(data, bytes[0], n * sizeof(T), stream));
+    return;
+  }
+
+  const ptrdiff_t perVector = sizeof(uint4) / sizeof(T);
+  uint4 pattern;
+  for (ptrdiff_t i = 0; i < perVector; ++i) {
+    memcpy((unsigned char*) &pattern + i * sizeof(T), &value, sizeof(T));
+  }
+  ptrdiff_t misalignment = (ptrdiff_t) ((uintptr_t) data % sizeof(uint4));
+  ptrdiff_t head = std::min(n, (ptrdiff_t) ((sizeof(uint4) - misalignment) % sizeof(uint4)) /
+                                (ptrdiff_t) sizeof(T));
+  ptrdiff_t vectors = (n - head) / perVector;
+
+  int mpc = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
+  ptrdiff_t work = std::max(vectors, std::min(n, perVector));
+  dim3 grid(std::min(THCCeilDiv(work, (ptrdiff_t) THC_FILL_THREADS), (ptrdiff_t) (mpc * 8)));
+  hipLaunchKernelGGL(
+    (fillContiguousKernel<T>), grid, dim3(THC_FILL_THREADS), 0, stream,
+    data, n, value, pattern, head, vectors);
+  THCudaCheck(hipGetLastError());
+}
+
+#endif // THC_FILL_CUH
@@ -2,6 +2,7 @@
 #include "TH.h"
 #include "THCTensorRandom.h"
 #include "THCBlas.h"
+#include "THCFFT.h"
 #include "THCAllocator.h"
 #include "THCThreadLocal.h"
 #include "THCStream.h"
@@ -10,6 +11,20 @@
 
 /* Size of scratch space available in global memory per each SM + stream */
 #define GLOBAL_SCRATCH_SPACE_PER_SM_STREAM 4 * sizeof(float)
+/* Smallest pinned host scratch buffer allocated for a thread */
+#define HOST_SCRATCH_SPACE_MIN_SIZE 4096
+/* Size of each of the two chunks of THCudaCopyFromHostStaged */
+#define STAGED_COPY_CHUNK_SIZE (4 * 1024 * 1024)
+
+/* Pinned host buffer of a thread, with the event marking its last use on
+   each device */
+typedef struct THCHostScratch {
+  void *data;
+  size_t size;
+  /* Device whose event was recorded last, or -1 when the buffer is idle */
+  int lastDevice;
+  hipEvent_t *lastUse;
+} THCHostScratch;
 
 
 THCCudaResourcesPerDevice* THCState_getDeviceResourcePtr(
@@ -64,6 +79,7 @@ void THCudaInit(THCState* state)
     state->currentStreams[i] = THCThreadLocal_alloc();
   }
   state->currentPerDeviceBlasHandle = THCThreadLocal_alloc();
+  state->hostScratch = THCThreadLocal_alloc();
 
   state->resourcesPerDevice = (THCCudaResourcesPerDevice*)
     malloc(numDevices * sizeof(THCCudaResourcesPerDevice));
@@ -119,6 +135,7 @@ void THCudaInit(THCState* state)
 void THCudaShutdown(THCState* state)
 {
   THCRandom_shutdown(state);
+  THCFFT_freePlans(state);
 
   free(state->rngState);
   free(state->cudaHostAllocator);
@@ -129,6 +146,23 @@ void THCudaShutdown(THCState* state)
   THCudaCheck(hipGetDevice(&prevDev));
   THCudaCheck(hipGetDeviceCount(&deviceCount));
 
+  /* Only the buffer of the calling thread can be reached here */
+  THCHostScratch* scratch = (THCHostScratch*) THCThreadLocal_get(state->hostScratch);
+  if (scratch) {
+    for (int dev = 0; dev < deviceCount; ++dev) {
+      if (scratch->lastUse[dev]) {
+        THCudaCheck(hipEventSynchronize(scratch->lastUse[dev]));
+        THCudaCheck(hipEventDestroy(scratch->lastUse[dev]));
+      }
+    }
+    if (scratch->data) {
+      THCudaCheck(hipHostFree(scratch->data));
+    }
+    free(scratch->lastUse);
+    free(scratch);
+  }
+  THCThreadLocal_free(state->hostScratch);
+
   /* cleanup p2p access state */
   for (int dev = 0; dev < deviceCount; ++dev) {
     free(state->p2pAccessEnabled[dev]);
@@ -290,6 +324,42 @@ void THCState_setKernelPeerToPeerAccessEnabled(THCState* state, int val) {
   state->p2pKernelAccessEnabled = val;
 }
 
+int THCState_getBlasMathMode(THCState* state) {
+  return state->blasMathMode;
+}
+
+void THCState_setBlasMathMode(THCState* state, int mode) {
+  THArgCheck(mode == THC_BLAS_MATH_FLOAT || mode == THC_BLAS_MATH_HALF, 2,
+             "unknown BLAS math mode %d", mode);
+  state->blasMathMode = mode;
+}
+
+int THCState_getBlasForceLibrary(THCState* state) {
+  return state->blasForceLibrary;
+}
+
+void THCState_setBlasForceLibrary(THCState* state, int val) {
+  state->blasForceLibrary = val;
+}
+
+int THCState_getConvAlgorithm(THCState* state) {
+  return state->convAlgorithm;
+}
+
+void THCState_setConvAlgorithm(THCState* state, int algorithm) {
+  THArgCheck(algorithm >= THC_CONV_ALGO_AUTO && algorithm <= THC_CONV_ALGO_FFT, 2,
+             "unknown convolution algorithm %d", algorithm);
+  state->convAlgorithm = algorithm;
+}
+
+int THCState_getDeterministic(THCState* state) {
+  return state->deterministic;
+}
+
+void THCState_setDeterministic(THCState* state, int val) {
+  state->deterministic = val;
+}
+
 struct hipDeviceProp_t* THCState_getCurrentDeviceProperties(THCState* state)
 {
   int curDev = -1;
@@ -616,6 +686,47 @@ size_t THCState_getDeviceScratchSpaceSize(THCState* state, int device)
   return res->scratchSpacePerStream;
 }
 
+void* THCState_getHostScratchSpace(THCState* state, size_t size)
+{
+  THCHostScratch* scratch = (THCHostScratch*) THCThreadLocal_get(state->hostScratch);
+  if (!scratch) {
+    scratch = (THCHostScratch*) calloc(1, sizeof(THCHostScratch));
+    scratch->lastDevice = -1;
+    scratch->lastUse = (hipEvent_t*) calloc(state->numDevices, sizeof(hipEvent_t));
+    THCThreadLocal_set(state->hostScratch, scratch);
+  }
+
+  if (scratch->lastDevice >= 0) {
+    THCudaCheck(hipEventSynchronize(scratch->lastUse[scratch->lastDevice]));
+    scratch->lastDevice = -1;
+  }
+
+  if (scratch->size < size) {
+    if (scratch->data) {
+      THCudaCheck(hipHostFree(scratch->data));
+    }
+    size_t newSize = THMax(THMax(size, 2 * scratch->size),
+                           (size_t) HOST_SCRATCH_SPACE_MIN_SIZE);
+    THCudaCheck(hipHostMalloc(&scratch->data, newSize));
+    scratch->size = newSize;
+  }
+  return scratch->data;
+}
+
+void THCState_releaseHostScratchSpace(THCState* state, hipStream_t stream)
+{
+  THCHostScratch* scratch = (THCHostScratch*) THCThreadLocal_get(state->hostScratch);
+  THAssert(scratch != NULL);
+
+  int device = -1;
+  THCudaCheck(hipGetDevice(&device));
+  if (!scratch->lastUse[device]) {
+    THCudaCheck(hipEventCreateWithFlags(&scratch->lastUse[device], hipEventDisableTiming));
+  }
+  THCudaCheck(hipEventRecord(scratch->lastUse[device], stream));
+  scratch->lastDevice = device;
+}
+
 void __THCudaCheck(hipError_t err, const char *file, const int line)
 {
   if(err != hipSuccess)
@@ -706,6 +817,37 @@ hipError_t THCudaFree(THCState *state, void *ptr)
   return hipFree(ptr); 
 }
 
+void THCudaCopyFromHostStaged(THCState *state, void *dst, const void *src, size_t size)
+{
+  if (size == 0) {
+    return;
+  }
+  hipStream_t stream = THCState_getCurrentStream(state);
+  size_t chunk = THMin(size, (size_t) STAGED_COPY_CHUNK_SIZE);
+  char *staging = (char*) THCState_getHostScratchSpace(state, 2 * chunk);
+
+  hipEvent_t copied[2];
+  THCudaCheck(hipEventCreateWithFlags(&copied[0], hipEventDisableTiming));
+  THCudaCheck(hipEventCreateWithFlags(&copied[1], hipEventDisableTiming));
+
+  size_t step = 0;
+  for (size_t offset = 0; offset < size; offset += chunk, ++step) {
+    size_t n = THMin(chunk, size - offset);
+    char *buffer = staging + (step % 2) * chunk;
+    if (step >= 2) {
+      THCudaCheck(hipEventSynchronize(copied[step % 2]));
+    }
+    memcpy(buffer, (const char*) src + offset, n);
+    THCudaCheck(hipMemcpyAsync((char*) dst + offset, buffer, n,
+                               hipMemcpyHostToDevice, stream));
+    THCudaCheck(hipEventRecord(copied[step % 2], stream));
+  }
+
+  THCState_releaseHostScratchSpace(state, stream);
+  THCudaCheck(hipEventDestroy(copied[0]));
+  THCudaCheck(hipEventDestroy(copied[1]));
+}
+
 static ptrdiff_t applyHeapDelta(THCState *state) {
   ptrdiff_t newHeapSize = THAtomicAddPtrdiff(&heapSize, state->heapDelta) + state->heapDelta;
   state->heapDelta = 0;
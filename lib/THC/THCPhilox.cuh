@@ -0,0 +1,95 @@
+#ifndef THC_PHILOX_INC
+#define THC_PHILOX_INC
+
+#include "hip/hip_runtime.h"
+#include <math.h>
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random
+// Numbers: As Easy as 1, 2, 3"). A draw is a pure function of a 64-bit key
+// (the seed) and a 128-bit counter, so any element can be generated
+// independently of how the work is split across threads. Every function
+// here is callable from both host and device; the host versions act as the
+// reference implementation for the device kernels.
+//
+// Element `i` of a generation call at `offset` is word `i % 4` of the block
+// produced for counter `offset + i / 4`.
+
+#define THC_PHILOX_M0 0xD2511F53U
+#define THC_PHILOX_M1 0xCD9E8D57U
+#define THC_PHILOX_W0 0x9E3779B9U
+#define THC_PHILOX_W1 0xBB67AE85U
+#define THC_PHILOX_ROUNDS 10
+
+struct THCPhiloxBlock {
+  unsigned int x[4];
+};
+
+__host__ __device__ __forceinline__ void
+philoxMulHiLo(unsigned int a, unsigned int b,
+              unsigned int* hi, unsigned int* lo) {
+  unsigned long long p = (unsigned long long) a * b;
+  *hi = (unsigned int) (p >> 32);
+  *lo = (unsigned int) p;
+}
+
+__host__ __device__ __forceinline__ THCPhiloxBlock
+philox4x32(unsigned long long seed, unsigned long long counter) {
+  THCPhiloxBlock c;
+  c.x[0] = (unsigned int) counter;
+  c.x[1] = (unsigned int) (counter >> 32);
+  c.x[2] = 0;
+  c.x[3] = 0;
+  unsigned int k0 = (unsigned int) seed;
+  unsigned int k1 = (unsigned int) (seed >> 32);
+
+  for (int round = 0; round < THC_PHILOX_ROUNDS; ++round) {
+    unsigned int hi0, lo0, hi1, lo1;
+    philoxMulHiLo(THC_PHILOX_M0, c.x[0], &hi0, &lo0);
+    philoxMulHiLo(THC_PHILOX_M1, c.x[2], &hi1, &lo1);
+
+    THCPhiloxBlock next;
+    next.x[0] = hi1 ^ c.x[1] ^ k0;
+    next.x[1] = lo1;
+    next.x[2] = hi0 ^ c.x[3] ^ k1;
+    next.x[3] = lo0;
+    c = next;
+
+    k0 += THC_PHILOX_W0;
+    k1 += THC_PHILOX_W1;
+  }
+
+  return c;
+}
+
+// Maps a 32-bit word to a float in (0, 1], matching curand_uniform's range.
+// Only the top 24 bits are used so the result is exact in single precision.
+__host__ __device__ __forceinline__ float
+philoxToUniform(unsigned int x) {
+  return (float) (x >> 8) * (1.0f / 16777216.0f) + (1.0f / 16777216.0f);
+}
+
+__host__ __device__ __forceinline__ void
+philoxUniform4(unsigned long long seed, unsigned long long counter,
+               float (&out)[4]) {
+  THCPhiloxBlock b = philox4x32(seed, counter);
+  for (int i = 0; i < 4; ++i) {
+    out[i] = philoxToUniform(b.x[i]);
+  }
+}
+
+// Standard normals via Box-Muller; words (0, 1) and (2, 3) of the same
+// block form the two pairs, so a block still yields four values.
+__host__ __device__ __forceinline__ void
+philoxNormal4(unsigned long long seed, unsigned long long counter,
+              float (&out)[4]) {
+  float u[4];
+  philoxUniform4(seed, counter, u);
+  for (int i = 0; i < 4; i += 2) {
+    float r = sqrtf(-2.0f * logf(u[i]));
+    float theta = 6.2831853071795864f * u[i + 1];
+    out[i] = r * cosf(theta);
+    out[i + 1] = r * sinf(theta);
+  }
+}
+
+#endif // THC_PHILOX_INC
@@ -61,16 +61,18 @@ void exclusivePrefixSum(T* smem, T in, T* out, T* carry)
 template <typename T, bool KillWARDependency>
 __device__ void inclusiveBinaryPrefixSum(T* smem, bool in, T* out) {
   // Within-warp, we use warp voting.
-  T vote = __ballot(in);
   #if defined(__HIP_PLATFORM_HCC__)
+    // Wavefronts are 64 wide; keep the whole ballot
+    std::uint64_t vote = __ballot(in);
     T index = __popcll(getLaneMaskLe() & vote);
     T carry = __popcll(vote);
   #else
+    T vote = __ballot(in);
     T index = __popc(getLaneMaskLe() & vote);
     T carry = __popc(vote);
   #endif
 
-  int warp = hipThreadIdx_x / 32;
+  int warp = hipThreadIdx_x / warpSize;
 
   // Per each warp, write out a value
   if (getLaneId() == 0) {
@@ -83,7 +85,7 @@ __device__ void inclusiveBinaryPrefixSum(T* smem, bool in, T* out) {
   // warp shuffle scan for CC 3.0+
   if (hipThreadIdx_x == 0) {
     int current = 0;
-    for (int i = 0; i < hipBlockDim_x / 32; ++i) {
+    for (int i = 0; i < hipBlockDim_x / warpSize; ++i) {
       T v = smem[i];
       smem[i] += current;
       current += v;
@@ -116,11 +118,96 @@ void exclusiveBinaryPrefixSum(T* smem, bool in, T* out, T* carry)
   *out -= (T) in;
 
   // The outgoing carry for all threads is the last warp's sum
-  *carry = smem[(hipBlockDim_x / 32) - 1];
+  *carry = smem[(hipBlockDim_x / warpSize) - 1];
 
   if (KillWARDependency) {
     __syncthreads();
   }
 }
 
+// Single-pass scan across blocks ("decoupled look-back"). Each tile
+// of work publishes a 64-bit status word: the top two bits hold the
+// status, the rest hold either the tile's own aggregate or its
+// inclusive prefix. Successors walk backwards over their predecessors'
+// words until they meet an inclusive prefix, so the whole scan needs
+// only one pass over the input and no host synchronization.
+// The status array must be zeroed before launch, and tiles must be
+// assigned in launch order (see getDynamicTileId) so that a tile never
+// waits on a predecessor that has not been scheduled yet.
+#define THC_TILE_STATUS_INVALID   0ULL
+#define THC_TILE_STATUS_AGGREGATE 1ULL
+#define THC_TILE_STATUS_PREFIX    2ULL
+#define THC_TILE_STATUS_SHIFT     62
+#define THC_TILE_VALUE_MASK       ((1ULL << THC_TILE_STATUS_SHIFT) - 1ULL)
+
+// Returns a tile index in the order in which blocks actually start
+// running; `counter` must be zeroed before launch. All threads in the
+// block receive the same value.
+__device__
+inline
+unsigned int getDynamicTileId(unsigned int* counter, unsigned int* smem)
+{
+  if (hipThreadIdx_x == 0) {
+    *smem = atomicAdd(counter, 1u);
+  }
+  __syncthreads();
+
+  unsigned int tile = *smem;
+  __syncthreads();
+
+  return tile;
+}
+
+__device__
+inline
+void publishTileStatus(
+    unsigned long long* tileStatus,
+    unsigned int tile,
+    unsigned long long status,
+    unsigned long long value)
+{
+  // Make the tile's output visible before its successors can use it
+  __threadfence();
+  atomicExch(&tileStatus[tile], (status << THC_TILE_STATUS_SHIFT) | value);
+}
+
+// Given this tile's `aggregate`, returns the exclusive prefix of all
+// tiles preceding `tile` and publishes the inclusive prefix for the
+// tiles that follow. Only one thread per tile may call this.
+__device__
+inline
+unsigned long long tileExclusivePrefix(
+    unsigned long long* tileStatus,
+    unsigned int tile,
+    unsigned long long aggregate)
+{
+  if (tile == 0) {
+    publishTileStatus(tileStatus, tile, THC_TILE_STATUS_PREFIX, aggregate);
+    return 0;
+  }
+
+  // Let successors make progress while we look back
+  publishTileStatus(tileStatus, tile, THC_TILE_STATUS_AGGREGATE, aggregate);
+
+  volatile unsigned long long* status = tileStatus;
+  unsigned long long exclusive = 0;
+
+  for (long pred = (long) tile - 1; pred >= 0; --pred) {
+    unsigned long long word;
+    do {
+      word = status[pred];
+    } while ((word >> THC_TILE_STATUS_SHIFT) == THC_TILE_STATUS_INVALID);
+
+    exclusive += word & THC_TILE_VALUE_MASK;
+
+    if ((word >> THC_TILE_STATUS_SHIFT) == THC_TILE_STATUS_PREFIX) {
+      break;
+    }
+  }
+
+  publishTileStatus(
+    tileStatus, tile, THC_TILE_STATUS_PREFIX, exclusive + aggregate);
+  return exclusive;
+}
+
 #endif // THC_SCAN_UTILS_INC
@@ -1,17 +1,38 @@
 #include "THCStorage.h"
 
-#ifdef THRUST_PATH
-    #include <thrust/device_ptr.h>
-    #include <thrust/fill.h>
-    #if CUDA_VERSION >= 7000
-        #include <thrust/system/cuda/execution_policy.h>
-    #endif
-#else
-    #include <bolt/amp/fill.h>
-    #include <bolt/amp/iterator/ubiquitous_iterator.h>
-#endif
-
+#include "THCFill.cuh"
 #include "THCHalf.h"
+#include "THCDeviceUtils.cuh"
+#include <algorithm>
+#include <cstring>
+
+#define THC_STORAGE_ELEMENTS_THREADS 256
+
+template <typename T>
+__global__ void
+storageGatherKernel(const T *data, const ptrdiff_t *offsets, T *values, ptrdiff_t n)
+{
+  for (ptrdiff_t i = (ptrdiff_t) hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x; i < n;
+       i += (ptrdiff_t) hipGridDim_x * hipBlockDim_x) {
+    values[i] = data[offsets[i]];
+  }
+}
+
+template <typename T>
+__global__ void
+storageScatterKernel(T *data, const ptrdiff_t *offsets, const T *values, ptrdiff_t n)
+{
+  for (ptrdiff_t i = (ptrdiff_t) hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x; i < n;
+       i += (ptrdiff_t) hipGridDim_x * hipBlockDim_x) {
+    data[offsets[i]] = values[i];
+  }
+}
+
+static dim3 THCStorage_elementsGrid(ptrdiff_t n)
+{
+  return dim3(std::min(THCCeilDiv(n, (ptrdiff_t) THC_STORAGE_ELEMENTS_THREADS),
+                       (ptrdiff_t) 65535));
+}
 
 #include "generic/THCStorage.cu"
 #include "THCGenerateAllTypes.h"
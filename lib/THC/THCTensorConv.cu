@@ -3,6 +3,10 @@
 #include "THCTensorMath.h"
 #include "THCTensorCopy.h"
 #include "THCGeneral.h"
+#include "THCBlas.h"
+#include "THCDeviceUtils.cuh"
+#include "THCNumerics.cuh"
+#include "THCFFT.cuh"
 #include <stdio.h>
 
 /*
@@ -19,6 +23,43 @@
 
 #define CUDA_SHARED_MEM_SIZE (12*1024-32) // this is given by nVidia: max shared mem per block
 
+// Threads per block of the im2col and Winograd transform kernels
+#define THC_CONV_THREADS 256
+// Largest im2col / Winograd / FFT buffer, in elements; larger batches are split
+#define THC_CONV_MAX_BUFFER_ELEMENTS (1L << 25)
+// Outputs up to which the single-launch direct kernel is preferred
+#define THC_CONV_DIRECT_MAX_OUTPUTS 4096
+// Input and output planes from which Winograd is preferred for 3x3 kernels
+#define THC_CONV_WINOGRAD_MIN_PLANES 8
+// Kernel elements from which the FFT is preferred (15x15 and up)
+#define THC_CONV_FFT_MIN_KERNEL_ELEMENTS 225
+
+static dim3 THCTensorConv_grid(long n)
+{
+  long blocks = THCCeilDiv(n, (long) THC_CONV_THREADS);
+  return dim3(blocks < 65535 ? blocks : 65535);
+}
+
+static long THCTensorConv_nextPow2(long n)
+{
+  long p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+// Complex elements conv2DFFT holds for the kernel spectra and the spectra of
+// a single image, the least it needs whatever the batch size
+static long THCTensorConv_fftElements(long nInputPlane, long nOutputPlane,
+                                      long nInputRows, long nInputCols,
+                                      long nKernelRows, long nKernelCols)
+{
+  long nfreq = THCTensorConv_nextPow2(nInputRows + nKernelRows - 1) *
+               THCTensorConv_nextPow2(nInputCols + nKernelCols - 1);
+  return nfreq * (nOutputPlane * nInputPlane + nInputPlane + nOutputPlane);
+}
+
 /*
  * Description:
  *   base conv2D routine: 3D input, 3D output, 4D kernel
@@ -27,9 +68,10 @@
  *   - the swapkernel flag can be used to generate a conv2 instead of xcorr2
  *   - the templated kernel size is useful to generate code that's 2x faster
  *     but can be set to 0 to allow arbitrary kernel sizes
+ *   - products are accumulated in AccT
  */
-template <bool swapkernel, int T_kernel_h, int T_kernel_w>
-  __global__ void conv2generic(float *input, float *kernel, float *output,
+template <typename T, typename AccT, bool swapkernel, int T_kernel_h, int T_kernel_w>
+  __global__ void conv2generic(T *input, T *kernel, T *output,
                                int input_n, int input_h, int input_w,
                                int kernel_n, int kernel_h, int kernel_w,
                                int stride_h, int stride_w)
@@ -66,11 +108,14 @@ template <bool swapkernel, int T_kernel_h, int T_kernel_w>
   // iterators
   int oo, ii, xx, yy, kx, ky, kk;
 
-  // do the kernels fit in shared mem ?
-  if (input_n*kernel_w*kernel_h <= CUDA_SHARED_MEM_SIZE) {
+  // the shared buffer holds CUDA_SHARED_MEM_SIZE floats whatever T is, and
+  // is declared as double so that it is aligned for every T
+  __shared__ double shared_mem[CUDA_SHARED_MEM_SIZE / 2];
+  T *shared_kernel = (T *) shared_mem;
+  const int shared_kernel_size = CUDA_SHARED_MEM_SIZE * sizeof(float) / sizeof(T);
 
-    // put the kernel in shared memory
-    __shared__ float shared_kernel[CUDA_SHARED_MEM_SIZE];
+  // do the kernels fit in shared mem ?
+  if (input_n*kernel_w*kernel_h <= shared_kernel_size) {
 
     // first thread of each block does the copy
     for (kk = tid; kk < kernel_w*kernel_h*input_n; kk += nthreads) {
@@ -86,16 +131,16 @@ template <bool swapkernel, int T_kernel_h, int T_kernel_w>
           for(yy = yy_start; yy < yy_end; yy+=yy_step) {
             for(xx = xx_start; xx < xx_end; xx+=xx_step) {
               // Dot product in two dimensions... (between input image and the mask)
-              float *input_p = input + ii*input_h*input_w + yy*stride_h*input_w + xx*stride_w;
-              float *output_p = output + oo*output_h*output_w + yy*output_w + xx;
-              float *kernel_p = shared_kernel + (ii % input_n)*kernel_w*kernel_h + koffset;
-              float sum = 0;
+              T *input_p = input + ii*input_h*input_w + yy*stride_h*input_w + xx*stride_w;
+              T *output_p = output + oo*output_h*output_w + yy*output_w + xx;
+              T *kernel_p = shared_kernel + (ii % input_n)*kernel_w*kernel_h + koffset;
+              AccT sum = ScalarConvert<int, AccT>::to(0);
               if (swapkernel) {
 #pragma unroll
                 for(ky = 0; ky < T_kernel_h; ky++) {
 #pragma unroll
                   for(kx = 0; kx < T_kernel_w; kx++) {
-                    sum += input_p[kx]*(*kernel_p--);
+                    sum += ScalarConvert<T, AccT>::to(input_p[kx])*ScalarConvert<T, AccT>::to(*kernel_p--);
                   }
                   input_p += input_w;
                 }
@@ -104,12 +149,12 @@ template <bool swapkernel, int T_kernel_h, int T_kernel_w>
                 for(ky = 0; ky < T_kernel_h; ky++) {
 #pragma unroll
                   for(kx = 0; kx < T_kernel_w; kx++) {
-                    sum += input_p[kx]*(*kernel_p++);
+                    sum += ScalarConvert<T, AccT>::to(input_p[kx])*ScalarConvert<T, AccT>::to(*kernel_p++);
                   }
                   input_p += input_w;
                 }
               }
-              *output_p += sum;
+              *output_p = ScalarConvert<AccT, T>::to(ScalarConvert<T, AccT>::to(*output_p) + sum);
             }
           }
         }
@@ -121,15 +166,15 @@ template <bool swapkernel, int T_kernel_h, int T_kernel_w>
           for(yy = yy_start; yy < yy_end; yy+=yy_step) {
             for(xx = xx_start; xx < xx_end; xx+=xx_step) {
               // Dot product in two dimensions... (between input image and the mask)
-              float *input_p = input + ii*input_h*input_w + yy*stride_h*input_w + xx*stride_w;
-              float *output_p = output + oo*output_h*output_w + yy*output_w + xx;
-              float *kernel_p = shared_kernel + (ii % input_n) * kernel_w * kernel_h + koffset;
-              float sum = 0;
+              T *input_p = input + ii*input_h*input_w + yy*stride_h*input_w + xx*stride_w;
+              T *output_p = output + oo*output_h*output_w + yy*output_w + xx;
+              T *kernel_p = shared_kernel + (ii % input_n) * kernel_w * kernel_h + koffset;
+              AccT sum = ScalarConvert<int, AccT>::to(0);
               if (swapkernel) {
                 for(ky = 0; ky < kernel_h; ky++) {
 #pragma unroll 5
                   for(kx = 0; kx < kernel_w; kx++) {
-                    sum += input_p[kx]*(*kernel_p--);
+                    sum += ScalarConvert<T, AccT>::to(input_p[kx])*ScalarConvert<T, AccT>::to(*kernel_p--);
                   }
                   input_p += input_w;
                 }
@@ -137,12 +182,12 @@ template <bool swapkernel, int T_kernel_h, int T_kernel_w>
                 for(ky = 0; ky < kernel_h; ky++) {
 #pragma unroll 5
                   for(kx = 0; kx < kernel_w; kx++) {
-                    sum += input_p[kx]*(*kernel_p++);
+                    sum += ScalarConvert<T, AccT>::to(input_p[kx])*ScalarConvert<T, AccT>::to(*kernel_p++);
                   }
                   input_p += input_w;
                 }
               }
-              *output_p += sum;
+              *output_p = ScalarConvert<AccT, T>::to(ScalarConvert<T, AccT>::to(*output_p) + sum);
             }
           }
         }
@@ -157,15 +202,15 @@ template <bool swapkernel, int T_kernel_h, int T_kernel_w>
         for(yy = yy_start; yy < yy_end; yy+=yy_step) {
           for(xx = xx_start; xx < xx_end; xx+=xx_step) {
             // Dot product in two dimensions... (between input image and the mask)
-            float *input_p = input + ii*input_h*input_w + yy*stride_h*input_w + xx*stride_w;
-            float *output_p = output + oo*output_h*output_w + yy*output_w + xx;
-            float *kernel_p = kernel + ((oo % output_n) * input_n + (ii % input_n))*kernel_w*kernel_h + koffset;
-            float sum = 0;
+            T *input_p = input + ii*input_h*input_w + yy*stride_h*input_w + xx*stride_w;
+            T *output_p = output + oo*output_h*output_w + yy*output_w + xx;
+            T *kernel_p = kernel + ((oo % output_n) * input_n + (ii % input_n))*kernel_w*kernel_h + koffset;
+            AccT sum = ScalarConvert<int, AccT>::to(0);
             if (swapkernel) {
               for(ky = 0; ky < kernel_h; ky++) {
 #pragma unroll 5
                 for(kx = 0; kx < kernel_w; kx++) {
-                  sum += input_p[kx]*(*kernel_p--);
+                  sum += ScalarConvert<T, AccT>::to(input_p[kx])*ScalarConvert<T, AccT>::to(*kernel_p--);
                 }
                 input_p += input_w;
               }
@@ -173,12 +218,12 @@ template <bool swapkernel, int T_kernel_h, int T_kernel_w>
               for(ky = 0; ky < kernel_h; ky++) {
 #pragma unroll 5
                 for(kx = 0; kx < kernel_w; kx++) {
-                  sum += input_p[kx]*(*kernel_p++);
+                  sum += ScalarConvert<T, AccT>::to(input_p[kx])*ScalarConvert<T, AccT>::to(*kernel_p++);
                 }
                 input_p += input_w;
               }
             }
-            *output_p += sum;
+            *output_p = ScalarConvert<AccT, T>::to(ScalarConvert<T, AccT>::to(*output_p) + sum);
           }
         }
       }
@@ -186,6 +231,284 @@ template <bool swapkernel, int T_kernel_h, int T_kernel_w>
   }
 }
 
+/*
+ * Description:
+ *   im2col for the GEMM formulation of conv2D: unfolds a batch of contiguous
+ *   3D inputs into matrices with one row per (plane, kernel row, kernel
+ *   column) and one column per output pixel, so that the convolution of
+ *   image b becomes the product kernel (nOutputPlane x rows) * columns[b].
+ *
+ *   - the swapkernel flag reads the patch backwards, generating a conv2
+ *     with the kernel left as it is
+ */
+template <typename T, bool swapkernel>
+__global__ void conv2im2col(const T *input, T *columns, long n,
+                            int input_n, int input_h, int input_w,
+                            int kernel_h, int kernel_w,
+                            int stride_h, int stride_w,
+                            int output_h, int output_w)
+{
+  long npixels = (long) output_h * output_w;
+  long nrows = (long) input_n * kernel_h * kernel_w;
+
+  for (long linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < n;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    long pixel = linearIndex % npixels;
+    long row = (linearIndex / npixels) % nrows;
+    long batch = linearIndex / (npixels * nrows);
+
+    int xx = pixel % output_w;
+    int yy = pixel / output_w;
+    int kx = row % kernel_w;
+    int ky = (row / kernel_w) % kernel_h;
+    int ii = row / (kernel_w * kernel_h);
+    if (swapkernel) {
+      kx = kernel_w - 1 - kx;
+      ky = kernel_h - 1 - ky;
+    }
+
+    columns[linearIndex] =
+      input[((batch * input_n + ii) * input_h + yy * stride_h + ky) * input_w + xx * stride_w + kx];
+  }
+}
+
+/*
+ * Description:
+ *   Winograd F(2x2, 3x3) for 3x3 kernels with unit stride (Lavin and Gray,
+ *   "Fast Algorithms for Convolutional Neural Networks"). Each 2x2 output
+ *   tile is computed from a 4x4 input tile with 16 multiplications instead
+ *   of 36:
+ *
+ *     Y = A' [ (G g G') .* (B' d B) ] A
+ *
+ *   The elementwise products summed over input planes are 16 independent
+ *   GEMMs, one per position in the 4x4 transformed tile, which run as one
+ *   strided-batched GEMM between the kernel transform below and the input
+ *   transform. Tiles are numbered (batch, tile row, tile column) and
+ *   transforms are computed in AccT.
+ */
+
+// U[xi][o][i] = G g G' for kernel plane (o, i)
+template <typename T, typename AccT, bool swapkernel>
+__global__ void conv2winogradKernel(const T *kernel, T *transformed, int output_n, int input_n)
+{
+  long n = (long) output_n * input_n;
+  for (long linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < n;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    const T *g_p = kernel + linearIndex * 9;
+    AccT g[3][3];
+    for (int ky = 0; ky < 3; ky++) {
+      for (int kx = 0; kx < 3; kx++) {
+        g[ky][kx] = ScalarConvert<T, AccT>::to(swapkernel ? g_p[8 - (ky * 3 + kx)] : g_p[ky * 3 + kx]);
+      }
+    }
+
+    // G g
+    AccT gg[4][3];
+    for (int kx = 0; kx < 3; kx++) {
+      gg[0][kx] = g[0][kx];
+      gg[1][kx] = (g[0][kx] + g[1][kx] + g[2][kx]) * (AccT) 0.5;
+      gg[2][kx] = (g[0][kx] - g[1][kx] + g[2][kx]) * (AccT) 0.5;
+      gg[3][kx] = g[2][kx];
+    }
+
+    // (G g) G'
+    for (int r = 0; r < 4; r++) {
+      AccT u[4];
+      u[0] = gg[r][0];
+      u[1] = (gg[r][0] + gg[r][1] + gg[r][2]) * (AccT) 0.5;
+      u[2] = (gg[r][0] - gg[r][1] + gg[r][2]) * (AccT) 0.5;
+      u[3] = gg[r][2];
+      for (int c = 0; c < 4; c++) {
+        transformed[(r * 4 + c) * n + linearIndex] = ScalarConvert<AccT, T>::to(u[c]);
+      }
+    }
+  }
+}
+
+// V[xi][i][tile] = B' d B for the 4x4 input patch d under each tile; patches
+// that run past the input read zeros
+template <typename T, typename AccT>
+__global__ void conv2winogradInput(const T *input, T *transformed,
+                                   int batch_n, int input_n, int input_h, int input_w,
+                                   int tiles_h, int tiles_w)
+{
+  long ntiles = (long) batch_n * tiles_h * tiles_w;
+  long n = ntiles * input_n;
+  for (long linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < n;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    long tile = linearIndex % ntiles;
+    int ii = linearIndex / ntiles;
+    int tx = tile % tiles_w;
+    int ty = (tile / tiles_w) % tiles_h;
+    long batch = tile / ((long) tiles_w * tiles_h);
+
+    const T *input_p = input + (batch * input_n + ii) * input_h * input_w;
+    AccT d[4][4];
+    for (int r = 0; r < 4; r++) {
+      int yy = 2 * ty + r;
+      for (int c = 0; c < 4; c++) {
+        int xx = 2 * tx + c;
+        d[r][c] = (yy < input_h && xx < input_w) ?
+          ScalarConvert<T, AccT>::to(input_p[yy * input_w + xx]) :
+          ScalarConvert<int, AccT>::to(0);
+      }
+    }
+
+    // B' d
+    AccT bd[4][4];
+    for (int c = 0; c < 4; c++) {
+      bd[0][c] = d[0][c] - d[2][c];
+      bd[1][c] = d[1][c] + d[2][c];
+      bd[2][c] = d[2][c] - d[1][c];
+      bd[3][c] = d[1][c] - d[3][c];
+    }
+
+    // (B' d) B
+    for (int r = 0; r < 4; r++) {
+      AccT v[4];
+      v[0] = bd[r][0] - bd[r][2];
+      v[1] = bd[r][1] + bd[r][2];
+      v[2] = bd[r][2] - bd[r][1];
+      v[3] = bd[r][1] - bd[r][3];
+      for (int c = 0; c < 4; c++) {
+        transformed[(r * 4 + c) * n + linearIndex] = ScalarConvert<AccT, T>::to(v[c]);
+      }
+    }
+  }
+}
+
+// output += A' m A for the 4x4 products m of each tile, dropping the parts
+// of the last tile row/column that fall outside an odd-sized output
+template <typename T, typename AccT>
+__global__ void conv2winogradOutput(const T *products, T *output,
+                                    int batch_n, int output_n, int output_h, int output_w,
+                                    int tiles_h, int tiles_w)
+{
+  long ntiles = (long) batch_n * tiles_h * tiles_w;
+  long n = ntiles * output_n;
+  for (long linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < n;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    long tile = linearIndex % ntiles;
+    int oo = linearIndex / ntiles;
+    int tx = tile % tiles_w;
+    int ty = (tile / tiles_w) % tiles_h;
+    long batch = tile / ((long) tiles_w * tiles_h);
+
+    AccT m[4][4];
+    for (int r = 0; r < 4; r++) {
+      for (int c = 0; c < 4; c++) {
+        m[r][c] = ScalarConvert<T, AccT>::to(products[(r * 4 + c) * n + linearIndex]);
+      }
+    }
+
+    // A' m
+    AccT am[2][4];
+    for (int c = 0; c < 4; c++) {
+      am[0][c] = m[0][c] + m[1][c] + m[2][c];
+      am[1][c] = m[1][c] - m[2][c] - m[3][c];
+    }
+
+    T *output_p = output + (batch * output_n + oo) * output_h * output_w;
+    for (int r = 0; r < 2; r++) {
+      int yy = 2 * ty + r;
+      AccT y[2];
+      // (A' m) A
+      y[0] = am[r][0] + am[r][1] + am[r][2];
+      y[1] = am[r][1] - am[r][2] - am[r][3];
+      for (int c = 0; c < 2; c++) {
+        int xx = 2 * tx + c;
+        if (yy < output_h && xx < output_w) {
+          T *out = output_p + yy * output_w + xx;
+          *out = ScalarConvert<AccT, T>::to(ScalarConvert<T, AccT>::to(*out) + y[c]);
+        }
+      }
+    }
+  }
+}
+
+/*
+ * Description:
+ *   FFT convolution, for large kernels with unit stride: planes are
+ *   zero-padded into complex buffers, transformed with THCFFT, multiplied
+ *   and summed over input planes per frequency, transformed back and the
+ *   valid or full region is added to the output.
+ */
+
+// Copies planes of rows x cols into zero-padded complex planes of
+// padRows x padCols; `flip` reverses both axes, turning a convolution into
+// a correlation
+template <typename T, typename AccT>
+__global__ void conv2fftPad(const T *src, THCComplex<AccT> *dst, long n,
+                            int rows, int cols, int padRows, int padCols, bool flip)
+{
+  for (long linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < n;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    int xx = linearIndex % padCols;
+    int yy = (linearIndex / padCols) % padRows;
+    long plane = linearIndex / ((long) padRows * padCols);
+
+    THCComplex<AccT> v;
+    v.re = ScalarConvert<int, AccT>::to(0);
+    v.im = ScalarConvert<int, AccT>::to(0);
+    if (yy < rows && xx < cols) {
+      int sy = flip ? rows - 1 - yy : yy;
+      int sx = flip ? cols - 1 - xx : xx;
+      v.re = ScalarConvert<T, AccT>::to(src[(plane * rows + sy) * cols + sx]);
+    }
+    dst[linearIndex] = v;
+  }
+}
+
+// output[b][o] = sum over i of input[b][i] * kernel[o][i], per frequency
+template <typename AccT>
+__global__ void conv2fftMultiply(const THCComplex<AccT> *input, const THCComplex<AccT> *kernel,
+                                 THCComplex<AccT> *output, long n,
+                                 int input_n, int output_n, long nfreq)
+{
+  for (long linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < n;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    long freq = linearIndex % nfreq;
+    int oo = (linearIndex / nfreq) % output_n;
+    long batch = linearIndex / (nfreq * output_n);
+
+    const THCComplex<AccT> *input_p = input + batch * input_n * nfreq + freq;
+    const THCComplex<AccT> *kernel_p = kernel + (long) oo * input_n * nfreq + freq;
+    THCComplex<AccT> sum;
+    sum.re = ScalarConvert<int, AccT>::to(0);
+    sum.im = ScalarConvert<int, AccT>::to(0);
+    for (int ii = 0; ii < input_n; ++ii) {
+      sum = THCComplex_add(sum, THCComplex_mul(input_p[ii * nfreq], kernel_p[ii * nfreq]));
+    }
+    output[linearIndex] = sum;
+  }
+}
+
+// output += scale * real part of the output_h x output_w window of each
+// padded plane that starts at (rowOffset, colOffset)
+template <typename T, typename AccT>
+__global__ void conv2fftExtract(const THCComplex<AccT> *src, T *output, long n,
+                                int output_h, int output_w, int padRows, int padCols,
+                                int rowOffset, int colOffset, AccT scale)
+{
+  for (long linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < n;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    int xx = linearIndex % output_w;
+    int yy = (linearIndex / output_w) % output_h;
+    long plane = linearIndex / ((long) output_h * output_w);
+
+    AccT v = src[(plane * padRows + yy + rowOffset) * padCols + xx + colOffset].re * scale;
+    output[linearIndex] = ScalarConvert<AccT, T>::to(ScalarConvert<T, AccT>::to(output[linearIndex]) + v);
+  }
+}
+
 /*
  * Description:
  *   base conv2D routine with reversed stride: 3D input, 4D output, 3D kernel
@@ -289,303 +612,6 @@ __global__ void conv2genericrev(float *input, float *kernel, float *output,
     KERNEL(0);                                                  \
   }
 
-/*
- * API-compatible with THRealTensor_conv2Dmv
- * 3D input, 4D kernel, 3D output
- * matrix vector product like: y <- Ax + beta*y
- */
-THC_API void THCudaTensor_conv2Dmv(THCState *state, THCudaTensor *output, float beta, THCudaTensor *input,
-                                   THCudaTensor *kernel, long srow, long scol, const char *type)
-{
-  THAssert(THCudaTensor_checkGPU(state, 3, output, input, kernel));
-  long nInputPlane, nInputRows, nInputCols;
-  long nKernelRows, nKernelCols;
-  long nOutputPlane, nOutputRows, nOutputCols;
-
-  THArgCheck(kernel->nDimension == 4 , 4, "kernel: 4D Tensor expected");
-  THArgCheck(srow >= 1, 5, "Stride should be a positive integer");
-  THArgCheck(scol >= 1, 6, "Stride should be a positive integer");
-  THArgCheck(type[0] == 'v' || type[0] == 'f', 7, "type of convolution can 'v' or 'f'");
-  THArgCheck(type[1] == 'c' || type[1] == 'x', 7, "type of convolution can 'x' or 'c'");
-
-  input = THCudaTensor_newContiguous(state, input);
-  kernel = THCudaTensor_newContiguous(state, kernel);
-
-  nInputPlane = input->size[0];
-  nInputRows  = input->size[1];
-  nInputCols  = input->size[2];
-
-  nKernelRows  = kernel->size[2];
-  nKernelCols  = kernel->size[3];
-  nOutputPlane = kernel->size[0];
-  THArgCheck(kernel->size[1] == nInputPlane, 2, "invalid number of input planes");
-
-  THArgCheck( (nInputRows >= nKernelRows && nInputCols >= nKernelCols) || *type == 'f', 2,
-              "conv2Dmv : Input image is smaller than kernel");
-
-  if (*type == 'f') {
-    // output dims
-    nOutputRows = (nInputRows - 1) * srow + nKernelRows;
-    nOutputCols = (nInputCols - 1) * scol + nKernelCols;
-
-    // use temp buffer
-    THCudaTensor *inputP = THCudaTensor_new(state);
-
-    // create a zero-padded input
-    long nInputRowsPadded = (nOutputRows - 1) * srow + nKernelRows;
-    long nInputColsPadded = (nOutputCols - 1) * scol + nKernelCols;
-    THCudaTensor_resize3d(state, inputP, nInputPlane, nInputRowsPadded, nInputColsPadded);
-    THCudaTensor_zero(state, inputP);
-
-    THCudaTensor *centered = THCudaTensor_new(state);
-    THCudaTensor_narrow(state, centered, inputP, 2, nKernelCols-1, nInputCols);
-    THCudaTensor_narrow(state, centered, NULL, 1, nKernelRows-1, nInputRows);
-    THCudaTensor_copy(state, centered, input);
-    THCudaTensor_free(state, centered);
-
-    // remap input to newly created tensor
-    THCudaTensor_free(state, input);
-    input = inputP;
-    nInputRows = nInputRowsPadded;
-    nInputCols = nInputColsPadded;
-
-  } else { // 'v'
-    // output dims
-    nOutputRows = (nInputRows - nKernelRows) / srow + 1;
-    nOutputCols = (nInputCols - nKernelCols) / scol + 1;
-  }
-
-  ptrdiff_t nelem = THCudaTensor_nElement(state, output);
-  THCudaTensor_resize3d(state, output, nOutputPlane, nOutputRows, nOutputCols);
-
-  if (beta == 0 || nelem != THCudaTensor_nElement(state, output)) {
-    THCudaTensor_zero(state, output);
-  } else if (beta != 1) {
-    THCudaTensor_mul(state, output, output, beta);
-  }
-
-  float *input_data = THCudaTensor_data(state, input);
-  float *weight_data = THCudaTensor_data(state, kernel);
-  float *output_data = THCudaTensor_data(state, output);
-
-  // cuda blocks & threads:
-  int yblocks = (int)(16L / nOutputPlane);
-  yblocks = yblocks < 1 ? 1 : yblocks;
-  dim3 blocks(nOutputPlane,yblocks);
-  dim3 threads(32,8);
-
-  // convolution: xcorr2 or conv2
-  if (type[1] == 'x') {
-#define X_CONV_KERNEL(dim)\
-    hipLaunchKernelGGL(\
-      (conv2generic<false, (dim), (dim)>),\
-      dim3(blocks),\
-      dim3(threads),\
-      0,\
-      THCState_getCurrentStream(state),\
-      input_data,\
-      weight_data,\
-      output_data,\
-      nInputPlane,\
-      nInputRows,\
-      nInputCols,\
-      nOutputPlane*nInputPlane,\
-      nKernelRows,\
-      nKernelCols,\
-      srow,\
-      scol);
-
-    FOR_KERNEL_SPECIALIZED_DIMENSION(nKernelRows, nKernelCols, X_CONV_KERNEL);
-#undef X_CONV_KERNEL
-  } else { // 'c'
-#define C_CONV_KERNEL(dim)\
-    hipLaunchKernelGGL(\
-      (conv2generic<true, (dim), (dim)>),\
-      dim3(blocks),\
-      dim3(threads),\
-      0,\
-      THCState_getCurrentStream(state),\
-      input_data,\
-      weight_data,\
-      output_data,\
-      nInputPlane,\
-      nInputRows,\
-      nInputCols,\
-      nOutputPlane*nInputPlane,\
-      nKernelRows,\
-      nKernelCols,\
-      srow,\
-      scol);
-
-    FOR_KERNEL_SPECIALIZED_DIMENSION(nKernelRows, nKernelCols, C_CONV_KERNEL);
-#undef C_CONV_KERNEL
-  }
-
-  // clean
-  if (*type != 'f') THCudaTensor_free(state, input);
-  THCudaTensor_free(state, kernel);
-
-  // check for errors
-  hipError_t err = hipGetLastError();
-  if (err != hipSuccess) {
-    printf("error in conv2Dmv: %s\n", hipGetErrorString(err));
-    THError("aborting");
-  }
-}
-
-/*
- * API-compatible with THRealTensor_conv2Dmm
- * 4D input, 4D kernel, 4D output
- * matrix vector product like: y <- Ax + beta*y
- */
-THC_API void THCudaTensor_conv2Dmm(THCState *state, THCudaTensor *output, float beta, THCudaTensor *input,
-                                   THCudaTensor *kernel, long srow, long scol, const char *type)
-{
-  THAssert(THCudaTensor_checkGPU(state, 3, output, input, kernel));
-  long nbatch, nInputPlane, nInputRows, nInputCols;
-  long nKernelRows, nKernelCols;
-  long nOutputPlane, nOutputRows, nOutputCols;
-
-  THArgCheck(kernel->nDimension == 4 , 4, "kernel: 4D Tensor expected");
-  THArgCheck(srow >= 1, 5, "Stride should be a positive integer");
-  THArgCheck(scol >= 1, 6, "Stride should be a positive integer");
-  THArgCheck(type[0] == 'v' || type[0] == 'f', 7, "type of convolution can 'v' or 'f'");
-  THArgCheck(type[1] == 'c' || type[1] == 'x', 7, "type of convolution can 'x' or 'c'");
-
-  input = THCudaTensor_newContiguous(state, input);
-  kernel = THCudaTensor_newContiguous(state, kernel);
-
-  nbatch      = input->size[0];
-  nInputPlane = input->size[1];
-  nInputRows  = input->size[2];
-  nInputCols  = input->size[3];
-
-  nKernelRows  = kernel->size[2];
-  nKernelCols  = kernel->size[3];
-  nOutputPlane = kernel->size[0];
-  THArgCheck(kernel->size[1] == nInputPlane, 2, "invalid number of input planes");
-
-  THArgCheck( (nInputRows >= nKernelRows && nInputCols >= nKernelCols) || *type == 'f', 2,
-              "conv2Dmm : Input image is smaller than kernel");
-
-  if (*type == 'f') {
-    // output dims
-    nOutputRows = (nInputRows - 1) * srow + nKernelRows;
-    nOutputCols = (nInputCols - 1) * scol + nKernelCols;
-
-    // use temp buffer
-    THCudaTensor *inputP = THCudaTensor_new(state);
-
-    // create a zero-padded input
-    long nInputRowsPadded = (nOutputRows - 1) * srow + nKernelRows;
-    long nInputColsPadded = (nOutputCols - 1) * scol + nKernelCols;
-    THCudaTensor_resize4d(state, inputP, nbatch, nInputPlane, nInputRowsPadded, nInputColsPadded);
-    THCudaTensor_zero(state, inputP);
-
-    THCudaTensor *centered = THCudaTensor_new(state);
-    THCudaTensor_narrow(state, centered, inputP, 3, nKernelCols-1, nInputCols);
-    THCudaTensor_narrow(state, centered, NULL, 2, nKernelRows-1, nInputRows);
-    THCudaTensor_copy(state, centered, input);
-    THCudaTensor_free(state, centered);
-
-    // remap input to newly created tensor
-    THCudaTensor_free(state, input);
-    input = inputP;
-    nInputRows = nInputRowsPadded;
-    nInputCols = nInputColsPadded;
-
-  } else { // 'v'
-    // output dims
-    nOutputRows = (nInputRows - nKernelRows) / srow + 1;
-    nOutputCols = (nInputCols - nKernelCols) / scol + 1;
-  }
-
-  ptrdiff_t nelem = THCudaTensor_nElement(state, output);
-  THCudaTensor_resize4d(state, output, nbatch, nOutputPlane, nOutputRows, nOutputCols);
-
-  if (beta == 0 || nelem != THCudaTensor_nElement(state, output)) {
-    THCudaTensor_zero(state, output);
-  } else if (beta != 1) {
-    THCudaTensor_mul(state, output, output, beta);
-  }
-
-  float *input_data = THCudaTensor_data(state, input);
-  float *weight_data = THCudaTensor_data(state, kernel);
-  float *output_data = THCudaTensor_data(state, output);
-
-  // cuda blocks & threads:
-  int yblocks = (int)(16L / nOutputPlane);
-  yblocks = yblocks < 1 ? 1 : yblocks;
-  dim3 blocks(nOutputPlane*nbatch,yblocks);
-  dim3 threads(32,8);
-
-  // convolution: xcorr2 or conv2
-  if (type[1] == 'x') {
-#define X_CONV_KERNEL(dim)\
-    hipLaunchKernelGGL(\
-      (conv2generic<false, (dim), (dim)>),\
-      dim3(blocks),\
-      dim3(threads),\
-      0,\
-      THCState_getCurrentStream(state),\
-      input_data,\
-      weight_data,\
-      output_data,\
-      nInputPlane,\
-      nInputRows,\
-      nInputCols,\
-      nOutputPlane*nInputPlane,\
-      nKernelRows,\
-      nKernelCols,\
-      srow,\
-      scol);
-
-    FOR_KERNEL_SPECIALIZED_DIMENSION(nKernelCols, nKernelRows, X_CONV_KERNEL);
-#undef X_CONV_KERNEL
-  } else { // 'c'
-#define C_CONV_KERNEL(dim) \
-    hipLaunchKernelGGL(\
-      (conv2generic<true, (dim), (dim)>),\
-      dim3(blocks),\
-      dim3(threads),\
-      0,\
-      THCState_getCurrentStream(state),\
-      input_data,\
-      weight_data,\
-      output_data,\
-      nInputPlane,\
-      nInputRows,\
-      nInputCols,\
-      nOutputPlane*nInputPlane,\
-      nKernelRows,\
-      nKernelCols,\
-      srow,\
-      scol);
-
-    FOR_KERNEL_SPECIALIZED_DIMENSION(nKernelCols, nKernelRows, C_CONV_KERNEL);
-#undef C_CONV_KERNEL
-  }
-
-  // clean
-  if (*type != 'f') THCudaTensor_free(state, input);
-  THCudaTensor_free(state, kernel);
-
-  // check for errors
-  hipError_t err = hipGetLastError();
-  if (err != hipSuccess) {
-    hipDeviceProp_t deviceProp;
-    hipGetDeviceProperties(&deviceProp, 0);
-    printf("error in conv2Dmm: %s\n", hipGetErrorString(err));
-    printf("requested grid size: %dx%dx%d, max allowed: %dx%dx%d\n",
-           blocks.x, blocks.y, blocks.z,
-           deviceProp.maxGridSize[0], deviceProp.maxGridSize[1], deviceProp.maxGridSize[2]);
-    printf("requested block size: %dx%dx%d, max allowed: %dx%dx%d\n",
-           threads.x, threads.y, threads.z,
-           deviceProp.maxThreadsDim[0], deviceProp.maxThreadsDim[1], deviceProp.maxThreadsDim[2]);
-    THError("aborting");
-  }
-}
-
 /*
  * API-compatible with THRealTensor_conv2DRevger
  * 3D input, 3D kernel, 4D output
@@ -1038,4 +1064,7 @@ THC_API void THCudaTensor_conv2Dmap(THCState *state, THCudaTensor *output, THCud
   }
 }
 
+#include "generic/THCTensorConv.cu"
+#include "THCGenerateFloatTypes.h"
+
 #undef FOR_KERNEL_SPECIALIZED_DIMENSION
@@ -5,12 +5,8 @@
 
 struct THCState;
 
-THC_API void THCudaTensor_conv2Dmv(struct THCState *state, THCudaTensor *output,
-                                   float beta, THCudaTensor *input, THCudaTensor *kernel,
-                                   long srow, long scol, const char *type);
-THC_API void THCudaTensor_conv2Dmm(struct THCState *state, THCudaTensor *output,
-                                   float beta, THCudaTensor *input, THCudaTensor *kernel,
-                                   long srow, long scol, const char *type);
+#include "generic/THCTensorConv.h"
+#include "THCGenerateFloatTypes.h"
 
 THC_API void THCudaTensor_conv2DRevger(struct THCState *state, THCudaTensor *output,
                                        float beta, float alpha, THCudaTensor *input,
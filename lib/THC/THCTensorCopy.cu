@@ -18,6 +18,23 @@ struct CopyOp {
   }
 };
 
+// Copy operator converting through AccT, then scaling and shifting:
+// dst = src * scale + shift
+template <typename TypeDst, typename TypeSrc, typename AccT>
+struct CopyScaledOp {
+  CopyScaledOp(AccT scale, AccT shift) : scale(scale), shift(shift) {}
+
+  __device__ __forceinline__
+  void operator()(TypeDst* dst, TypeSrc* src)
+  {
+    AccT value = ScalarConvert<TypeSrc, AccT>::to(*src);
+    *dst = ScalarConvert<AccT, TypeDst>::to(value * scale + shift);
+  }
+
+  const AccT scale;
+  const AccT shift;
+};
+
 // Copy for the same type to the same type
 template <typename TensorTypeDst, typename TensorTypeSrc>
 void
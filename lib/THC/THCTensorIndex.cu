@@ -11,6 +11,7 @@
 #include "THCDeviceUtils.cuh"
 #include "THCNumerics.cuh"
 #include "THCAtomics.cuh"
+#include "THCTensorSortedAdd.cuh"
 #include <algorithm> // for std::min
 #include "hip/hip_runtime.h"
 
@@ -366,5 +367,86 @@ void indexSelectLargeIndex(
   }
 }
 
+// indexSelect of whole rows from a contiguous tensor into a contiguous
+// tensor, as in embedding lookups. Each row of the block copies one selected
+// row in units of U, the widest type that the row length and the alignment
+// of both tensors allow. The indices of the rows a block handles are loaded
+// once into shared memory.
+template <typename U>
+__global__ void
+indexSelectRows(U *dst, const U *src, const long *indices,
+                long numIndices, long rowUnits, long srcRows)
+{
+  __shared__ long rowIndex[THC_APPLY_ROW_THREADS];
+  int tid = hipThreadIdx_y * hipBlockDim_x + hipThreadIdx_x;
+
+  for (long first = hipBlockIdx_x * hipBlockDim_y;
+       first < numIndices;
+       first += hipGridDim_x * hipBlockDim_y) {
+    if (tid < hipBlockDim_y && first + tid < numIndices) {
+      // Lua indices begin at 1
+      rowIndex[tid] = indices[first + tid] - TH_INDEX_BASE;
+    }
+    __syncthreads();
+
+    long row = first + hipThreadIdx_y;
+    if (row < numIndices) {
+      long srcRow = rowIndex[hipThreadIdx_y];
+      if (srcRow >= 0 && srcRow < srcRows) {
+        const U *srcRowData = src + srcRow * rowUnits;
+        U *dstRowData = dst + row * rowUnits;
+        for (long i = hipThreadIdx_x; i < rowUnits; i += hipBlockDim_x) {
+          dstRowData[i] = srcRowData[i];
+        }
+      }
+    }
+    __syncthreads();
+  }
+}
+
+template <typename U>
+void THC_indexSelectRows(THCState *state, U *dst, const U *src, const long *indices,
+                         long numIndices, long rowUnits, long srcRows)
+{
+  dim3 block = getApplyRowBlock(rowUnits);
+  int mpc = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
+  dim3 grid(std::min(THCCeilDiv(numIndices, (long) block.y), (long) (mpc * 8)));
+
+  hipLaunchKernelGGL(
+    (indexSelectRows<U>), grid, block, 0, THCState_getCurrentStream(state),
+    dst, src, indices, numIndices, rowUnits, srcRows);
+  THCudaCheck(hipGetLastError());
+}
+
+// Fused gather and sum of the rows of each bag: bag b covers the indices
+// from offsets[b] up to offsets[b + 1] (exclusive) or the end, and its sum,
+// or mean when `average` is set, goes to row b of `dst`. Empty bags give
+// zeros. Offsets and indices are checked on the host beforehand.
+template <typename T, typename AccT>
+__global__ void
+embeddingBagKernel(T *dst, const T *src, const long *indices, const long *offsets,
+                   long numIndices, long numBags, long rowSize, long srcRows,
+                   bool average)
+{
+  for (long bag = hipBlockIdx_x * hipBlockDim_y + hipThreadIdx_y;
+       bag < numBags;
+       bag += hipGridDim_x * hipBlockDim_y) {
+    long begin = offsets[bag] - TH_INDEX_BASE;
+    long end = bag + 1 < numBags ? offsets[bag + 1] - TH_INDEX_BASE : numIndices;
+
+    for (long e = hipThreadIdx_x; e < rowSize; e += hipBlockDim_x) {
+      AccT sum = ScalarConvert<int, AccT>::to(0);
+      for (long i = begin; i < end; ++i) {
+        long srcRow = indices[i] - TH_INDEX_BASE;
+        sum = sum + ScalarConvert<T, AccT>::to(src[srcRow * rowSize + e]);
+      }
+      if (average && end > begin) {
+        sum = sum / ScalarConvert<long, AccT>::to(end - begin);
+      }
+      dst[bag * rowSize + e] = ScalarConvert<AccT, T>::to(sum);
+    }
+  }
+}
+
 #include "generic/THCTensorIndex.cu"
 #include "THCGenerateAllTypes.h"
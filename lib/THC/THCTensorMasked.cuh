@@ -5,6 +5,8 @@
 #include "THCTensorCopy.h"
 #include "THCApply.cuh"
 #include "THCReduce.cuh"
+#include "THCScanUtils.cuh"
+#include "THCNumerics.cuh"
 
 #ifdef THRUST_PATH
   #include <thrust/device_ptr.h>
@@ -69,4 +71,190 @@ struct TensorMaskedSelectOp {
   T* out;
 };
 
+// Block size and per-thread work for the single-pass compaction
+// kernels below; one tile is THC_COMPACT_THREADS *
+// THC_COMPACT_ITEMS_PER_THREAD input elements
+#define THC_COMPACT_THREADS 256
+#define THC_COMPACT_ITEMS_PER_THREAD 4
+
+inline ptrdiff_t THC_getCompactTiles(ptrdiff_t totalElements) {
+  return THCCeilDiv(totalElements,
+                    (ptrdiff_t) (THC_COMPACT_THREADS *
+                                 THC_COMPACT_ITEMS_PER_THREAD));
+}
+
+// Allocates the look-back scratch for `numTiles` tiles: one status word
+// per tile followed by the counter handing out tile indices in launch
+// order. The scratch is zeroed on the current stream and must be
+// released with THCudaFree.
+inline unsigned long long* THC_newCompactScratch(THCState* state,
+                                                 ptrdiff_t numTiles) {
+  size_t scratchSize = (numTiles + 1) * sizeof(unsigned long long);
+  unsigned long long* tileStatus = NULL;
+  THCudaCheck(THCudaMalloc(state, (void**) &tileStatus, scratchSize));
+  THCudaCheck(hipMemsetAsync(tileStatus, 0, scratchSize,
+                             THCState_getCurrentStream(state)));
+  return tileStatus;
+}
+
+// Given the per-item selection flags of this thread within `tile`,
+// computes the global output position of each selected item such that
+// selected elements keep their linear order. Each tile counts its
+// selected elements with warp ballots and obtains its global offset
+// via look-back over the preceding tiles. If `lastTile` is set, the
+// total number selected is written to `count`, so the host never needs
+// to read anything back. All threads of the block must call this.
+template <typename IndexType>
+__device__ void
+compactTileWriteIndices(const bool (&flags)[THC_COMPACT_ITEMS_PER_THREAD],
+                        IndexType (&writeIndex)[THC_COMPACT_ITEMS_PER_THREAD],
+                        unsigned int tile,
+                        bool lastTile,
+                        unsigned long long* tileStatus,
+                        long* count)
+{
+  // one per each warp, up to warp limit
+  __shared__ int smem[32];
+  __shared__ unsigned long long tileOffset;
+
+  int localIndex[THC_COMPACT_ITEMS_PER_THREAD];
+  int tileCount = 0;
+
+  // Items are strided by the block size so that loads stay coalesced;
+  // this is also the order in which their prefix is accumulated
+#pragma unroll
+  for (int item = 0; item < THC_COMPACT_ITEMS_PER_THREAD; ++item) {
+    int index;
+    int carry;
+    exclusiveBinaryPrefixSum<int, true>(smem, flags[item], &index, &carry);
+
+    localIndex[item] = tileCount + index;
+    tileCount += carry;
+  }
+
+  if (hipThreadIdx_x == 0) {
+    tileOffset = tileExclusivePrefix(tileStatus, tile, tileCount);
+
+    if (lastTile) {
+      *count = (long) (tileOffset + tileCount);
+    }
+  }
+  __syncthreads();
+
+#pragma unroll
+  for (int item = 0; item < THC_COMPACT_ITEMS_PER_THREAD; ++item) {
+    writeIndex[item] = (IndexType) tileOffset + localIndex[item];
+  }
+}
+
+// Stream compaction of `src` where `mask` is set into the contiguous
+// array `out`, preserving element order.
+template <typename T, typename MaskT, typename IndexType,
+          int SrcDims, int MaskDims>
+__global__ void
+kernelMaskedSelectCompact(reference_to_const(TensorInfo<T, IndexType>) src,
+                          reference_to_const(TensorInfo<MaskT, IndexType>) mask,
+                          T* out,
+                          IndexType totalElements,
+                          unsigned long long* tileStatus,
+                          unsigned int* tileCounter,
+                          long* count)
+{
+  __shared__ unsigned int tileSmem;
+
+  unsigned int tile = getDynamicTileId(tileCounter, &tileSmem);
+  IndexType tileSize = hipBlockDim_x * THC_COMPACT_ITEMS_PER_THREAD;
+  IndexType tileStart = (IndexType) tile * tileSize;
+
+  if (tileStart >= totalElements) {
+    return;
+  }
+
+  bool flags[THC_COMPACT_ITEMS_PER_THREAD];
+  IndexType writeIndex[THC_COMPACT_ITEMS_PER_THREAD];
+
+#pragma unroll
+  for (int item = 0; item < THC_COMPACT_ITEMS_PER_THREAD; ++item) {
+    IndexType linearIndex =
+      tileStart + item * hipBlockDim_x + hipThreadIdx_x;
+
+    flags[item] = (linearIndex < totalElements) &&
+      mask.data[IndexToOffset<MaskT, IndexType, MaskDims>::get(
+        linearIndex, mask)];
+  }
+
+  compactTileWriteIndices<IndexType>(
+    flags, writeIndex, tile, tileStart + tileSize >= totalElements,
+    tileStatus, count);
+
+#pragma unroll
+  for (int item = 0; item < THC_COMPACT_ITEMS_PER_THREAD; ++item) {
+    if (flags[item]) {
+      IndexType linearIndex =
+        tileStart + item * hipBlockDim_x + hipThreadIdx_x;
+      out[writeIndex[item]] =
+        src.data[IndexToOffset<T, IndexType, SrcDims>::get(linearIndex, src)];
+    }
+  }
+}
+
+// Writes the coordinates of every non-zero element of `src` as rows of
+// the contiguous (count x dims) array `out`, in linear element order.
+// `src` is read through its (possibly collapsed) layout, while `sizes`
+// holds the original sizes that the coordinates refer to.
+template <typename T, typename IndexType, int SrcDims>
+__global__ void
+kernelNonzeroCompact(reference_to_const(TensorInfo<T, IndexType>) src,
+                     reference_to_const(TensorInfo<T, IndexType>) sizes,
+                     long* out,
+                     IndexType totalElements,
+                     unsigned long long* tileStatus,
+                     unsigned int* tileCounter,
+                     long* count)
+{
+  __shared__ unsigned int tileSmem;
+
+  unsigned int tile = getDynamicTileId(tileCounter, &tileSmem);
+  IndexType tileSize = hipBlockDim_x * THC_COMPACT_ITEMS_PER_THREAD;
+  IndexType tileStart = (IndexType) tile * tileSize;
+
+  if (tileStart >= totalElements) {
+    return;
+  }
+
+  bool flags[THC_COMPACT_ITEMS_PER_THREAD];
+  IndexType writeIndex[THC_COMPACT_ITEMS_PER_THREAD];
+
+#pragma unroll
+  for (int item = 0; item < THC_COMPACT_ITEMS_PER_THREAD; ++item) {
+    IndexType linearIndex =
+      tileStart + item * hipBlockDim_x + hipThreadIdx_x;
+
+    flags[item] = (linearIndex < totalElements) &&
+      THCNumerics<T>::ne(
+        src.data[IndexToOffset<T, IndexType, SrcDims>::get(linearIndex, src)],
+        ScalarConvert<int, T>::to(0));
+  }
+
+  compactTileWriteIndices<IndexType>(
+    flags, writeIndex, tile, tileStart + tileSize >= totalElements,
+    tileStatus, count);
+
+  int dims = sizes.dims;
+
+#pragma unroll
+  for (int item = 0; item < THC_COMPACT_ITEMS_PER_THREAD; ++item) {
+    if (flags[item]) {
+      IndexType linearIndex =
+        tileStart + item * hipBlockDim_x + hipThreadIdx_x;
+      long* row = &out[(ptrdiff_t) writeIndex[item] * dims];
+
+      for (int d = dims - 1; d >= 0; --d) {
+        row[d] = (long) (linearIndex % sizes.sizes[d]) + TH_INDEX_BASE;
+        linearIndex /= sizes.sizes[d];
+      }
+    }
+  }
+}
+
 #endif // THC_TENSOR_MASKED_CUH
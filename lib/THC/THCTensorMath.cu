@@ -3,8 +3,10 @@
 #include "THCTensorCopy.h"
 #include "THCApply.cuh"
 #include "THCNumerics.cuh"
+#include "THCFill.cuh"
 
 #include <cfloat>
+#include <algorithm>
 
 template <typename T>
 struct TensorFillOp {
@@ -15,5 +17,70 @@ struct TensorFillOp {
   const T val;
 };
 
+// Most parts catArray and splitArray copy per launch, one per grid row
+#define THC_CAT_MAX_PARTS_PER_LAUNCH 65535
+#define THC_CAT_THREADS 256
+
+// One contiguous part of a concatenation along some dimension: every row of
+// `rowLength` elements of the part sits at `offset` in a row of the whole
+template <typename T, typename IndexType>
+struct THCCatPart {
+  T *data;
+  IndexType offset;
+  IndexType rowLength;
+  IndexType nElement;
+};
+
+// Copies every part into (or, for Split, out of) the contiguous `whole`;
+// hipBlockIdx_y picks the part
+template <typename T, typename IndexType, bool Split>
+__global__ void
+catArrayBatchedCopy(T *whole, const THCCatPart<T, IndexType> *parts, IndexType wholeRowLength)
+{
+  const THCCatPart<T, IndexType> part = parts[hipBlockIdx_y];
+  for (IndexType linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < part.nElement;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    IndexType row = linearIndex / part.rowLength;
+    IndexType wholeOffset =
+      row * wholeRowLength + part.offset + linearIndex % part.rowLength;
+    if (Split) {
+      part.data[linearIndex] = whole[wholeOffset];
+    } else {
+      whole[wholeOffset] = part.data[linearIndex];
+    }
+  }
+}
+
+// Uploads the descriptors of `numParts` parts and copies them all, with
+// one launch per THC_CAT_MAX_PARTS_PER_LAUNCH parts
+template <typename T, typename IndexType, bool Split>
+void THC_catArrayBatched(THCState *state, T *whole, IndexType wholeRowLength,
+                         const THCCatPart<T, IndexType> *hostParts, int numParts,
+                         IndexType maxElements)
+{
+  size_t bytes = numParts * sizeof(THCCatPart<T, IndexType>);
+  THCCatPart<T, IndexType> *parts;
+  THCudaCheck(THCudaMalloc(state, (void**) &parts, bytes));
+  hipStream_t stream = THCState_getCurrentStream(state);
+  THCudaCheck(hipMemcpyAsync(parts, hostParts, bytes, hipMemcpyHostToDevice, stream));
+
+  // enough blocks per part for the largest one to fill the device when
+  // there are few parts, a single block each when there are many
+  int mpc = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
+  long blocksPerPart = std::min(THCCeilDiv((long) maxElements, (long) THC_CAT_THREADS),
+                                std::max(THCCeilDiv((long) mpc * 8, (long) numParts), 1L));
+  for (int first = 0; first < numParts; first += THC_CAT_MAX_PARTS_PER_LAUNCH) {
+    int count = std::min(numParts - first, THC_CAT_MAX_PARTS_PER_LAUNCH);
+    dim3 grid(blocksPerPart, count);
+    hipLaunchKernelGGL(
+      (catArrayBatchedCopy<T, IndexType, Split>), grid, dim3(THC_CAT_THREADS), 0, stream,
+      whole, parts + first, wholeRowLength);
+    THCudaCheck(hipGetLastError());
+  }
+
+  THCudaCheck(THCudaFree(state, parts));
+}
+
 #include "generic/THCTensorMath.cu"
 #include "THCGenerateAllTypes.h"
@@ -37,6 +37,37 @@
 #include "generic/THCTensorSort.h"
 #include "THCGenerateAllTypes.h"
 
+/* Largest matrices the batched factorizations and solves take */
+#define THC_LINALG_MAX_N 64
+
+#include "generic/THCTensorMathLinalg.h"
+#include "THCGenerateFloatTypes.h"
+
+/* Elementwise expressions are programs of a stack machine, one int per
+   instruction: the opcode, plus the index of the constant << 8 for CONST.
+   X, Y and Z push the elements of the operands, CONST a constant; the other
+   instructions pop their arguments (SELECT: condition, then, else) and push
+   the result. Comparisons and logic give 1 or 0. */
+#define THC_EXPR_MAX_CODE 128
+#define THC_EXPR_MAX_CONSTANTS 32
+#define THC_EXPR_MAX_STACK 16
+
+#define THC_EXPR_OPCODES(_)                                             \
+  _(X) _(Y) _(Z) _(CONST)                                               \
+  _(NEG) _(NOT) _(ABS) _(EXP) _(LOG) _(LOG1P) _(SQRT) _(RSQRT)          \
+  _(SIN) _(COS) _(TAN) _(TANH) _(SIGMOID) _(FLOOR) _(CEIL) _(ROUND)     \
+  _(TRUNC)                                                              \
+  _(ADD) _(SUB) _(MUL) _(DIV) _(MOD) _(POW) _(MIN) _(MAX)               \
+  _(LT) _(LE) _(GT) _(GE) _(EQ) _(NE) _(AND) _(OR)                      \
+  _(SELECT)
+
+#define THC_EXPR_ENUM(name) THC_EXPR_##name,
+enum THCExprOpcode { THC_EXPR_OPCODES(THC_EXPR_ENUM) THC_EXPR_NUM_OPCODES };
+#undef THC_EXPR_ENUM
+
+#include "generic/THCTensorMathExpr.h"
+#include "THCGenerateAllTypes.h"
+
 THC_API void THCudaTensor_tril(THCState *state, THCudaTensor *self, THCudaTensor *src, long k);
 THC_API void THCudaTensor_triu(THCState *state, THCudaTensor *self, THCudaTensor *src, long k);
 THC_API void THCudaTensor_diag(THCState *state, THCudaTensor *self, THCudaTensor *src, long k);
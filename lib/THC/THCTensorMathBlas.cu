@@ -4,5 +4,8 @@
 #include "THCTensorCopy.h"
 #include "THCNumerics.cuh"
 
+// Largest batch of products addbmm stages in a temporary for one batched GEMM
+#define THC_ADDBMM_BATCHED_MAX_ELEMENTS (1L << 24)
+
 #include "generic/THCTensorMathBlas.cu"
 #include "THCGenerateAllTypes.h"
@@ -0,0 +1,176 @@
+#include "THCTensorMath.h"
+#include "THCGeneral.h"
+#include "THCTensorCopy.h"
+#include "THCApply.cuh"
+#include "THCNumerics.cuh"
+#include <cstring>
+
+// Elementwise expressions, run by a small stack machine. The program is
+// passed by value in the kernel arguments, so every thread of a launch
+// reads the same instruction at the same time and the dispatch does not
+// diverge; the stack lives in registers or local memory. Both branches of
+// SELECT are evaluated.
+
+struct THCExprProgram {
+  int length;
+  int code[THC_EXPR_MAX_CODE];
+  double constants[THC_EXPR_MAX_CONSTANTS];
+};
+
+// Type the programs of a tensor type are evaluated in
+template <typename T>
+struct THCExprCompute { typedef float type; };
+template <>
+struct THCExprCompute<double> { typedef double type; };
+template <>
+struct THCExprCompute<int> { typedef double type; };
+template <>
+struct THCExprCompute<long> { typedef double type; };
+
+// Checks a program against the stack discipline and copies it into p.
+static void THCExpr_prepare(THCExprProgram *p, const int *code, int length,
+                            const double *constants, int numConstants, int inputs)
+{
+  THArgCheck(length > 0 && length <= THC_EXPR_MAX_CODE, 6,
+             "expression programs have 1 to %d instructions", THC_EXPR_MAX_CODE);
+  THArgCheck(numConstants >= 0 && numConstants <= THC_EXPR_MAX_CONSTANTS, 8,
+             "expression programs have at most %d constants", THC_EXPR_MAX_CONSTANTS);
+
+  int depth = 0;
+  for (int pc = 0; pc < length; ++pc) {
+    int op = code[pc] & 0xff;
+    int arg = code[pc] >> 8;
+    int pops, pushes = 1;
+    if (op <= THC_EXPR_CONST) {
+      pops = 0;
+      if (op == THC_EXPR_Y || op == THC_EXPR_Z) {
+        THArgCheck(op - THC_EXPR_X < inputs, 5,
+                   "the expression uses more operands than it is given");
+      } else if (op == THC_EXPR_CONST) {
+        THArgCheck(arg >= 0 && arg < numConstants, 5,
+                   "invalid constant %d at instruction %d", arg, pc);
+      }
+    } else if (op < THC_EXPR_ADD) {
+      pops = 1;
+    } else if (op < THC_EXPR_SELECT) {
+      pops = 2;
+    } else if (op == THC_EXPR_SELECT) {
+      pops = 3;
+    } else {
+      THArgCheck(false, 5, "invalid opcode %d at instruction %d", op, pc);
+    }
+    THArgCheck(depth >= pops, 5, "stack underflow at instruction %d", pc);
+    depth += pushes - pops;
+    THArgCheck(depth <= THC_EXPR_MAX_STACK, 5,
+               "expressions need at most %d stack entries", THC_EXPR_MAX_STACK);
+  }
+  THArgCheck(depth == 1, 5, "the expression leaves %d values on the stack", depth);
+
+  p->length = length;
+  memcpy(p->code, code, length * sizeof(int));
+  memcpy(p->constants, constants, numConstants * sizeof(double));
+}
+
+template <typename T>
+__device__ __forceinline__ T
+THCExpr_eval(const THCExprProgram &p, T x, T y, T z)
+{
+  typedef THCNumerics<T> N;
+  const T one = ScalarConvert<int, T>::to(1);
+  const T zero = ScalarConvert<int, T>::to(0);
+  T stack[THC_EXPR_MAX_STACK];
+  int top = -1;
+
+  for (int pc = 0; pc < p.length; ++pc) {
+    int op = p.code[pc] & 0xff;
+    if (op == THC_EXPR_X) {
+      stack[++top] = x;
+    } else if (op == THC_EXPR_Y) {
+      stack[++top] = y;
+    } else if (op == THC_EXPR_Z) {
+      stack[++top] = z;
+    } else if (op == THC_EXPR_CONST) {
+      stack[++top] = (T) p.constants[p.code[pc] >> 8];
+    } else if (op < THC_EXPR_ADD) {
+      T a = stack[top];
+      T r;
+      switch (op) {
+        case THC_EXPR_NEG:     r = -a; break;
+        case THC_EXPR_NOT:     r = a == zero ? one : zero; break;
+        case THC_EXPR_ABS:     r = N::abs(a); break;
+        case THC_EXPR_EXP:     r = N::exp(a); break;
+        case THC_EXPR_LOG:     r = N::log(a); break;
+        case THC_EXPR_LOG1P:   r = N::log1p(a); break;
+        case THC_EXPR_SQRT:    r = N::sqrt(a); break;
+        case THC_EXPR_RSQRT:   r = N::rsqrt(a); break;
+        case THC_EXPR_SIN:     r = N::sin(a); break;
+        case THC_EXPR_COS:     r = N::cos(a); break;
+        case THC_EXPR_TAN:     r = N::tan(a); break;
+        case THC_EXPR_TANH:    r = N::tanh(a); break;
+        case THC_EXPR_SIGMOID: r = one / (one + N::exp(-a)); break;
+        case THC_EXPR_FLOOR:   r = N::floor(a); break;
+        case THC_EXPR_CEIL:    r = N::ceil(a); break;
+        case THC_EXPR_ROUND:   r = N::round(a); break;
+        default:               r = N::trunc(a); break;
+      }
+      stack[top] = r;
+    } else if (op < THC_EXPR_SELECT) {
+      T b = stack[top--];
+      T a = stack[top];
+      T r;
+      switch (op) {
+        case THC_EXPR_ADD: r = a + b; break;
+        case THC_EXPR_SUB: r = a - b; break;
+        case THC_EXPR_MUL: r = a * b; break;
+        case THC_EXPR_DIV: r = a / b; break;
+        // as Lua's %: the result has the sign of b
+        case THC_EXPR_MOD: r = a - N::floor(a / b) * b; break;
+        case THC_EXPR_POW: r = N::pow(a, b); break;
+        case THC_EXPR_MIN: r = a < b ? a : b; break;
+        case THC_EXPR_MAX: r = a > b ? a : b; break;
+        case THC_EXPR_LT:  r = a < b ? one : zero; break;
+        case THC_EXPR_LE:  r = a <= b ? one : zero; break;
+        case THC_EXPR_GT:  r = a > b ? one : zero; break;
+        case THC_EXPR_GE:  r = a >= b ? one : zero; break;
+        case THC_EXPR_EQ:  r = a == b ? one : zero; break;
+        case THC_EXPR_NE:  r = a != b ? one : zero; break;
+        case THC_EXPR_AND: r = a != zero && b != zero ? one : zero; break;
+        default:           r = a != zero || b != zero ? one : zero; break;
+      }
+      stack[top] = r;
+    } else {
+      T otherwise = stack[top--];
+      T then = stack[top--];
+      stack[top] = stack[top] != zero ? then : otherwise;
+    }
+  }
+  return stack[0];
+}
+
+template <typename Real, typename T>
+struct THCExprOp {
+  THCExprOp(const THCExprProgram &program) : program(program) {}
+
+  __device__ __forceinline__ void operator()(Real *out) {
+    T x = ScalarConvert<Real, T>::to(*out);
+    *out = ScalarConvert<T, Real>::to(THCExpr_eval<T>(program, x, x, x));
+  }
+
+  __device__ __forceinline__ void operator()(Real *out, Real *a) {
+    T x = ScalarConvert<Real, T>::to(*out);
+    T y = ScalarConvert<Real, T>::to(*a);
+    *out = ScalarConvert<T, Real>::to(THCExpr_eval<T>(program, x, y, y));
+  }
+
+  __device__ __forceinline__ void operator()(Real *out, Real *a, Real *b) {
+    T x = ScalarConvert<Real, T>::to(*out);
+    T y = ScalarConvert<Real, T>::to(*a);
+    T z = ScalarConvert<Real, T>::to(*b);
+    *out = ScalarConvert<T, Real>::to(THCExpr_eval<T>(program, x, y, z));
+  }
+
+  const THCExprProgram program;
+};
+
+#include "generic/THCTensorMathExpr.cu"
+#include "THCGenerateAllTypes.h"
@@ -0,0 +1,324 @@
+#include "THCTensorMath.h"
+#include "THCGeneral.h"
+#include "THCTensorCopy.h"
+#include "THCDeviceUtils.cuh"
+#include "THCNumerics.cuh"
+#include <algorithm>
+
+// Batched small-matrix factorizations and solves. Each matrix is staged in
+// shared memory and handled by one slice of a block, hipBlockDim_x threads
+// wide; the hipBlockDim_y slices of a block take consecutive matrices of the
+// batch, so that a block stays full when the matrices are tiny. Every slice
+// runs the same number of steps, so block-wide barriers are safe, and a
+// slice past the end of the batch only skips its loads and stores.
+
+#define THC_LINALG_THREADS 256
+// Shared memory a block stages its matrices in
+#define THC_LINALG_SMEM_BYTES (32 * 1024)
+#define THC_LINALG_MAX_SLICES (THC_LINALG_THREADS / 32)
+// Right-hand side columns solved per pass
+#define THC_LINALG_MAX_RHS 16
+
+// One triangular solve in a sequence: op(A) X = B with op(A) = A or A^T
+struct THCTriangularStep {
+  bool lower;
+  bool trans;
+  bool unit;
+};
+
+template <typename T>
+__global__ void
+batchedLUKernel(const T *input, T *output, int *pivots, int *info, long batch, int n)
+{
+  HIP_DYNAMIC_SHARED( char, smemChar)
+  __shared__ int pivotRow[THC_LINALG_MAX_SLICES];
+  __shared__ int singular[THC_LINALG_MAX_SLICES];
+
+  int slice = hipThreadIdx_y;
+  int tid = hipThreadIdx_x;
+  int nthreads = hipBlockDim_x;
+  int nn = n * n;
+  T *a = (T*) smemChar + slice * nn;
+
+  for (long base = (long) hipBlockIdx_x * hipBlockDim_y; base < batch;
+       base += (long) hipGridDim_x * hipBlockDim_y) {
+    long m = base + slice;
+    bool active = m < batch;
+
+    if (active) {
+      for (int i = tid; i < nn; i += nthreads) {
+        a[i] = input[m * nn + i];
+      }
+    }
+    if (tid == 0) {
+      singular[slice] = 0;
+    }
+    __syncthreads();
+
+    for (int k = 0; k < n; ++k) {
+      // a serial search is as fast as a reduction for n <= 64
+      if (tid == 0) {
+        int p = k;
+        T best = THCNumerics<T>::abs(a[k * n + k]);
+        for (int i = k + 1; i < n; ++i) {
+          T v = THCNumerics<T>::abs(a[i * n + k]);
+          if (v > best) {
+            best = v;
+            p = i;
+          }
+        }
+        pivotRow[slice] = p;
+        if (best == ScalarConvert<int, T>::to(0) && singular[slice] == 0) {
+          singular[slice] = k + 1;
+        }
+        if (active) {
+          pivots[m * n + k] = p + TH_INDEX_BASE;
+        }
+      }
+      __syncthreads();
+
+      int p = pivotRow[slice];
+      if (p != k) {
+        for (int j = tid; j < n; j += nthreads) {
+          T tmp = a[k * n + j];
+          a[k * n + j] = a[p * n + j];
+          a[p * n + j] = tmp;
+        }
+      }
+      __syncthreads();
+
+      T diag = a[k * n + k];
+      if (diag != ScalarConvert<int, T>::to(0)) {
+        for (int i = k + 1 + tid; i < n; i += nthreads) {
+          a[i * n + k] /= diag;
+        }
+      }
+      __syncthreads();
+
+      int rest = n - k - 1;
+      for (int e = tid; e < rest * rest; e += nthreads) {
+        int i = k + 1 + e / rest;
+        int j = k + 1 + e % rest;
+        a[i * n + j] -= a[i * n + k] * a[k * n + j];
+      }
+      __syncthreads();
+    }
+
+    if (active) {
+      for (int i = tid; i < nn; i += nthreads) {
+        output[m * nn + i] = a[i];
+      }
+      if (tid == 0) {
+        info[m] = singular[slice];
+      }
+    }
+    __syncthreads();
+  }
+}
+
+// Right-looking Cholesky on the lower triangle; an upper factor is computed
+// as the transpose of the lower one
+template <typename T>
+__global__ void
+batchedCholeskyKernel(const T *input, T *output, int *info, long batch, int n, bool upper)
+{
+  HIP_DYNAMIC_SHARED( char, smemChar)
+  __shared__ int singular[THC_LINALG_MAX_SLICES];
+
+  int slice = hipThreadIdx_y;
+  int tid = hipThreadIdx_x;
+  int nthreads = hipBlockDim_x;
+  int nn = n * n;
+  T *a = (T*) smemChar + slice * nn;
+
+  for (long base = (long) hipBlockIdx_x * hipBlockDim_y; base < batch;
+       base += (long) hipGridDim_x * hipBlockDim_y) {
+    long m = base + slice;
+    bool active = m < batch;
+
+    if (active) {
+      for (int e = tid; e < nn; e += nthreads) {
+        int i = e / n;
+        int j = e % n;
+        a[e] = upper ? input[m * nn + j * n + i] : input[m * nn + e];
+      }
+    }
+    if (tid == 0) {
+      singular[slice] = 0;
+    }
+    __syncthreads();
+
+    for (int k = 0; k < n; ++k) {
+      if (tid == 0) {
+        T d = a[k * n + k];
+        if (!(d > ScalarConvert<int, T>::to(0)) && singular[slice] == 0) {
+          singular[slice] = k + 1;
+        }
+        a[k * n + k] = THCNumerics<T>::sqrt(d);
+      }
+      __syncthreads();
+
+      T diag = a[k * n + k];
+      for (int i = k + 1 + tid; i < n; i += nthreads) {
+        a[i * n + k] /= diag;
+      }
+      __syncthreads();
+
+      int rest = n - k - 1;
+      for (int e = tid; e < rest * rest; e += nthreads) {
+        int i = k + 1 + e / rest;
+        int j = k + 1 + e % rest;
+        if (j <= i) {
+          a[i * n + j] -= a[i * n + k] * a[j * n + k];
+        }
+      }
+      __syncthreads();
+    }
+
+    if (active) {
+      for (int e = tid; e < nn; e += nthreads) {
+        int i = e / n;
+        int j = e % n;
+        T zero = ScalarConvert<int, T>::to(0);
+        if (upper) {
+          output[m * nn + e] = j >= i ? a[j * n + i] : zero;
+        } else {
+          output[m * nn + e] = j <= i ? a[e] : zero;
+        }
+      }
+      if (tid == 0) {
+        info[m] = singular[slice];
+      }
+    }
+    __syncthreads();
+  }
+}
+
+// Solves op(A) X = B in place for the w columns of b, by columns of op(A):
+// x_k is final once row k is divided by the diagonal, and is then
+// eliminated from the rows still to solve
+template <typename T>
+__device__ void
+sharedTriangularSolve(const T *a, T *b, int n, int w, THCTriangularStep step,
+                      int tid, int nthreads)
+{
+  bool opLower = step.lower != step.trans;
+  for (int s = 0; s < n; ++s) {
+    int k = opLower ? s : n - 1 - s;
+    if (!step.unit) {
+      T diag = a[k * n + k];
+      for (int r = tid; r < w; r += nthreads) {
+        b[k * w + r] /= diag;
+      }
+    }
+    __syncthreads();
+
+    int rest = n - 1 - s;
+    for (int e = tid; e < rest * w; e += nthreads) {
+      int i = opLower ? k + 1 + e / w : e / w;
+      int r = e % w;
+      T aik = step.trans ? a[k * n + i] : a[i * n + k];
+      b[i * w + r] -= aik * b[k * w + r];
+    }
+    __syncthreads();
+  }
+}
+
+// X = op2(A)^-1 op1(A)^-1 P^T B: the row swaps of `pivots` (may be NULL)
+// then up to two triangular solves against the same matrix
+template <typename T>
+__global__ void
+batchedSolveKernel(const T *a, const T *b, T *x, const int *pivots,
+                   long batch, int n, int nrhs,
+                   int nsteps, THCTriangularStep step1, THCTriangularStep step2)
+{
+  HIP_DYNAMIC_SHARED( char, smemChar)
+
+  int slice = hipThreadIdx_y;
+  int tid = hipThreadIdx_x;
+  int nthreads = hipBlockDim_x;
+  int nn = n * n;
+  int tile = nrhs < THC_LINALG_MAX_RHS ? nrhs : THC_LINALG_MAX_RHS;
+  T *sa = (T*) smemChar + slice * (nn + n * tile);
+  T *sb = sa + nn;
+
+  for (long base = (long) hipBlockIdx_x * hipBlockDim_y; base < batch;
+       base += (long) hipGridDim_x * hipBlockDim_y) {
+    long m = base + slice;
+    bool active = m < batch;
+
+    if (active) {
+      for (int i = tid; i < nn; i += nthreads) {
+        sa[i] = a[m * nn + i];
+      }
+    }
+
+    for (int c0 = 0; c0 < nrhs; c0 += tile) {
+      int w = nrhs - c0 < tile ? nrhs - c0 : tile;
+      if (active) {
+        for (int e = tid; e < n * w; e += nthreads) {
+          sb[e] = b[(m * n + e / w) * nrhs + c0 + e % w];
+        }
+      }
+      __syncthreads();
+
+      if (pivots && active) {
+        // each thread swaps whole columns, in the order of the factorization
+        for (int r = tid; r < w; r += nthreads) {
+          for (int k = 0; k < n; ++k) {
+            int p = pivots[m * n + k] - TH_INDEX_BASE;
+            if (p != k) {
+              T tmp = sb[k * w + r];
+              sb[k * w + r] = sb[p * w + r];
+              sb[p * w + r] = tmp;
+            }
+          }
+        }
+      }
+      __syncthreads();
+
+      sharedTriangularSolve<T>(sa, sb, n, w, step1, tid, nthreads);
+      if (nsteps > 1) {
+        sharedTriangularSolve<T>(sa, sb, n, w, step2, tid, nthreads);
+      }
+
+      if (active) {
+        for (int e = tid; e < n * w; e += nthreads) {
+          x[(m * n + e / w) * nrhs + c0 + e % w] = sb[e];
+        }
+      }
+      __syncthreads();
+    }
+  }
+}
+
+// Threads per matrix and matrices per block for matrices of n rows taking
+// `sliceBytes` of shared memory each
+static void THCLinalg_launchConfig(THCState *state, long batch, int n, size_t sliceBytes,
+                                   dim3& grid, dim3& block, size_t& smem)
+{
+  int threadsPerMatrix = n > 16 ? 64 : 32;
+  long slices = std::min((long) (THC_LINALG_THREADS / threadsPerMatrix),
+                         (long) (THC_LINALG_SMEM_BYTES / sliceBytes));
+  slices = std::max(slices, 1L);
+  block = dim3(threadsPerMatrix, slices);
+  grid = dim3(std::min(THCCeilDiv(batch, slices), 65535L));
+  smem = slices * sliceBytes;
+}
+
+// Hands `info` over to rinfo_ when the caller asked for it; otherwise
+// returns the worst status of the batch, which synchronizes
+static int THCLinalg_finishInfo(THCState *state, THCudaIntTensor *info, THCudaIntTensor *rinfo_)
+{
+  if (rinfo_) {
+    THCudaIntTensor_freeCopyTo(state, info, rinfo_);
+    return 0;
+  }
+  int worst = THCudaIntTensor_nElement(state, info) > 0 ?
+    THCudaIntTensor_maxall(state, info) : 0;
+  THCudaIntTensor_free(state, info);
+  return worst;
+}
+
+#include "generic/THCTensorMathLinalg.cu"
+#include "THCGenerateFloatTypes.h"
@@ -5,6 +5,10 @@
 #include "THCTensorCopy.h"
 #include "THCTensorMath.h"
 #include "THCReduceApplyUtils.cuh"
+#include "THCTensorRandom.cuh"
+#include "THCTensorTopK.h"
+#include <cfloat>
+#include <cmath>
 #ifdef CURAND_PATH
   #include <curand.h>
   #include <curand_kernel.h>
@@ -98,11 +102,13 @@ void THCRandom_init(THCState* state, int devices, int current_device)
 {
   THCRNGState* rng_state = THCState_getRngState(state);
   rng_state->num_devices = devices;
+  rng_state->type = THC_RNG_MTGP32;
   rng_state->gen = (Generator*)malloc(rng_state->num_devices * sizeof(Generator));
   for (int i = 0; i < rng_state->num_devices; ++i)
   {
     rng_state->gen[i].initf = 0;
     rng_state->gen[i].initial_seed = 0;
+    rng_state->gen[i].philox_offset = 0;
 #ifdef CURAND_PATH
     rng_state->gen[i].gen_states = NULL;
     rng_state->gen[i].kernel_params = NULL;
@@ -129,6 +135,7 @@ void THCRandom_shutdown(THCState* state)
 static void THCRandom_manualSeedGen(THCState* state, Generator* gen, unsigned long seed)
 {
   gen->initial_seed = seed;
+  gen->philox_offset = 0;
   createGeneratorState(state, gen, seed);
   gen->initf = 1;
 }
@@ -202,10 +209,34 @@ unsigned long THCRandom_initialSeed(THCState* state)
   return THCRandom_getGenerator(state)->initial_seed;
 }
 
+void THCRandom_setGeneratorType(THCState* state, int type)
+{
+  THArgCheck(type == THC_RNG_MTGP32 || type == THC_RNG_PHILOX, 2,
+             "unknown generator type");
+  THCState_getRngState(state)->type = type;
+}
+
+int THCRandom_getGeneratorType(THCState* state)
+{
+  return THCState_getRngState(state)->type;
+}
+
+// The Philox state is only the seed and the counter offset.
+static const size_t philox_state_size = 2 * sizeof(unsigned long);
+
 void THCRandom_getRNGState(THCState* state, THByteTensor *rng_state)
 {
   Generator* gen = THCRandom_getGenerator(state);
 
+  if (THCRandom_getGeneratorType(state) == THC_RNG_PHILOX) {
+    THByteTensor_resize1d(rng_state, philox_state_size);
+    THArgCheck(THByteTensor_isContiguous(rng_state), 1, "RNG state must be contiguous");
+    unsigned char* data = THByteTensor_data(rng_state);
+    memcpy(data, &gen->initial_seed, sizeof(unsigned long));
+    memcpy(data + sizeof(unsigned long), &gen->philox_offset, sizeof(unsigned long));
+    return;
+  }
+
   // The RNG state comprises the MTPG32 states and the seed.
 #ifdef CURAND_PATH
   static const size_t states_size = MAX_NUM_BLOCKS * sizeof(curandStateMtgp32);
@@ -240,6 +271,15 @@ void THCRandom_setRNGState(THCState* state, THByteTensor *rng_state)
 {
   Generator* gen = THCRandom_getGenerator(state);
 
+  if (THCRandom_getGeneratorType(state) == THC_RNG_PHILOX) {
+    THArgCheck(THByteTensor_nElement(rng_state) == philox_state_size, 1, "RNG state is wrong size");
+    THArgCheck(THByteTensor_isContiguous(rng_state), 1, "RNG state must be contiguous");
+    unsigned char* data = THByteTensor_data(rng_state);
+    memcpy(&gen->initial_seed, data, sizeof(unsigned long));
+    memcpy(&gen->philox_offset, data + sizeof(unsigned long), sizeof(unsigned long));
+    return;
+  }
+
 #ifdef CURAND_PATH
   static const size_t states_size = MAX_NUM_BLOCKS * sizeof(curandStateMtgp32);
 #else
@@ -326,88 +366,6 @@ GENERATE_KERNEL1(generate_exponential, double lambda, curand_uniform, (float)(-1
 GENERATE_KERNEL2(generate_cauchy, double median, double sigma, curand_uniform, (float)(median + sigma * tan(M_PI*(x-0.5))))
 #else
 
-// Adding All HC based constructors
-
-class user_uniform_functor {
-  double _a;
-  double _b;
-public:
-  __host__ __device__
-  user_uniform_functor(double a, double b) : _a(a), _b(b) {}
-
-  __host__ __device__
-  double operator()(float x) const { return x * (_b - _a) + _a; }
-};
-
-
-class user_bernoulli_functor {
-  double _p;
-public:
-  __host__ __device__
-  explicit
-  user_bernoulli_functor(double p) : _p(p) {}
-
-  __host__ __device__
-  double operator()(float x) const { return static_cast<double>(x) <= _p; }
-};
-
-
-class user_normal_functor {
-  double _stdv;
-  double _mean;
-public:
-  __host__ __device__
-  user_normal_functor(double stdv, double mean) : _stdv(stdv), _mean(mean) {}
-
-  __host__ __device__
-  double operator()(float x) const { return (x * _stdv) + _mean; }
-};
-
-class user_geometric_functor {
-  double _p;
-public:
-  __host__ __device__
-  explicit
-  user_geometric_functor(double p) : _p(p) {}
-
-  __device__
-  double operator()(float x) const
-  {
-      return (log((double)(1 - x)) / log(_p)) + 1;
-  }
-};
-
-class user_exponential_functor {
-  double _lambda;
-public:
-  __host__ __device__
-  explicit
-  user_exponential_functor(double lambda) : _lambda(lambda) {}
-
-  __device__
-  double operator()(float x) const
-  {
-    return (double)(-1. / _lambda * log((double)(1 - x)));
-  }
-};
-
-class user_cauchy_functor {
-  double _median;
-  double _sigma;
-public:
-  __host__ __device__
-  user_cauchy_functor(double median, double sigma)
-      : _median(median), _sigma(sigma)
-  {}
-
-  __device__
-  double operator()(float x) const
-  {
-    return (double)(_median + _sigma * tan((double)M_PI * (x - 0.5)));
-  }
-};
-
-
 GENERATE_KERNEL2(generate_uniform, double a, double b, user_uniform, user_uniform_functor(a, b))
 GENERATE_KERNEL1(generate_bernoulli, double p, user_uniform, user_bernoulli_functor(p))
 GENERATE_KERNEL2(generate_normal, double mean, double stdv, user_normal, user_normal_functor(stdv,  mean))
@@ -442,12 +400,41 @@ void generate_log_normal(THCState* state, HipRandStateMtgp32 *rngstate, int size
 }
 #endif
 
+static void THCRandom_philoxHost(THFloatTensor *result, unsigned long seed,
+                                 unsigned long offset, bool normal)
+{
+  THArgCheck(THFloatTensor_isContiguous(result), 1, "result must be contiguous");
+  ptrdiff_t size = THFloatTensor_nElement(result);
+  float *data = THFloatTensor_data(result);
+
+  for (ptrdiff_t block = 0; block * 4 < size; ++block) {
+    float x[4];
+    if (normal) {
+      philoxNormal4(seed, offset + block, x);
+    } else {
+      philoxUniform4(seed, offset + block, x);
+    }
+    for (int i = 0; i < 4 && block * 4 + i < size; ++i) {
+      data[block * 4 + i] = x[i];
+    }
+  }
+}
+
+void THCRandom_philoxUniformHost(THFloatTensor *result, unsigned long seed, unsigned long offset)
+{
+  THCRandom_philoxHost(result, seed, offset, false);
+}
+
+void THCRandom_philoxNormalHost(THFloatTensor *result, unsigned long seed, unsigned long offset)
+{
+  THCRandom_philoxHost(result, seed, offset, true);
+}
+
 #define NUM_BLOCKS min((int)THCCeilDiv(size, (ptrdiff_t) BLOCK_SIZE), MAX_NUM_BLOCKS)
-THC_API void THCudaTensor_uniform(THCState* state, THCudaTensor *self_, double a, double b)
+/* MTGP fills a contiguous float buffer; see generic/THCTensorRandom.cu */
+static void THCRandom_mtgpUniform(THCState* state, THCudaTensor *self, double a, double b)
 {
-  THAssert(THCudaTensor_checkGPU(state, 1, self_));
   Generator* gen = THCRandom_getGenerator(state);
-  THCudaTensor *self = THCudaTensor_newContiguous(state, self_);
   ptrdiff_t size = THCudaTensor_nElement(state, self);
   float *data = THCudaTensor_data(state, self);
   #ifdef CURAND_PATH
@@ -465,15 +452,11 @@ THC_API void THCudaTensor_uniform(THCState* state, THCudaTensor *self_, double a
   #else
     generate_uniform(state, gen->h_gen_states, size, data, a, b);
   #endif
+}
 
-  THCudaTensor_freeCopyTo(state, self, self_);
-};
-
-THC_API void THCudaTensor_bernoulli(THCState* state, THCudaTensor *self_, double p)
+static void THCRandom_mtgpBernoulli(THCState* state, THCudaTensor *self, double p)
 {
-  THAssert(THCudaTensor_checkGPU(state, 1, self_));
   Generator* gen = THCRandom_getGenerator(state);
-  THCudaTensor *self = THCudaTensor_newContiguous(state, self_);
   ptrdiff_t size = THCudaTensor_nElement(state, self);
   float *data = THCudaTensor_data(state, self);
   #ifdef CURAND_PATH
@@ -490,14 +473,11 @@ THC_API void THCudaTensor_bernoulli(THCState* state, THCudaTensor *self_, double
   #else
   generate_bernoulli(state, gen->h_gen_states, size, data, p);
   #endif
-  THCudaTensor_freeCopyTo(state, self, self_);
-};
+}
 
-THC_API void THCudaTensor_normal(THCState* state, THCudaTensor *self_, double mean, double stdv)
+static void THCRandom_mtgpNormal(THCState* state, THCudaTensor *self, double mean, double stdv)
 {
-  THAssert(THCudaTensor_checkGPU(state, 1, self_));
   Generator* gen = THCRandom_getGenerator(state);
-  THCudaTensor *self = THCudaTensor_newContiguous(state, self_);
   ptrdiff_t size = THCudaTensor_nElement(state, self);
   float *data = THCudaTensor_data(state, self);
   #ifdef CURAND_PATH
@@ -515,16 +495,11 @@ THC_API void THCudaTensor_normal(THCState* state, THCudaTensor *self_, double me
   #else
   generate_normal(state, gen->h_gen_states, size, data, mean, stdv);
   #endif
+}
 
-  THCudaTensor_freeCopyTo(state, self, self_);
-};
-
-THC_API void THCudaTensor_logNormal(THCState* state, THCudaTensor *self_, double mean, double stdv)
+static void THCRandom_mtgpLogNormal(THCState* state, THCudaTensor *self, double mean, double stdv)
 {
-  THAssert(THCudaTensor_checkGPU(state, 1, self_));
   Generator* gen = THCRandom_getGenerator(state);
-
-  THCudaTensor *self = THCudaTensor_newContiguous(state, self_);
   ptrdiff_t size = THCudaTensor_nElement(state, self);
   float *data = THCudaTensor_data(state, self);
   #ifdef CURAND_PATH
@@ -542,15 +517,11 @@ THC_API void THCudaTensor_logNormal(THCState* state, THCudaTensor *self_, double
   #else
     generate_log_normal(state, gen->h_gen_states, size, data, mean, stdv);
   #endif
-  THCudaTensor_freeCopyTo(state, self, self_);
-};
+}
 
-THC_API void THCudaTensor_geometric(THCState* state, THCudaTensor *self_, double p)
+static void THCRandom_mtgpGeometric(THCState* state, THCudaTensor *self, double p)
 {
-  THAssert(THCudaTensor_checkGPU(state, 1, self_));
   Generator* gen = THCRandom_getGenerator(state);
-
-  THCudaTensor *self = THCudaTensor_newContiguous(state, self_);
   ptrdiff_t size = THCudaTensor_nElement(state, self);
   float *data = THCudaTensor_data(state, self);
   #ifdef CURAND_PATH
@@ -567,16 +538,11 @@ THC_API void THCudaTensor_geometric(THCState* state, THCudaTensor *self_, double
   #else
   generate_geometric(state, gen->h_gen_states, size, data, p);
   #endif
+}
 
-  THCudaTensor_freeCopyTo(state, self, self_);
-};
-
-THC_API void THCudaTensor_exponential(THCState* state, THCudaTensor *self_, double lambda)
+static void THCRandom_mtgpExponential(THCState* state, THCudaTensor *self, double lambda)
 {
-  THAssert(THCudaTensor_checkGPU(state, 1, self_));
   Generator* gen = THCRandom_getGenerator(state);
-
-  THCudaTensor *self = THCudaTensor_newContiguous(state, self_);
   ptrdiff_t size = THCudaTensor_nElement(state, self);
   float *data = THCudaTensor_data(state, self);
   #ifdef CURAND_PATH
@@ -593,16 +559,11 @@ THC_API void THCudaTensor_exponential(THCState* state, THCudaTensor *self_, doub
   #else
   generate_exponential(state, gen->h_gen_states, size, data, lambda);
   #endif
+}
 
-  THCudaTensor_freeCopyTo(state, self, self_);
-};
-
-THC_API void THCudaTensor_cauchy(THCState* state, THCudaTensor *self_, double median, double sigma)
+static void THCRandom_mtgpCauchy(THCState* state, THCudaTensor *self, double median, double sigma)
 {
-  THAssert(THCudaTensor_checkGPU(state, 1, self_));
   Generator* gen = THCRandom_getGenerator(state);
-
-  THCudaTensor *self = THCudaTensor_newContiguous(state, self_);
   ptrdiff_t size = THCudaTensor_nElement(state, self);
   float *data = THCudaTensor_data(state, self);
   #ifdef CURAND_PATH
@@ -620,98 +581,33 @@ THC_API void THCudaTensor_cauchy(THCState* state, THCudaTensor *self_, double me
   #else
   generate_cauchy(state, gen->h_gen_states, size, data, median, sigma);
   #endif
+}
 
-  THCudaTensor_freeCopyTo(state, self, self_);
-};
-
-__device__ int binarySearchForMultinomial(float* dist,
-                                          int size,
-                                          float val) {
-  int start = 0;
-  int end = size;
+// Index of the first element of the sorted `data` that is >= `val`
+// (`strict` = false) or > `val` (`strict` = true)
+__device__ long searchSortedDouble(const double* data, long size,
+                                   double val, bool strict) {
+  long start = 0;
+  long end = size;
 
   while (end - start > 0) {
-    int mid = start + (end - start) / 2;
+    long mid = start + (end - start) / 2;
 
-    float midVal = dist[mid];
-    if (midVal < val) {
+    double midVal = data[mid];
+    if (midVal < val || (strict && midVal == val)) {
       start = mid + 1;
     } else {
       end = mid;
     }
   }
 
-  if (start == size) {
-    // No probability mass or precision problems; just return the
-    // first element
-    start = 0;
-  }
-
   return start;
 }
 
-// Normalizes the L1 norm of every row to 1; used by multinomial
-__global__ void renormRowsL1(float* dist, long rows, long cols) {
-  HIP_DYNAMIC_SHARED( float, smem)
-
-  for (long row = hipBlockIdx_x; row < rows; row += hipGridDim_x) {
-    float sum = 0.0f;
-    for (long col = hipThreadIdx_x; col < cols; col += hipBlockDim_x) {
-      sum += dist[row * cols + col];
-    }
-
-   sum = reduceBlock(reinterpret_cast<float*>(smem),
-                      hipBlockDim_x,
-                      sum,
-    #if defined(THRUST_PATH)
-                      thrust::plus<float>(),
-    #else
-                      bolt::amp::plus<float>(),
-    #endif
-                      0.0f);
-    if (hipThreadIdx_x == 0) {
-      smem[0] = sum;
-    }
-    __syncthreads();
-
-    sum = smem[0];
-    if (sum > 0.0f) {
-      for (long col = hipThreadIdx_x; col < cols; col += hipBlockDim_x) {
-        dist[row * cols + col] /= sum;
-      }
-    }
-  }
-}
-
-void THCudaTensor_renormRows(struct THCState* state,
-                             THCudaTensor* t) {
-  THAssert(THCudaTensor_nDimension(state, t) == 2);
-  long rows = THCudaTensor_size(state, t, 0);
-  long cols = THCudaTensor_size(state, t, 1);
-
-  hipDeviceProp_t* props = THCState_getCurrentDeviceProperties(state);
-  THAssert(props != NULL);
-
-  int numSM = props->multiProcessorCount;
-  int maxThreads = props->maxThreadsPerBlock;
-
-  dim3 grid(rows < numSM * 4 ? rows : numSM * 4);
-  dim3 block(cols < maxThreads ? cols : maxThreads);
-
-  hipLaunchKernelGGL(
-    renormRowsL1,
-    dim3(grid),
-    dim3(block),
-    block.x * sizeof(float),
-    THCState_getCurrentStream(state),
-    THCudaTensor_data(state, t),
-    rows,
-    cols);
-}
-
 __global__
 void sampleMultinomialOnce(
-  float* dest, long distributions, int categories, float* dist)
+  long* dest, long distributions, long categories,
+  float* sampled, float* dist)
 {
   HIP_DYNAMIC_SHARED( float, smem)
 
@@ -720,7 +616,7 @@ void sampleMultinomialOnce(
     // Each block handles one distribution
     // First pass, find the total sum of the distribution
     float sum = 0.0f;
-    for (int cat = hipThreadIdx_x; cat < categories; cat += hipBlockDim_x) {
+    for (long cat = hipThreadIdx_x; cat < categories; cat += hipBlockDim_x) {
       sum += dist[curDist * categories + cat];
     }
 
@@ -738,7 +634,7 @@ void sampleMultinomialOnce(
     // Broadcast sum and sample value
     if (hipThreadIdx_x == 0) {
       smem[0] = sum;
-      smem[1] = dest[curDist];
+      smem[1] = sampled[curDist];
     }
     __syncthreads();
 
@@ -749,18 +645,18 @@ void sampleMultinomialOnce(
     if (sum == 0.0f || sample == 0.0f) {
       // Choose the first element
       if (hipThreadIdx_x == 0) {
-        dest[curDist] = 1;
+        dest[curDist] = TH_INDEX_BASE;
       }
 
       continue;
     }
 
-    int chunks = THCCeilDiv(categories, (int) hipBlockDim_x);
+    long chunks = THCCeilDiv(categories, (long) hipBlockDim_x);
     float prevHighProb = 0.0f;
 
-    for (int chunk = 0; chunk < chunks; ++chunk) {
+    for (long chunk = 0; chunk < chunks; ++chunk) {
       // All threads in bounds load a value
-      int cat = chunk * hipBlockDim_x + hipThreadIdx_x;
+      long cat = chunk * hipBlockDim_x + hipThreadIdx_x;
 
       float val =
         cat < categories ? dist[curDist * categories + cat] / sum : 0.0f;
@@ -806,127 +702,301 @@ void sampleMultinomialOnce(
   }
 }
 
-#ifdef CURAND_PATH
-__global__ void
-sampleMultinomialWithReplacement(curandStateMtgp32* state,
-                                 int totalSamples,
-                                 float* dest,
-                                 long distributions,
-                                 int categories,
-                                 float* normDistPrefixSum) {
-#else
+// Alias tables are built in parallel from prefix sums (Hubschle-Schneider
+// and Sanders, "Parallel Weighted Random Sampling"). With every row scaled
+// to an average weight of 1, walking the light (q < 1) and heavy (q >= 1)
+// categories in index order, as Vose's sweep does, means the i-th light
+// category borrows from the first heavy category whose cumulative excess
+// reaches the lights' cumulative deficit before i, and a heavy category
+// turns light once the cumulative deficit passes its cumulative excess.
+// Both are binary searches once the two sums are known.
+
+// One block per row: scales the row, classifies every category and writes
+// the cumulative light deficits and heavy excesses in rank order. `alias`
+// temporarily holds the light rank, or -1 - rank for heavy categories.
 __global__ void
-sampleMultinomialWithReplacement(HipRandStateMtgp32* state,
-                                 int totalSamples,
-                                 float* dest,
-                                 long distributions,
-                                 int categories,
-                                 float* normDistPrefixSum) {
+aliasSplit(float* prob, long* alias,
+           double* lightDeficit, double* heavyExcess, long* heavyIndex,
+           long* numHeavy, float* dist, long distributions, long categories)
+{
+  HIP_DYNAMIC_SHARED( double, smem)
+  double* deficit = smem;
+  double* excess = smem + hipBlockDim_x;
+  double* heavy = smem + 2 * hipBlockDim_x;
 
-#endif
-  // At the moment, each warp computes one sample value in the binary
-  // search due to divergence. It seems possible to compute multiple
-  // values and limit divergence though later on. However, no matter
-  // what, all block threads must participate in the curand_uniform
-  // call to update the generator state.
+  for (long row = hipBlockIdx_x; row < distributions; row += hipGridDim_x) {
+    float* rowDist = dist + row * categories;
+    long rowStart = row * categories;
 
-  // The block determines the distribution for which we generate a point
-  for (long curDist = hipBlockIdx_x;
-       curDist < distributions;
-       curDist += hipGridDim_x) {
-    for (int sampleBase = 0;
-         sampleBase < totalSamples; sampleBase += hipBlockDim_y) {
-      // The warp determines the sample
-      int sample = sampleBase + hipThreadIdx_y;
-
-      // All threads participate in this
-      float r = 0.0f;
-      #ifdef CURAND_PATH
-      r = curand_uniform(&state[hipBlockIdx_x]);
-      #else
-     // r = _hiprand_uniform(&state[hipBlockIdx_x]);
-      #endif
-
-      if (hipThreadIdx_x == 0 && sample < totalSamples) {
-        // Find the bucket that a uniform sample lies in
-        int choice = binarySearchForMultinomial(
-          normDistPrefixSum + curDist * categories,
-          categories,
-          r);
+    float sum = 0.0f;
+    for (long cat = hipThreadIdx_x; cat < categories; cat += hipBlockDim_x) {
+      sum += rowDist[cat];
+    }
 
-        // Torch indices are 1-based
-        dest[curDist * totalSamples + sample] = (float) choice + (float)TH_INDEX_BASE;
+    sum = reduceBlock(reinterpret_cast<float*>(smem),
+                      hipBlockDim_x,
+                      sum,
+    #if defined(THRUST_PATH)
+                      thrust::plus<float>(),
+    #else
+                      bolt::amp::plus<float>(),
+    #endif
+                      0.0f);
+    if (hipThreadIdx_x == 0) {
+      reinterpret_cast<float*>(smem)[0] = sum;
+    }
+    __syncthreads();
+    sum = reinterpret_cast<float*>(smem)[0];
+    __syncthreads();
+
+    double carryDeficit = 0.0;
+    double carryExcess = 0.0;
+    long carryHeavy = 0;
+
+    for (long chunk = 0; chunk < categories; chunk += hipBlockDim_x) {
+      long cat = chunk + hipThreadIdx_x;
+      bool valid = cat < categories;
+
+      // Without any mass, everything goes to the first category
+      double q = 0.0;
+      if (valid) {
+        q = sum > 0.0f ? (double) rowDist[cat] * categories / sum :
+          (cat == 0 ? (double) categories : 0.0);
+      }
+      bool isHeavy = valid && q >= 1.0;
+
+      deficit[hipThreadIdx_x] = (valid && !isHeavy) ? 1.0 - q : 0.0;
+      excess[hipThreadIdx_x] = isHeavy ? q - 1.0 : 0.0;
+      heavy[hipThreadIdx_x] = isHeavy ? 1.0 : 0.0;
+      __syncthreads();
+
+      // Inclusive prefix sums of the three shared memory arrays
+      for (int offset = 1; offset < hipBlockDim_x; offset *= 2) {
+        double d = 0.0, e = 0.0, h = 0.0;
+        if (hipThreadIdx_x >= offset) {
+          d = deficit[hipThreadIdx_x - offset];
+          e = excess[hipThreadIdx_x - offset];
+          h = heavy[hipThreadIdx_x - offset];
+        }
+        __syncthreads();
+        deficit[hipThreadIdx_x] += d;
+        excess[hipThreadIdx_x] += e;
+        heavy[hipThreadIdx_x] += h;
+        __syncthreads();
+      }
+
+      if (valid) {
+        long heavyCount = carryHeavy + (long) heavy[hipThreadIdx_x];
+        prob[rowStart + cat] = (float) q;
+
+        if (isHeavy) {
+          long rank = heavyCount - 1;
+          heavyIndex[rowStart + rank] = cat;
+          heavyExcess[rowStart + rank] = carryExcess + excess[hipThreadIdx_x];
+          alias[rowStart + cat] = -1 - rank;
+        } else {
+          long rank = cat - heavyCount;
+          lightDeficit[rowStart + rank] = carryDeficit + deficit[hipThreadIdx_x];
+          alias[rowStart + cat] = rank;
+        }
       }
+
+      carryDeficit += deficit[hipBlockDim_x - 1];
+      carryExcess += excess[hipBlockDim_x - 1];
+      carryHeavy += (long) heavy[hipBlockDim_x - 1];
+      __syncthreads();
+    }
+
+    if (hipThreadIdx_x == 0) {
+      numHeavy[row] = carryHeavy;
     }
   }
 }
 
-#ifdef CURAND_PATH
-__global__ void
-sampleMultinomialWithoutReplacement(curandStateMtgp32* state,
-                                    int totalSamples,
-                                    int sample,
-                                    float* dest,
-                                    long distributions,
-                                    int categories,
-                                    float* origDist,
-                                    float* normDistPrefixSum) {
-#else
+// One thread per category: resolves each bucket's probability and alias
 __global__ void
-sampleMultinomialWithoutReplacement(HipRandStateMtgp32* state,
-                                    int totalSamples,
-                                    int sample,
-                                    float* dest,
-                                    long distributions,
-                                    int categories,
-                                    float* origDist,
-                                    float* normDistPrefixSum) {
-#endif
-  // At the moment, each warp computes one sample value in the binary
-  // search due to divergence. It seems possible to compute multiple
-  // values and limit divergence though later on. However, no matter
-  // what, all block threads must participate in the curand_uniform
-  // call to update the generator state.
-
-  // The block and warp determines the distribution for which we
-  // generate a point
-  for (long curDistBase = hipBlockIdx_x * hipBlockDim_y;
-       curDistBase < distributions;
-       curDistBase += hipGridDim_x * hipBlockDim_y) {
-    // The warp determines the distribution
-    long curDist = curDistBase + hipThreadIdx_y;
-
-    // All threads must participate in this
-    float r = 0.0f;
-    #ifdef CURAND_PATH
-    r = curand_uniform(&state[hipBlockIdx_x]);
-    #endif
+aliasBuild(float* prob, long* alias,
+           double* lightDeficit, double* heavyExcess, long* heavyIndex,
+           long* numHeavy, long distributions, long categories)
+{
+  for (long idx = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       idx < distributions * categories;
+       idx += hipGridDim_x * hipBlockDim_x) {
+    long row = idx / categories;
+    long cat = idx % categories;
+    long nHeavy = numHeavy[row];
+    long nLight = categories - nHeavy;
+    double* rowDeficit = lightDeficit + row * categories;
+    double* rowExcess = heavyExcess + row * categories;
+    long* rowHeavy = heavyIndex + row * categories;
+    long rank = alias[idx];
+
+    if (rank >= 0) {
+      // Light: keeps its own weight, borrows the rest from the current donor
+      double before = rank == 0 ? 0.0 : rowDeficit[rank - 1];
+      if (nHeavy == 0) {
+        prob[idx] = 1.0f;
+        alias[idx] = cat;
+      } else {
+        long donor = searchSortedDouble(rowExcess, nHeavy, before, false);
+        alias[idx] = rowHeavy[donor < nHeavy ? donor : nHeavy - 1];
+      }
+    } else {
+      // Heavy: full unless its excess runs out, then the next heavy tops it up
+      rank = -1 - rank;
+      double excess = rowExcess[rank];
+      long light = searchSortedDouble(rowDeficit, nLight, excess, true);
+      if (light == nLight || rank + 1 == nHeavy) {
+        prob[idx] = 1.0f;
+        alias[idx] = cat;
+      } else {
+        prob[idx] = (float) (1.0 - (rowDeficit[light] - excess));
+        alias[idx] = rowHeavy[rank + 1];
+      }
+    }
+  }
+}
 
-    if (hipThreadIdx_x == 0 && curDist < distributions) {
-      // Find the bucket that a uniform sample lies in
-      int choice = binarySearchForMultinomial(
-        normDistPrefixSum + curDist * categories,
-        categories,
-        r);
+// One thread per sample. Three uniforms per sample: two form a 48-bit column
+// draw, so more than 2^24 categories remain reachable, the third picks
+// between the column and its alias.
+__global__ void
+aliasSample(long* dest, float* uniforms, float* prob, long* alias,
+            long distributions, long categories, long totalSamples)
+{
+  const double step = 1.0 / 16777216.0;
+
+  for (long idx = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       idx < distributions * totalSamples;
+       idx += hipGridDim_x * hipBlockDim_x) {
+    long row = idx / totalSamples;
+    float* u = uniforms + idx * 3;
+
+    // Uniforms are in (0, 1] on a 2^-24 grid
+    double v = ((double) u[0] - step) + ((double) u[1] - step) * step;
+    long cat = (long) (v * categories);
+    cat = cat < categories ? cat : categories - 1;
+
+    long offset = row * categories + cat;
+    long choice = u[2] <= prob[offset] ? cat : alias[offset];
+    dest[idx] = choice + TH_INDEX_BASE;
+  }
+}
 
-      // Torch indices are 1-based
-      dest[curDist * totalSamples + sample] = (float) choice + (float)TH_INDEX_BASE;
+// Turns a uniform draw into a Gumbel-perturbed log-probability; the top k
+// keys of a row are a sample of k categories without replacement. The draw
+// is in (0, 1]: it is kept below 1, whose key would be +inf, and categories
+// of probability 0 get -inf, so they are never chosen ahead of the others.
+struct GumbelKeyOp {
+  __device__ __forceinline__ void operator()(float* key, float* p) {
+    float u = fminf(*key, 1.0f - FLT_EPSILON);
+    *key = *p > 0.0f ? logf(*p) - logf(-logf(u)) : -INFINITY;
+  }
+};
 
-      // Without replacement, so update the original probability so it
-      // is not considered a second time
-      origDist[curDist * categories + choice] = 0.0f;
-    }
+static dim3 THCudaTensor_multinomialGrid(THCState* state, long total)
+{
+  dim3 grid;
+  if (!getApplyGrid(state, total, grid)) {
+    THError("Unable to compute a launch grid");
   }
+  return grid;
+}
+
+static void THCudaTensor_multinomialAlias(THCState* state,
+                                          THCudaLongTensor* self,
+                                          THCudaTensor* probDist,
+                                          long numDist,
+                                          long numCategories,
+                                          int n_sample)
+{
+  hipStream_t stream = THCState_getCurrentStream(state);
+  long numEntries = numDist * numCategories;
+
+  float* prob;
+  long* alias;
+  double* lightDeficit;
+  double* heavyExcess;
+  long* heavyIndex;
+  long* numHeavy;
+  THCudaCheck(THCudaMalloc(state, (void**) &prob, numEntries * sizeof(float)));
+  THCudaCheck(THCudaMalloc(state, (void**) &alias, numEntries * sizeof(long)));
+  THCudaCheck(THCudaMalloc(state, (void**) &lightDeficit, numEntries * sizeof(double)));
+  THCudaCheck(THCudaMalloc(state, (void**) &heavyExcess, numEntries * sizeof(double)));
+  THCudaCheck(THCudaMalloc(state, (void**) &heavyIndex, numEntries * sizeof(long)));
+  THCudaCheck(THCudaMalloc(state, (void**) &numHeavy, numDist * sizeof(long)));
+
+  hipDeviceProp_t* props = THCState_getCurrentDeviceProperties(state);
+  THAssert(props != NULL);
+  int numSM = props->multiProcessorCount;
+
+  dim3 splitBlock(numCategories < BLOCK_SIZE ? numCategories : BLOCK_SIZE);
+  dim3 splitGrid(numDist < numSM * 4 ? numDist : numSM * 4);
+  hipLaunchKernelGGL(
+    aliasSplit,
+    splitGrid,
+    splitBlock,
+    3 * splitBlock.x * sizeof(double),
+    stream,
+    prob,
+    alias,
+    lightDeficit,
+    heavyExcess,
+    heavyIndex,
+    numHeavy,
+    THCudaTensor_data(state, probDist),
+    numDist,
+    numCategories);
+
+  hipLaunchKernelGGL(
+    aliasBuild,
+    THCudaTensor_multinomialGrid(state, numEntries),
+    getApplyBlock(),
+    0,
+    stream,
+    prob,
+    alias,
+    lightDeficit,
+    heavyExcess,
+    heavyIndex,
+    numHeavy,
+    numDist,
+    numCategories);
+
+  THCudaTensor* uniforms = THCudaTensor_newWithSize1d(state, numDist * n_sample * 3);
+  THCudaTensor_uniform(state, uniforms, 0.0, 1.0);
+
+  hipLaunchKernelGGL(
+    aliasSample,
+    THCudaTensor_multinomialGrid(state, numDist * n_sample),
+    getApplyBlock(),
+    0,
+    stream,
+    THCudaLongTensor_data(state, self),
+    THCudaTensor_data(state, uniforms),
+    prob,
+    alias,
+    numDist,
+    numCategories,
+    (long) n_sample);
+
+  THCudaTensor_free(state, uniforms);
+  THCudaCheck(THCudaFree(state, numHeavy));
+  THCudaCheck(THCudaFree(state, heavyIndex));
+  THCudaCheck(THCudaFree(state, heavyExcess));
+  THCudaCheck(THCudaFree(state, lightDeficit));
+  THCudaCheck(THCudaFree(state, alias));
+  THCudaCheck(THCudaFree(state, prob));
 }
 
 THC_API void THCudaTensor_multinomial(struct THCState *state,
-                                      THCudaTensor *self,
+                                      THCudaLongTensor *self,
                                       THCudaTensor *prob_dist,
                                       int n_sample,
                                       int with_replacement)
 {
-  THAssert(THCudaTensor_checkGPU(state, 2, self, prob_dist));
-  Generator* gen = THCRandom_getGenerator(state);
+  THAssert(THCudaTensor_checkGPU(state, 1, prob_dist));
+  THAssert(THCudaLongTensor_checkGPU(state, 1, self));
 
   int inputSize = THCudaTensor_nDimension(state, prob_dist);
   THArgCheck(inputSize > 0 && inputSize <= 2, 2,
@@ -935,16 +1005,10 @@ THC_API void THCudaTensor_multinomial(struct THCState *state,
   // Categories are in the innermost dimension
   long numDist =
     inputSize == 1 ? 1 : THCudaTensor_size(state, prob_dist, 0);
-  long numCategoriesLong =
+  long numCategories =
     inputSize == 1 ? THCudaTensor_size(state, prob_dist, 0) :
     THCudaTensor_size(state, prob_dist, 1);
 
-  // Since the index tensor is float, numCategories cannot exceed max
-  // float integer precision
-  THArgCheck(numCategoriesLong <= FLOAT32_MAX_CONSECUTIVE_INT, 2,
-             "number of categories cannot exceed 2^24");
-  int numCategories = (int) numCategoriesLong;
-
   THArgCheck(n_sample > 0, 3, "cannot sample <= 0 samples");
 
   if (!with_replacement) {
@@ -962,15 +1026,15 @@ THC_API void THCudaTensor_multinomial(struct THCState *state,
     THCudaTensor_resize2d(state, probDistContig, 1, numCategories);
   }
 
-  THCudaTensor_resize2d(state, self, numDist, n_sample);
+  THCudaLongTensor_resize2d(state, self, numDist, n_sample);
 
   if (n_sample == 1) {
-    // Optimized allocation-free implementation
+    // Optimized implementation: a single scan per distribution
 
     // To exploit greater parallelism for the sampling, generate the
-    // Uniform random samples in a separate kernel launch, into the
-    // result memory. The device RNG is thread-limited
-    THCudaTensor_uniform(state, self, 0.0, 1.0);
+    // Uniform random samples in a separate kernel launch
+    THCudaTensor* sampled = THCudaTensor_newWithSize1d(state, numDist);
+    THCudaTensor_uniform(state, sampled, 0.0, 1.0);
 
     hipDeviceProp_t* props = THCState_getCurrentDeviceProperties(state);
     THAssert(props != NULL);
@@ -987,137 +1051,38 @@ THC_API void THCudaTensor_multinomial(struct THCState *state,
       dim3(block),
       block.x * sizeof(float),
       THCState_getCurrentStream(state),
-      THCudaTensor_data(state, self),
+      THCudaLongTensor_data(state, self),
       numDist,
       numCategories,
+      THCudaTensor_data(state, sampled),
       THCudaTensor_data(state, probDistContig));
-  } else {
-    // Generic, slow implementation with memory allocations
-
-    // For sampling without replacement, we modify the distribution
-    // for subsequent samples in this space
-    THCudaTensor* origDist = THCudaTensor_new(state);
-    THCudaTensor_resizeAs(state, origDist, probDistContig);
-    THCudaTensor_copy(state, origDist, probDistContig);
-
-    THCudaTensor* normDist = THCudaTensor_new(state);
-    THCudaTensor_resizeAs(state, normDist, probDistContig);
-
-    THCudaTensor* prefixSum = THCudaTensor_new(state);
-
-    // Renorm along rows
-    THCudaTensor_copy(state, normDist, origDist);
-    THCudaTensor_renormRows(state, normDist);
-
-    // Prefix sum along rows
-    THCudaTensor_cumsum(state, prefixSum, normDist, 1);
-
-    if (with_replacement) {
-      // Sample with replacement
-
-      // Binary search is warp divergent (so effectively we're running
-      // with just a single thread), but for better utilization,
-      // we need each block to have at least 4 warps.
-      dim3 block(32, 4);
-
-      // Each warp in a block will generate a sample from one
-      // distribution concurrently.
-      dim3 grid(numDist < MAX_NUM_BLOCKS ? numDist : MAX_NUM_BLOCKS);
 
-#ifdef CURAND_PATH
-      hipLaunchKernelGGL(
-        sampleMultinomialWithReplacement,
-        dim3(grid),
-        dim3(block),
-        0,
-        THCState_getCurrentStream(state),
-        gen->gen_states,
-        n_sample,
-        THCudaTensor_data(state, self),
-        numDist,
-        numCategories,
-        THCudaTensor_data(state, prefixSum));
-#else
-      hipLaunchKernelGGL(
-          sampleMultinomialWithReplacement,
-          dim3(grid),
-          dim3(block),
-          0,
-          THCState_getCurrentStream(state),
-          gen->h_gen_states,
-          n_sample,
-          THCudaTensor_data(state, self),
-          numDist,
-          numCategories,
-          THCudaTensor_data(state, prefixSum));
-#endif
-    } else {
-      // Sample without replacement
-
-      // Binary search is warp divergent (so effectively we're running
-      // with just a single thread), but for better utilization,
-      // we need each block to have at least 4 warps.
-      dim3 block(32, 4);
-
-      // Each warp in a block will generate a sample from a different
-      // distribution concurrently.
-      ptrdiff_t numBlocks = THCCeilDiv(numDist, 4L);
-      dim3 grid(numBlocks < MAX_NUM_BLOCKS ? numBlocks : MAX_NUM_BLOCKS);
-
-      for (int sample = 0; sample < n_sample; ++sample) {
-        if (sample > 0) {
-          // Update probabilities
-          // Renorm along rows
-          THCudaTensor_copy(state, normDist, origDist);
-          THCudaTensor_renormRows(state, normDist);
-
-          // Prefix sum along rows
-          THCudaTensor_cumsum(state, prefixSum, normDist, 1);
-        }
-
-        // The kernel can only draw one sample before we have to
-        // recalculate our distribution
-#ifdef CURAND_PATH
-        hipLaunchKernelGGL(
-          sampleMultinomialWithoutReplacement,
-          dim3(grid),
-          dim3(block),
-          0,
-          THCState_getCurrentStream(state),
-          gen->gen_states,
-          n_sample,
-          sample,
-          THCudaTensor_data(state, self),
-          numDist,
-          numCategories,
-          THCudaTensor_data(state, origDist),
-          THCudaTensor_data(state, prefixSum));
-#else
-        hipLaunchKernelGGL(
-          (sampleMultinomialWithoutReplacement),
-          dim3(grid),
-          dim3(block),
-          0,
-          THCState_getCurrentStream(state),
-          gen->h_gen_states,
-          n_sample,
-          sample,
-          THCudaTensor_data(state, self),
-          numDist, numCategories,
-          THCudaTensor_data(state, origDist),
-          THCudaTensor_data(state, prefixSum));
-#endif
-      }
+    THCudaTensor_free(state, sampled);
+  } else if (with_replacement) {
+    // Alias tables make every sample O(1), independent of the number
+    // of categories
+    THCudaTensor_multinomialAlias(state, self, probDistContig,
+                                  numDist, numCategories, n_sample);
+  } else {
+    // Gumbel-top-k: perturb the log-probabilities once and select the
+    // n_sample largest keys per row, instead of one launch per sample
+    THCudaTensor* keys = THCudaTensor_new(state);
+    THCudaTensor_resizeAs(state, keys, probDistContig);
+    THCudaTensor_uniform(state, keys, 0.0, 1.0);
+    if (!THC_pointwiseApply2(state, keys, probDistContig, GumbelKeyOp())) {
+      THArgCheck(false, 2, CUTORCH_DIM_WARNING);
     }
 
-    THCudaTensor_free(state, prefixSum);
-    THCudaTensor_free(state, normDist);
-    THCudaTensor_free(state, origDist);
+    THCudaTensor* topKeys = THCudaTensor_new(state);
+    THCudaTensor_topk(state, topKeys, self, keys, n_sample, 1, 1, 1);
+
+    THCudaTensor_free(state, topKeys);
+    THCudaTensor_free(state, keys);
   }
 
   // Revert data restructuring based on input sizes
   if (inputSize == 1) {
-    THCudaTensor_resize1d(state, self, n_sample);
+    THCudaLongTensor_resize1d(state, self, n_sample);
 
     // Unfortunately, if prob_dist is contiguous already,
     // newContiguous is not a private copy, so we have to restructure
@@ -1129,3 +1094,6 @@ THC_API void THCudaTensor_multinomial(struct THCState *state,
 }
 
 #undef NUM_BLOCKS
+
+#include "generic/THCTensorRandom.cu"
+#include "THCGenerateAllTypes.h"
@@ -0,0 +1,251 @@
+#ifndef THC_TENSOR_RANDOM_CUH
+#define THC_TENSOR_RANDOM_CUH
+
+#include "THCTensorRandom.h"
+#include "THCApply.cuh"
+#include "THCNumerics.cuh"
+#include "THCPhilox.cuh"
+
+// Distribution transforms applied to a uniform or standard normal draw; used
+// by the HC MTGP path and by the Philox kernels on both platforms.
+class user_uniform_functor {
+  double _a;
+  double _b;
+public:
+  __host__ __device__
+  user_uniform_functor(double a, double b) : _a(a), _b(b) {}
+
+  __host__ __device__
+  double operator()(float x) const { return x * (_b - _a) + _a; }
+};
+
+
+class user_bernoulli_functor {
+  double _p;
+public:
+  __host__ __device__
+  explicit
+  user_bernoulli_functor(double p) : _p(p) {}
+
+  __host__ __device__
+  double operator()(float x) const { return static_cast<double>(x) <= _p; }
+};
+
+
+class user_normal_functor {
+  double _stdv;
+  double _mean;
+public:
+  __host__ __device__
+  user_normal_functor(double stdv, double mean) : _stdv(stdv), _mean(mean) {}
+
+  __host__ __device__
+  double operator()(float x) const { return (x * _stdv) + _mean; }
+};
+
+class user_geometric_functor {
+  double _p;
+public:
+  __host__ __device__
+  explicit
+  user_geometric_functor(double p) : _p(p) {}
+
+  __device__
+  double operator()(float x) const
+  {
+      return (log((double)(1 - x)) / log(_p)) + 1;
+  }
+};
+
+class user_exponential_functor {
+  double _lambda;
+public:
+  __host__ __device__
+  explicit
+  user_exponential_functor(double lambda) : _lambda(lambda) {}
+
+  __device__
+  double operator()(float x) const
+  {
+    return (double)(-1. / _lambda * log((double)(1 - x)));
+  }
+};
+
+class user_cauchy_functor {
+  double _median;
+  double _sigma;
+public:
+  __host__ __device__
+  user_cauchy_functor(double median, double sigma)
+      : _median(median), _sigma(sigma)
+  {}
+
+  __device__
+  double operator()(float x) const
+  {
+    return (double)(_median + _sigma * tan((double)M_PI * (x - 0.5)));
+  }
+};
+
+class user_log_normal_functor {
+  double _mean;
+  double _stdv;
+public:
+  __host__ __device__
+  user_log_normal_functor(double mean, double stdv) : _mean(mean), _stdv(stdv) {}
+
+  __device__
+  double operator()(float x) const { return exp((x * _stdv) + _mean); }
+};
+
+// Philox generation through TensorInfo offsets, so strided and non-float
+// tensors are filled in place. Each thread expands one Philox block into
+// four consecutive linear indices; the values only depend on the seed, the
+// offset and the linear index, never on the launch shape.
+template <typename Op,
+          typename T,
+          typename IndexType,
+          int ADims,
+          bool Normal>
+#if __CUDA_ARCH__ >= 350
+__launch_bounds__(32 * 16, 4)
+#endif
+__global__ void
+kernelPhiloxApply1(reference_to_const(TensorInfo<T, IndexType>) a,
+                   IndexType totalElements,
+                   unsigned long long seed,
+                   unsigned long long offset,
+                   Op op)
+{
+  IndexType numBlocks = THCCeilDiv(totalElements, (IndexType) 4);
+
+  for (IndexType block = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       block < numBlocks;
+       block += hipGridDim_x * hipBlockDim_x) {
+    float x[4];
+    if (Normal) {
+      philoxNormal4(seed, offset + block, x);
+    } else {
+      philoxUniform4(seed, offset + block, x);
+    }
+
+    IndexType base = block * 4;
+#pragma unroll
+    for (int i = 0; i < 4; ++i) {
+      if (base + i < totalElements) {
+        // Convert the linear index into an offset of `a`
+        const IndexType aOffset =
+          IndexToOffset<T, IndexType, ADims>::get(base + i, a);
+
+        a.data[aOffset] = ScalarConvert<double, T>::to(op(x[i]));
+      }
+    }
+  }
+}
+
+template <bool Normal,
+          typename TensorTypeA,
+          typename Op>
+bool THC_philoxApply1(THCState* state,
+                      Generator* gen,
+                      TensorTypeA* a,
+                      const Op& op) {
+  if (TensorUtils<TensorTypeA>::getDims(state, a) > MAX_CUTORCH_DIMS) {
+    return false;
+  }
+
+  if (TensorUtils<TensorTypeA>::getDims(state, a) == 0) {
+    // Zero-dim tensor; do nothing
+    return true;
+  }
+
+  const dim3 block = getApplyBlock();
+
+  dim3 grid;
+  ptrdiff_t totalElements = TensorUtils<TensorTypeA>::getNumElements(state, a);
+  ptrdiff_t numBlocks = THCCeilDiv(totalElements, (ptrdiff_t) 4);
+
+  if (!getApplyGrid(state, numBlocks, grid)) {
+    return false;
+  }
+
+  // As in THC_pointwiseApply1, overlapping indices are written in
+  // contiguous space and copied back
+  TensorTypeA* oldA = NULL;
+
+  if (TensorUtils<TensorTypeA>::overlappingIndices(state, a)) {
+    oldA = a;
+    a = TensorUtils<TensorTypeA>::newContiguous(state, a);
+  }
+
+  unsigned long long seed = (unsigned long long) gen->initial_seed;
+  unsigned long long offset = (unsigned long long) gen->philox_offset;
+
+#define HANDLE_CASE(TYPE, A)                                            \
+  hipLaunchKernelGGL(                                                   \
+    (kernelPhiloxApply1<                                                \
+        Op, typename TensorUtils<TensorTypeA>::DataType, TYPE, A, Normal>), \
+    grid,                                                               \
+    block,                                                              \
+    0,                                                                  \
+    THCState_getCurrentStream(state),                                   \
+    make_magic_wrapper(aInfo),                                          \
+    (TYPE) totalElements,                                               \
+    seed,                                                               \
+    offset,                                                             \
+    op);
+
+#define HANDLE_A_CASE(TYPE, A)                  \
+  {                                             \
+    if (aInfo.isContiguous()) {                 \
+      HANDLE_CASE(TYPE, -2);                    \
+    } else {                                    \
+      switch (A) {                              \
+        case 1:                                 \
+        HANDLE_CASE(TYPE, 1);                   \
+        break;                                  \
+        case 2:                                 \
+        HANDLE_CASE(TYPE, 2);                   \
+        break;                                  \
+        default:                                \
+        HANDLE_CASE(TYPE, -1);                  \
+        break;                                  \
+      }                                         \
+    }                                           \
+  }
+
+  if (TensorUtils<TensorTypeA>::canUse32BitIndexMath(state, a)) {
+    TensorInfo<typename TensorUtils<TensorTypeA>::DataType, unsigned int> aInfo =
+      getTensorInfo<TensorTypeA, unsigned int>(state, a);
+    aInfo.collapseDims();
+
+    HANDLE_A_CASE(unsigned int, aInfo.dims);
+  } else {
+    TensorInfo<typename TensorUtils<TensorTypeA>::DataType, unsigned long> aInfo =
+      getTensorInfo<TensorTypeA, unsigned long>(state, a);
+    aInfo.collapseDims();
+
+    // For large tensors, we only compile the completely contiguous
+    // version and the completely generic version
+    if (aInfo.isContiguous()) {
+      HANDLE_CASE(unsigned long, -2);
+    } else {
+      HANDLE_CASE(unsigned long, -1);
+    }
+  }
+#undef HANDLE_CASE
+#undef HANDLE_A_CASE
+
+  // Reserve the counters this call consumed
+  gen->philox_offset += numBlocks;
+
+  if (oldA) {
+    TensorUtils<TensorTypeA>::copyIgnoringOverlaps(state, oldA, a);
+    TensorUtils<TensorTypeA>::free(state, a);
+    a = oldA;
+  }
+
+  return true;
+}
+
+#endif // THC_TENSOR_RANDOM_CUH
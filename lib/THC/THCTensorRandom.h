@@ -3,6 +3,10 @@
 
 #include "THCTensor.h"
 
+/* Generator engines, selectable per THCState */
+#define THC_RNG_MTGP32 0
+#define THC_RNG_PHILOX 1
+
 /* Generator */
 typedef struct _Generator {
 #ifdef CURAND_PATH
@@ -13,12 +17,16 @@ typedef struct _Generator {
 #endif
   int initf;
   unsigned long initial_seed;
+  /* Philox counter, in 128-bit blocks consumed since the seed was set */
+  unsigned long philox_offset;
 } Generator;
 
 typedef struct THCRNGState {
   /* One generator per GPU */
   Generator* gen;
   int num_devices;
+  /* THC_RNG_MTGP32 or THC_RNG_PHILOX */
+  int type;
 } THCRNGState;
 
 struct THCState;
@@ -32,15 +40,17 @@ THC_API void THCRandom_manualSeedAll(struct THCState *state, unsigned long the_s
 THC_API unsigned long THCRandom_initialSeed(struct THCState *state);
 THC_API void THCRandom_getRNGState(struct THCState *state, THByteTensor *rng_state);
 THC_API void THCRandom_setRNGState(struct THCState *state, THByteTensor *rng_state);
-THC_API void THCudaTensor_geometric(struct THCState *state, THCudaTensor *self, double p);
-THC_API void THCudaTensor_bernoulli(struct THCState *state, THCudaTensor *self, double p);
-THC_API void THCudaTensor_uniform(struct THCState *state, THCudaTensor *self, double a, double b);
-THC_API void THCudaTensor_normal(struct THCState *state, THCudaTensor *self, double mean, double stdv);
-THC_API void THCudaTensor_exponential(struct THCState *state, THCudaTensor *self, double lambda);
-THC_API void THCudaTensor_cauchy(struct THCState *state, THCudaTensor *self, double median, double sigma);
-THC_API void THCudaTensor_logNormal(struct THCState *state, THCudaTensor *self, double mean, double stdv);
-
-THC_API void THCudaTensor_multinomial(struct THCState *state, THCudaTensor *self, THCudaTensor *prob_dist, int n_sample, int with_replacement);
+THC_API void THCRandom_setGeneratorType(struct THCState *state, int type);
+THC_API int THCRandom_getGeneratorType(struct THCState *state);
+/* Host reference for the Philox engine: fills `result` with what uniform(0, 1)
+   or normal(0, 1) produce on the device for a given seed and offset */
+THC_API void THCRandom_philoxUniformHost(THFloatTensor *result, unsigned long seed, unsigned long offset);
+THC_API void THCRandom_philoxNormalHost(THFloatTensor *result, unsigned long seed, unsigned long offset);
+
+#include "generic/THCTensorRandom.h"
+#include "THCGenerateAllTypes.h"
+
+THC_API void THCudaTensor_multinomial(struct THCState *state, THCudaLongTensor *self, THCudaTensor *prob_dist, int n_sample, int with_replacement);
 
 #ifdef CURAND_PATH
 THC_API struct curandStateMtgp32* THCRandom_generatorStates(struct THCState* state);
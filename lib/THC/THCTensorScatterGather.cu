@@ -2,16 +2,22 @@
 #include "THCTensorMath.h"
 #include "THCGeneral.h"
 #include "THCApply.cuh"
+#include "THCAtomics.cuh"
+#include "THCTensorSortedAdd.cuh"
+#include <climits>
+#include <algorithm>
 
 // Compute the offsets into the given tensors for a linear index. For the 't2'
 // tensor, dimension 'dim' is skipped. The tensors are assumed to have the same
 // size (with the exception of 't2' in dimension 'dim').
-// This version uses a static number of dimensions.
+// This version uses a static number of dimensions. The index tensor may hold
+// long or int elements.
 template <typename IndexType, typename Real, int Dims>
 struct IndexToScatterGatherOffsets {
+  template <typename IndexT>
   static __device__ void compute(
       IndexType linearId, const int dim,
-      const TensorInfo<long, IndexType>& index, IndexType* indexOffset,
+      const TensorInfo<IndexT, IndexType>& index, IndexType* indexOffset,
       const TensorInfo<Real, IndexType>& t1, IndexType* t1Offset,
       const TensorInfo<Real, IndexType>& t2, IndexType* t2Offset) {
     for (int d = Dims - 1; d >= 0; d--) {
@@ -25,9 +31,10 @@ struct IndexToScatterGatherOffsets {
     }
   }
 
+  template <typename IndexT>
   static __device__ void compute(
       IndexType linearId, const int dim,
-      const TensorInfo<long, IndexType>& index, IndexType* indexOffset,
+      const TensorInfo<IndexT, IndexType>& index, IndexType* indexOffset,
       const TensorInfo<Real, IndexType>& t2, IndexType* t2Offset) {
     for (int d = Dims - 1; d >= 0; d--) {
       IndexType curDimIndex = linearId % index.sizes[d];
@@ -43,9 +50,10 @@ struct IndexToScatterGatherOffsets {
 // Same as above but using a dynamic number of dimensions.
 template <typename IndexType, typename Real>
 struct IndexToScatterGatherOffsets<IndexType, Real, -1> {
+  template <typename IndexT>
   static __device__ void compute(
       IndexType linearId, const int dim,
-      const TensorInfo<long, IndexType>& index, IndexType* indexOffset,
+      const TensorInfo<IndexT, IndexType>& index, IndexType* indexOffset,
       const TensorInfo<Real, IndexType>& t1, IndexType* t1Offset,
       const TensorInfo<Real, IndexType>& t2, IndexType* t2Offset) {
     for (int d = index.dims - 1; d >= 0; d--) {
@@ -59,9 +67,10 @@ struct IndexToScatterGatherOffsets<IndexType, Real, -1> {
     }
   }
 
+  template <typename IndexT>
   static __device__ void compute(
       IndexType linearId, const int dim,
-      const TensorInfo<long, IndexType>& index, IndexType* indexOffset,
+      const TensorInfo<IndexT, IndexType>& index, IndexType* indexOffset,
       const TensorInfo<Real, IndexType>& t2, IndexType* t2Offset) {
     for (int d = index.dims - 1; d >= 0; d--) {
       IndexType curDimIndex = linearId % index.sizes[d];
@@ -75,12 +84,12 @@ struct IndexToScatterGatherOffsets<IndexType, Real, -1> {
 };
 
 
-template <typename IndexType, typename Real, int Dims>
+template <typename IndexType, typename Real, int Dims, typename IndexT>
 __global__
 void THCudaTensor_gatherKernel(
     reference_to_const(TensorInfo<Real, IndexType>) tensor,
     reference_to_const(TensorInfo<Real, IndexType>) src,
-    reference_to_const(TensorInfo<long, IndexType>) index,
+    reference_to_const(TensorInfo<IndexT, IndexType>) index,
     const int dim,
     const IndexType totalElements)
 {
@@ -103,12 +112,12 @@ void THCudaTensor_gatherKernel(
   }
 }
 
-template <typename IndexType, typename Real, int Dims>
+template <typename IndexType, typename Real, int Dims, typename IndexT>
 __global__
 void THCudaTensor_scatterKernel(
     reference_to_const(TensorInfo<Real, IndexType>) tensor,
     reference_to_const(TensorInfo<Real, IndexType>) src,
-    reference_to_const(TensorInfo<long, IndexType>) index,
+    reference_to_const(TensorInfo<IndexT, IndexType>) index,
     int dim,
     IndexType totalElements)
 {
@@ -133,10 +142,72 @@ void THCudaTensor_scatterKernel(
 
 template <typename IndexType, typename Real, int Dims>
 __global__
+void THCudaTensor_scatterAddKernel(
+    reference_to_const(TensorInfo<Real, IndexType>) tensor,
+    reference_to_const(TensorInfo<Real, IndexType>) src,
+    reference_to_const(TensorInfo<long, IndexType>) index,
+    int dim,
+    IndexType totalElements)
+{
+  for (IndexType linearId = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearId < totalElements;
+       linearId += hipGridDim_x * hipBlockDim_x) {
+    IndexType tensorOffset = 0;
+    IndexType srcOffset = 0;
+    IndexType indexOffset = 0;
+
+    IndexToScatterGatherOffsets<IndexType, Real, Dims>::compute(linearId, dim,
+                                                          index, &indexOffset,
+                                                          src, &srcOffset,
+                                                          tensor, &tensorOffset);
+
+    IndexType indexValue = (IndexType)index.data[indexOffset] - TH_INDEX_BASE;
+    tensorOffset += indexValue * tensor.strides[dim];
+
+    atomicAdd(&tensor.data[tensorOffset], src.data[srcOffset]);
+  }
+}
+
+// Deterministic scatterAdd: records, for every element, the offset it adds
+// to in `tensor` and the offset it reads in `src` (both 1-based), so that
+// THC_sortedIndexAdd can reduce them as flat arrays
+template <typename IndexType, typename Real, int Dims>
+__global__
+void THCudaTensor_scatterAddOffsetsKernel(
+    reference_to_const(TensorInfo<Real, IndexType>) tensor,
+    reference_to_const(TensorInfo<Real, IndexType>) src,
+    reference_to_const(TensorInfo<long, IndexType>) index,
+    int dim,
+    IndexType totalElements,
+    long *tensorOffsets,
+    long *srcOffsets)
+{
+  for (IndexType linearId = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearId < totalElements;
+       linearId += hipGridDim_x * hipBlockDim_x) {
+    IndexType tensorOffset = 0;
+    IndexType srcOffset = 0;
+    IndexType indexOffset = 0;
+
+    IndexToScatterGatherOffsets<IndexType, Real, Dims>::compute(linearId, dim,
+                                                          index, &indexOffset,
+                                                          src, &srcOffset,
+                                                          tensor, &tensorOffset);
+
+    IndexType indexValue = (IndexType)index.data[indexOffset] - TH_INDEX_BASE;
+    tensorOffset += indexValue * tensor.strides[dim];
+
+    tensorOffsets[linearId] = (long) tensorOffset + TH_INDEX_BASE;
+    srcOffsets[linearId] = (long) srcOffset + TH_INDEX_BASE;
+  }
+}
+
+template <typename IndexType, typename Real, int Dims, typename IndexT>
+__global__
 inline
 void THCudaTensor_scatterFillKernel(
     reference_to_const(TensorInfo<Real, IndexType>) tensor,
-    reference_to_const(TensorInfo<long, IndexType>) index,
+    reference_to_const(TensorInfo<IndexT, IndexType>) index,
     Real value,
     int dim,
     IndexType totalElements)
@@ -158,5 +229,69 @@ void THCudaTensor_scatterFillKernel(
   }
 }
 
+// gather and scatter when the index only varies along `dim` and both
+// tensors are contiguous: the elements after `dim` then form contiguous rows
+// that move as a whole, in units of U as wide as their size and alignment
+// allow. Row r of the indexed side is slice r / indexDimSize of the
+// dimensions before `dim`, entry r % indexDimSize of the index; it maps to
+// the same slice of the other side, at the indexed position along `dim`.
+template <typename U, typename IndexT, bool Scatter>
+__global__ void
+THCudaTensor_gatherScatterRowsKernel(U *tensor, const U *src,
+                                     const IndexT *index, long indexStride,
+                                     long numRows, long indexDimSize,
+                                     long otherDimSize, long rowUnits)
+{
+  for (long row = hipBlockIdx_x * hipBlockDim_y + hipThreadIdx_y;
+       row < numRows;
+       row += hipGridDim_x * hipBlockDim_y) {
+    long outer = row / indexDimSize;
+    long otherRow = outer * otherDimSize +
+      (long) index[(row % indexDimSize) * indexStride] - TH_INDEX_BASE;
+    U *dstRow = tensor + (Scatter ? otherRow : row) * rowUnits;
+    const U *srcRow = src + (Scatter ? row : otherRow) * rowUnits;
+    for (long i = hipThreadIdx_x; i < rowUnits; i += hipBlockDim_x) {
+      dstRow[i] = srcRow[i];
+    }
+  }
+}
+
+template <typename U, typename IndexT, bool Scatter>
+void THC_gatherScatterRows(THCState* state, U *tensor, const U *src,
+                           const IndexT *index, long indexStride,
+                           long numRows, long indexDimSize,
+                           long otherDimSize, long rowUnits)
+{
+  dim3 block = getApplyRowBlock(rowUnits);
+  int mpc = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
+  dim3 grid(std::min(THCCeilDiv(numRows, (long) block.y), (long) (mpc * 8)));
+
+  hipLaunchKernelGGL(
+    (THCudaTensor_gatherScatterRowsKernel<U, IndexT, Scatter>), grid, block, 0,
+    THCState_getCurrentStream(state),
+    tensor, src, index, indexStride, numRows, indexDimSize, otherDimSize, rowUnits);
+  THCudaCheck(hipGetLastError());
+}
+
+// Whether the row path above applies: both tensors contiguous and the
+// index constant across every dimension but `dim`
+template <typename TensorType, typename IndexTensor>
+bool THC_canGatherScatterRows(THCState* state, TensorType* tensor, TensorType* src,
+                              IndexTensor* index, int dim)
+{
+  if (!TensorUtils<TensorType>::isContiguous(state, tensor) ||
+      !TensorUtils<TensorType>::isContiguous(state, src)) {
+    return false;
+  }
+  for (int d = 0; d < TensorUtils<IndexTensor>::getDims(state, index); d++) {
+    if (d != dim &&
+        TensorUtils<IndexTensor>::getSize(state, index, d) > 1 &&
+        TensorUtils<IndexTensor>::getStride(state, index, d) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 #include "generic/THCTensorScatterGather.cu"
 #include "THCGenerateAllTypes.h"
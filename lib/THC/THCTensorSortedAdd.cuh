@@ -0,0 +1,207 @@
+#ifndef THC_TENSOR_SORTED_ADD_CUH
+#define THC_TENSOR_SORTED_ADD_CUH
+
+#include "THCTensorMath.h"
+#include "THCTensorInfo.cuh"
+#include "THCDeviceUtils.cuh"
+#include "THCNumerics.cuh"
+#include <algorithm>
+#include <cmath>
+
+// Deterministic indexed accumulation without atomics: dst[key] += src[pos]
+// for every (key, pos) pair, where a key names a slice of `dst` along
+// `dstAddDim` and a position a slice of `src` along `srcAddDim`.
+//
+// The pairs are sorted by key, so duplicates form contiguous runs. The sorted
+// array is cut into chunks of equal length; one pass sums every run inside a
+// chunk and writes the runs that do not cross a chunk boundary straight to
+// `dst`. A run crossing boundaries leaves its partial sums in per-chunk
+// buffers, and a second pass lets the chunk where it starts add them up in
+// order. Every `dst` slice then has a single writer, and the summation order
+// depends only on the sorted keys, whatever the index distribution.
+//
+// Keys and positions are 1-based, as THCudaLongTensor_sort returns positions.
+
+#define THC_SORTED_ADD_MIN_CHUNK 32
+#define THC_SORTED_ADD_THREADS 128
+
+template <typename T, typename AccT, typename IndexType>
+__device__ __forceinline__ void
+sortedAddToDst(const TensorInfo<T, IndexType>& dst, int dstAddDim,
+               IndexType elementInSlice, long key, long dstAddDimSize, AccT sum)
+{
+  // Keys outside [0, dstAddDimSize) are skipped, the same as indexAdd's
+  // atomic kernels, whose unsigned IndexType comparison also drops negative
+  // indices. scatterAdd passes LONG_MAX and so checks nothing, as its
+  // atomic kernel does not either.
+  if (key >= 0 && key < dstAddDimSize) {
+    IndexType dstOffset =
+      IndexToOffset<T, IndexType, -1>::get(elementInSlice, dst);
+    dstOffset += key * dst.strides[dstAddDim];
+    dst.data[dstOffset] = ScalarConvert<AccT, T>::to(
+      ScalarConvert<T, AccT>::to(dst.data[dstOffset]) + sum);
+  }
+}
+
+// First pass: one thread per (chunk, element of the slice)
+template <typename T, typename AccT, typename IndexType>
+__global__ void
+sortedAddChunk(reference_to_const(TensorInfo<T, IndexType>) dst,
+               reference_to_const(TensorInfo<T, IndexType>) src,
+               int dstAddDim,
+               int srcAddDim,
+               IndexType innerSize,
+               long dstAddDimSize,
+               const long *keys,
+               const long *positions,
+               long n,
+               long chunkSize,
+               long numChunks,
+               AccT *carry,
+               AccT *head)
+{
+  for (IndexType linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < innerSize * numChunks;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    IndexType chunk = linearIndex / innerSize;
+    IndexType elementInSlice = linearIndex % innerSize;
+    IndexType srcSliceOffset =
+      IndexToOffset<T, IndexType, -1>::get(elementInSlice, src);
+
+    long begin = chunk * chunkSize;
+    long end = begin + chunkSize < n ? begin + chunkSize : n;
+
+    long i = begin;
+    while (i < end) {
+      long key = keys[i];
+      long runStart = i;
+      AccT sum = ScalarConvert<int, AccT>::to(0);
+      for (; i < end && keys[i] == key; ++i) {
+        IndexType srcOffset = srcSliceOffset +
+          (positions[i] - TH_INDEX_BASE) * src.strides[srcAddDim];
+        sum = sum + ScalarConvert<T, AccT>::to(src.data[srcOffset]);
+      }
+
+      if (runStart == begin && begin > 0 && keys[begin - 1] == key) {
+        // continues a run started in an earlier chunk
+        carry[linearIndex] = sum;
+      } else if (i == end && end < n && keys[end] == key) {
+        // starts a run that continues in the next chunk
+        head[linearIndex] = sum;
+      } else {
+        sortedAddToDst<T, AccT, IndexType>(dst, dstAddDim, elementInSlice,
+                                           key - TH_INDEX_BASE, dstAddDimSize, sum);
+      }
+    }
+  }
+}
+
+// Second pass: the chunk where a boundary-crossing run starts adds the
+// partial sums of the chunks it covers
+template <typename T, typename AccT, typename IndexType>
+__global__ void
+sortedAddCarry(reference_to_const(TensorInfo<T, IndexType>) dst,
+               int dstAddDim,
+               IndexType innerSize,
+               long dstAddDimSize,
+               const long *keys,
+               long n,
+               long chunkSize,
+               long numChunks,
+               const AccT *carry,
+               const AccT *head)
+{
+  for (IndexType linearIndex = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+       linearIndex < innerSize * numChunks;
+       linearIndex += hipGridDim_x * hipBlockDim_x) {
+    IndexType chunk = linearIndex / innerSize;
+    IndexType elementInSlice = linearIndex % innerSize;
+
+    long begin = chunk * chunkSize;
+    long end = begin + chunkSize < n ? begin + chunkSize : n;
+    long key = keys[end - 1];
+    bool hasHead = end < n && keys[end] == key &&
+      !(begin > 0 && keys[begin - 1] == key);
+    if (!hasHead) {
+      continue;
+    }
+
+    AccT sum = head[linearIndex];
+    for (long next = chunk + 1; next < numChunks; ++next) {
+      sum = sum + carry[next * innerSize + elementInSlice];
+      long nextEnd = (next + 1) * chunkSize;
+      if (nextEnd >= n || keys[nextEnd] != key) {
+        break;
+      }
+    }
+    sortedAddToDst<T, AccT, IndexType>(dst, dstAddDim, elementInSlice,
+                                       key - TH_INDEX_BASE, dstAddDimSize, sum);
+  }
+}
+
+// `keys` is a vector of 1-based slice indices into `dst`. When `positions`
+// is NULL, key i adds slice i of `src`; otherwise it adds slice
+// positions[i] (1-based).
+template <typename T, typename AccT, typename IndexType>
+void THC_sortedIndexAdd(THCState *state,
+                        const TensorInfo<T, IndexType>& dst,
+                        const TensorInfo<T, IndexType>& src,
+                        int dstAddDim,
+                        int srcAddDim,
+                        IndexType innerSize,
+                        long dstAddDimSize,
+                        THCudaLongTensor *keys,
+                        THCudaLongTensor *positions)
+{
+  long n = THCudaLongTensor_nElement(state, keys);
+  if (n == 0 || innerSize == 0) {
+    return;
+  }
+
+  THCudaLongTensor *sortedKeys = THCudaLongTensor_new(state);
+  THCudaLongTensor *order = THCudaLongTensor_new(state);
+  THCudaLongTensor_sort(state, sortedKeys, order, keys, 0, 0);
+  if (positions) {
+    THCudaLongTensor *sortedPositions = THCudaLongTensor_new(state);
+    THCudaLongTensor_indexSelect(state, sortedPositions, positions, 0, order);
+    THCudaLongTensor_free(state, order);
+    order = sortedPositions;
+  }
+
+  // Chunks of about sqrt(n) balance the two passes when a single key
+  // covers most of the input
+  long chunkSize = std::max((long) THC_SORTED_ADD_MIN_CHUNK,
+                            (long) std::ceil(std::sqrt((double) n)));
+  long numChunks = THCCeilDiv(n, chunkSize);
+  ptrdiff_t threads = (ptrdiff_t) numChunks * innerSize;
+
+  AccT *partials;
+  THCudaCheck(THCudaMalloc(state, (void**) &partials, 2 * threads * sizeof(AccT)));
+
+  int mpc = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
+  dim3 grid(std::min(THCCeilDiv(threads, (ptrdiff_t) THC_SORTED_ADD_THREADS),
+                     (ptrdiff_t) (mpc * 8)));
+  dim3 block(std::min(threads, (ptrdiff_t) THC_SORTED_ADD_THREADS));
+  hipStream_t stream = THCState_getCurrentStream(state);
+
+  hipLaunchKernelGGL(
+    (sortedAddChunk<T, AccT, IndexType>), grid, block, 0, stream,
+    make_magic_wrapper(dst), make_magic_wrapper(src), dstAddDim, srcAddDim,
+    innerSize, dstAddDimSize,
+    THCudaLongTensor_data(state, sortedKeys), THCudaLongTensor_data(state, order),
+    n, chunkSize, numChunks, partials, partials + threads);
+  THCudaCheck(hipGetLastError());
+
+  hipLaunchKernelGGL(
+    (sortedAddCarry<T, AccT, IndexType>), grid, block, 0, stream,
+    make_magic_wrapper(dst), dstAddDim, innerSize, dstAddDimSize,
+    THCudaLongTensor_data(state, sortedKeys),
+    n, chunkSize, numChunks, partials, partials + threads);
+  THCudaCheck(hipGetLastError());
+
+  THCudaCheck(THCudaFree(state, partials));
+  THCudaLongTensor_free(state, sortedKeys);
+  THCudaLongTensor_free(state, order);
+}
+
+#endif // THC_TENSOR_SORTED_ADD_CUH
@@ -20,16 +20,39 @@ int THCStorage_(elementSize)(THCState *state)
 void THCStorage_(set)(THCState *state, THCStorage *self, ptrdiff_t index, real value)
 {
   THArgCheck((index >= 0) && (index < self->size), 2, "index out of bounds");
-  THCudaCheck(hipMemcpy(self->data + index, &value, sizeof(real),
-                         hipMemcpyHostToDevice));
+  int currentDevice;
+  THCudaCheck(hipGetDevice(&currentDevice));
+  if (currentDevice != self->device) {
+    THCudaCheck(hipSetDevice(self->device));
+  }
+  hipStream_t stream = THCState_getCurrentStream(state);
+  real *staging = (real*) THCState_getHostScratchSpace(state, sizeof(real));
+  *staging = value;
+  THCudaCheck(hipMemcpyAsync(self->data + index, staging, sizeof(real),
+                             hipMemcpyHostToDevice, stream));
+  THCState_releaseHostScratchSpace(state, stream);
+  if (currentDevice != self->device) {
+    THCudaCheck(hipSetDevice(currentDevice));
+  }
 }
 
 real THCStorage_(get)(THCState *state, const THCStorage *self, ptrdiff_t index)
 {
   THArgCheck((index >= 0) && (index < self->size), 2, "index out of bounds");
-  real value;
-  THCudaCheck(hipMemcpy(&value, self->data + index, sizeof(real),
-                         hipMemcpyDeviceToHost));
+  int currentDevice;
+  THCudaCheck(hipGetDevice(&currentDevice));
+  if (currentDevice != self->device) {
+    THCudaCheck(hipSetDevice(self->device));
+  }
+  hipStream_t stream = THCState_getCurrentStream(state);
+  real *staging = (real*) THCState_getHostScratchSpace(state, sizeof(real));
+  THCudaCheck(hipMemcpyAsync(staging, self->data + index, sizeof(real),
+                             hipMemcpyDeviceToHost, stream));
+  THCudaCheck(hipStreamSynchronize(stream));
+  real value = *staging;
+  if (currentDevice != self->device) {
+    THCudaCheck(hipSetDevice(currentDevice));
+  }
   return value;
 }
 
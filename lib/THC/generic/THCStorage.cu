@@ -3,23 +3,109 @@
 #define THC_GENERIC_FILE "generic/THCStorage.cu"
 #else
 
-#ifdef __HCC__
-#include <bolt/amp/fill.h>
-#include <bolt/amp/iterator/ubiquitous_iterator.h>
-#endif
-
 void THCStorage_(fill)(THCState *state, THCStorage *self, real value)
 {
-#ifdef THRUST_PATH
-  thrust::device_ptr<real> self_data(self->data);
-  thrust::fill(
-    self_data, self_data+self->size, value);
-#else
-    bolt::amp::fill(
-        bolt::amp::make_ubiquitous_iterator(self->data),
-        bolt::amp::make_ubiquitous_iterator(self->data) + self->size,
-        value);
-#endif
+  if (self->size == 0) return;
+
+  // Fill wrt the current stream on the storage's device.
+  int currentDevice;
+  THCudaCheck(hipGetDevice(&currentDevice));
+
+  if (currentDevice != self->device) {
+    THCudaCheck(hipSetDevice(self->device));
+  }
+
+  THC_fillContiguous<real>(state, self->data, self->size, value);
+
+  if (currentDevice != self->device) {
+    THCudaCheck(hipSetDevice(currentDevice));
+  }
+}
+
+static void THCStorage_(checkOffsets)(THCState *state, const THCStorage *self,
+                                      const ptrdiff_t *offsets, ptrdiff_t n)
+{
+  THArgCheck(n >= 0, 4, "invalid number of elements");
+  for (ptrdiff_t i = 0; i < n; ++i) {
+    THArgCheck(offsets[i] >= 0 && offsets[i] < self->size, 3,
+               "index %ld out of bounds", (long) offsets[i]);
+  }
+}
+
+void THCStorage_(getMany)(THCState *state, const THCStorage *self,
+                          const ptrdiff_t *offsets, ptrdiff_t n, real *values)
+{
+  THCStorage_(checkOffsets)(state, self, offsets, n);
+  if (n == 0) return;
+
+  int currentDevice;
+  THCudaCheck(hipGetDevice(&currentDevice));
+  if (currentDevice != self->device) {
+    THCudaCheck(hipSetDevice(self->device));
+  }
+  hipStream_t stream = THCState_getCurrentStream(state);
+
+  // offsets go up and values come back through the same buffers, one
+  // transfer each way
+  size_t offsetBytes = n * sizeof(ptrdiff_t);
+  size_t valueBytes = n * sizeof(real);
+  char *staging = (char*) THCState_getHostScratchSpace(state, offsetBytes + valueBytes);
+  memcpy(staging, offsets, offsetBytes);
+  char *buffer;
+  THCudaCheck(THCudaMalloc(state, (void**) &buffer, offsetBytes + valueBytes));
+
+  THCudaCheck(hipMemcpyAsync(buffer, staging, offsetBytes,
+                             hipMemcpyHostToDevice, stream));
+  hipLaunchKernelGGL(
+    (storageGatherKernel<real>), THCStorage_elementsGrid(n),
+    dim3(THC_STORAGE_ELEMENTS_THREADS), 0, stream,
+    self->data, (const ptrdiff_t*) buffer, (real*) (buffer + offsetBytes), n);
+  THCudaCheck(hipGetLastError());
+  THCudaCheck(hipMemcpyAsync(staging + offsetBytes, buffer + offsetBytes, valueBytes,
+                             hipMemcpyDeviceToHost, stream));
+  THCudaCheck(THCudaFree(state, buffer));
+  THCudaCheck(hipStreamSynchronize(stream));
+  memcpy(values, staging + offsetBytes, valueBytes);
+
+  if (currentDevice != self->device) {
+    THCudaCheck(hipSetDevice(currentDevice));
+  }
+}
+
+void THCStorage_(setMany)(THCState *state, THCStorage *self,
+                          const ptrdiff_t *offsets, ptrdiff_t n, const real *values)
+{
+  THCStorage_(checkOffsets)(state, self, offsets, n);
+  if (n == 0) return;
+
+  int currentDevice;
+  THCudaCheck(hipGetDevice(&currentDevice));
+  if (currentDevice != self->device) {
+    THCudaCheck(hipSetDevice(self->device));
+  }
+  hipStream_t stream = THCState_getCurrentStream(state);
+
+  size_t offsetBytes = n * sizeof(ptrdiff_t);
+  size_t valueBytes = n * sizeof(real);
+  char *staging = (char*) THCState_getHostScratchSpace(state, offsetBytes + valueBytes);
+  memcpy(staging, offsets, offsetBytes);
+  memcpy(staging + offsetBytes, values, valueBytes);
+  char *buffer;
+  THCudaCheck(THCudaMalloc(state, (void**) &buffer, offsetBytes + valueBytes));
+
+  THCudaCheck(hipMemcpyAsync(buffer, staging, offsetBytes + valueBytes,
+                             hipMemcpyHostToDevice, stream));
+  THCState_releaseHostScratchSpace(state, stream);
+  hipLaunchKernelGGL(
+    (storageScatterKernel<real>), THCStorage_elementsGrid(n),
+    dim3(THC_STORAGE_ELEMENTS_THREADS), 0, stream,
+    self->data, (const ptrdiff_t*) buffer, (const real*) (buffer + offsetBytes), n);
+  THCudaCheck(hipGetLastError());
+  THCudaCheck(THCudaFree(state, buffer));
+
+  if (currentDevice != self->device) {
+    THCudaCheck(hipSetDevice(currentDevice));
+  }
 }
 
 void THCStorage_(resize)(THCState *state, THCStorage *self, ptrdiff_t size)
@@ -32,7 +118,9 @@ void THCStorage_(resize)(THCState *state, THCStorage *self, ptrdiff_t size)
   if(!(self->flag & TH_STORAGE_RESIZABLE))
     THError("Trying to resize storage that is not resizable");
 
-  if (self->allocator->realloc) {
+  // only memory the storage owns may go back to its allocator; wrapped
+  // pointers (setFlag without FREEMEM) take the copying path below
+  if (self->allocator->realloc && (self->flag & TH_STORAGE_FREEMEM)) {
     THCHeapUpdate(state, (size - self->size) * sizeof(real));
     hipError_t err = (*self->allocator->realloc)(
       self->allocatorContext,
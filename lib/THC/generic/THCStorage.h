@@ -23,9 +23,16 @@ THC_API real* THCStorage_(data)(THCState *state, const THCStorage*);
 THC_API ptrdiff_t THCStorage_(size)(THCState *state, const THCStorage*);
 THC_API int THCStorage_(elementSize)(THCState *state);
 
-/* slow access -- checks everything */
+/* slow access -- checks everything. Both go through a pinned buffer on the
+   current stream: set returns once the value is queued, get waits for the
+   current stream only. */
 THC_API void THCStorage_(set)(THCState *state, THCStorage*, ptrdiff_t, real);
 THC_API real THCStorage_(get)(THCState *state, const THCStorage*, ptrdiff_t);
+/* The same for n elements at once, with one transfer each way: values[i]
+   is the element at offsets[i]. Of repeated offsets in setMany, any one of
+   the values may be the one written. */
+THC_API void THCStorage_(getMany)(THCState *state, const THCStorage*, const ptrdiff_t *offsets, ptrdiff_t n, real *values);
+THC_API void THCStorage_(setMany)(THCState *state, THCStorage*, const ptrdiff_t *offsets, ptrdiff_t n, const real *values);
 
 THC_API THCStorage* THCStorage_(new)(THCState *state);
 THC_API THCStorage* THCStorage_(newWithSize)(THCState *state, ptrdiff_t size);
@@ -0,0 +1,583 @@
+#ifndef THC_GENERIC_FILE
+#define THC_GENERIC_FILE "generic/THCTensorConv.cu"
+#else
+
+#ifdef THC_REAL_IS_HALF
+#define THC_CONV_GEMM_STRIDED_BATCHED THCudaBlas_HgemmStridedBatched
+#elif defined(THC_REAL_IS_FLOAT)
+#define THC_CONV_GEMM_STRIDED_BATCHED THCudaBlas_SgemmStridedBatched
+#elif defined(THC_REAL_IS_DOUBLE)
+#define THC_CONV_GEMM_STRIDED_BATCHED THCudaBlas_DgemmStridedBatched
+#endif
+
+/*
+ * Picks the conv2D algorithm for a 'v' convolution of the given shape,
+ * unless one is forced through THCState_setConvAlgorithm:
+ *   - tiny problems, dominated by launch overhead, run on the direct kernel,
+ *     which is a single launch
+ *   - large kernels with unit stride run through the FFT, whose cost does
+ *     not grow with the kernel size, as long as the spectra of the kernel and
+ *     of one image fit in THC_CONV_MAX_BUFFER_ELEMENTS
+ *   - 3x3 kernels with unit stride run Winograd F(2x2, 3x3), once there are
+ *     enough planes for the GEMMs to outweigh the transforms
+ *   - everything else runs im2col + GEMM
+ */
+static int THCTensor_(conv2DAlgorithm)(THCState *state, long nbatch,
+                                       long nInputPlane, long nOutputPlane,
+                                       long nInputRows, long nInputCols,
+                                       long nKernelRows, long nKernelCols,
+                                       long nOutputRows, long nOutputCols,
+                                       long srow, long scol)
+{
+  int winogradApplies = nKernelRows == 3 && nKernelCols == 3 && srow == 1 && scol == 1;
+  int fftApplies = srow == 1 && scol == 1 &&
+    THCTensorConv_fftElements(nInputPlane, nOutputPlane, nInputRows, nInputCols,
+                              nKernelRows, nKernelCols) <= THC_CONV_MAX_BUFFER_ELEMENTS;
+  int algorithm = THCState_getConvAlgorithm(state);
+
+  if ((algorithm == THC_CONV_ALGO_WINOGRAD && !winogradApplies) ||
+      (algorithm == THC_CONV_ALGO_FFT && !fftApplies)) {
+    return THC_CONV_ALGO_IM2COL;
+  }
+  if (algorithm != THC_CONV_ALGO_AUTO) {
+    return algorithm;
+  }
+
+  if (nbatch * nOutputPlane * nOutputRows * nOutputCols <= THC_CONV_DIRECT_MAX_OUTPUTS) {
+    return THC_CONV_ALGO_DIRECT;
+  }
+  if (fftApplies && nKernelRows * nKernelCols >= THC_CONV_FFT_MIN_KERNEL_ELEMENTS) {
+    return THC_CONV_ALGO_FFT;
+  }
+  if (winogradApplies &&
+      nInputPlane >= THC_CONV_WINOGRAD_MIN_PLANES &&
+      nOutputPlane >= THC_CONV_WINOGRAD_MIN_PLANES) {
+    return THC_CONV_ALGO_WINOGRAD;
+  }
+  return THC_CONV_ALGO_IM2COL;
+}
+
+static void THCTensor_(conv2DDirect)(THCState *state, real *output_data,
+                                     real *input_data, real *weight_data,
+                                     long nbatch, long nInputPlane, long nInputRows, long nInputCols,
+                                     long nOutputPlane, long nKernelRows, long nKernelCols,
+                                     long srow, long scol, char xc)
+{
+  // cuda blocks & threads:
+  int yblocks = (int)(16L / nOutputPlane);
+  yblocks = yblocks < 1 ? 1 : yblocks;
+  dim3 blocks(nOutputPlane*nbatch,yblocks);
+  dim3 threads(32,8);
+
+  // convolution: xcorr2 or conv2
+  if (xc == 'x') {
+#define X_CONV_KERNEL(dim)\
+    hipLaunchKernelGGL(\
+      (conv2generic<real, accreal, false, (dim), (dim)>),\
+      dim3(blocks),\
+      dim3(threads),\
+      0,\
+      THCState_getCurrentStream(state),\
+      input_data,\
+      weight_data,\
+      output_data,\
+      nInputPlane,\
+      nInputRows,\
+      nInputCols,\
+      nOutputPlane*nInputPlane,\
+      nKernelRows,\
+      nKernelCols,\
+      srow,\
+      scol);
+
+    FOR_KERNEL_SPECIALIZED_DIMENSION(nKernelRows, nKernelCols, X_CONV_KERNEL);
+#undef X_CONV_KERNEL
+  } else { // 'c'
+#define C_CONV_KERNEL(dim)\
+    hipLaunchKernelGGL(\
+      (conv2generic<real, accreal, true, (dim), (dim)>),\
+      dim3(blocks),\
+      dim3(threads),\
+      0,\
+      THCState_getCurrentStream(state),\
+      input_data,\
+      weight_data,\
+      output_data,\
+      nInputPlane,\
+      nInputRows,\
+      nInputCols,\
+      nOutputPlane*nInputPlane,\
+      nKernelRows,\
+      nKernelCols,\
+      srow,\
+      scol);
+
+    FOR_KERNEL_SPECIALIZED_DIMENSION(nKernelRows, nKernelCols, C_CONV_KERNEL);
+#undef C_CONV_KERNEL
+  }
+}
+
+static void THCTensor_(conv2DIm2col)(THCState *state, real *output_data,
+                                     real *input_data, real *weight_data,
+                                     long nbatch, long nInputPlane, long nInputRows, long nInputCols,
+                                     long nOutputPlane, long nKernelRows, long nKernelCols,
+                                     long nOutputRows, long nOutputCols,
+                                     long srow, long scol, char xc)
+{
+  long nrows = nInputPlane * nKernelRows * nKernelCols;
+  long npixels = nOutputRows * nOutputCols;
+
+  long chunk = THC_CONV_MAX_BUFFER_ELEMENTS / (nrows * npixels);
+  chunk = chunk < 1 ? 1 : (chunk > nbatch ? nbatch : chunk);
+
+  THCTensor *columns = THCTensor_(newWithSize1d)(state, chunk * nrows * npixels);
+  real *columns_data = THCTensor_(data)(state, columns);
+  real one = ScalarConvert<int, real>::to(1);
+
+  for (long b = 0; b < nbatch; b += chunk) {
+    long nb = nbatch - b < chunk ? nbatch - b : chunk;
+    long n = nb * nrows * npixels;
+    real *input_b = input_data + b * nInputPlane * nInputRows * nInputCols;
+
+    if (xc == 'x') {
+      hipLaunchKernelGGL(
+        (conv2im2col<real, false>),
+        THCTensorConv_grid(n), dim3(THC_CONV_THREADS), 0, THCState_getCurrentStream(state),
+        input_b, columns_data, n, nInputPlane, nInputRows, nInputCols,
+        nKernelRows, nKernelCols, srow, scol, nOutputRows, nOutputCols);
+    } else {
+      hipLaunchKernelGGL(
+        (conv2im2col<real, true>),
+        THCTensorConv_grid(n), dim3(THC_CONV_THREADS), 0, THCState_getCurrentStream(state),
+        input_b, columns_data, n, nInputPlane, nInputRows, nInputCols,
+        nKernelRows, nKernelCols, srow, scol, nOutputRows, nOutputCols);
+    }
+    THCudaCheck(hipGetLastError());
+
+    // output[b] (nOutputPlane x npixels) += kernel (nOutputPlane x nrows) *
+    // columns[b] (nrows x npixels); column-major, that is
+    // output[b]' += columns[b]' * kernel', with the kernel shared (stride 0)
+    THC_CONV_GEMM_STRIDED_BATCHED(
+      state, 'n', 'n', npixels, nOutputPlane, nrows, one,
+      columns_data, npixels, nrows * npixels,
+      weight_data, nrows, 0,
+      one, output_data + b * nOutputPlane * npixels, npixels, nOutputPlane * npixels,
+      nb);
+  }
+
+  THCTensor_(free)(state, columns);
+}
+
+static void THCTensor_(conv2DWinograd)(THCState *state, real *output_data,
+                                       real *input_data, real *weight_data,
+                                       long nbatch, long nInputPlane, long nInputRows, long nInputCols,
+                                       long nOutputPlane, long nOutputRows, long nOutputCols,
+                                       char xc)
+{
+  long tilesRows = (nOutputRows + 1) / 2;
+  long tilesCols = (nOutputCols + 1) / 2;
+  long tilesPerImage = tilesRows * tilesCols;
+
+  long chunk = THC_CONV_MAX_BUFFER_ELEMENTS / (16 * (nInputPlane + nOutputPlane) * tilesPerImage);
+  chunk = chunk < 1 ? 1 : (chunk > nbatch ? nbatch : chunk);
+
+  THCTensor *kernelT = THCTensor_(newWithSize1d)(state, 16 * nOutputPlane * nInputPlane);
+  THCTensor *inputT = THCTensor_(newWithSize1d)(state, 16 * nInputPlane * chunk * tilesPerImage);
+  THCTensor *products = THCTensor_(newWithSize1d)(state, 16 * nOutputPlane * chunk * tilesPerImage);
+  real *kernelT_data = THCTensor_(data)(state, kernelT);
+  real *inputT_data = THCTensor_(data)(state, inputT);
+  real *products_data = THCTensor_(data)(state, products);
+
+  long nkernels = nOutputPlane * nInputPlane;
+  if (xc == 'x') {
+    hipLaunchKernelGGL(
+      (conv2winogradKernel<real, accreal, false>),
+      THCTensorConv_grid(nkernels), dim3(THC_CONV_THREADS), 0, THCState_getCurrentStream(state),
+      weight_data, kernelT_data, nOutputPlane, nInputPlane);
+  } else {
+    hipLaunchKernelGGL(
+      (conv2winogradKernel<real, accreal, true>),
+      THCTensorConv_grid(nkernels), dim3(THC_CONV_THREADS), 0, THCState_getCurrentStream(state),
+      weight_data, kernelT_data, nOutputPlane, nInputPlane);
+  }
+  THCudaCheck(hipGetLastError());
+
+  real one = ScalarConvert<int, real>::to(1);
+  real zero = ScalarConvert<int, real>::to(0);
+
+  for (long b = 0; b < nbatch; b += chunk) {
+    long nb = nbatch - b < chunk ? nbatch - b : chunk;
+    long ntiles = nb * tilesPerImage;
+
+    hipLaunchKernelGGL(
+      (conv2winogradInput<real, accreal>),
+      THCTensorConv_grid(ntiles * nInputPlane), dim3(THC_CONV_THREADS), 0,
+      THCState_getCurrentStream(state),
+      input_data + b * nInputPlane * nInputRows * nInputCols, inputT_data,
+      nb, nInputPlane, nInputRows, nInputCols, tilesRows, tilesCols);
+    THCudaCheck(hipGetLastError());
+
+    // for each of the 16 tile positions, products (nOutputPlane x ntiles) =
+    // kernelT (nOutputPlane x nInputPlane) * inputT (nInputPlane x ntiles)
+    THC_CONV_GEMM_STRIDED_BATCHED(
+      state, 'n', 'n', ntiles, nOutputPlane, nInputPlane, one,
+      inputT_data, ntiles, nInputPlane * ntiles,
+      kernelT_data, nInputPlane, nkernels,
+      zero, products_data, ntiles, nOutputPlane * ntiles,
+      16);
+
+    hipLaunchKernelGGL(
+      (conv2winogradOutput<real, accreal>),
+      THCTensorConv_grid(ntiles * nOutputPlane), dim3(THC_CONV_THREADS), 0,
+      THCState_getCurrentStream(state),
+      products_data, output_data + b * nOutputPlane * nOutputRows * nOutputCols,
+      nb, nOutputPlane, nOutputRows, nOutputCols, tilesRows, tilesCols);
+    THCudaCheck(hipGetLastError());
+  }
+
+  THCTensor_(free)(state, kernelT);
+  THCTensor_(free)(state, inputT);
+  THCTensor_(free)(state, products);
+}
+
+// output += 'v' or 'f' convolution of a batch of contiguous 3D inputs, with
+// unit stride, as a product of 2D FFTs. Inputs and kernels are zero-padded
+// to power-of-two sizes at least as large as the full convolution, so the
+// circular convolution of the FFT is the linear one; xcorr flips the kernel
+// while padding it. Transforms are computed in accreal.
+static void THCTensor_(conv2DFFT)(THCState *state, real *output_data,
+                                  real *input_data, real *weight_data,
+                                  long nbatch, long nInputPlane, long nInputRows, long nInputCols,
+                                  long nOutputPlane, long nKernelRows, long nKernelCols,
+                                  long nOutputRows, long nOutputCols, char vf, char xc)
+{
+  long fftRows = THCTensorConv_nextPow2(nInputRows + nKernelRows - 1);
+  long fftCols = THCTensorConv_nextPow2(nInputCols + nKernelCols - 1);
+  long nfreq = fftRows * fftCols;
+
+  // conv2DAlgorithm only picks the FFT when the kernel spectra and one image
+  // fit in the buffer bound; the rest of it goes to the batch
+  long kernelElements = nOutputPlane * nInputPlane * nfreq;
+  long chunk = (THC_CONV_MAX_BUFFER_ELEMENTS - kernelElements) / (nfreq * (nInputPlane + nOutputPlane));
+  chunk = chunk < 1 ? 1 : (chunk > nbatch ? nbatch : chunk);
+
+  long inputElements = chunk * nInputPlane * nfreq;
+  long outputElements = chunk * nOutputPlane * nfreq;
+  long scratchElements = kernelElements;
+  scratchElements = inputElements > scratchElements ? inputElements : scratchElements;
+  scratchElements = outputElements > scratchElements ? outputElements : scratchElements;
+
+  THCComplex<accreal> *kernelF, *inputF, *outputF, *scratch;
+  THCudaCheck(THCudaMalloc(state, (void**) &kernelF, kernelElements * sizeof(THCComplex<accreal>)));
+  THCudaCheck(THCudaMalloc(state, (void**) &inputF, inputElements * sizeof(THCComplex<accreal>)));
+  THCudaCheck(THCudaMalloc(state, (void**) &outputF, outputElements * sizeof(THCComplex<accreal>)));
+  THCudaCheck(THCudaMalloc(state, (void**) &scratch, scratchElements * sizeof(THCComplex<accreal>)));
+
+  hipStream_t stream = THCState_getCurrentStream(state);
+
+  hipLaunchKernelGGL(
+    (conv2fftPad<real, accreal>),
+    THCTensorConv_grid(kernelElements), dim3(THC_CONV_THREADS), 0, stream,
+    weight_data, kernelF, kernelElements, nKernelRows, nKernelCols, fftRows, fftCols, xc == 'x');
+  THCudaCheck(hipGetLastError());
+  THCFFT_transform2d<accreal>(state, kernelF, scratch, nOutputPlane * nInputPlane,
+                              fftRows, fftCols, false);
+
+  long rowOffset = vf == 'f' ? 0 : nKernelRows - 1;
+  long colOffset = vf == 'f' ? 0 : nKernelCols - 1;
+  accreal scale = (accreal) 1 / (accreal) nfreq;
+
+  for (long b = 0; b < nbatch; b += chunk) {
+    long nb = nbatch - b < chunk ? nbatch - b : chunk;
+    long nInputF = nb * nInputPlane * nfreq;
+    long nOutputF = nb * nOutputPlane * nfreq;
+    long nOutput = nb * nOutputPlane * nOutputRows * nOutputCols;
+
+    hipLaunchKernelGGL(
+      (conv2fftPad<real, accreal>),
+      THCTensorConv_grid(nInputF), dim3(THC_CONV_THREADS), 0, stream,
+      input_data + b * nInputPlane * nInputRows * nInputCols, inputF, nInputF,
+      nInputRows, nInputCols, fftRows, fftCols, false);
+    THCudaCheck(hipGetLastError());
+    THCFFT_transform2d<accreal>(state, inputF, scratch, nb * nInputPlane,
+                                fftRows, fftCols, false);
+
+    hipLaunchKernelGGL(
+      (conv2fftMultiply<accreal>),
+      THCTensorConv_grid(nOutputF), dim3(THC_CONV_THREADS), 0, stream,
+      inputF, kernelF, outputF, nOutputF, nInputPlane, nOutputPlane, nfreq);
+    THCudaCheck(hipGetLastError());
+    THCFFT_transform2d<accreal>(state, outputF, scratch, nb * nOutputPlane,
+                                fftRows, fftCols, true);
+
+    hipLaunchKernelGGL(
+      (conv2fftExtract<real, accreal>),
+      THCTensorConv_grid(nOutput), dim3(THC_CONV_THREADS), 0, stream,
+      outputF, output_data + b * nOutputPlane * nOutputRows * nOutputCols, nOutput,
+      nOutputRows, nOutputCols, fftRows, fftCols, rowOffset, colOffset, scale);
+    THCudaCheck(hipGetLastError());
+  }
+
+  THCudaCheck(THCudaFree(state, kernelF));
+  THCudaCheck(THCudaFree(state, inputF));
+  THCudaCheck(THCudaFree(state, outputF));
+  THCudaCheck(THCudaFree(state, scratch));
+}
+
+// output += 'v' convolution of a batch of contiguous 3D inputs, with any
+// algorithm but the FFT
+static void THCTensor_(conv2DValid)(THCState *state, int algorithm, real *output_data,
+                                    real *input_data, real *weight_data,
+                                    long nbatch, long nInputPlane, long nInputRows, long nInputCols,
+                                    long nOutputPlane, long nKernelRows, long nKernelCols,
+                                    long nOutputRows, long nOutputCols,
+                                    long srow, long scol, char xc)
+{
+  switch (algorithm) {
+    case THC_CONV_ALGO_DIRECT:
+      THCTensor_(conv2DDirect)(state, output_data, input_data, weight_data,
+                               nbatch, nInputPlane, nInputRows, nInputCols,
+                               nOutputPlane, nKernelRows, nKernelCols, srow, scol, xc);
+      break;
+    case THC_CONV_ALGO_WINOGRAD:
+      THCTensor_(conv2DWinograd)(state, output_data, input_data, weight_data,
+                                 nbatch, nInputPlane, nInputRows, nInputCols,
+                                 nOutputPlane, nOutputRows, nOutputCols, xc);
+      break;
+    default:
+      THCTensor_(conv2DIm2col)(state, output_data, input_data, weight_data,
+                               nbatch, nInputPlane, nInputRows, nInputCols,
+                               nOutputPlane, nKernelRows, nKernelCols,
+                               nOutputRows, nOutputCols, srow, scol, xc);
+      break;
+  }
+}
+
+/*
+ * API-compatible with THRealTensor_conv2Dmv
+ * 3D input, 4D kernel, 3D output
+ * matrix vector product like: y <- Ax + beta*y
+ */
+THC_API void THCTensor_(conv2Dmv)(THCState *state, THCTensor *output, real beta, THCTensor *input,
+                                  THCTensor *kernel, long srow, long scol, const char *type)
+{
+  THAssert(THCTensor_(checkGPU)(state, 3, output, input, kernel));
+  long nInputPlane, nInputRows, nInputCols;
+  long nKernelRows, nKernelCols;
+  long nOutputPlane, nOutputRows, nOutputCols;
+
+  THArgCheck(kernel->nDimension == 4 , 4, "kernel: 4D Tensor expected");
+  THArgCheck(srow >= 1, 5, "Stride should be a positive integer");
+  THArgCheck(scol >= 1, 6, "Stride should be a positive integer");
+  THArgCheck(type[0] == 'v' || type[0] == 'f', 7, "type of convolution can 'v' or 'f'");
+  THArgCheck(type[1] == 'c' || type[1] == 'x', 7, "type of convolution can 'x' or 'c'");
+
+  input = THCTensor_(newContiguous)(state, input);
+  kernel = THCTensor_(newContiguous)(state, kernel);
+
+  nInputPlane = input->size[0];
+  nInputRows  = input->size[1];
+  nInputCols  = input->size[2];
+
+  nKernelRows  = kernel->size[2];
+  nKernelCols  = kernel->size[3];
+  nOutputPlane = kernel->size[0];
+  THArgCheck(kernel->size[1] == nInputPlane, 2, "invalid number of input planes");
+
+  THArgCheck( (nInputRows >= nKernelRows && nInputCols >= nKernelCols) || *type == 'f', 2,
+              "conv2Dmv : Input image is smaller than kernel");
+
+  // output dims
+  if (*type == 'f') {
+    nOutputRows = (nInputRows - 1) * srow + nKernelRows;
+    nOutputCols = (nInputCols - 1) * scol + nKernelCols;
+  } else { // 'v'
+    nOutputRows = (nInputRows - nKernelRows) / srow + 1;
+    nOutputCols = (nInputCols - nKernelCols) / scol + 1;
+  }
+
+  int algorithm = THCTensor_(conv2DAlgorithm)(state, 1, nInputPlane, nOutputPlane,
+                                              nInputRows, nInputCols, nKernelRows, nKernelCols,
+                                              nOutputRows, nOutputCols, srow, scol);
+
+  // the FFT computes 'f' convolutions directly; the other algorithms run a
+  // 'v' convolution of a zero-padded copy of the input
+  if (*type == 'f' && algorithm != THC_CONV_ALGO_FFT) {
+    // use temp buffer
+    THCTensor *inputP = THCTensor_(new)(state);
+
+    // create a zero-padded input
+    long nInputRowsPadded = (nOutputRows - 1) * srow + nKernelRows;
+    long nInputColsPadded = (nOutputCols - 1) * scol + nKernelCols;
+    THCTensor_(resize3d)(state, inputP, nInputPlane, nInputRowsPadded, nInputColsPadded);
+    THCTensor_(zero)(state, inputP);
+
+    THCTensor *centered = THCTensor_(new)(state);
+    THCTensor_(narrow)(state, centered, inputP, 2, nKernelCols-1, nInputCols);
+    THCTensor_(narrow)(state, centered, NULL, 1, nKernelRows-1, nInputRows);
+    THCTensor_(copy)(state, centered, input);
+    THCTensor_(free)(state, centered);
+
+    // remap input to newly created tensor
+    THCTensor_(free)(state, input);
+    input = inputP;
+    nInputRows = nInputRowsPadded;
+    nInputCols = nInputColsPadded;
+  }
+
+  ptrdiff_t nelem = THCTensor_(nElement)(state, output);
+  THCTensor_(resize3d)(state, output, nOutputPlane, nOutputRows, nOutputCols);
+
+  if (THCNumerics<real>::eq(beta, ScalarConvert<int, real>::to(0)) ||
+      nelem != THCTensor_(nElement)(state, output)) {
+    THCTensor_(zero)(state, output);
+  } else if (!THCNumerics<real>::eq(beta, ScalarConvert<int, real>::to(1))) {
+    THCTensor_(mul)(state, output, output, beta);
+  }
+
+  if (algorithm == THC_CONV_ALGO_FFT) {
+    THCTensor_(conv2DFFT)(state,
+                          THCTensor_(data)(state, output),
+                          THCTensor_(data)(state, input),
+                          THCTensor_(data)(state, kernel),
+                          1, nInputPlane, nInputRows, nInputCols,
+                          nOutputPlane, nKernelRows, nKernelCols,
+                          nOutputRows, nOutputCols, type[0], type[1]);
+  } else {
+    THCTensor_(conv2DValid)(state, algorithm,
+                            THCTensor_(data)(state, output),
+                            THCTensor_(data)(state, input),
+                            THCTensor_(data)(state, kernel),
+                            1, nInputPlane, nInputRows, nInputCols,
+                            nOutputPlane, nKernelRows, nKernelCols,
+                            nOutputRows, nOutputCols, srow, scol, type[1]);
+  }
+
+  // clean
+  THCTensor_(free)(state, input);
+  THCTensor_(free)(state, kernel);
+
+  // check for errors
+  hipError_t err = hipGetLastError();
+  if (err != hipSuccess) {
+    printf("error in conv2Dmv: %s\n", hipGetErrorString(err));
+    THError("aborting");
+  }
+}
+
+/*
+ * API-compatible with THRealTensor_conv2Dmm
+ * 4D input, 4D kernel, 4D output
+ * matrix vector product like: y <- Ax + beta*y
+ */
+THC_API void THCTensor_(conv2Dmm)(THCState *state, THCTensor *output, real beta, THCTensor *input,
+                                  THCTensor *kernel, long srow, long scol, const char *type)
+{
+  THAssert(THCTensor_(checkGPU)(state, 3, output, input, kernel));
+  long nbatch, nInputPlane, nInputRows, nInputCols;
+  long nKernelRows, nKernelCols;
+  long nOutputPlane, nOutputRows, nOutputCols;
+
+  THArgCheck(kernel->nDimension == 4 , 4, "kernel: 4D Tensor expected");
+  THArgCheck(srow >= 1, 5, "Stride should be a positive integer");
+  THArgCheck(scol >= 1, 6, "Stride should be a positive integer");
+  THArgCheck(type[0] == 'v' || type[0] == 'f', 7, "type of convolution can 'v' or 'f'");
+  THArgCheck(type[1] == 'c' || type[1] == 'x', 7, "type of convolution can 'x' or 'c'");
+
+  input = THCTensor_(newContiguous)(state, input);
+  kernel = THCTensor_(newContiguous)(state, kernel);
+
+  nbatch      = input->size[0];
+  nInputPlane = input->size[1];
+  nInputRows  = input->size[2];
+  nInputCols  = input->size[3];
+
+  nKernelRows  = kernel->size[2];
+  nKernelCols  = kernel->size[3];
+  nOutputPlane = kernel->size[0];
+  THArgCheck(kernel->size[1] == nInputPlane, 2, "invalid number of input planes");
+
+  THArgCheck( (nInputRows >= nKernelRows && nInputCols >= nKernelCols) || *type == 'f', 2,
+              "conv2Dmm : Input image is smaller than kernel");
+
+  // output dims
+  if (*type == 'f') {
+    nOutputRows = (nInputRows - 1) * srow + nKernelRows;
+    nOutputCols = (nInputCols - 1) * scol + nKernelCols;
+  } else { // 'v'
+    nOutputRows = (nInputRows - nKernelRows) / srow + 1;
+    nOutputCols = (nInputCols - nKernelCols) / scol + 1;
+  }
+
+  int algorithm = THCTensor_(conv2DAlgorithm)(state, nbatch, nInputPlane, nOutputPlane,
+                                              nInputRows, nInputCols, nKernelRows, nKernelCols,
+                                              nOutputRows, nOutputCols, srow, scol);
+
+  // the FFT computes 'f' convolutions directly; the other algorithms run a
+  // 'v' convolution of a zero-padded copy of the input
+  if (*type == 'f' && algorithm != THC_CONV_ALGO_FFT) {
+    // use temp buffer
+    THCTensor *inputP = THCTensor_(new)(state);
+
+    // create a zero-padded input
+    long nInputRowsPadded = (nOutputRows - 1) * srow + nKernelRows;
+    long nInputColsPadded = (nOutputCols - 1) * scol + nKernelCols;
+    THCTensor_(resize4d)(state, inputP, nbatch, nInputPlane, nInputRowsPadded, nInputColsPadded);
+    THCTensor_(zero)(state, inputP);
+
+    THCTensor *centered = THCTensor_(new)(state);
+    THCTensor_(narrow)(state, centered, inputP, 3, nKernelCols-1, nInputCols);
+    THCTensor_(narrow)(state, centered, NULL, 2, nKernelRows-1, nInputRows);
+    THCTensor_(copy)(state, centered, input);
+    THCTensor_(free)(state, centered);
+
+    // remap input to newly created tensor
+    THCTensor_(free)(state, input);
+    input = inputP;
+    nInputRows = nInputRowsPadded;
+    nInputCols = nInputColsPadded;
+  }
+
+  ptrdiff_t nelem = THCTensor_(nElement)(state, output);
+  THCTensor_(resize4d)(state, output, nbatch, nOutputPlane, nOutputRows, nOutputCols);
+
+  if (THCNumerics<real>::eq(beta, ScalarConvert<int, real>::to(0)) ||
+      nelem != THCTensor_(nElement)(state, output)) {
+    THCTensor_(zero)(state, output);
+  } else if (!THCNumerics<real>::eq(beta, ScalarConvert<int, real>::to(1))) {
+    THCTensor_(mul)(state, output, output, beta);
+  }
+
+  if (algorithm == THC_CONV_ALGO_FFT) {
+    THCTensor_(conv2DFFT)(state,
+                          THCTensor_(data)(state, output),
+                          THCTensor_(data)(state, input),
+                          THCTensor_(data)(state, kernel),
+                          nbatch, nInputPlane, nInputRows, nInputCols,
+                          nOutputPlane, nKernelRows, nKernelCols,
+                          nOutputRows, nOutputCols, type[0], type[1]);
+  } else {
+    THCTensor_(conv2DValid)(state, algorithm,
+                            THCTensor_(data)(state, output),
+                            THCTensor_(data)(state, input),
+                            THCTensor_(data)(state, kernel),
+                            nbatch, nInputPlane, nInputRows, nInputCols,
+                            nOutputPlane, nKernelRows, nKernelCols,
+                            nOutputRows, nOutputCols, srow, scol, type[1]);
+  }
+
+  // clean
+  THCTensor_(free)(state, input);
+  THCTensor_(free)(state, kernel);
+
+  // check for errors
+  hipError_t err = hipGetLastError();
+  if (err != hipSuccess) {
+    printf("error in conv2Dmm: %s\n", hipGetErrorString(err));
+    THError("aborting");
+  }
+}
+
+#undef THC_CONV_GEMM_STRIDED_BATCHED
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef THC_GENERIC_FILE
+#define THC_GENERIC_FILE "generic/THCTensorConv.h"
+#else
+
+/* conv2Dmv and conv2Dmm pick between a direct kernel, im2col + GEMM and
+   Winograd F(2x2, 3x3) per call; see THCState_setConvAlgorithm. */
+THC_API void THCTensor_(conv2Dmv)(struct THCState *state, THCTensor *output,
+                                  real beta, THCTensor *input, THCTensor *kernel,
+                                  long srow, long scol, const char *type);
+THC_API void THCTensor_(conv2Dmm)(struct THCState *state, THCTensor *output,
+                                  real beta, THCTensor *input, THCTensor *kernel,
+                                  long srow, long scol, const char *type);
+
+#endif
@@ -24,45 +24,84 @@ void THCTensor_(copyCPU)(THCState *state, THCTensor *self, struct THTensor *src)
 }
 #endif
 
+/* Sources of another type are uploaded as they are, on the device of self,
+   and converted there: a byte tensor moves a quarter of the bytes of the
+   float tensor it becomes. */
+#define THC_UPLOAD_NATIVE(TYPEC, TYPECUDA, CONVERT)                     \
+  {                                                                     \
+    int tensorDevice = THCTensor_(getDevice)(state, self);              \
+    int currentDevice;                                                  \
+    THCudaCheck(hipGetDevice(&currentDevice));                          \
+    if (currentDevice != tensorDevice) {                                \
+      THCudaCheck(hipSetDevice(tensorDevice));                          \
+    }                                                                   \
+    THLongStorage *size = TH##TYPEC##Tensor_newSizeOf(src);             \
+    THCuda##TYPECUDA##Tensor *buffer = THCuda##TYPECUDA##Tensor_newWithSize(state, size, NULL); \
+    THCuda##TYPECUDA##Tensor_copyCPU(state, buffer, src);               \
+    CONVERT;                                                            \
+    THCuda##TYPECUDA##Tensor_free(state, buffer);                       \
+    THLongStorage_free(size);                                           \
+    if (currentDevice != tensorDevice) {                                \
+      THCudaCheck(hipSetDevice(currentDevice));                         \
+    }                                                                   \
+  }
+
 #ifndef THC_REAL_IS_HALF
-#define IMPLEMENT_TH_CUDA_TENSOR_COPY(TYPEC)                            \
+#define IMPLEMENT_TH_CUDA_TENSOR_COPY(TYPEC, TYPECUDA)                  \
 void THCTensor_(copy##TYPEC)(THCState *state, THCTensor *self, struct TH##TYPEC##Tensor *src)                \
 {                                                                       \
   THArgCheck(THCTensor_(nElement)(state, self) == TH##TYPEC##Tensor_nElement(src), 2, "sizes do not match"); \
   if(THCTypeIdx_(Real) == THCTypeIdx_(TYPEC)) {               \
     THCTensor_(copyCPU)(state, self, (THTensor*) src);  /* cast just removes warnings */                     \
-  } else {                                                              \
-    THLongStorage *size = TH##TYPEC##Tensor_newSizeOf(src);             \
-    THTensor *srcf = THTensor_(newWithSize)(size, NULL);                \
-                                                                        \
-    THTensor_(copy##TYPEC)(srcf, src);                                  \
-    THCTensor_(copyCPU)(state, self, srcf);                             \
-                                                                        \
-    THLongStorage_free(size);                                           \
-    THTensor_(free)(srcf);                                              \
+  } else if (THCTensor_(nElement)(state, self) > 0) {                   \
+    THC_UPLOAD_NATIVE(TYPEC, TYPECUDA,                                  \
+                      THCTensor_(copyCuda##TYPEC)(state, self, buffer)) \
   }                                                                     \
 }
 #else
-#define IMPLEMENT_TH_CUDA_TENSOR_COPY(TYPEC)                            \
+#define IMPLEMENT_TH_CUDA_TENSOR_COPY(TYPEC, TYPECUDA)                  \
 void THCTensor_(copy##TYPEC)(THCState *state, THCTensor *self, struct TH##TYPEC##Tensor *src)                \
 {                                                                       \
   THArgCheck(THCTensor_(nElement)(state, self) == TH##TYPEC##Tensor_nElement(src), 2, "sizes do not match"); \
-  THLongStorage *size = TH##TYPEC##Tensor_newSizeOf(src);               \
-  THCudaTensor *buffer = THCudaTensor_newWithSize(state, size, NULL);   \
-  THCudaTensor_copy##TYPEC(state, buffer, src);                         \
-  THCudaHalfTensor_copyCudaFloat(state, self, buffer);                  \
-  THCudaTensor_free(state, buffer);                                     \
-  THLongStorage_free(size);                                             \
+  if (THCTensor_(nElement)(state, self) > 0) {                          \
+    THC_UPLOAD_NATIVE(TYPEC, TYPECUDA,                                  \
+                      THCTensor_(copyCuda##TYPEC)(state, self, buffer)) \
+  }                                                                     \
 }
 #endif
 
-IMPLEMENT_TH_CUDA_TENSOR_COPY(Byte)
-IMPLEMENT_TH_CUDA_TENSOR_COPY(Char)
-IMPLEMENT_TH_CUDA_TENSOR_COPY(Short)
-IMPLEMENT_TH_CUDA_TENSOR_COPY(Int)
-IMPLEMENT_TH_CUDA_TENSOR_COPY(Long)
-IMPLEMENT_TH_CUDA_TENSOR_COPY(Float)
-IMPLEMENT_TH_CUDA_TENSOR_COPY(Double)
+IMPLEMENT_TH_CUDA_TENSOR_COPY(Byte, Byte)
+IMPLEMENT_TH_CUDA_TENSOR_COPY(Char, Char)
+IMPLEMENT_TH_CUDA_TENSOR_COPY(Short, Short)
+IMPLEMENT_TH_CUDA_TENSOR_COPY(Int, Int)
+IMPLEMENT_TH_CUDA_TENSOR_COPY(Long, Long)
+IMPLEMENT_TH_CUDA_TENSOR_COPY(Float, )
+IMPLEMENT_TH_CUDA_TENSOR_COPY(Double, Double)
+
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE) || defined(THC_REAL_IS_HALF)
+#define IMPLEMENT_TH_CUDA_TENSOR_COPY_SCALED(TYPEC, TYPECUDA)           \
+void THCTensor_(copyScaled##TYPEC)(THCState *state, THCTensor *self, struct TH##TYPEC##Tensor *src, \
+                                   accreal scale, accreal shift)        \
+{                                                                       \
+  THArgCheck(THCTensor_(nElement)(state, self) == TH##TYPEC##Tensor_nElement(src), 2, "sizes do not match"); \
+  if (THCTensor_(nElement)(state, self) > 0) {                          \
+    THC_UPLOAD_NATIVE(TYPEC, TYPECUDA,                                  \
+                      THCTensor_(copyScaledCuda##TYPEC)(state, self, buffer, scale, shift)) \
+  }                                                                     \
+}
+
+IMPLEMENT_TH_CUDA_TENSOR_COPY_SCALED(Byte, Byte)
+IMPLEMENT_TH_CUDA_TENSOR_COPY_SCALED(Char, Char)
+IMPLEMENT_TH_CUDA_TENSOR_COPY_SCALED(Short, Short)
+IMPLEMENT_TH_CUDA_TENSOR_COPY_SCALED(Int, Int)
+IMPLEMENT_TH_CUDA_TENSOR_COPY_SCALED(Long, Long)
+IMPLEMENT_TH_CUDA_TENSOR_COPY_SCALED(Float, )
+IMPLEMENT_TH_CUDA_TENSOR_COPY_SCALED(Double, Double)
+
+#undef IMPLEMENT_TH_CUDA_TENSOR_COPY_SCALED
+#endif
+
+#undef THC_UPLOAD_NATIVE
 
 /* copyCuda */
 
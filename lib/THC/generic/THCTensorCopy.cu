@@ -44,4 +44,49 @@ IMPLEMENT_THC_CUDA_TENSOR_COPY(Half, Half)
 
 #undef IMPLEMENT_THC_CUDA_TENSOR_COPY
 
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE) || defined(THC_REAL_IS_HALF)
+#define IMPLEMENT_THC_CUDA_TENSOR_COPY_SCALED(TYPEC, TYPECUDA)          \
+  THC_API void                                                          \
+  THCTensor_(copyScaledCuda##TYPEC)(THCState *state,                    \
+                                    THCTensor *self,                    \
+                                    THCuda##TYPECUDA##Tensor *src,      \
+                                    accreal scale, accreal shift) {     \
+    THArgCheck(THCTensor_(nElement)(state, self) ==                     \
+               THCuda##TYPECUDA##Tensor_nElement(state, src),           \
+               2, "sizes do not match");                                \
+    if (THCTensor_(nElement)(state, self) == 0) {                       \
+      return;                                                           \
+    }                                                                   \
+    int device = THCTensor_(getDevice)(state, self);                    \
+    THArgCheck(THCuda##TYPECUDA##Tensor_getDevice(state, src) == device, 3, \
+               "source and destination should be on the same device");  \
+    int oldDev = curGPU();                                              \
+    if (device != oldDev) {                                             \
+      THCudaCheck(hipSetDevice(device));                                \
+    }                                                                   \
+    bool succ = THC_pointwiseApply2(                                    \
+      state, self, src,                                                 \
+      CopyScaledOp<real,                                                \
+                   typename TensorUtils<THCuda##TYPECUDA##Tensor>::DataType, \
+                   accreal>(scale, shift));                             \
+    if (device != oldDev) {                                             \
+      THCudaCheck(hipSetDevice(oldDev));                                \
+    }                                                                   \
+    THArgCheck(succ, 2, CUTORCH_DIM_WARNING);                           \
+  }
+
+IMPLEMENT_THC_CUDA_TENSOR_COPY_SCALED(Byte, Byte)
+IMPLEMENT_THC_CUDA_TENSOR_COPY_SCALED(Char, Char)
+IMPLEMENT_THC_CUDA_TENSOR_COPY_SCALED(Short, Short)
+IMPLEMENT_THC_CUDA_TENSOR_COPY_SCALED(Int, Int)
+IMPLEMENT_THC_CUDA_TENSOR_COPY_SCALED(Long, Long)
+IMPLEMENT_THC_CUDA_TENSOR_COPY_SCALED(Float, )
+IMPLEMENT_THC_CUDA_TENSOR_COPY_SCALED(Double, Double)
+#ifdef CUDA_HALF_TENSOR
+IMPLEMENT_THC_CUDA_TENSOR_COPY_SCALED(Half, Half)
+#endif
+
+#undef IMPLEMENT_THC_CUDA_TENSOR_COPY_SCALED
+#endif
+
 #endif
@@ -23,6 +23,29 @@ THC_API void THCTensor_(copyCudaDouble)(THCState *state, THCTensor *dst, struct
 THC_API void THCTensor_(copyCudaHalf)(THCState *state, THCTensor *dst, struct THCudaHalfTensor *src);
 #endif
 
+/* self = src * scale + shift, converted on the device; host sources are
+   uploaded in their own type */
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE) || defined(THC_REAL_IS_HALF)
+THC_API void THCTensor_(copyScaledByte)(THCState *state, THCTensor *self, THByteTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledChar)(THCState *state, THCTensor *self, THCharTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledShort)(THCState *state, THCTensor *self, THShortTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledInt)(THCState *state, THCTensor *self, THIntTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledLong)(THCState *state, THCTensor *self, THLongTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledFloat)(THCState *state, THCTensor *self, THFloatTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledDouble)(THCState *state, THCTensor *self, THDoubleTensor *src, accreal scale, accreal shift);
+
+THC_API void THCTensor_(copyScaledCudaByte)(THCState *state, THCTensor *self, struct THCudaByteTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledCudaChar)(THCState *state, THCTensor *self, struct THCudaCharTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledCudaShort)(THCState *state, THCTensor *self, struct THCudaShortTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledCudaInt)(THCState *state, THCTensor *self, struct THCudaIntTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledCudaLong)(THCState *state, THCTensor *self, struct THCudaLongTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledCudaFloat)(THCState *state, THCTensor *self, struct THCudaTensor *src, accreal scale, accreal shift);
+THC_API void THCTensor_(copyScaledCudaDouble)(THCState *state, THCTensor *self, struct THCudaDoubleTensor *src, accreal scale, accreal shift);
+#ifdef CUDA_HALF_TENSOR
+THC_API void THCTensor_(copyScaledCudaHalf)(THCState *state, THCTensor *self, struct THCudaHalfTensor *src, accreal scale, accreal shift);
+#endif
+#endif
+
 THC_API void TH_CONCAT_2(THByteTensor_copyCuda  , Real)  (THCState *state, THByteTensor *self, THCTensor *src);
 THC_API void TH_CONCAT_2(THCharTensor_copyCuda  , Real)  (THCState *state, THCharTensor *self, THCTensor *src);
 THC_API void TH_CONCAT_2(THShortTensor_copyCuda , Real)  (THCState *state, THShortTensor *self, THCTensor *src);
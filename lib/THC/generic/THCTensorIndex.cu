@@ -196,6 +196,13 @@ void THCTensor_(indexAdd)(THCState *state, THCTensor *dst, int dim, THCudaLongTe
 
   int mpc = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
 
+#if defined(THC_REAL_IS_HALF) && defined(__HIP_PLATFORM_HCC__)
+  // atomicAdd is not implemented for half on this platform
+  int sorted = 1;
+#else
+  int sorted = THCState_getDeterministic(state);
+#endif
+
 #define SMALL_INDEX(TENSOR_TYPE, TYPE, DST_DIM, SRC_DIM, IDX_DIM) \
   hipLaunchKernelGGL(\
     (indexAddSmallIndex<TENSOR_TYPE, TYPE, DST_DIM, SRC_DIM, IDX_DIM>),\
@@ -251,7 +258,11 @@ void THCTensor_(indexAdd)(THCState *state, THCTensor *dst, int dim, THCudaLongTe
 
     // A reasonable choice for when to have each thread iterate over
     // indices to choose
-    if (numIndices <= 16) {
+    if (sorted) {
+      THC_sortedIndexAdd<real, accreal, unsigned int>(
+        state, dstInfo, srcInfo, dstAddDim, srcAddDim, sliceSize, dstAddDimSize,
+        indices, NULL);
+    } else if (numIndices <= 16) {
       if (dstInfo.dims == 1 && srcInfo.dims == 1 && indContig) {
         SMALL_INDEX(real, unsigned int, 1, 1, -2);
       } else if (dstInfo.dims == 2 && srcInfo.dims == 2 && indContig) {
@@ -287,7 +298,13 @@ void THCTensor_(indexAdd)(THCState *state, THCTensor *dst, int dim, THCudaLongTe
       getTensorInfo<THCudaLongTensor, unsigned long>(state, indices);
     indicesInfo.collapseDims();
 
-    LARGE_INDEX(real, unsigned long, -1, -1, -1);
+    if (sorted) {
+      THC_sortedIndexAdd<real, accreal, unsigned long>(
+        state, dstInfo, srcInfo, dstAddDim, srcAddDim, sliceSize, dstAddDimSize,
+        indices, NULL);
+    } else {
+      LARGE_INDEX(real, unsigned long, -1, -1, -1);
+    }
   }
 #undef SMALL_INDEX
 #undef LARGE_INDEX
@@ -435,6 +452,41 @@ void THCTensor_(indexSelect_long)(THCState *state, THCTensor *dst, THCTensor *sr
   THCudaLongTensor_free(state, indices_);
 }
 
+// indexSelect along the first dimension of contiguous tensors: whole rows
+// are copied with the widest accesses their size and alignment allow
+static void THCTensor_(indexSelectRows)(THCState *state, THCTensor *dst, THCTensor *src,
+                                        THCudaLongTensor *indices)
+{
+  long numIndices = THCudaLongTensor_nElement(state, indices);
+  long srcRows = THCTensor_(size)(state, src, 0);
+  if (numIndices == 0 || srcRows == 0) {
+    return;
+  }
+  size_t rowBytes = THCTensor_(nElement)(state, src) / srcRows * sizeof(real);
+  char *dstData = (char *) THCTensor_(data)(state, dst);
+  char *srcData = (char *) THCTensor_(data)(state, src);
+  const long *indicesData = THCudaLongTensor_data(state, indices);
+  size_t alignment = (size_t) dstData | (size_t) srcData | rowBytes;
+
+#define ROWS(UNIT) \
+  THC_indexSelectRows<UNIT>(state, (UNIT *) dstData, (const UNIT *) srcData, indicesData, \
+                            numIndices, rowBytes / sizeof(UNIT), srcRows)
+
+  if (alignment % sizeof(uint4) == 0) {
+    ROWS(uint4);
+  } else if (alignment % sizeof(uint2) == 0) {
+    ROWS(uint2);
+  } else if (alignment % sizeof(unsigned int) == 0) {
+    ROWS(unsigned int);
+  } else if (alignment % sizeof(unsigned short) == 0) {
+    ROWS(unsigned short);
+  } else {
+    ROWS(unsigned char);
+  }
+
+#undef ROWS
+}
+
 void THCTensor_(indexSelect)(THCState *state, THCTensor *dst, THCTensor *src, int dim, THCudaLongTensor *indices)
 {
   THAssert(THCTensor_(checkGPU)(state, 3, dst, src, indices));
@@ -463,6 +515,12 @@ void THCTensor_(indexSelect)(THCState *state, THCTensor *dst, THCTensor *src, in
 
   int indContig = THCudaLongTensor_isContiguous(state, indices);
 
+  if (dim == 0 && indContig &&
+      THCTensor_(isContiguous)(state, src) && THCTensor_(isContiguous)(state, dst)) {
+    THCTensor_(indexSelectRows)(state, dst, src, indices);
+    return;
+  }
+
   // The `src` is partitioned into two parts:
   // -the size of each slice we are indexing, which is the
   // total size of the tensor ignoring dimension `dim`;
@@ -573,4 +631,74 @@ void THCTensor_(indexSelect)(THCState *state, THCTensor *dst, THCTensor *src, in
 #undef LARGE_INDEX
 }
 
+void THCTensor_(embeddingBag)(THCState *state, THCTensor *dst, THCTensor *src,
+                              THCudaLongTensor *indices, THCudaLongTensor *offsets,
+                              int average)
+{
+  THAssert(THCTensor_(checkGPU)(state, 2, dst, src));
+  THAssert(THCudaLongTensor_checkGPU(state, 2, indices, offsets));
+  THArgCheck(THCTensor_(nDimension)(state, src) == 2, 2,
+             "expecting a matrix of rows to select from");
+  THArgCheck(THCudaLongTensor_nDimension(state, indices) == 1, 3,
+             "expecting vector of indices");
+  THArgCheck(THCudaLongTensor_nDimension(state, offsets) == 1, 4,
+             "expecting vector of bag offsets");
+
+  long numIndices = THCudaLongTensor_nElement(state, indices);
+  long numBags = THCudaLongTensor_nElement(state, offsets);
+  long srcRows = THCTensor_(size)(state, src, 0);
+  long rowSize = THCTensor_(size)(state, src, 1);
+
+  // the kernel trusts both: offsets must start the bags in order, within
+  // the indices, and every index must be a row of src
+  if (numIndices > 0) {
+    THArgCheck(THCudaLongTensor_minall(state, indices) - TH_INDEX_BASE >= 0 &&
+               THCudaLongTensor_maxall(state, indices) - TH_INDEX_BASE < srcRows, 3,
+               "index out of range");
+  }
+  if (numBags > 0) {
+    THLongTensor *hostOffsets = THLongTensor_newWithSize1d(numBags);
+    THLongTensor_copyCudaLong(state, hostOffsets, offsets);
+    const long *o = THLongTensor_data(hostOffsets);
+    long previous = 0;
+    long bad = -1;
+    for (long b = 0; b < numBags && bad < 0; ++b) {
+      long offset = o[b] - TH_INDEX_BASE;
+      if (offset < previous || offset > numIndices) {
+        bad = b;
+      }
+      previous = offset;
+    }
+    THLongTensor_free(hostOffsets);
+    THArgCheck(bad < 0, 4, "offset %ld is out of range or smaller than the previous one",
+               bad + TH_INDEX_BASE);
+  }
+
+  THCTensor_(resize2d)(state, dst, numBags, rowSize);
+  if (numBags == 0 || rowSize == 0) {
+    return;
+  }
+
+  THCTensor *dst_ = THCTensor_(newContiguous)(state, dst);
+  THCTensor *src_ = THCTensor_(newContiguous)(state, src);
+  THCudaLongTensor *indices_ = THCudaLongTensor_newContiguous(state, indices);
+  THCudaLongTensor *offsets_ = THCudaLongTensor_newContiguous(state, offsets);
+
+  dim3 block = getApplyRowBlock(rowSize);
+  int mpc = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
+  dim3 grid(std::min(THCCeilDiv(numBags, (long) block.y), (long) (mpc * 8)));
+
+  hipLaunchKernelGGL(
+    (embeddingBagKernel<real, accreal>), grid, block, 0, THCState_getCurrentStream(state),
+    THCTensor_(data)(state, dst_), THCTensor_(data)(state, src_),
+    THCudaLongTensor_data(state, indices_), THCudaLongTensor_data(state, offsets_),
+    numIndices, numBags, rowSize, srcRows, (bool) average);
+  THCudaCheck(hipGetLastError());
+
+  THCTensor_(free)(state, src_);
+  THCudaLongTensor_free(state, indices_);
+  THCudaLongTensor_free(state, offsets_);
+  THCTensor_(freeCopyTo)(state, dst_, dst);
+}
+
 #endif
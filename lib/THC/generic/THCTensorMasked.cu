@@ -127,6 +127,99 @@ THCTensor_(maskedCopyByte)(THCState* state,
   THCudaByteTensor_free(state, maskCuda);
 }
 
+// Compacts the elements of `src` where `mask` is set into the
+// contiguous array `out`, which must have room for nElement(src)
+// values, and writes the number selected to the device location
+// `count`. Runs as a single kernel; nothing is read back to the host.
+static bool
+THCTensor_(compactMasked)(THCState* state,
+                          real* out, long* count,
+                          THCTensor* src, THCudaByteTensor* mask)
+{
+  ptrdiff_t totalElements = THCTensor_(nElement)(state, src);
+  hipStream_t stream = THCState_getCurrentStream(state);
+
+  if (THCTensor_(nDimension)(state, src) > MAX_CUTORCH_DIMS ||
+      THCudaByteTensor_nDimension(state, mask) > MAX_CUTORCH_DIMS) {
+    return false;
+  }
+
+  if (totalElements == 0) {
+    THCudaCheck(hipMemsetAsync(count, 0, sizeof(long), stream));
+    return true;
+  }
+
+  ptrdiff_t numTiles = THC_getCompactTiles(totalElements);
+  dim3 grid;
+  if (!THC_getGridFromTiles(numTiles, grid)) {
+    return false;
+  }
+  dim3 block(THC_COMPACT_THREADS);
+
+  unsigned long long* tileStatus = THC_newCompactScratch(state, numTiles);
+  unsigned int* tileCounter = (unsigned int*) (tileStatus + numTiles);
+
+#define HANDLE_CASE(TYPE, SRC_DIMS, MASK_DIMS)\
+  hipLaunchKernelGGL(\
+    (kernelMaskedSelectCompact<real, unsigned char, TYPE, SRC_DIMS, MASK_DIMS>),\
+    grid,\
+    block,\
+    0,\
+    stream,\
+    make_magic_wrapper(srcInfo),\
+    make_magic_wrapper(maskInfo),\
+    out,\
+    (TYPE) totalElements,\
+    tileStatus,\
+    tileCounter,\
+    count);
+
+#define HANDLE_MASK_CASE(TYPE, SRC_DIMS)\
+  if (maskInfo.isContiguous()) {\
+    HANDLE_CASE(TYPE, SRC_DIMS, -2);\
+  } else if (maskInfo.dims == 2) {\
+    HANDLE_CASE(TYPE, SRC_DIMS, 2);\
+  } else {\
+    HANDLE_CASE(TYPE, SRC_DIMS, -1);\
+  }
+
+#define HANDLE_SRC_CASE(TYPE)\
+  if (srcInfo.isContiguous()) {\
+    HANDLE_MASK_CASE(TYPE, -2);\
+  } else if (srcInfo.dims == 2) {\
+    HANDLE_MASK_CASE(TYPE, 2);\
+  } else {\
+    HANDLE_MASK_CASE(TYPE, -1);\
+  }
+
+  if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, src) &&
+      TensorUtils<THCudaByteTensor>::canUse32BitIndexMath(state, mask)) {
+    TensorInfo<real, unsigned int> srcInfo =
+      getTensorInfo<THCTensor, unsigned int>(state, src);
+    srcInfo.collapseDims();
+    TensorInfo<unsigned char, unsigned int> maskInfo =
+      getTensorInfo<THCudaByteTensor, unsigned int>(state, mask);
+    maskInfo.collapseDims();
+
+    HANDLE_SRC_CASE(unsigned int);
+  } else {
+    TensorInfo<real, unsigned long> srcInfo =
+      getTensorInfo<THCTensor, unsigned long>(state, src);
+    srcInfo.collapseDims();
+    TensorInfo<unsigned char, unsigned long> maskInfo =
+      getTensorInfo<THCudaByteTensor, unsigned long>(state, mask);
+    maskInfo.collapseDims();
+
+    HANDLE_SRC_CASE(unsigned long);
+  }
+#undef HANDLE_SRC_CASE
+#undef HANDLE_MASK_CASE
+#undef HANDLE_CASE
+
+  THCudaFree(state, tileStatus);
+  return true;
+}
+
 THC_API void
 THCTensor_(maskedSelect)(THCState* state,
                          THCTensor* tensor, THCTensor* src, THCudaByteTensor* mask) {
@@ -135,69 +228,146 @@ THCTensor_(maskedSelect)(THCState* state,
              THCTensor_(nElement)(state, src),
              2, "sizes do not match");
 
-  // Determine our output size
-  ptrdiff_t totalElements = THCudaByteTensor_sumall(state, mask);
-  THCTensor* tensorContig = THCTensor_(newContiguous)(state, tensor);
+  // Compact into a scratch tensor of the upper-bound size, then shrink it
+  // once the count is known; reading back the count is the only
+  // synchronization. `tensor` is resized once, to the final size, so that
+  // a view of the right size keeps its strides.
+  THCTensor* out = THCTensor_(newWithSize1d)(state, THCTensor_(nElement)(state, src));
 
-  THCTensor_(resize1d)(state, tensorContig, totalElements);
-  if (tensor != tensorContig) {
-    THCTensor_(resize1d)(state, tensor, totalElements);
+  long* devCount = NULL;
+  THCudaCheck(THCudaMalloc(state, (void**) &devCount, sizeof(long)));
+
+  bool status = THCTensor_(compactMasked)(
+    state, THCTensor_(data)(state, out), devCount, src, mask);
+
+  long totalElements = 0;
+  if (status) {
+    hipStream_t stream = THCState_getCurrentStream(state);
+    THCudaCheck(hipMemcpyAsync(&totalElements, devCount, sizeof(long),
+                               hipMemcpyDeviceToHost, stream));
+    THCudaCheck(hipStreamSynchronize(stream));
   }
+  THCudaFree(state, devCount);
 
-  // FIXME: there appears to be a bug in Thrust (CUDA 7.0) for mixed
-  // iterator prefix sums? Convert `mask` to the same datatype as what
-  // we're accumulating the prefix sum in (long) to get around it
-  THCudaLongTensor* maskLong = THCudaLongTensor_new(state);
-  THLongStorage* maskSizes = THCudaByteTensor_newSizeOf(state, mask);
-  THCudaLongTensor_resize(state, maskLong, maskSizes, NULL);
-  THCudaLongTensor_copyCudaByte(state, maskLong, mask);
+  if (!status) {
+    THCTensor_(free)(state, out);
+  }
+  THArgCheck(status, 2, CUTORCH_DIM_WARNING);
+  THCTensor_(resize1d)(state, out, totalElements);
+  THCTensor_(resize1d)(state, tensor, totalElements);
+  THCTensor_(freeCopyTo)(state, out, tensor);
+  THCudaCheck(hipGetLastError());
+}
 
-  // Use a prefix sum to determine the output locations of the masked elements
-  THCudaLongTensor* maskPrefixSum = THCudaLongTensor_new(state);
-  THCudaLongTensor_resize(state, maskPrefixSum, maskSizes, NULL);
-  THLongStorage_free(maskSizes);
+THC_API void
+THCTensor_(maskedSelectBounded)(THCState* state,
+                                THCTensor* tensor, THCudaLongTensor* count,
+                                THCTensor* src, THCudaByteTensor* mask) {
+  THAssert(THCTensor_(checkGPU)(state, 3, tensor, src, mask));
+  THAssert(THCudaLongTensor_checkGPU(state, 1, count));
+  THArgCheck(THCudaByteTensor_nElement(state, mask) ==
+             THCTensor_(nElement)(state, src),
+             3, "sizes do not match");
+
+  // `tensor` keeps the upper-bound size; only its first `count`
+  // elements are valid once the kernel has run
+  THCTensor_(resize1d)(state, tensor, THCTensor_(nElement)(state, src));
+  THCudaLongTensor_resize1d(state, count, 1);
+  THCTensor* out = THCTensor_(newContiguous)(state, tensor);
+  THCudaLongTensor* outCount = THCudaLongTensor_newContiguous(state, count);
+
+  bool status = THCTensor_(compactMasked)(
+    state, THCTensor_(data)(state, out),
+    THCudaLongTensor_data(state, outCount), src, mask);
+
+  if (!status) {
+    THCTensor_(free)(state, out);
+    THCudaLongTensor_free(state, outCount);
+  }
+  THArgCheck(status, 2, CUTORCH_DIM_WARNING);
+  THCTensor_(freeCopyTo)(state, out, tensor);
+  THCudaLongTensor_freeCopyTo(state, outCount, count);
+  THCudaCheck(hipGetLastError());
+}
 
-#ifdef THRUST_PATH
-  thrust::device_ptr<long>
-    maskData(THCudaLongTensor_data(state, maskLong));
-  thrust::device_ptr<long>
-    maskPrefixSumData(THCudaLongTensor_data(state, maskPrefixSum));
+THC_API void
+THCTensor_(nonzero)(THCState* state, THCudaLongTensor *tensor, THCTensor *self)
+{
+  THAssert(THCTensor_(checkGPU)(state, 1, self));
+  THAssert(THCudaLongTensor_checkGPU(state, 1, tensor));
+  THArgCheck(THCTensor_(nDimension)(state, self) <= MAX_CUTORCH_DIMS, 2,
+             CUTORCH_DIM_WARNING);
 
-  thrust::exclusive_scan(
-#if CUDA_VERSION >= 7000
-    thrust::cuda::par.on(THCState_getCurrentStream(state)),
-#endif
-    maskData,
-    maskData + THCudaLongTensor_nElement(state, maskLong),
-    maskPrefixSumData);
-#else
-    auto maskData = bolt::amp::make_ubiquitous_iterator(
-        THCudaLongTensor_data(state, maskLong));
-    auto maskPrefixSumData = bolt::amp::make_ubiquitous_iterator(
-        THCudaLongTensor_data(state, maskPrefixSum));
-    bolt::amp::exclusive_scan(
-        maskData,
-        maskData + THCudaLongTensor_nElement(state, maskLong),
-        maskPrefixSumData);
-#endif
+  ptrdiff_t totalElements = THCTensor_(nElement)(state, self);
+  int dims = THCTensor_(nDimension)(state, self);
 
- bool status = false;
-  // Then copy over the masked elements at their desired output index
-  status = THC_pointwiseApply3(
-    state, mask, maskPrefixSum,
-    src, TensorMaskedSelectOp<real, unsigned char, long>(
-      THCTensor_(data)(state, tensor)));
+  if (totalElements == 0) {
+    THCudaLongTensor_resize2d(state, tensor, 0, dims);
+    return;
+  }
 
-  THCudaLongTensor_free(state, maskLong);
-  THCudaLongTensor_free(state, maskPrefixSum);
+  hipStream_t stream = THCState_getCurrentStream(state);
+
+  ptrdiff_t numTiles = THC_getCompactTiles(totalElements);
+  dim3 grid;
+  THArgCheck(THC_getGridFromTiles(numTiles, grid), 2, CUTORCH_DIM_WARNING);
+  dim3 block(THC_COMPACT_THREADS);
+  // Compact into a scratch tensor of one row per element, then shrink it
+  // once the count is known; `tensor` is only resized to the final size
+  THCudaLongTensor* result = THCudaLongTensor_newWithSize2d(state, totalElements, dims);
+
+  // The count lives after the tile scratch, so one allocation serves both
+  unsigned long long* tileStatus = THC_newCompactScratch(state, numTiles + 1);
+  unsigned int* tileCounter = (unsigned int*) (tileStatus + numTiles);
+  long* devCount = (long*) (tileStatus + numTiles + 1);
+  long* out = THCudaLongTensor_data(state, result);
+
+#define HANDLE_CASE(TYPE, SRC_DIMS)\
+  hipLaunchKernelGGL(\
+    (kernelNonzeroCompact<real, TYPE, SRC_DIMS>),\
+    grid,\
+    block,\
+    0,\
+    stream,\
+    make_magic_wrapper(srcInfo),\
+    make_magic_wrapper(sizesInfo),\
+    out,\
+    (TYPE) totalElements,\
+    tileStatus,\
+    tileCounter,\
+    devCount);
+
+#define HANDLE_SRC_CASE(TYPE)\
+  TensorInfo<real, TYPE> sizesInfo =\
+    getTensorInfo<THCTensor, TYPE>(state, self);\
+  TensorInfo<real, TYPE> srcInfo = sizesInfo;\
+  srcInfo.collapseDims();\
+  \
+  if (srcInfo.isContiguous()) {\
+    HANDLE_CASE(TYPE, -2);\
+  } else if (srcInfo.dims == 2) {\
+    HANDLE_CASE(TYPE, 2);\
+  } else {\
+    HANDLE_CASE(TYPE, -1);\
+  }
 
-  if (tensor != tensorContig) {
-    THCTensor_(freeCopyTo)(state, tensorContig, tensor);
+  if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, self)) {
+    HANDLE_SRC_CASE(unsigned int);
   } else {
-    THCTensor_(free)(state, tensorContig);
+    HANDLE_SRC_CASE(unsigned long);
   }
-
-  THArgCheck(status, 2, CUTORCH_DIM_WARNING);
+#undef HANDLE_SRC_CASE
+#undef HANDLE_CASE
+
+  long count = 0;
+  THCudaCheck(hipMemcpyAsync(&count, devCount, sizeof(long),
+                             hipMemcpyDeviceToHost, stream));
+  THCudaCheck(hipStreamSynchronize(stream));
+  THCudaFree(state, tileStatus);
+
+  THCudaLongTensor_resize2d(state, result, count, dims);
+  THCudaLongTensor_resize2d(state, tensor, count, dims);
+  THCudaLongTensor_freeCopyTo(state, result, tensor);
   THCudaCheck(hipGetLastError());
 }
 
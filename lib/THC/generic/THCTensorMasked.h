@@ -29,6 +29,21 @@ THC_API void THCTensor_(maskedSelect)(THCState *state,
                                       THCTensor *src,
                                       THCudaByteTensor *mask);
 
+// Like maskedSelect, but never synchronizes with the host: `tensor` is
+// resized to the upper bound nElement(src) and the number of valid
+// leading elements is written to the one-element tensor `count`
+THC_API void THCTensor_(maskedSelectBounded)(THCState *state,
+                                             THCTensor *tensor,
+                                             THCudaLongTensor *count,
+                                             THCTensor *src,
+                                             THCudaByteTensor *mask);
+
+// Coordinates of the non-zero elements of `self`, one row of
+// nDimension(self) indices per element, in linear element order
+THC_API void THCTensor_(nonzero)(THCState *state,
+                                 THCudaLongTensor *tensor,
+                                 THCTensor *self);
+
 // FIXME: remove now that we have THCudaByteTensor?
 THC_API void THCTensor_(maskedSelectByte)(THCState *state,
                                           THCTensor *tensor,
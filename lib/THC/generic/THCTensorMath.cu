@@ -7,8 +7,11 @@ THCTensor_(fill)(THCState* state, THCTensor *self_, real value)
 {
   THAssert(THCTensor_(checkGPU)(state, 1, self_));
 
-  if (!THC_pointwiseApply1(
-        state, self_, TensorFillOp<real>(value))) {
+  if (THCTensor_(isContiguous)(state, self_)) {
+    THC_fillContiguous<real>(state, THCTensor_(data)(state, self_),
+                             THCTensor_(nElement)(state, self_), value);
+  } else if (!THC_pointwiseApply1(
+               state, self_, TensorFillOp<real>(value))) {
     THArgCheck(false, 1, CUTORCH_DIM_WARNING);
   }
 
@@ -18,21 +21,7 @@ THCTensor_(fill)(THCState* state, THCTensor *self_, real value)
 THC_API void
 THCTensor_(zero)(THCState *state, THCTensor *self_)
 {
-  THAssert(THCTensor_(checkGPU)(state, 1, self_));
-  if (THCTensor_(isContiguous)(state, self_)) {
-    THCudaCheck(hipMemsetAsync(THCTensor_(data)(state, self_),
-                                0,
-                                sizeof(real) * THCTensor_(nElement)(state, self_),
-                                THCState_getCurrentStream(state)));
-  } else {
-    if (!THC_pointwiseApply1(
-          state, self_,
-          TensorFillOp<real>(ScalarConvert<int, real>::to(0)))) {
-      THArgCheck(false, 1, CUTORCH_DIM_WARNING);
-    }
-  }
-
-  THCudaCheck(hipGetLastError());
+  THCTensor_(fill)(state, self_, ScalarConvert<int, real>::to(0));
 }
 
 THC_API void
@@ -74,6 +63,83 @@ void THCTensor_(cat)(THCState *state, THCTensor *result,
   THCTensor_(catArray)(state, result, inputs, 2, dimension);
 }
 
+// Whether `part` can be copied to or from its slice of the concatenation
+// `whole` by catArrayBatched: both contiguous and on the current device
+static int THCTensor_(canCatBatched)(THCState *state, THCTensor *whole, THCTensor *part,
+                                     int dimension, long dimSize)
+{
+  int device;
+  THCudaCheck(hipGetDevice(&device));
+  ptrdiff_t wholeElements = THCTensor_(nElement)(state, whole);
+  if (wholeElements == 0 ||
+      !THCTensor_(isContiguous)(state, whole) ||
+      !THCTensor_(isContiguous)(state, part) ||
+      THCTensor_(getDevice)(state, whole) != device ||
+      THCTensor_(getDevice)(state, part) != device) {
+    return 0;
+  }
+  ptrdiff_t partElements = wholeElements / THCTensor_(size)(state, whole, dimension) * dimSize;
+  return partElements > 0 && THCTensor_(nElement)(state, part) == partElements;
+}
+
+template <typename IndexType>
+static void THCTensor_(catArrayBatchedImpl)(THCState *state, THCTensor *whole,
+                                            THCTensor **parts, long *offsets, long *sizes,
+                                            int numParts, int dimension, int split)
+{
+  long inner = 1;
+  for (int d = dimension + 1; d < THCTensor_(nDimension)(state, whole); d++) {
+    inner *= THCTensor_(size)(state, whole, d);
+  }
+  IndexType wholeRowLength = THCTensor_(size)(state, whole, dimension) * inner;
+
+  THCCatPart<real, IndexType> *hostParts =
+    (THCCatPart<real, IndexType>*) THAlloc(numParts * sizeof(THCCatPart<real, IndexType>));
+  IndexType maxElements = 0;
+  for (int j = 0; j < numParts; j++) {
+    hostParts[j].data = THCTensor_(data)(state, parts[j]);
+    hostParts[j].offset = offsets[j] * inner;
+    hostParts[j].rowLength = sizes[j] * inner;
+    hostParts[j].nElement = THCTensor_(nElement)(state, parts[j]);
+    maxElements = std::max(maxElements, hostParts[j].nElement);
+  }
+
+  if (split) {
+    THC_catArrayBatched<real, IndexType, true>(
+      state, THCTensor_(data)(state, whole), wholeRowLength, hostParts, numParts, maxElements);
+  } else {
+    THC_catArrayBatched<real, IndexType, false>(
+      state, THCTensor_(data)(state, whole), wholeRowLength, hostParts, numParts, maxElements);
+  }
+  THFree(hostParts);
+}
+
+// Copies the parts of the concatenation `whole` along `dimension` into it
+// (or out of it, with split) in one batched launch; parts[j] covers sizes[j]
+// indices from offsets[j]. A single part goes through copy instead.
+static void THCTensor_(catArrayBatched)(THCState *state, THCTensor *whole,
+                                        THCTensor **parts, long *offsets, long *sizes,
+                                        int numParts, int dimension, int split)
+{
+  if (numParts == 1) {
+    THCTensor *nt = THCTensor_(newNarrow)(state, whole, dimension, offsets[0], sizes[0]);
+    if (split) {
+      THCTensor_(copy)(state, parts[0], nt);
+    } else {
+      THCTensor_(copy)(state, nt, parts[0]);
+    }
+    THCTensor_(free)(state, nt);
+  } else if (numParts > 1) {
+    if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, whole)) {
+      THCTensor_(catArrayBatchedImpl)<unsigned int>(
+        state, whole, parts, offsets, sizes, numParts, dimension, split);
+    } else {
+      THCTensor_(catArrayBatchedImpl)<unsigned long>(
+        state, whole, parts, offsets, sizes, numParts, dimension, split);
+    }
+  }
+}
+
 void THCTensor_(catArray)(THCState *state, THCTensor *result,
 			  THCTensor **inputs, int numInputs, int dimension)
 {
@@ -123,17 +189,78 @@ void THCTensor_(catArray)(THCState *state, THCTensor *result,
   THLongStorage_free(size);
 
   offset = 0;
+  int numBatched = 0;
+  THCTensor **batched = (THCTensor**) THAlloc(numInputs * sizeof(THCTensor*));
+  long *batchedOffsets = (long*) THAlloc(numInputs * sizeof(long));
+  long *batchedSizes = (long*) THAlloc(numInputs * sizeof(long));
   for (j = 0; j < numInputs; j++)
   {
     long dimSize = dimension < THCTensor_(nDimension)(state, inputs[j])
 			       ? THCTensor_(size)(state, inputs[j], dimension)
 			       : 1;
-    THCTensor *nt = THCTensor_(newWithTensor)(state, result);
-    THCTensor_(narrow)(state, nt, NULL, dimension, offset, dimSize);
-    THCTensor_(copy)(state, nt, inputs[j]);
-    THCTensor_(free)(state, nt);
+    if (THCTensor_(canCatBatched)(state, result, inputs[j], dimension, dimSize)) {
+      batched[numBatched] = inputs[j];
+      batchedOffsets[numBatched] = offset;
+      batchedSizes[numBatched] = dimSize;
+      numBatched++;
+    } else {
+      THCTensor *nt = THCTensor_(newWithTensor)(state, result);
+      THCTensor_(narrow)(state, nt, NULL, dimension, offset, dimSize);
+      THCTensor_(copy)(state, nt, inputs[j]);
+      THCTensor_(free)(state, nt);
+    }
     offset += dimSize;
   }
+
+  THCTensor_(catArrayBatched)(state, result, batched, batchedOffsets, batchedSizes,
+                              numBatched, dimension, 0);
+  THFree(batched);
+  THFree(batchedOffsets);
+  THFree(batchedSizes);
+}
+
+void THCTensor_(splitArray)(THCState *state, THCTensor **results, int numResults,
+                            THCTensor *src, long splitSize, int dimension)
+{
+  THAssert(THCTensor_(checkGPU)(state, 1, src));
+  THArgCheck(dimension >= 0 && dimension < THCTensor_(nDimension)(state, src), 5,
+             "invalid dimension %d", dimension + 1);
+  THArgCheck(splitSize > 0, 4, "split size should be positive, got %ld", splitSize);
+  long dimSize = THCTensor_(size)(state, src, dimension);
+  THArgCheck(numResults == THCCeilDiv(dimSize, splitSize), 2,
+             "expected %ld results for a split of %ld into %ld, got %d",
+             THCCeilDiv(dimSize, splitSize), dimSize, splitSize, numResults);
+
+  THCTensor *whole = THCTensor_(newContiguous)(state, src);
+  THLongStorage *size = THCTensor_(newSizeOf)(state, src);
+  int numBatched = 0;
+  THCTensor **batched = (THCTensor**) THAlloc(numResults * sizeof(THCTensor*));
+  long *batchedOffsets = (long*) THAlloc(numResults * sizeof(long));
+  long *batchedSizes = (long*) THAlloc(numResults * sizeof(long));
+  for (int j = 0; j < numResults; j++) {
+    long offset = j * splitSize;
+    long partSize = THMin(splitSize, dimSize - offset);
+    size->data[dimension] = partSize;
+    THCTensor_(resize)(state, results[j], size, NULL);
+    if (THCTensor_(canCatBatched)(state, whole, results[j], dimension, partSize)) {
+      batched[numBatched] = results[j];
+      batchedOffsets[numBatched] = offset;
+      batchedSizes[numBatched] = partSize;
+      numBatched++;
+    } else {
+      THCTensor *nt = THCTensor_(newNarrow)(state, whole, dimension, offset, partSize);
+      THCTensor_(copy)(state, results[j], nt);
+      THCTensor_(free)(state, nt);
+    }
+  }
+
+  THCTensor_(catArrayBatched)(state, whole, batched, batchedOffsets, batchedSizes,
+                              numBatched, dimension, 1);
+  THFree(batched);
+  THFree(batchedOffsets);
+  THFree(batchedSizes);
+  THLongStorage_free(size);
+  THCTensor_(free)(state, whole);
 }
 
 #endif
@@ -11,6 +11,10 @@ THC_API void THCTensor_(reshape)(THCState *state, THCTensor *r_, THCTensor *t, T
 THC_API ptrdiff_t THCTensor_(numel)(THCState *state, THCTensor *t);
 THC_API void THCTensor_(cat)(THCState *state, THCTensor *result, THCTensor *ta, THCTensor *tb, int dimension);
 THC_API void THCTensor_(catArray)(THCState *state, THCTensor *result, THCTensor **inputs, int numInputs, int dimension);
+/* The inverse of catArray: results[j] becomes a contiguous copy of the
+   splitSize indices of src from j * splitSize along dimension (fewer for the
+   last one), with ceil(size / splitSize) results */
+THC_API void THCTensor_(splitArray)(THCState *state, THCTensor **results, int numResults, THCTensor *src, long splitSize, int dimension);
 
 				   
 
@@ -43,7 +43,7 @@ THCTensor_(dot)(THCState *state, THCTensor *self, THCTensor *src)
 THC_API void
 THCTensor_(addmv)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real alpha, THCTensor *mat, THCTensor *vec)
 {
-#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE) || defined(THC_REAL_IS_HALF)
   THAssert(THCTensor_(checkGPU)(state, 4, r_, t, mat, vec));
   if( (mat->nDimension != 2) || (vec->nDimension != 1) )
     THError("matrix and vector expected");
@@ -75,6 +75,11 @@ THCTensor_(addmv)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real
                     alpha, THCTensor_(data)(state, mat), mat->stride[1],
                     THCTensor_(data)(state, vec), vec->stride[0],
                     beta, THCTensor_(data)(state, r_), r_->stride[0]);
+#elif defined(THC_REAL_IS_HALF)
+    THCudaBlas_Hgemv(state, 'n', mat->size[0], mat->size[1],
+                    alpha, THCTensor_(data)(state, mat), mat->stride[1],
+                    THCTensor_(data)(state, vec), vec->stride[0],
+                    beta, THCTensor_(data)(state, r_), r_->stride[0]);
 #endif
   }
   else if(mat->stride[1] == 1)
@@ -89,6 +94,11 @@ THCTensor_(addmv)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real
                      alpha, THCTensor_(data)(state, mat), mat->stride[0],
                      THCTensor_(data)(state, vec), vec->stride[0],
                      beta, THCTensor_(data)(state, r_), r_->stride[0]);
+#elif defined(THC_REAL_IS_HALF)
+    THCudaBlas_Hgemv(state, 't',  mat->size[1], mat->size[0],
+                     alpha, THCTensor_(data)(state, mat), mat->stride[0],
+                     THCTensor_(data)(state, vec), vec->stride[0],
+                     beta, THCTensor_(data)(state, r_), r_->stride[0]);
 #endif
   }
   else
@@ -105,6 +115,11 @@ THCTensor_(addmv)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real
                     alpha, THCTensor_(data)(state, cmat), cmat->stride[0],
                     THCTensor_(data)(state, vec), vec->stride[0],
                     beta, THCTensor_(data)(state, r_), r_->stride[0]);
+#elif defined(THC_REAL_IS_HALF)
+    THCudaBlas_Hgemv(state, 't',  mat->size[1], mat->size[0],
+                    alpha, THCTensor_(data)(state, cmat), cmat->stride[0],
+                    THCTensor_(data)(state, vec), vec->stride[0],
+                    beta, THCTensor_(data)(state, r_), r_->stride[0]);
 #endif
 
     THCTensor_(free)(state, cmat);
@@ -118,7 +133,7 @@ THCTensor_(addmv)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real
 THC_API void
 THCTensor_(addr)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real alpha, THCTensor *vec1, THCTensor *vec2)
 {
-#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE) || defined(THC_REAL_IS_HALF)
   THAssert(THCTensor_(checkGPU)(state, 4, r_, t, vec1, vec2));
   if ( (vec1->nDimension != 1) || (vec2->nDimension != 1) ) {
     THError("vector and vector expected");
@@ -137,7 +152,7 @@ THCTensor_(addr)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real a
     THCTensor_(copy)(state, r_, t);
   }
 
-  if(beta != 1) {
+  if(!THCNumerics<real>::eq(beta, ScalarConvert<int, real>::to(1))) {
     THCTensor_(mul)(state, r_, r_, beta);
   }
 
@@ -153,6 +168,11 @@ THCTensor_(addr)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real a
                    alpha, THCTensor_(data)(state, vec1), vec1->stride[0],
                    THCTensor_(data)(state, vec2), vec2->stride[0],
                    THCTensor_(data)(state, r_), r_->stride[1]);
+#elif defined(THC_REAL_IS_HALF)
+    THCudaBlas_Hger(state, vec1->size[0], vec2->size[0],
+                   alpha, THCTensor_(data)(state, vec1), vec1->stride[0],
+                   THCTensor_(data)(state, vec2), vec2->stride[0],
+                   THCTensor_(data)(state, r_), r_->stride[1]);
 #endif
   }
   else if(r_->stride[1] == 1)
@@ -167,6 +187,11 @@ THCTensor_(addr)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real a
                    alpha, THCTensor_(data)(state, vec2), vec2->stride[0],
                    THCTensor_(data)(state, vec1), vec1->stride[0],
                    THCTensor_(data)(state, r_), r_->stride[0]);
+#elif defined(THC_REAL_IS_HALF)
+    THCudaBlas_Hger(state, vec2->size[0], vec1->size[0],
+                   alpha, THCTensor_(data)(state, vec2), vec2->stride[0],
+                   THCTensor_(data)(state, vec1), vec1->stride[0],
+                   THCTensor_(data)(state, r_), r_->stride[0]);
 #endif
   }
   else
@@ -183,6 +208,11 @@ THCTensor_(addr)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real a
                    alpha, THCTensor_(data)(state, vec2), vec2->stride[0],
                    THCTensor_(data)(state, vec1), vec1->stride[0],
                    THCTensor_(data)(state, cr), cr->stride[0]);
+#elif defined(THC_REAL_IS_HALF)
+    THCudaBlas_Hger(state, vec2->size[0], vec1->size[0],
+                   alpha, THCTensor_(data)(state, vec2), vec2->stride[0],
+                   THCTensor_(data)(state, vec1), vec1->stride[0],
+                   THCTensor_(data)(state, cr), cr->stride[0]);
 #endif
 
     THCTensor_(freeCopyTo)(state, cr, r_);
@@ -192,30 +222,17 @@ THCTensor_(addr)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real a
 #endif
 }
 
-THC_API void
-THCTensor_(addmm)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real alpha, THCTensor *m1, THCTensor *m2)
-{
 #if defined(THC_REAL_IS_HALF) || defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
-
-  THAssert(THCTensor_(checkGPU)(state, 4, r_, t, m1, m2));
+// Picks the BLAS layout for r_ = beta * r_ + alpha * m1 * m2, shared by
+// addmm and, with `fused` set, by the bias/activation epilogue of addmmFused
+static void
+THCTensor_(gemm)(THCState *state, THCTensor *r_, real beta, real alpha,
+                 THCTensor *m1, THCTensor *m2, int fused,
+                 THCTensor *bias, int biasDim, int activation)
+{
   char transpose_r, transpose_m1, transpose_m2;
   THCTensor *r__, *m1_, *m2_;
 
-  if( (m1->nDimension != 2) || (m2->nDimension != 2) )
-    THError("matrix and matrix expected");
-
-  if(t->nDimension != 2)
-    THError("size mismatch");
-
-  if( (t->size[0] != m1->size[0]) || (t->size[1] != m2->size[1]) || (m1->size[1] != m2->size[0]) )
-    THError("size mismatch");
-
-  if(t != r_)
-  {
-    THCTensor_(resizeAs)(state, r_, t);
-    THCTensor_(copy)(state, r_, t);
-  }
-
   /* r_ */
   if(r_->stride[0] == 1 &&
      r_->stride[1] != 0)
@@ -280,52 +297,45 @@ THCTensor_(addmm)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real
     m2_ = THCTensor_(newContiguous)(state, m2);
   }
 
+  long m = r__->size[(transpose_r == 'n' ? 0 : 1)];
+  long n = r__->size[(transpose_r == 'n' ? 1 : 0)];
+  long k = m1_->size[(transpose_r == 'n' ? 1 : 0)];
+  long lda = (transpose_m1 == 'n' ? m1_->stride[(transpose_r == 'n' ? 1 : 0)] : m1_->stride[(transpose_r == 'n' ? 0 : 1)]);
+  long ldb = (transpose_m2 == 'n' ? m2_->stride[(transpose_r == 'n' ? 1 : 0)] : m2_->stride[(transpose_r == 'n' ? 0 : 1)]);
+  long ldc = r__->stride[(transpose_r == 'n' ? 1 : 0)];
+
+  if (fused) {
+    // The BLAS sees r_ transposed when transpose_r is 't', so rows and
+    // columns of the bias swap with it
+    int blasBiasDim = (transpose_r == 'n' ? biasDim : 1 - biasDim);
+    real *biasData = bias ? THCTensor_(data)(state, bias) : NULL;
+    long biasStride = bias ? bias->stride[0] : 0;
+#ifdef THC_REAL_IS_HALF
+    THCudaBlas_HgemmEpilogue(
+#elif defined(THC_REAL_IS_FLOAT)
+    THCudaBlas_SgemmEpilogue(
+#elif defined(THC_REAL_IS_DOUBLE)
+    THCudaBlas_DgemmEpilogue(
+#endif
+        state, transpose_m1, transpose_m2, m, n, k, alpha,
+        THCTensor_(data)(state, m1_), lda,
+        THCTensor_(data)(state, m2_), ldb,
+        THCTensor_(data)(state, r__), ldc,
+        biasData, biasStride, blasBiasDim, activation);
+  } else {
 #ifdef THC_REAL_IS_HALF
-  THCudaBlas_Hgemm(state,
-                   transpose_m1,
-                   transpose_m2,
-                   r__->size[(transpose_r == 'n' ? 0 : 1)],
-                   r__->size[(transpose_r == 'n' ? 1 : 0)],
-                   m1_->size[(transpose_r == 'n' ? 1 : 0)],
-                   alpha,
-                   THCTensor_(data)(state, m1_),
-                   (transpose_m1 == 'n' ? m1_->stride[(transpose_r == 'n' ? 1 : 0)] : m1_->stride[(transpose_r == 'n' ? 0 : 1)]),
-                   THCTensor_(data)(state, m2_),
-                   (transpose_m2 == 'n' ? m2_->stride[(transpose_r == 'n' ? 1 : 0)] : m2_->stride[(transpose_r == 'n' ? 0 : 1)]),
-                   beta,
-                   THCTensor_(data)(state, r__),
-                   r__->stride[(transpose_r == 'n' ? 1 : 0)]);
+    THCudaBlas_Hgemm(
 #elif defined(THC_REAL_IS_FLOAT)
-  THCudaBlas_Sgemm(state,
-                   transpose_m1,
-                   transpose_m2,
-                   r__->size[(transpose_r == 'n' ? 0 : 1)],
-                   r__->size[(transpose_r == 'n' ? 1 : 0)],
-                   m1_->size[(transpose_r == 'n' ? 1 : 0)],
-                   alpha,
-                   THCTensor_(data)(state, m1_),
-                   (transpose_m1 == 'n' ? m1_->stride[(transpose_r == 'n' ? 1 : 0)] : m1_->stride[(transpose_r == 'n' ? 0 : 1)]),
-                   THCTensor_(data)(state, m2_),
-                   (transpose_m2 == 'n' ? m2_->stride[(transpose_r == 'n' ? 1 : 0)] : m2_->stride[(transpose_r == 'n' ? 0 : 1)]),
-                   beta,
-                   THCTensor_(data)(state, r__),
-                   r__->stride[(transpose_r == 'n' ? 1 : 0)]);
+    THCudaBlas_Sgemm(
 #elif defined(THC_REAL_IS_DOUBLE)
-  THCudaBlas_Dgemm(state,
-                   transpose_m1,
-                   transpose_m2,
-                   r__->size[(transpose_r == 'n' ? 0 : 1)],
-                   r__->size[(transpose_r == 'n' ? 1 : 0)],
-                   m1_->size[(transpose_r == 'n' ? 1 : 0)],
-                   alpha,
-                   THCTensor_(data)(state, m1_),
-                   (transpose_m1 == 'n' ? m1_->stride[(transpose_r == 'n' ? 1 : 0)] : m1_->stride[(transpose_r == 'n' ? 0 : 1)]),
-                   THCTensor_(data)(state, m2_),
-                   (transpose_m2 == 'n' ? m2_->stride[(transpose_r == 'n' ? 1 : 0)] : m2_->stride[(transpose_r == 'n' ? 0 : 1)]),
-                   beta,
-                   THCTensor_(data)(state, r__),
-                   r__->stride[(transpose_r == 'n' ? 1 : 0)]);
+    THCudaBlas_Dgemm(
 #endif
+        state, transpose_m1, transpose_m2, m, n, k, alpha,
+        THCTensor_(data)(state, m1_), lda,
+        THCTensor_(data)(state, m2_), ldb,
+        beta,
+        THCTensor_(data)(state, r__), ldc);
+  }
 
   /* free intermediate variables */
   if(m1_ != m1) {
@@ -339,6 +349,66 @@ THCTensor_(addmm)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real
   if(r__ != r_) {
     THCTensor_(freeCopyTo)(state, r__, r_);
   }
+}
+#endif
+
+THC_API void
+THCTensor_(addmm)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real alpha, THCTensor *m1, THCTensor *m2)
+{
+#if defined(THC_REAL_IS_HALF) || defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
+
+  THAssert(THCTensor_(checkGPU)(state, 4, r_, t, m1, m2));
+
+  if( (m1->nDimension != 2) || (m2->nDimension != 2) )
+    THError("matrix and matrix expected");
+
+  if(t->nDimension != 2)
+    THError("size mismatch");
+
+  if( (t->size[0] != m1->size[0]) || (t->size[1] != m2->size[1]) || (m1->size[1] != m2->size[0]) )
+    THError("size mismatch");
+
+  if(t != r_)
+  {
+    THCTensor_(resizeAs)(state, r_, t);
+    THCTensor_(copy)(state, r_, t);
+  }
+
+  THCTensor_(gemm)(state, r_, beta, alpha, m1, m2, 0, NULL, 0, THC_ACTIVATION_NONE);
+#else
+  THError("unimplemented data type");
+#endif
+}
+
+THC_API void
+THCTensor_(addmmFused)(THCState *state, THCTensor *r_, real alpha, THCTensor *m1, THCTensor *m2,
+                       THCTensor *bias, int biasDim, int activation)
+{
+#if defined(THC_REAL_IS_HALF) || defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
+  THAssert(THCTensor_(checkGPU)(state, 4, r_, m1, m2, bias));
+
+  if( (m1->nDimension != 2) || (m2->nDimension != 2) )
+    THError("matrix and matrix expected");
+
+  if(m1->size[1] != m2->size[0])
+    THError("size mismatch");
+
+  THArgCheck(biasDim == 0 || biasDim == 1, 7, "bias dimension must be 1 (rows) or 2 (columns)");
+  THArgCheck(activation >= THC_ACTIVATION_NONE && activation <= THC_ACTIVATION_RELU, 8,
+             "unknown activation");
+
+  long outSize = (biasDim == 0 ? m1->size[0] : m2->size[1]);
+  THArgCheck(bias == NULL ||
+             (bias->nDimension == 1 && bias->size[0] == outSize), 6,
+             "bias must be a vector of %ld elements", outSize);
+
+  // r_ is written, never read, so an output aliasing an input would be
+  // clobbered before the product is complete
+  THArgCheck(r_ != m1 && r_ != m2 && r_ != bias, 1, "result must not be an input");
+
+  THCTensor_(resize2d)(state, r_, m1->size[0], m2->size[1]);
+  THCTensor_(gemm)(state, r_, ScalarConvert<int, real>::to(0), alpha, m1, m2,
+                   1, bias, biasDim, activation);
 #else
   THError("unimplemented data type");
 #endif
@@ -373,6 +443,29 @@ THCTensor_(addbmm)(THCState *state, THCTensor *result, real beta, THCTensor *t,
     THCTensor_(copy)(state, result, t);
   }
 
+  // Many small products are dominated by per-GEMM launch cost; compute them
+  // all with one strided-batched GEMM and reduce over the batch instead.
+  if (batchnum > 1 && batchnum * m1d1 * m2d2 <= THC_ADDBMM_BATCHED_MAX_ELEMENTS) {
+    THCTensor *products = THCTensor_(newWithSize3d)(state, batchnum, m1d1, m2d2);
+    THCTensor_(baddbmm)(state, products, ScalarConvert<int, real>::to(0), products,
+                        ScalarConvert<int, real>::to(1), batch1, batch2);
+
+    THCTensor *summed = THCTensor_(new)(state);
+    THCTensor_(sum)(state, summed, products, 0);
+    THCTensor_(select)(state, summed, NULL, 0, 0);
+    THCTensor_(free)(state, products);
+
+    if (THCNumerics<real>::eq(beta, ScalarConvert<int, real>::to(0))) {
+      // Like gemm, a zero beta ignores whatever result held, NaNs included
+      THCTensor_(mul)(state, result, summed, alpha);
+    } else {
+      THCTensor_(mul)(state, result, result, beta);
+      THCTensor_(cadd)(state, result, result, alpha, summed);
+    }
+    THCTensor_(free)(state, summed);
+    return;
+  }
+
   THCTensor *slice1 = THCTensor_(new)(state);
   THCTensor *slice2 = THCTensor_(new)(state);
   for (long i=0; i<batchnum; i++) {
@@ -392,7 +485,7 @@ THCTensor_(addbmm)(THCState *state, THCTensor *result, real beta, THCTensor *t,
 THC_API void
 THCTensor_(baddbmm)(THCState *state, THCTensor *result, real beta, THCTensor *t,
                     real alpha, THCTensor *batch1, THCTensor *batch2) {
-#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
+#if defined(THC_REAL_IS_HALF) || defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
   THAssert(THCTensor_(checkGPU)(state, 4, result, t, batch1, batch2));
   THArgCheck(THCTensor_(nDimension)(state, t) == 3, 4, "expected 3D tensor");
   THArgCheck(THCTensor_(nDimension)(state, batch1) == 3, 6, "expected 3D tensor");
@@ -484,49 +577,15 @@ THCTensor_(baddbmm)(THCState *state, THCTensor *result, real beta, THCTensor *t,
     ldb = batch2_->stride[1];
   }
 
-  // Compute pointers to matrices in each batch.
-  long num_batches = result_->size[0];
-  size_t matrices_size = num_batches * sizeof(real*);
-  const real **matrices1 = (const real **)THAlloc(matrices_size);
-  const real **matrices2 = (const real **)THAlloc(matrices_size);
-  real **result_matrices = (real **)THAlloc(matrices_size);
-  for (int i = 0; i < num_batches; ++i)
-  {
-    matrices1[i] = THCTensor_(data)(state, batch1_) + i * batch1_->stride[0];
-    matrices2[i] = THCTensor_(data)(state, batch2_) + i * batch2_->stride[0];
-    result_matrices[i] = THCTensor_(data)(state, result_) + i * result_->stride[0];
-  }
-
-  // Copy pointers to device.
-  const real **d_matrices1, **d_matrices2;
-  real **d_result_matrices;
-  THCudaCheck(THCudaMalloc(state, (void**)&d_matrices1, matrices_size));
-  THCudaCheck(THCudaMalloc(state, (void**)&d_matrices2, matrices_size));
-  THCudaCheck(THCudaMalloc(state, (void**)&d_result_matrices, matrices_size));
-
-  THCudaCheck(hipMemcpyAsync(d_matrices1, matrices1, matrices_size,
-                              hipMemcpyHostToDevice, THCState_getCurrentStream(state)));
-  THCudaCheck(hipMemcpyAsync(d_matrices2, matrices2, matrices_size,
-                              hipMemcpyHostToDevice, THCState_getCurrentStream(state)));
-  THCudaCheck(hipMemcpyAsync(d_result_matrices, result_matrices, matrices_size,
-                              hipMemcpyHostToDevice, THCState_getCurrentStream(state)));
-
+  // Consecutive matrices of a batch are a fixed stride apart, so the BLAS
+  // can address them directly without a device array of pointers.
 #ifdef THC_REAL_IS_FLOAT
-  THCudaBlas_SgemmBatched(
-      state,
-      transpose_batch1,
-      transpose_batch2,
-      result_->size[transpose_result ? 2 : 1],
-      result_->size[transpose_result ? 1 : 2],
-      batch1_->size[transpose_result ? 1 : 2],
-      alpha,
-      d_matrices1, lda,
-      d_matrices2, ldb,
-      beta,
-      d_result_matrices, ldc,
-      num_batches);
+  THCudaBlas_SgemmStridedBatched(
 #elif defined(THC_REAL_IS_DOUBLE)
-  THCudaBlas_DgemmBatched(
+  THCudaBlas_DgemmStridedBatched(
+#elif defined(THC_REAL_IS_HALF)
+  THCudaBlas_HgemmStridedBatched(
+#endif
       state,
       transpose_batch1,
       transpose_batch2,
@@ -534,19 +593,11 @@ THCTensor_(baddbmm)(THCState *state, THCTensor *result, real beta, THCTensor *t,
       result_->size[transpose_result ? 1 : 2],
       batch1_->size[transpose_result ? 1 : 2],
       alpha,
-      d_matrices1, lda,
-      d_matrices2, ldb,
+      THCTensor_(data)(state, batch1_), lda, batch1_->stride[0],
+      THCTensor_(data)(state, batch2_), ldb, batch2_->stride[0],
       beta,
-      d_result_matrices, ldc,
-      num_batches);
-#endif
-
-  THCudaFree(state, d_matrices1);
-  THCudaFree(state, d_matrices2);
-  THCudaFree(state, d_result_matrices);
-  THFree(matrices1);
-  THFree(matrices2);
-  THFree(result_matrices);
+      THCTensor_(data)(state, result_), ldc, result_->stride[0],
+      result_->size[0]);
 
   if (batch1_ != batch1) {
     THCTensor_(free)(state, batch1_);
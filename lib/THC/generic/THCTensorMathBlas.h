@@ -5,6 +5,10 @@
 THC_API real THCTensor_(dot)(THCState *state, THCTensor *self, THCTensor *src);
 THC_API void THCTensor_(addmv)(THCState *state, THCTensor *self, real beta, THCTensor *t, real alpha, THCTensor *mat, THCTensor *vec);
 THC_API void THCTensor_(addmm)(THCState *state, THCTensor *self, real beta, THCTensor *t, real alpha, THCTensor *mat1, THCTensor *mat2);
+/* self = act(alpha * mat1 * mat2 + bias) in one pass over self. bias (may be
+   NULL) holds one value per row (biasDim 0) or per column (biasDim 1) of
+   self; activation is one of THC_ACTIVATION_* from THCBlas.h. */
+THC_API void THCTensor_(addmmFused)(THCState *state, THCTensor *self, real alpha, THCTensor *mat1, THCTensor *mat2, THCTensor *bias, int biasDim, int activation);
 THC_API void THCTensor_(addr)(THCState *state, THCTensor *self, real beta, THCTensor *t, real alpha, THCTensor *vec1, THCTensor *vec2);
 THC_API void THCTensor_(addbmm)(THCState *state, THCTensor *result, real beta, THCTensor *t, real alpha, THCTensor *batch1, THCTensor *batch2);
 THC_API void THCTensor_(baddbmm)(THCState *state, THCTensor *result, real beta, THCTensor *t, real alpha, THCTensor *batch1, THCTensor *batch2);
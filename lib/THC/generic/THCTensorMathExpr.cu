@@ -0,0 +1,36 @@
+#ifndef THC_GENERIC_FILE
+#define THC_GENERIC_FILE "generic/THCTensorMathExpr.cu"
+#else
+
+void THCTensor_(pointwiseExpr)(THCState *state, THCTensor *self,
+                               THCTensor *src1, THCTensor *src2,
+                               const int *code, int length,
+                               const double *constants, int numConstants)
+{
+  THArgCheck(src1 != NULL || src2 == NULL, 3, "the second operand needs the first one");
+  THAssert(THCTensor_(checkGPU)(state, 3, self, src1 ? src1 : self, src2 ? src2 : self));
+  ptrdiff_t n = THCTensor_(nElement)(state, self);
+  THArgCheck(src1 == NULL || THCTensor_(nElement)(state, src1) == n, 3, "sizes do not match");
+  THArgCheck(src2 == NULL || THCTensor_(nElement)(state, src2) == n, 4, "sizes do not match");
+
+  int inputs = src2 ? 3 : (src1 ? 2 : 1);
+  THCExprProgram program;
+  THCExpr_prepare(&program, code, length, constants, numConstants, inputs);
+  if (n == 0) {
+    return;
+  }
+
+  THCExprOp<real, typename THCExprCompute<real>::type> op(program);
+  bool succ;
+  if (src2) {
+    succ = THC_pointwiseApply3(state, self, src1, src2, op, ReadWrite, ReadOnly, ReadOnly);
+  } else if (src1) {
+    succ = THC_pointwiseApply2(state, self, src1, op, ReadWrite, ReadOnly);
+  } else {
+    succ = THC_pointwiseApply1(state, self, op);
+  }
+  THArgCheck(succ, 2, CUTORCH_DIM_WARNING);
+  THCudaCheck(hipGetLastError());
+}
+
+#endif
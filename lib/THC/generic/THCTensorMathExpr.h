@@ -0,0 +1,15 @@
+#ifndef THC_GENERIC_FILE
+#define THC_GENERIC_FILE "generic/THCTensorMathExpr.h"
+#else
+
+/* self = f(self [, src1 [, src2]]) element by element, where f is the
+   program code (length instructions) with the given constants, and X, Y
+   and Z stand for the elements of self, src1 and src2 (src2 needs src1).
+   Evaluated in double for double, int and long tensors, in float
+   otherwise. */
+THC_API void THCTensor_(pointwiseExpr)(THCState *state, THCTensor *self,
+                                       THCTensor *src1, THCTensor *src2,
+                                       const int *code, int length,
+                                       const double *constants, int numConstants);
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef THC_GENERIC_FILE
+#define THC_GENERIC_FILE "generic/THCTensorMathLinalg.cu"
+#else
+
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
+
+static void THCTensor_(checkBatchedSquare)(THCState *state, THCTensor *a, int argNumber)
+{
+  THArgCheck(a->nDimension == 3, argNumber, "expected a batch x n x n tensor, got %d dimensions",
+             a->nDimension);
+  THArgCheck(a->size[1] == a->size[2], argNumber, "expected a batch of square matrices");
+  THArgCheck(a->size[1] <= THC_LINALG_MAX_N, argNumber,
+             "matrices of at most %d rows are supported, got %ld",
+             THC_LINALG_MAX_N, a->size[1]);
+}
+
+void THCTensor_(btrifact)(THCState *state, THCTensor *ra_, THCudaIntTensor *rpivots_,
+                          THCudaIntTensor *rinfo_, THCTensor *a)
+{
+  THAssert(THCTensor_(checkGPU)(state, 2, ra_, a));
+  THCTensor_(checkBatchedSquare)(state, a, 5);
+
+  long batch = a->size[0];
+  int n = a->size[1];
+
+  THCTensor *input = THCTensor_(newContiguous)(state, a);
+  THCTensor_(resizeAs)(state, ra_, a);
+  THCTensor *output = THCTensor_(newContiguous)(state, ra_);
+  THCudaIntTensor_resize2d(state, rpivots_, batch, n);
+  THCudaIntTensor *pivots = THCudaIntTensor_newContiguous(state, rpivots_);
+  THCudaIntTensor *info;
+  if (rinfo_) {
+    THCudaIntTensor_resize1d(state, rinfo_, batch);
+    info = THCudaIntTensor_newContiguous(state, rinfo_);
+  } else {
+    info = THCudaIntTensor_newWithSize1d(state, batch);
+  }
+
+  if (batch > 0 && n > 0) {
+    dim3 grid, block;
+    size_t smem;
+    THCLinalg_launchConfig(state, batch, n, n * n * sizeof(real), grid, block, smem);
+    hipLaunchKernelGGL(
+      (batchedLUKernel<real>), grid, block, smem, THCState_getCurrentStream(state),
+      THCTensor_(data)(state, input), THCTensor_(data)(state, output),
+      THCudaIntTensor_data(state, pivots), THCudaIntTensor_data(state, info), batch, n);
+    THCudaCheck(hipGetLastError());
+  }
+
+  THCTensor_(free)(state, input);
+  THCTensor_(freeCopyTo)(state, output, ra_);
+  THCudaIntTensor_freeCopyTo(state, pivots, rpivots_);
+
+  int worst = THCLinalg_finishInfo(state, info, rinfo_);
+  if (worst > 0) {
+    THError("btrifact: U(%d,%d) is zero, singular matrix in the batch", worst, worst);
+  }
+}
+
+void THCTensor_(bpotrf)(THCState *state, THCTensor *ra_, THCudaIntTensor *rinfo_,
+                        THCTensor *a, const char *uplo)
+{
+  THAssert(THCTensor_(checkGPU)(state, 2, ra_, a));
+  THCTensor_(checkBatchedSquare)(state, a, 4);
+  THArgCheck(uplo[0] == 'U' || uplo[0] == 'L', 5, "uplo should be 'U' or 'L'");
+
+  long batch = a->size[0];
+  int n = a->size[1];
+
+  THCTensor *input = THCTensor_(newContiguous)(state, a);
+  THCTensor_(resizeAs)(state, ra_, a);
+  THCTensor *output = THCTensor_(newContiguous)(state, ra_);
+  THCudaIntTensor *info;
+  if (rinfo_) {
+    THCudaIntTensor_resize1d(state, rinfo_, batch);
+    info = THCudaIntTensor_newContiguous(state, rinfo_);
+  } else {
+    info = THCudaIntTensor_newWithSize1d(state, batch);
+  }
+
+  if (batch > 0 && n > 0) {
+    dim3 grid, block;
+    size_t smem;
+    THCLinalg_launchConfig(state, batch, n, n * n * sizeof(real), grid, block, smem);
+    hipLaunchKernelGGL(
+      (batchedCholeskyKernel<real>), grid, block, smem, THCState_getCurrentStream(state),
+      THCTensor_(data)(state, input), THCTensor_(data)(state, output),
+      THCudaIntTensor_data(state, info), batch, n, uplo[0] == 'U');
+    THCudaCheck(hipGetLastError());
+  }
+
+  THCTensor_(free)(state, input);
+  THCTensor_(freeCopyTo)(state, output, ra_);
+
+  int worst = THCLinalg_finishInfo(state, info, rinfo_);
+  if (worst > 0) {
+    THError("bpotrf: the leading minor of order %d is not positive definite", worst);
+  }
+}
+
+// rb_ = the solution of the steps against each matrix of a, after the row
+// swaps of pivots (may be NULL)
+static void THCTensor_(batchedSolve)(THCState *state, THCTensor *rb_, THCTensor *b, THCTensor *a,
+                                     THCudaIntTensor *pivots, int nsteps,
+                                     THCTriangularStep step1, THCTriangularStep step2)
+{
+  THAssert(THCTensor_(checkGPU)(state, 3, rb_, b, a));
+  THCTensor_(checkBatchedSquare)(state, a, 3);
+  THArgCheck(b->nDimension == 2 || b->nDimension == 3, 2,
+             "expected a batch x n or batch x n x nrhs right-hand side");
+  THArgCheck(b->size[0] == a->size[0] && b->size[1] == a->size[1], 2,
+             "right-hand side does not match the matrices");
+
+  long batch = a->size[0];
+  int n = a->size[1];
+  int nrhs = b->nDimension == 3 ? b->size[2] : 1;
+
+  THCTensor *matrices = THCTensor_(newContiguous)(state, a);
+  THCTensor *input = THCTensor_(newContiguous)(state, b);
+  THCTensor_(resizeAs)(state, rb_, b);
+  THCTensor *output = THCTensor_(newContiguous)(state, rb_);
+  THCudaIntTensor *swaps = NULL;
+  if (pivots) {
+    THArgCheck(THCudaIntTensor_nElement(state, pivots) == batch * n, 4,
+               "expected batch x n pivots");
+    swaps = THCudaIntTensor_newContiguous(state, pivots);
+  }
+
+  if (batch > 0 && n > 0 && nrhs > 0) {
+    int tile = std::min(nrhs, THC_LINALG_MAX_RHS);
+    dim3 grid, block;
+    size_t smem;
+    THCLinalg_launchConfig(state, batch, n, (n * n + n * tile) * sizeof(real), grid, block, smem);
+    hipLaunchKernelGGL(
+      (batchedSolveKernel<real>), grid, block, smem, THCState_getCurrentStream(state),
+      THCTensor_(data)(state, matrices), THCTensor_(data)(state, input),
+      THCTensor_(data)(state, output), swaps ? THCudaIntTensor_data(state, swaps) : NULL,
+      batch, n, nrhs, nsteps, step1, step2);
+    THCudaCheck(hipGetLastError());
+  }
+
+  THCTensor_(free)(state, matrices);
+  THCTensor_(free)(state, input);
+  THCTensor_(freeCopyTo)(state, output, rb_);
+  if (swaps) {
+    THCudaIntTensor_free(state, swaps);
+  }
+}
+
+void THCTensor_(btrisolve)(THCState *state, THCTensor *rb_, THCTensor *b, THCTensor *lu,
+                           THCudaIntTensor *pivots)
+{
+  THCTriangularStep l = {true, false, true};
+  THCTriangularStep u = {false, false, false};
+  THCTensor_(batchedSolve)(state, rb_, b, lu, pivots, 2, l, u);
+}
+
+void THCTensor_(bpotrs)(THCState *state, THCTensor *rb_, THCTensor *b, THCTensor *chol,
+                        const char *uplo)
+{
+  THArgCheck(uplo[0] == 'U' || uplo[0] == 'L', 5, "uplo should be 'U' or 'L'");
+  bool lower = uplo[0] == 'L';
+  // L L^T x = b, or U^T U x = b
+  THCTriangularStep first = {lower, !lower, false};
+  THCTriangularStep second = {lower, lower, false};
+  THCTensor_(batchedSolve)(state, rb_, b, chol, NULL, 2, first, second);
+}
+
+void THCTensor_(btrtrs)(THCState *state, THCTensor *rb_, THCTensor *b, THCTensor *a,
+                        const char *uplo, const char *trans, const char *diag)
+{
+  THArgCheck(uplo[0] == 'U' || uplo[0] == 'L', 5, "uplo should be 'U' or 'L'");
+  THArgCheck(trans[0] == 'N' || trans[0] == 'T', 6, "trans should be 'N' or 'T'");
+  THArgCheck(diag[0] == 'N' || diag[0] == 'U', 7, "diag should be 'N' or 'U'");
+  THCTriangularStep step = {uplo[0] == 'L', trans[0] == 'T', diag[0] == 'U'};
+  THCTensor_(batchedSolve)(state, rb_, b, a, NULL, 1, step, step);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef THC_GENERIC_FILE
+#define THC_GENERIC_FILE "generic/THCTensorMathLinalg.h"
+#else
+
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
+
+/* Batched factorizations and solves of many small matrices (at most
+   THC_LINALG_MAX_N rows), entirely on the device. A is batch x n x n, a
+   right-hand side is batch x n x nrhs or batch x n.
+
+   btrifact: LU with partial pivoting, A = P L U, L unit lower and U upper
+   packed in ra_; rpivots_ (batch x n) holds the 1-based row swapped with
+   row k at step k, as LAPACK getrf. bpotrf: Cholesky, A = L L^T ('L') or
+   A = U^T U ('U'), reading only that triangle of A.
+
+   rinfo_ (batch) receives 0 for a successful factorization, k > 0 when
+   step k found a zero pivot or a non positive definite minor. When rinfo_
+   is NULL a failure raises an error instead, which synchronizes. */
+THC_API void THCTensor_(btrifact)(THCState *state, THCTensor *ra_, THCudaIntTensor *rpivots_, THCudaIntTensor *rinfo_, THCTensor *a);
+THC_API void THCTensor_(btrisolve)(THCState *state, THCTensor *rb_, THCTensor *b, THCTensor *lu, THCudaIntTensor *pivots);
+THC_API void THCTensor_(bpotrf)(THCState *state, THCTensor *ra_, THCudaIntTensor *rinfo_, THCTensor *a, const char *uplo);
+THC_API void THCTensor_(bpotrs)(THCState *state, THCTensor *rb_, THCTensor *b, THCTensor *chol, const char *uplo);
+/* op(A) X = B for triangular A, op(A) = A ('N') or A^T ('T'), with an
+   implicit unit diagonal when diag is 'U' */
+THC_API void THCTensor_(btrtrs)(THCState *state, THCTensor *rb_, THCTensor *b, THCTensor *a, const char *uplo, const char *trans, const char *diag);
+
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef THC_GENERIC_FILE
+#define THC_GENERIC_FILE "generic/THCTensorRandom.cu"
+#else
+
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE) || defined(THC_REAL_IS_HALF)
+
+// MTGP can only generate floats into contiguous memory, so it goes through a
+// float buffer unless the tensor already is one. The Philox engine writes
+// through the tensor's own strides and type instead.
+static THCudaTensor* THCTensor_(newMTGPBuffer)(THCState *state, THCTensor *self)
+{
+#ifdef THC_REAL_IS_FLOAT
+  return THCudaTensor_newContiguous(state, self);
+#else
+  THLongStorage *size = THCTensor_(newSizeOf)(state, self);
+  THCudaTensor *buffer = THCudaTensor_newWithSize(state, size, NULL);
+  THLongStorage_free(size);
+  return buffer;
+#endif
+}
+
+static void THCTensor_(freeMTGPBuffer)(THCState *state, THCudaTensor *buffer, THCTensor *self)
+{
+#ifdef THC_REAL_IS_FLOAT
+  THCudaTensor_freeCopyTo(state, buffer, self);
+#else
+  THCTensor_(copyCudaFloat)(state, self, buffer);
+  THCudaTensor_free(state, buffer);
+#endif
+}
+
+#define IMPLEMENT_CUDA_TENSOR_RANDOM(NAME, MTGP_NAME, NORMAL, FUNCTOR, ARGS, ARG_NAMES) \
+  void THCTensor_(NAME)(THCState *state, THCTensor *self, PARENS ARGS)  \
+  {                                                                     \
+    THAssert(THCTensor_(checkGPU)(state, 1, self));                     \
+    if (THCRandom_getGeneratorType(state) == THC_RNG_PHILOX) {          \
+      if (!THC_philoxApply1<NORMAL>(state, THCRandom_getGenerator(state), \
+                                    self, FUNCTOR)) {                   \
+        THArgCheck(false, 2, CUTORCH_DIM_WARNING);                      \
+      }                                                                 \
+    } else {                                                            \
+      THCudaTensor *buffer = THCTensor_(newMTGPBuffer)(state, self);    \
+      MTGP_NAME(state, buffer, PARENS ARG_NAMES);                       \
+      THCTensor_(freeMTGPBuffer)(state, buffer, self);                  \
+    }                                                                   \
+  }
+
+#define PARENS(...) __VA_ARGS__
+
+IMPLEMENT_CUDA_TENSOR_RANDOM(uniform, THCRandom_mtgpUniform, false,
+                             user_uniform_functor(a, b),
+                             (double a, double b), (a, b))
+IMPLEMENT_CUDA_TENSOR_RANDOM(bernoulli, THCRandom_mtgpBernoulli, false,
+                             user_bernoulli_functor(p),
+                             (double p), (p))
+IMPLEMENT_CUDA_TENSOR_RANDOM(normal, THCRandom_mtgpNormal, true,
+                             user_normal_functor(stdv, mean),
+                             (double mean, double stdv), (mean, stdv))
+IMPLEMENT_CUDA_TENSOR_RANDOM(logNormal, THCRandom_mtgpLogNormal, true,
+                             user_log_normal_functor(mean, stdv),
+                             (double mean, double stdv), (mean, stdv))
+IMPLEMENT_CUDA_TENSOR_RANDOM(geometric, THCRandom_mtgpGeometric, false,
+                             user_geometric_functor(p),
+                             (double p), (p))
+IMPLEMENT_CUDA_TENSOR_RANDOM(exponential, THCRandom_mtgpExponential, false,
+                             user_exponential_functor(lambda),
+                             (double lambda), (lambda))
+IMPLEMENT_CUDA_TENSOR_RANDOM(cauchy, THCRandom_mtgpCauchy, false,
+                             user_cauchy_functor(median, sigma),
+                             (double median, double sigma), (median, sigma))
+
+#undef PARENS
+#undef IMPLEMENT_CUDA_TENSOR_RANDOM
+
+#endif
+
+#endif
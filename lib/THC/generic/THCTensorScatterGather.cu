@@ -2,9 +2,61 @@
 #define THC_GENERIC_FILE "generic/THCTensorScatterGather.cu"
 #else
 
+// gather and scatter of whole contiguous rows; see
+// THCudaTensor_gatherScatterRowsKernel. `index` has the size of `src` for a
+// scatter and of `tensor` for a gather.
+template <typename IndexTensor, bool Scatter>
+static void THCTensor_(gatherScatterRows)(THCState* state, THCTensor *tensor, THCTensor *src,
+                                          IndexTensor *index, int dim) {
+  typedef typename TensorUtils<IndexTensor>::DataType IndexT;
+  THCTensor *indexed = Scatter ? src : tensor;
+  THCTensor *other = Scatter ? tensor : src;
+
+  long outer = 1;
+  for (int d = 0; d < dim; d++) {
+    outer *= THCTensor_(size)(state, indexed, d);
+  }
+  long inner = 1;
+  for (int d = dim + 1; d < THCTensor_(nDimension)(state, indexed); d++) {
+    inner *= THCTensor_(size)(state, indexed, d);
+  }
+  long indexDimSize = THCTensor_(size)(state, indexed, dim);
+  long numRows = outer * indexDimSize;
+  if (numRows == 0 || inner == 0) {
+    return;
+  }
+
+  size_t rowBytes = inner * sizeof(real);
+  char *tensorData = (char *) THCTensor_(data)(state, tensor);
+  char *srcData = (char *) THCTensor_(data)(state, src);
+  size_t alignment = (size_t) tensorData | (size_t) srcData | rowBytes;
+  const IndexT *indexData = TensorUtils<IndexTensor>::getData(state, index);
+  long indexStride = TensorUtils<IndexTensor>::getStride(state, index, dim);
+  long otherDimSize = THCTensor_(size)(state, other, dim);
+
+#define ROWS(UNIT) \
+  THC_gatherScatterRows<UNIT, IndexT, Scatter>( \
+    state, (UNIT *) tensorData, (const UNIT *) srcData, indexData, indexStride, \
+    numRows, indexDimSize, otherDimSize, rowBytes / sizeof(UNIT))
+
+  if (alignment % sizeof(uint4) == 0) {
+    ROWS(uint4);
+  } else if (alignment % sizeof(uint2) == 0) {
+    ROWS(uint2);
+  } else if (alignment % sizeof(unsigned int) == 0) {
+    ROWS(unsigned int);
+  } else if (alignment % sizeof(unsigned short) == 0) {
+    ROWS(unsigned short);
+  } else {
+    ROWS(unsigned char);
+  }
+
+#undef ROWS
+}
+
 #define RUN(TYPE, DIMS, REAL)\
   hipLaunchKernelGGL(\
-    (THCudaTensor_gatherKernel<TYPE, REAL, DIMS>),\
+    (THCudaTensor_gatherKernel<TYPE, REAL, DIMS, IndexT>),\
     grid,\
     block,\
     0,\
@@ -15,18 +67,19 @@
     dim,\
     (TYPE)totalElements);
 
-void THCTensor_(gather)(THCState* state, THCTensor *tensor,
-                         THCTensor *src, int dim, THCudaLongTensor *index) {
+template <typename IndexTensor>
+static void THCTensor_(gatherImpl)(THCState* state, THCTensor *tensor,
+                                   THCTensor *src, int dim, IndexTensor *index) {
+  typedef typename TensorUtils<IndexTensor>::DataType IndexT;
   THAssert(THCTensor_(checkGPU)(state, 2, tensor, src));
-  THAssert(THCudaLongTensor_checkGPU(state, 1, index));
 
   THArgCheck(THCTensor_(nDimension)(state, src) == THCTensor_(nDimension)(state, tensor), 2,
              "Input tensor must have same dimensions as output tensor");
   THArgCheck(dim >= 0 && dim < THCTensor_(nDimension)(state, tensor), 3,
              "Index dimension is out of bounds");
-  THArgCheck(THCudaLongTensor_nDimension(state, index) == THCTensor_(nDimension)(state, src), 4,
+  THArgCheck(TensorUtils<IndexTensor>::getDims(state, index) == THCTensor_(nDimension)(state, src), 4,
              "Index tensor must have same dimensions as input tensor");
-  THLongStorage *indexSize = THCudaLongTensor_newSizeOf(state, index);
+  THLongStorage *indexSize = TensorUtils<IndexTensor>::newSizeOf(state, index);
   THArgCheck(THCTensor_(isSize)(state, tensor, indexSize), 4,
              "Index tensor must have the same size as output tensor.");
   THLongStorage_free(indexSize);
@@ -41,8 +94,12 @@ void THCTensor_(gather)(THCState* state, THCTensor *tensor,
   THArgCheck(THCTensor_(nDimension)(state, tensor) <= MAX_CUTORCH_DIMS,
              1, CUTORCH_DIM_WARNING);
 
+  if (THC_canGatherScatterRows(state, tensor, src, index, dim)) {
+    THCTensor_(gatherScatterRows)<IndexTensor, false>(state, tensor, src, index, dim);
+    return;
+  }
 
-  const ptrdiff_t totalElements = THCudaLongTensor_nElement(state, index);
+  const ptrdiff_t totalElements = TensorUtils<IndexTensor>::getNumElements(state, index);
   const dim3 block = getApplyBlock();
   dim3 grid;
   THArgCheck(getApplyGrid(state, totalElements, grid), 1, CUTORCH_DIM_WARNING);
@@ -55,13 +112,13 @@ void THCTensor_(gather)(THCState* state, THCTensor *tensor,
 
   if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, tensor) &&
       TensorUtils<THCTensor>::canUse32BitIndexMath(state, src) &&
-      TensorUtils<THCudaLongTensor>::canUse32BitIndexMath(state, index)) {
+      TensorUtils<IndexTensor>::canUse32BitIndexMath(state, index)) {
     TensorInfo<real, unsigned int> tensorInfo =
       getTensorInfo<THCTensor, unsigned int>(state, tensor);
     TensorInfo<real, unsigned int> srcInfo =
       getTensorInfo<THCTensor, unsigned int>(state, src);
-    TensorInfo<long, unsigned int> indexInfo =
-      getTensorInfo<THCudaLongTensor, unsigned int>(state, index);
+    TensorInfo<IndexT, unsigned int> indexInfo =
+      getTensorInfo<IndexTensor, unsigned int>(state, index);
 
     // Specialize for a small number of dimensions.
     switch (indexInfo.dims) {
@@ -87,8 +144,8 @@ void THCTensor_(gather)(THCState* state, THCTensor *tensor,
       getTensorInfo<THCTensor, unsigned long>(state, tensor);
     TensorInfo<real, unsigned long> srcInfo =
       getTensorInfo<THCTensor, unsigned long>(state, src);
-    TensorInfo<long, unsigned long> indexInfo =
-      getTensorInfo<THCudaLongTensor, unsigned long>(state, index);
+    TensorInfo<IndexT, unsigned long> indexInfo =
+      getTensorInfo<IndexTensor, unsigned long>(state, index);
     RUN(unsigned long, -1, real);
     THCudaCheck(hipGetLastError());
   }
@@ -103,10 +160,22 @@ void THCTensor_(gather)(THCState* state, THCTensor *tensor,
 
 #undef RUN
 
+void THCTensor_(gather)(THCState* state, THCTensor *tensor,
+                         THCTensor *src, int dim, THCudaLongTensor *index) {
+  THAssert(THCudaLongTensor_checkGPU(state, 1, index));
+  THCTensor_(gatherImpl)(state, tensor, src, dim, index);
+}
+
+void THCTensor_(gatherInt)(THCState* state, THCTensor *tensor,
+                            THCTensor *src, int dim, THCudaIntTensor *index) {
+  THAssert(THCudaIntTensor_checkGPU(state, 1, index));
+  THCTensor_(gatherImpl)(state, tensor, src, dim, index);
+}
+
 
 #define RUN(TYPE, DIMS, REAL)\
   hipLaunchKernelGGL(\
-    (THCudaTensor_scatterKernel<TYPE, REAL, DIMS>),\
+    (THCudaTensor_scatterKernel<TYPE, REAL, DIMS, IndexT>),\
     grid,\
     block,\
     0,\
@@ -117,17 +186,19 @@ void THCTensor_(gather)(THCState* state, THCTensor *tensor,
     dim,\
     (TYPE)totalElements);
 
-void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLongTensor *index, THCTensor *src) {
+template <typename IndexTensor>
+static void THCTensor_(scatterImpl)(THCState* state, THCTensor *tensor, int dim,
+                                    IndexTensor *index, THCTensor *src) {
+  typedef typename TensorUtils<IndexTensor>::DataType IndexT;
   THAssert(THCTensor_(checkGPU)(state, 2, tensor, src));
-  THAssert(THCudaLongTensor_checkGPU(state, 1, index));
 
   THArgCheck(dim >= 0 && dim < THCTensor_(nDimension)(state, tensor), 2,
              "Index dimension is out of bounds");
-  THArgCheck(THCudaLongTensor_nDimension(state, index) == THCTensor_(nDimension)(state, src), 3,
+  THArgCheck(TensorUtils<IndexTensor>::getDims(state, index) == THCTensor_(nDimension)(state, src), 3,
              "Index tensor must have same dimensions as input tensor");
   THArgCheck(THCTensor_(nDimension)(state, src) == THCTensor_(nDimension)(state, tensor), 4,
              "Input tensor must have same dimensions as output tensor");
-  THLongStorage *indexDims = THCudaLongTensor_newSizeOf(state, index);
+  THLongStorage *indexDims = TensorUtils<IndexTensor>::newSizeOf(state, index);
   THArgCheck(THCTensor_(isSize)(state, src, indexDims), 3,
              "Index tensor must have the same size as input tensor.");
   THLongStorage_free(indexDims);
@@ -142,7 +213,12 @@ void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLong
   THArgCheck(THCTensor_(nDimension)(state, tensor) <= MAX_CUTORCH_DIMS,
              1, CUTORCH_DIM_WARNING);
 
-  const ptrdiff_t totalElements = THCudaLongTensor_nElement(state, index);
+  if (THC_canGatherScatterRows(state, tensor, src, index, dim)) {
+    THCTensor_(gatherScatterRows)<IndexTensor, true>(state, tensor, src, index, dim);
+    return;
+  }
+
+  const ptrdiff_t totalElements = TensorUtils<IndexTensor>::getNumElements(state, index);
   const dim3 block = getApplyBlock();
   dim3 grid;
   THArgCheck(getApplyGrid(state, totalElements, grid), 1, CUTORCH_DIM_WARNING);
@@ -155,13 +231,13 @@ void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLong
 
   if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, tensor) &&
       TensorUtils<THCTensor>::canUse32BitIndexMath(state, src) &&
-      TensorUtils<THCudaLongTensor>::canUse32BitIndexMath(state, index)) {
+      TensorUtils<IndexTensor>::canUse32BitIndexMath(state, index)) {
     TensorInfo<real, unsigned int> tensorInfo =
       getTensorInfo<THCTensor, unsigned int>(state, tensor);
     TensorInfo<real, unsigned int> srcInfo =
       getTensorInfo<THCTensor, unsigned int>(state, src);
-    TensorInfo<long, unsigned int> indexInfo =
-      getTensorInfo<THCudaLongTensor, unsigned int>(state, index);
+    TensorInfo<IndexT, unsigned int> indexInfo =
+      getTensorInfo<IndexTensor, unsigned int>(state, index);
 
     // Specialize for a small number of dimensions.
     switch (indexInfo.dims) {
@@ -178,6 +254,164 @@ void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLong
         RUN(unsigned int, -1, real);
         break;
     }
+  } else {
+    TensorInfo<real, unsigned long> tensorInfo =
+      getTensorInfo<THCTensor, unsigned long>(state, tensor);
+    TensorInfo<real, unsigned long> srcInfo =
+      getTensorInfo<THCTensor, unsigned long>(state, src);
+    TensorInfo<IndexT, unsigned long> indexInfo =
+      getTensorInfo<IndexTensor, unsigned long>(state, index);
+    RUN(unsigned long, -1, real)
+  }
+
+  if (oldTensor) {
+    TensorUtils<THCTensor>::copyIgnoringOverlaps(state, oldTensor, tensor);
+    THCTensor_(free)(state, tensor);
+    tensor = oldTensor;
+  }
+  THCudaCheck(hipGetLastError());
+}
+
+#undef RUN
+
+void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLongTensor *index, THCTensor *src) {
+  THAssert(THCudaLongTensor_checkGPU(state, 1, index));
+  THCTensor_(scatterImpl)(state, tensor, dim, index, src);
+}
+
+void THCTensor_(scatterInt)(THCState* state, THCTensor *tensor, int dim, THCudaIntTensor *index, THCTensor *src) {
+  THAssert(THCudaIntTensor_checkGPU(state, 1, index));
+  THCTensor_(scatterImpl)(state, tensor, dim, index, src);
+}
+
+// Deterministic scatterAdd: the offsets every element adds to are sorted
+// and duplicates reduced without atomics, on flat views of both tensors
+template <typename IndexType>
+static void THCTensor_(scatterAddSorted)(THCState* state,
+                                         const TensorInfo<real, IndexType>& tensorInfo,
+                                         const TensorInfo<real, IndexType>& srcInfo,
+                                         const TensorInfo<long, IndexType>& indexInfo,
+                                         int dim, ptrdiff_t totalElements,
+                                         dim3 grid, dim3 block) {
+  THCudaLongTensor *tensorOffsets = THCudaLongTensor_newWithSize1d(state, totalElements);
+  THCudaLongTensor *srcOffsets = THCudaLongTensor_newWithSize1d(state, totalElements);
+
+  hipLaunchKernelGGL(
+    (THCudaTensor_scatterAddOffsetsKernel<IndexType, real, -1>),
+    grid,
+    block,
+    0,
+    THCState_getCurrentStream(state),
+    make_magic_wrapper(tensorInfo),
+    make_magic_wrapper(srcInfo),
+    make_magic_wrapper(indexInfo),
+    dim,
+    (IndexType)totalElements,
+    THCudaLongTensor_data(state, tensorOffsets),
+    THCudaLongTensor_data(state, srcOffsets));
+  THCudaCheck(hipGetLastError());
+
+  // Slice k of a flat view is the element at offset k
+  IndexType sizes[MAX_CUTORCH_DIMS] = {1};
+  IndexType strides[MAX_CUTORCH_DIMS] = {1};
+  TensorInfo<real, IndexType> tensorFlat(tensorInfo.data, 1, sizes, strides);
+  TensorInfo<real, IndexType> srcFlat(srcInfo.data, 1, sizes, strides);
+
+  // Offsets are in range by construction
+  THC_sortedIndexAdd<real, accreal, IndexType>(
+    state, tensorFlat, srcFlat, 0, 0, (IndexType)1, LONG_MAX,
+    tensorOffsets, srcOffsets);
+
+  THCudaLongTensor_free(state, tensorOffsets);
+  THCudaLongTensor_free(state, srcOffsets);
+}
+
+#define RUN(TYPE, DIMS, REAL)\
+  hipLaunchKernelGGL(\
+    (THCudaTensor_scatterAddKernel<TYPE, REAL, DIMS>),\
+    grid,\
+    block,\
+    0,\
+    THCState_getCurrentStream(state),\
+    make_magic_wrapper(tensorInfo),\
+    make_magic_wrapper(srcInfo),\
+    make_magic_wrapper(indexInfo),\
+    dim,\
+    (TYPE)totalElements);
+
+void THCTensor_(scatterAdd)(THCState* state, THCTensor *tensor, int dim, THCudaLongTensor *index, THCTensor *src) {
+  THAssert(THCTensor_(checkGPU)(state, 2, tensor, src));
+  THAssert(THCudaLongTensor_checkGPU(state, 1, index));
+
+  THArgCheck(dim >= 0 && dim < THCTensor_(nDimension)(state, tensor), 2,
+             "Index dimension is out of bounds");
+  THArgCheck(THCudaLongTensor_nDimension(state, index) == THCTensor_(nDimension)(state, src), 3,
+             "Index tensor must have same dimensions as input tensor");
+  THArgCheck(THCTensor_(nDimension)(state, src) == THCTensor_(nDimension)(state, tensor), 4,
+             "Input tensor must have same dimensions as output tensor");
+  THLongStorage *indexDims = THCudaLongTensor_newSizeOf(state, index);
+  THArgCheck(THCTensor_(isSize)(state, src, indexDims), 3,
+             "Index tensor must have the same size as input tensor.");
+  THLongStorage_free(indexDims);
+
+  for (int d = 0; d < THCTensor_(nDimension)(state, tensor); d++) {
+    if (d != dim) {
+      THArgCheck(THCTensor_(size)(state, tensor, d) == THCTensor_(size)(state, src, d), 4,
+                 "Input tensor must have same size as output tensor apart from the specified dimension");
+    }
+  }
+
+  THArgCheck(THCTensor_(nDimension)(state, tensor) <= MAX_CUTORCH_DIMS,
+             1, CUTORCH_DIM_WARNING);
+
+  const ptrdiff_t totalElements = THCudaLongTensor_nElement(state, index);
+  const dim3 block = getApplyBlock();
+  dim3 grid;
+  THArgCheck(getApplyGrid(state, totalElements, grid), 1, CUTORCH_DIM_WARNING);
+
+#if defined(THC_REAL_IS_HALF) && defined(__HIP_PLATFORM_HCC__)
+  // atomicAdd is not implemented for half on this platform
+  int sorted = 1;
+#else
+  int sorted = THCState_getDeterministic(state);
+#endif
+
+  THCTensor* oldTensor = NULL;
+  if (TensorUtils<THCTensor>::overlappingIndices(state, tensor)) {
+    oldTensor = tensor;
+    tensor = THCTensor_(newContiguous)(state, tensor);
+  }
+
+  if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, tensor) &&
+      TensorUtils<THCTensor>::canUse32BitIndexMath(state, src) &&
+      TensorUtils<THCudaLongTensor>::canUse32BitIndexMath(state, index)) {
+    TensorInfo<real, unsigned int> tensorInfo =
+      getTensorInfo<THCTensor, unsigned int>(state, tensor);
+    TensorInfo<real, unsigned int> srcInfo =
+      getTensorInfo<THCTensor, unsigned int>(state, src);
+    TensorInfo<long, unsigned int> indexInfo =
+      getTensorInfo<THCudaLongTensor, unsigned int>(state, index);
+
+    if (sorted) {
+      THCTensor_(scatterAddSorted)<unsigned int>(state, tensorInfo, srcInfo, indexInfo,
+                                                 dim, totalElements, grid, block);
+    } else {
+      // Specialize for a small number of dimensions.
+      switch (indexInfo.dims) {
+        case 1:
+          RUN(unsigned int, 1, real);
+          break;
+        case 2:
+          RUN(unsigned int, 2, real);
+          break;
+        case 3:
+          RUN(unsigned int, 3, real);
+          break;
+        default:
+          RUN(unsigned int, -1, real);
+          break;
+      }
+    }
   } else {
     TensorInfo<real, unsigned long> tensorInfo =
       getTensorInfo<THCTensor, unsigned long>(state, tensor);
@@ -185,7 +419,13 @@ void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLong
       getTensorInfo<THCTensor, unsigned long>(state, src);
     TensorInfo<long, unsigned long> indexInfo =
       getTensorInfo<THCudaLongTensor, unsigned long>(state, index);
-    RUN(unsigned long, -1, real)
+
+    if (sorted) {
+      THCTensor_(scatterAddSorted)<unsigned long>(state, tensorInfo, srcInfo, indexInfo,
+                                                  dim, totalElements, grid, block);
+    } else {
+      RUN(unsigned long, -1, real);
+    }
   }
 
   if (oldTensor) {
@@ -200,7 +440,7 @@ void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLong
 
 #define RUN(TYPE, DIMS, REAL)\
   hipLaunchKernelGGL(\
-    (THCudaTensor_scatterFillKernel<TYPE, REAL, DIMS>),\
+    (THCudaTensor_scatterFillKernel<TYPE, REAL, DIMS, IndexT>),\
     grid,\
     block,\
     0,\
@@ -211,22 +451,22 @@ void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLong
     dim,\
     (TYPE)totalElements);
 
-void
-THCTensor_(scatterFill)(THCState* state, THCTensor *tensor,
-                         int dim, THCudaLongTensor *index, real value) {
+template <typename IndexTensor>
+static void THCTensor_(scatterFillImpl)(THCState* state, THCTensor *tensor,
+                                        int dim, IndexTensor *index, real value) {
+  typedef typename TensorUtils<IndexTensor>::DataType IndexT;
   THAssert(THCTensor_(checkGPU)(state, 1, tensor));
-  THAssert(THCudaLongTensor_checkGPU(state, 1, index));
 
   THArgCheck(dim >= 0 && dim < THCTensor_(nDimension)(state, tensor), 2,
              "Index dimension is out of bounds");
-  THArgCheck(THCudaLongTensor_nDimension(state, index) ==
+  THArgCheck(TensorUtils<IndexTensor>::getDims(state, index) ==
              THCTensor_(nDimension)(state, tensor), 3,
              "Index tensor must have same dimensions as output tensor");
 
   for (int d = 0; d < THCTensor_(nDimension)(state, tensor); d++) {
     if (d != dim) {
       THArgCheck(THCTensor_(size)(state, tensor, d) ==
-                 THCudaLongTensor_size(state, index, d), 4,
+                 TensorUtils<IndexTensor>::getSize(state, index, d), 4,
                  "Index tensor must have same size as output tensor apart from the specified dimension");
     }
   }
@@ -234,7 +474,7 @@ THCTensor_(scatterFill)(THCState* state, THCTensor *tensor,
   THArgCheck(THCTensor_(nDimension)(state, tensor) <= MAX_CUTORCH_DIMS,
              1, CUTORCH_DIM_WARNING);
 
-  const ptrdiff_t totalElements = THCudaLongTensor_nElement(state, index);
+  const ptrdiff_t totalElements = TensorUtils<IndexTensor>::getNumElements(state, index);
   const dim3 block = getApplyBlock();
   dim3 grid;
   THArgCheck(getApplyGrid(state, totalElements, grid), 1, CUTORCH_DIM_WARNING);
@@ -246,11 +486,11 @@ THCTensor_(scatterFill)(THCState* state, THCTensor *tensor,
   }
 
   if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, tensor) &&
-      TensorUtils<THCudaLongTensor>::canUse32BitIndexMath(state, index)) {
+      TensorUtils<IndexTensor>::canUse32BitIndexMath(state, index)) {
     TensorInfo<real, unsigned int> tensorInfo =
       getTensorInfo<THCTensor, unsigned int>(state, tensor);
-    TensorInfo<long, unsigned int> indexInfo =
-      getTensorInfo<THCudaLongTensor, unsigned int>(state, index);
+    TensorInfo<IndexT, unsigned int> indexInfo =
+      getTensorInfo<IndexTensor, unsigned int>(state, index);
 
     // Specialize for a small number of dimensions.
     switch (indexInfo.dims) {
@@ -270,8 +510,8 @@ THCTensor_(scatterFill)(THCState* state, THCTensor *tensor,
   } else {
     TensorInfo<real, unsigned long> tensorInfo =
       getTensorInfo<THCTensor, unsigned long>(state, tensor);
-    TensorInfo<long, unsigned long> indexInfo =
-      getTensorInfo<THCudaLongTensor, unsigned long>(state, index);
+    TensorInfo<IndexT, unsigned long> indexInfo =
+      getTensorInfo<IndexTensor, unsigned long>(state, index);
     RUN(unsigned long, -1, real);
   }
 
@@ -285,4 +525,18 @@ THCTensor_(scatterFill)(THCState* state, THCTensor *tensor,
 
 #undef RUN
 
+void
+THCTensor_(scatterFill)(THCState* state, THCTensor *tensor,
+                         int dim, THCudaLongTensor *index, real value) {
+  THAssert(THCudaLongTensor_checkGPU(state, 1, index));
+  THCTensor_(scatterFillImpl)(state, tensor, dim, index, value);
+}
+
+void
+THCTensor_(scatterFillInt)(THCState* state, THCTensor *tensor,
+                            int dim, THCudaIntTensor *index, real value) {
+  THAssert(THCudaIntTensor_checkGPU(state, 1, index));
+  THCTensor_(scatterFillImpl)(state, tensor, dim, index, value);
+}
+
 #endif
@@ -4,6 +4,12 @@
 
 THC_API void THCTensor_(gather)(THCState* state, THCTensor *tensor, THCTensor *src, int dim, THCudaLongTensor *index);
 THC_API void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLongTensor *index, THCTensor *src);
+THC_API void THCTensor_(scatterAdd)(THCState* state, THCTensor *tensor, int dim, THCudaLongTensor *index, THCTensor *src);
 THC_API void THCTensor_(scatterFill)(THCState* state, THCTensor *tensor, int dim, THCudaLongTensor *index, real value);
 
+/* Same, with 32-bit indices */
+THC_API void THCTensor_(gatherInt)(THCState* state, THCTensor *tensor, THCTensor *src, int dim, THCudaIntTensor *index);
+THC_API void THCTensor_(scatterInt)(THCState* state, THCTensor *tensor, int dim, THCudaIntTensor *index, THCTensor *src);
+THC_API void THCTensor_(scatterFillInt)(THCState* state, THCTensor *tensor, int dim, THCudaIntTensor *index, real value);
+
 #endif
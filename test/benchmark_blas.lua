@@ -0,0 +1,58 @@
+-- Times mm and mv on cutorch's built-in small/skinny kernels against the BLAS
+-- library over a grid of shapes, to tune the dispatch thresholds in THCBlas.cu.
+-- Usage: th test/benchmark_blas.lua [iterations]
+require 'cutorch'
+
+local iterations = tonumber(arg and arg[1]) or 200
+
+local function timeIt(f)
+   f() -- warm up, so allocations and first-launch costs are not measured
+   cutorch.synchronize()
+   local timer = torch.Timer()
+   for _ = 1, iterations do
+      f()
+   end
+   cutorch.synchronize()
+   return timer:time().real / iterations * 1e6
+end
+
+local function compare(label, f)
+   local oldForce = cutorch.getBlasForceLibrary()
+   cutorch.setBlasForceLibrary(false)
+   local builtin = timeIt(f)
+   cutorch.setBlasForceLibrary(true)
+   local library = timeIt(f)
+   cutorch.setBlasForceLibrary(oldForce)
+   print(string.format('%-28s %12.2f %12.2f %8.2fx', label, builtin, library, library / builtin))
+end
+
+print(string.format('%-28s %12s %12s %9s', 'shape', 'builtin(us)', 'library(us)', 'speedup'))
+
+-- mm: m x k times k x n, both operands plain and transposed
+local mmShapes = {
+   {4, 4, 4}, {8, 8, 8}, {16, 16, 16}, {32, 32, 32}, {64, 64, 64},
+   {13, 57, 31}, {64, 1, 64},
+   {256, 256, 1}, {1024, 1024, 1}, {1024, 1024, 4}, {1024, 1024, 8},
+   {4096, 256, 8}, {256, 4096, 8},
+}
+for _, shape in ipairs(mmShapes) do
+   local m, k, n = unpack(shape)
+   local a = torch.CudaTensor(m, k):uniform()
+   local at = torch.CudaTensor(k, m):uniform():t()
+   local b = torch.CudaTensor(k, n):uniform()
+   local c = torch.CudaTensor(m, n)
+   compare(string.format('mm %dx%d * %dx%d', m, k, k, n), function() c:mm(a, b) end)
+   compare(string.format('mm %dx%d^T * %dx%d', k, m, k, n), function() c:mm(at, b) end)
+end
+
+-- mv: m x n times n
+local mvShapes = {{8, 8}, {32, 32}, {64, 64}, {16, 256}, {256, 16}}
+for _, shape in ipairs(mvShapes) do
+   local m, n = unpack(shape)
+   local a = torch.CudaTensor(m, n):uniform()
+   local at = torch.CudaTensor(n, m):uniform():t()
+   local x = torch.CudaTensor(n):uniform()
+   local y = torch.CudaTensor(m)
+   compare(string.format('mv %dx%d', m, n), function() y:mv(a, x) end)
+   compare(string.format('mv %dx%d^T', n, m), function() y:mv(at, x) end)
+end
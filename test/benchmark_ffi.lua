@@ -0,0 +1,51 @@
+-- Times the per-call overhead of tensor methods against the LuaJIT FFI
+-- bindings of cutorch.ffi, on tensors small enough that the launch and the
+-- dispatch dominate. Usage: th test/benchmark_ffi.lua [iterations [size]]
+require 'cutorch'
+
+local iterations = tonumber(arg and arg[1]) or 10000
+local size = tonumber(arg and arg[2]) or 16
+
+assert(cutorch.ffi, 'cutorch.ffi needs LuaJIT and a loadable libTHC')
+local F = cutorch.ffi['torch.CudaTensor']
+
+local function timeIt(f)
+   f() -- warm up, so allocations and first-launch costs are not measured
+   cutorch.synchronize()
+   local timer = torch.Timer()
+   for _ = 1, iterations do
+      f()
+   end
+   cutorch.synchronize()
+   return timer:time().real / iterations * 1e6
+end
+
+local function compare(label, method, direct)
+   local viaMethod = timeIt(method)
+   local viaFFI = timeIt(direct)
+   print(string.format('%-12s %12.2f %12.2f %8.2fx', label, viaMethod, viaFFI, viaMethod / viaFFI))
+end
+
+local a = torch.CudaTensor(size, size):uniform()
+local b = torch.CudaTensor(size, size):uniform()
+local r = torch.CudaTensor(size, size)
+local view = torch.CudaTensor()
+local viewSize = torch.LongStorage{size * size}
+
+print(string.format('%d x %d float tensors, %d calls', size, size, iterations))
+print(string.format('%-12s %12s %12s %9s', 'op', 'method(us)', 'ffi(us)', 'speedup'))
+compare('fill', function() r:fill(1) end, function() F.fill(r, 1) end)
+compare('copy', function() r:copy(a) end, function() F.copy(r, a) end)
+compare('add', function() r:add(a, 2) end, function() F.add(r, a, 2) end)
+compare('mul', function() r:mul(a, 2) end, function() F.mul(r, a, 2) end)
+compare('cadd', function() r:add(a, 2, b) end, function() F.cadd(r, a, 2, b) end)
+compare('cmul', function() r:cmul(a, b) end, function() F.cmul(r, a, b) end)
+compare('sigmoid', function() r:sigmoid(a) end, function() F.sigmoid(r, a) end)
+compare('addmm', function() r:addmm(0.5, b, 1, a, b) end,
+        function() F.addmm(r, 0.5, b, 1, a, b) end)
+compare('narrow', function() a:narrow(1, 2, 3) end,
+        function() F.narrow(view, a, 1, 2, 3) end)
+compare('select', function() a:select(1, 2) end,
+        function() F.select(view, a, 1, 2) end)
+compare('view', function() view:view(a, viewSize) end,
+        function() F.view(view, a, viewSize) end)
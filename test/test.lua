@@ -764,6 +764,136 @@ function test.copyAsync()
                          "Async copy to host failed.")
 end
 
+function test.copyScaled()
+   local sz1, sz2 = chooseInt(minsize, maxsize), chooseInt(minsize, maxsize)
+   local x = torch.ByteTensor(sz1, sz2):random(0, 255)
+   local expected = x:double():mul(1 / 255):add(-0.5)
+   for _, typename in ipairs(float_typenames) do
+      local tolerance = typename == 'torch.CudaHalfTensor' and 1e-2 or 1e-5
+      local y = torch.Tensor():type(typename)
+      -- every host type is converted on the device
+      for _, srctype in ipairs(typenames) do
+         local src = x:type(t2cpu[srctype])
+         y:resize(sz1, sz2):copy(src)
+         tester:assertTensorEq(y:double(), src:double(), tolerance,
+                               'wrong copy from ' .. t2cpu[srctype] .. ' to ' .. typename)
+      end
+      local yt = y:resize(sz2, sz1):t():copyScaled(x, 1 / 255, -0.5)
+      tester:assertTensorEq(yt:double(), expected, tolerance,
+                            'wrong copyScaled from host to ' .. typename)
+      y = torch.Tensor(sz1, sz2):type(typename):copyScaled(x:cuda():byte(), 2)
+      tester:assertTensorEq(y:double(), x:double():mul(2), tolerance,
+                            'wrong copyScaled on the device to ' .. typename)
+   end
+end
+
+function test.ffiFastPath()
+   if not cutorch.ffi then
+      return
+   end
+   local sz1, sz2 = chooseInt(minsize, maxsize), chooseInt(minsize, maxsize)
+   for _, typename in ipairs(typenames) do
+      local F = cutorch.ffi[typename]
+      local a = torch.FloatTensor(sz1, sz2):random(1, 10):type(typename)
+      local b = torch.FloatTensor(sz1, sz2):random(1, 10):type(typename)
+      local r = a.new()
+
+      tester:assertTensorEq(F.fill(r:resize(sz1, sz2), 3):double(),
+                            r.new(sz1, sz2):fill(3):double(), 0, 'wrong fill of ' .. typename)
+      tester:assertTensorEq(F.copy(r, a):double(), a:double(), 0, 'wrong copy of ' .. typename)
+      tester:assertTensorEq(F.add(r, a, 2):double(), a:double():add(2), 0,
+                            'wrong add of ' .. typename)
+      tester:assertTensorEq(F.mul(r, a, 2):double(), a:double():mul(2), 0,
+                            'wrong mul of ' .. typename)
+      tester:assertTensorEq(F.cadd(r, a, 2, b):double(), a:double():add(2, b:double()), 0,
+                            'wrong cadd of ' .. typename)
+      tester:assertTensorEq(F.cmul(r, a, b):double(), a:double():cmul(b:double()), 0,
+                            'wrong cmul of ' .. typename)
+
+      local view = a.new()
+      tester:assertTensorEq(F.narrow(view, a, 2, 1, sz2 - 1):double(),
+                            a:narrow(2, 1, sz2 - 1):double(), 0, 'wrong narrow of ' .. typename)
+      tester:assertTensorEq(F.select(view, a, 1, sz1):double(), a[sz1]:double(), 0,
+                            'wrong select of ' .. typename)
+      tester:assertTensorEq(F.view(view, a, torch.LongStorage{sz1 * sz2}):double(),
+                            a:view(sz1 * sz2):double(), 0, 'wrong view of ' .. typename)
+      tester:assertError(function() F.copy(r, a:double()) end,
+                         'a tensor of another type should be rejected')
+      tester:assertError(function() F.select(view, a, 3, 1) end,
+                         'a dimension out of range should be rejected')
+   end
+
+   for _, typename in ipairs(float_typenames) do
+      local F = cutorch.ffi[typename]
+      local tolerance = typename == 'torch.CudaHalfTensor' and 1e-1 or 1e-4
+      local m1 = torch.FloatTensor(sz1, 5):uniform():type(typename)
+      local m2 = torch.FloatTensor(5, sz2):uniform():type(typename)
+      local t = torch.FloatTensor(sz1, sz2):uniform():type(typename)
+      local r = t.new()
+      tester:assertTensorEq(F.addmm(r, 0.5, t, 2, m1, m2):double(),
+                            t.new():addmm(0.5, t, 2, m1, m2):double(), tolerance,
+                            'wrong addmm of ' .. typename)
+      tester:assertTensorEq(F.sigmoid(r, t):double(), t:clone():sigmoid():double(), tolerance,
+                            'wrong sigmoid of ' .. typename)
+   end
+end
+
+function test.applyExpression()
+   local sz1, sz2 = chooseInt(minsize, maxsize), chooseInt(minsize, maxsize)
+   local x = torch.FloatTensor(sz1, sz2):uniform(-2, 2)
+   local y = torch.FloatTensor(sz1, sz2):uniform(0.5, 2)
+   local z = torch.FloatTensor(sz1, sz2):uniform(-1, 1)
+
+   local function check(expression, f)
+      for _, typename in ipairs(float_typenames) do
+         local tolerance = typename == 'torch.CudaHalfTensor' and 1e-2 or 1e-4
+         local cx, cy, cz = x:type(typename), y:type(typename), z:type(typename)
+         -- from the values the device sees, rounded to half for half tensors
+         local expected = cx:float():map2(cy:float(), cz:float(), f)
+         cx = cx:t():contiguous():t()
+         cx:map2(cy, cz, expression)
+         tester:assertTensorEq(cx:float(), expected, tolerance,
+                               "wrong '" .. expression .. "' on " .. typename)
+      end
+   end
+
+   check('x + y * z - 2', function(x, y, z) return x + y * z - 2 end)
+   check('-x^2 + (x - z) / y', function(x, y, z) return -x^2 + (x - z) / y end)
+   check('x > 0 ? log(y) : exp(z)', function(x, y, z) return x > 0 and math.log(y) or math.exp(z) end)
+   check('x >= z and not (y < 1) || x == 0',
+         function(x, y, z) return ((x >= z and not (y < 1)) or x == 0) and 1 or 0 end)
+   check('max(abs(x), sqrt(y)) + min(z, 0.5) + sigmoid(x)',
+         function(x, y, z)
+            return math.max(math.abs(x), math.sqrt(y)) + math.min(z, 0.5) + 1 / (1 + math.exp(-x))
+         end)
+   check('floor(x * 3) % 2 + tanh(z) * pi',
+         function(x, y, z) return math.floor(x * 3) % 2 + math.tanh(z) * math.pi end)
+
+   -- every type, and fewer operands
+   for _, typename in ipairs(typenames) do
+      local a = torch.FloatTensor(sz1, sz2):random(1, 50)
+      local b = torch.FloatTensor(sz1, sz2):random(1, 50)
+      local ca = a:type(typename)
+      ca:apply('x % 7 + 1')
+      tester:assertTensorEq(ca:float(), a:clone():apply(function(v) return v % 7 + 1 end), 0,
+                            'wrong apply on ' .. typename)
+      ca = a:type(typename)
+      ca:map(b:type(typename), 'x < y ? y - x : x - y')
+      tester:assertTensorEq(ca:float(), (a - b):abs(), 0, 'wrong map on ' .. typename)
+      -- a Lua function still works, on the host
+      ca = a:type(typename)
+      ca:apply(function(v) return v + 1 end)
+      tester:assertTensorEq(ca:float(), a + 1, 0, 'wrong host apply on ' .. typename)
+   end
+
+   local t = torch.CudaTensor(3)
+   tester:assertError(function() t:apply('x + y') end, 'y should not be available to apply')
+   tester:assertError(function() t:apply('x +') end, 'a syntax error should be reported')
+   tester:assertError(function() t:apply('foo(x)') end, 'an unknown name should be reported')
+   tester:assert(cutorch.compileExpression('x * 2') == cutorch.compileExpression('x * 2'),
+                 'expressions should be compiled once')
+end
+
 function test.largeNoncontiguous()
    local x = torch.FloatTensor():randn(20, 1, 60, 60)
    local sz = chooseInt(maxsize, 2 * maxsize)
@@ -796,6 +926,239 @@ function test.fill()
    checkMultiDevice(x, 'fill', v)
 end
 
+function test.fillContiguous()
+   -- every alignment of the head and length of the tail of the 16-byte
+   -- stores, and values that do and do not go through memset
+   cutorch.reserveStreams(1)
+   for k, typename in ipairs(typenames) do
+      local ctype = t2cpu[typename]
+      for _, v in ipairs({0, -1, 3, 100}) do
+         for offset = 0, 5 do
+            for _, len in ipairs({0, 1, 7, 33, 1000 + chooseInt(1, 64)}) do
+               local x = torch.Tensor(len + 12):fill(5):type(typename)
+               x:narrow(1, offset + 1, len):fill(v)
+               local expected = torch.Tensor(len + 12):fill(5)
+               expected:narrow(1, offset + 1, len):fill(v)
+               tester:assertTensorEq(x:type(ctype), expected:type(ctype), 0,
+                                     'wrong fill of ' .. len .. ' elements at offset ' .. offset)
+            end
+         end
+
+         -- storages fill on the current stream
+         cutorch.setStream(1)
+         local s = torch.Tensor(chooseInt(1, 1000)):type(typename):storage()
+         s:fill(v)
+         cutorch.setStream(0)
+         cutorch.synchronize()
+         local expected = torch.Tensor(s:size()):fill(v):type(ctype)
+         tester:assertTensorEq(torch.Tensor():type(typename):set(s):type(ctype), expected, 0,
+                               'wrong storage fill')
+      end
+   end
+end
+
+function test.loadMapped()
+   local filename = os.tmpname()
+   local objects = {}
+   for k, typename in ipairs(typenames) do
+      local x = torch.Tensor(chooseInt(1, 100), chooseInt(1, 100)):uniform(0, 100):floor():type(typename)
+      objects[typename] = {x = x, xt = x:t(), row = x[1]}
+   end
+   -- several chunks of the staging buffers
+   objects.big = torch.CudaTensor(3 * 1024 * 1024 + chooseInt(1, 1000)):uniform()
+   torch.save(filename, objects)
+
+   local loaded = cutorch.loadMapped(filename)
+   os.remove(filename)
+   for k, typename in ipairs(typenames) do
+      local ctype = t2cpu[typename]
+      local l = loaded[typename]
+      tester:assert(torch.type(l.x) == typename, 'wrong type after loadMapped')
+      tester:assertTensorEq(l.x:type(ctype), objects[typename].x:type(ctype), 0,
+                            'wrong contents after loadMapped')
+      tester:assertTensorEq(l.row:type(ctype), objects[typename].row:type(ctype), 0,
+                            'wrong contents of a view after loadMapped')
+      tester:assert(torch.pointer(l.x:storage()) == torch.pointer(l.xt:storage()) and
+                    torch.pointer(l.x:storage()) == torch.pointer(l.row:storage()),
+                    'shared storage loaded more than once')
+   end
+   tester:assertTensorEq(loaded.big:float(), objects.big:float(), 0,
+                         'wrong contents of a large storage after loadMapped')
+end
+
+function test.tensorArchive()
+   local filename = os.tmpname()
+   local tensors = {}
+   for k, typename in ipairs(typenames) do
+      tensors[typename] = torch.Tensor(chooseInt(1, 50), chooseInt(1, 50)):uniform(0, 100):floor():type(typename)
+   end
+   tensors.view = torch.CudaTensor(20, 30):uniform():t()
+   tensors.empty = torch.CudaTensor()
+   cutorch.saveTensors(filename, tensors):wait()
+
+   local index = cutorch.tensorArchiveIndex(filename)
+   for name, t in pairs(tensors) do
+      tester:assert(index[name].type == torch.type(t), 'wrong type in the index')
+      tester:assert(index[name].offset % 4096 == 0, 'data not aligned')
+      tester:assert(index[name].bytes == t:nElement() * t:elementSize(), 'wrong length in the index')
+   end
+
+   local all = cutorch.loadTensors(filename)
+   for name, t in pairs(tensors) do
+      local ctype = t2cpu[torch.type(t)]
+      tester:assert(torch.type(all[name]) == torch.type(t), 'wrong type after loadTensors')
+      if t:nElement() > 0 then
+         tester:assertTensorEq(all[name]:type(ctype), t:type(ctype), 0, 'wrong contents after loadTensors')
+      end
+   end
+
+   -- a subset, and rows of a tensor
+   local x = tensors['torch.CudaTensor']
+   local first = chooseInt(1, x:size(1))
+   local last = chooseInt(first, x:size(1))
+   local some = cutorch.loadTensors(filename, {view = true, ['torch.CudaTensor'] = {first, last}})
+   tester:assert(some['torch.CudaLongTensor'] == nil, 'loaded a tensor not selected')
+   tester:assertTensorEq(some.view:float(), tensors.view:float(), 0, 'wrong selected tensor')
+   tester:assertTensorEq(some['torch.CudaTensor']:float(), x:narrow(1, first, last - first + 1):float(), 0,
+                         'wrong rows')
+
+   -- a header naming a type that is not a CUDA tensor, and a file that is
+   -- not an archive at all
+   cutorch.saveTensors(filename, {x = torch.CudaTensor(3):fill(1)}):wait()
+   local f = io.open(filename, 'rb')
+   local bytes = f:read('*a')
+   f:close()
+   f = io.open(filename, 'wb')
+   f:write((bytes:gsub('torch%.CudaTensor', 'torch.FileTensor', 1)))
+   f:close()
+   tester:assertError(function() cutorch.loadTensors(filename) end,
+                      'loadTensors accepts an unknown tensor type')
+   tester:assertError(function() cutorch.tensorArchiveIndex(filename) end,
+                      'tensorArchiveIndex accepts an unknown tensor type')
+   torch.save(filename, {1, 2, 3})
+   tester:assertError(function() cutorch.loadTensors(filename) end,
+                      'loadTensors accepts a file that is not an archive')
+   os.remove(filename)
+end
+
+function test.saveAsync()
+   local filename = os.tmpname()
+   local objects = {}
+   for k, typename in ipairs(typenames) do
+      local x = torch.Tensor(chooseInt(1, 100), chooseInt(1, 100)):uniform(0, 100):floor():type(typename)
+      objects[typename] = {x = x, xt = x:t()}
+   end
+   objects.big = torch.CudaTensor(5 * 1024 * 1024 + chooseInt(1, 1000)):uniform()
+   local expected = objects.big:float()
+
+   local writer = cutorch.saveAsync(filename, objects)
+   -- the snapshot is taken before saveAsync returns
+   objects.big:zero()
+   writer:wait()
+   tester:assert(writer:isDone(), 'writer not done after wait')
+
+   local loaded = torch.load(filename)
+   for k, typename in ipairs(typenames) do
+      local ctype = t2cpu[typename]
+      tester:assertTensorEq(loaded[typename].x:type(ctype), objects[typename].x:type(ctype), 0,
+                            'wrong contents after saveAsync')
+      tester:assert(torch.pointer(loaded[typename].x:storage()) ==
+                    torch.pointer(loaded[typename].xt:storage()),
+                    'shared storage not shared after saveAsync')
+   end
+   tester:assertTensorEq(loaded.big:float(), expected, 0, 'wrong contents of a large storage')
+
+   if cutorch.hasHalf then
+      local x = torch.CudaTensor(chooseInt(1, 100)):uniform()
+      cutorch.saveAsync(filename, {x = x, y = x:narrow(1, 1, 1)}, {half = true}):wait()
+      local l = torch.load(filename)
+      tester:assert(torch.type(l.x) == 'torch.CudaHalfTensor', 'not converted to half')
+      tester:assertTensorEq(l.x:float(), x:cudaHalf():float(), 0, 'wrong half contents')
+      tester:assert(torch.pointer(l.x:storage()) == torch.pointer(l.y:storage()),
+                    'half views do not share their storage')
+   end
+   os.remove(filename)
+end
+
+function test.storageGrowth()
+   -- grows step by step, as a decoder output, then shrinks; the contents
+   -- must survive whether the block moves or grows in place
+   local factor = cutorch.getStorageGrowthFactor()
+   for _, f in ipairs({1, 2}) do
+      cutorch.setStorageGrowthFactor(f)
+      for k, typename in ipairs(typenames) do
+         local ctype = t2cpu[typename]
+         local x = torch.Tensor(1):zero():type(typename)
+         local expected = torch.Tensor(1):zero():type(ctype)
+         for step = 1, 40 do
+            local row = torch.Tensor(chooseInt(1, 3000)):fill(step % 100)
+            local n = x:nElement()
+            x:storage():resize(n + row:size(1))
+            x:set(x:storage())
+            x:narrow(1, n + 1, row:size(1)):copy(row:type(typename))
+            expected = torch.cat(expected, row:type(ctype))
+         end
+         tester:assertTensorEq(x:type(ctype), expected, 0, 'wrong contents after growth')
+
+         local keep = chooseInt(1, expected:size(1))
+         x:storage():resize(keep)
+         x:set(x:storage())
+         tester:assertTensorEq(x:type(ctype), expected:narrow(1, 1, keep), 0,
+                               'wrong contents after shrinking')
+      end
+   end
+   cutorch.setStorageGrowthFactor(factor)
+end
+
+function test.getSetElements()
+   for k, typename in ipairs(typenames) do
+      local ctype = t2cpu[typename]
+      local sz1, sz2 = chooseInt(2, 40), chooseInt(2, 40)
+      local x = torch.Tensor(sz1, sz2):uniform(-50, 50):floor():type(typename)
+      local y = x:t()
+      local n = chooseInt(1, 100)
+      local coords = torch.LongTensor(n, 2)
+      coords:select(2, 1):random(1, sz2)
+      coords:select(2, 2):random(1, sz1)
+      coords[1][1] = -1
+
+      local values = y:getElements(coords)
+      tester:assert(values:type() == 'torch.DoubleTensor', 'wrong type of getElements')
+      for i = 1, n do
+         tester:assert(values[i] == y[{coords[i][1], coords[i][2]}],
+                       'wrong getElements of ' .. typename)
+      end
+
+      -- distinct coordinates, so that every element is written once
+      local perm = torch.randperm(sz1 * sz2)
+      local m = chooseInt(1, sz1 * sz2)
+      coords = torch.LongTensor(m, 2)
+      for i = 1, m do
+         coords[i][1] = math.floor((perm[i] - 1) / sz1) + 1
+         coords[i][2] = (perm[i] - 1) % sz1 + 1
+      end
+      local expected = x:type(ctype):clone()
+      local written = torch.DoubleTensor(m):random(0, 50)
+      y:setElements(coords, written)
+      for i = 1, m do
+         expected[{coords[i][2], coords[i][1]}] = written[i]
+      end
+      tester:assertTensorEq(x:type(ctype), expected, 0, 'wrong setElements of ' .. typename)
+
+      y:setElements(coords, 7)
+      for i = 1, m do
+         tester:assert(y[{coords[i][1], coords[i][2]}] == 7, 'wrong setElements of a number')
+      end
+
+      -- single elements on a user stream
+      cutorch.reserveStreams(1)
+      cutorch.setStream(1)
+      x[1][1] = 9
+      tester:assert(x[1][1] == 9, 'wrong element write on a stream')
+      cutorch.setStream(0)
+   end
+end
+
 function test.reshape()
    local sz1 = chooseInt(minsize, maxsize)*2
    local sz2 = chooseInt(minsize, maxsize)
@@ -1692,6 +2055,38 @@ function test.indexAddHalf()
   end
 end
 
+function test.indexAddDeterministic()
+   -- Zipf-like indices: a few rows take most of the updates, and their runs
+   -- span many chunks of the sorted reduction
+   local numIndices, rows, cols = 5000, 100, 33
+   local indices = torch.rand(numIndices):pow(4):mul(rows):floor():add(1):long()
+   local src = torch.randn(numIndices, cols):float()
+   local dst = torch.randn(rows, cols):float()
+   local expected = dst:clone():indexAdd(1, indices, src)
+
+   local oldDeterministic = cutorch.getDeterministic()
+   for _, deterministic in ipairs({false, true}) do
+      cutorch.setDeterministic(deterministic)
+      for _, typename in ipairs({'torch.CudaTensor', 'torch.CudaDoubleTensor'}) do
+         local first = dst:type(typename):indexAdd(1, indices:cudaLong(), src:type(typename))
+         tester:assertlt((first:float() - expected):abs():max(), 1e-3,
+                         string.format('indexAdd diverges on %s (deterministic %s)',
+                                       typename, tostring(deterministic)))
+         if deterministic then
+            local second = dst:type(typename):indexAdd(1, indices:cudaLong(), src:type(typename))
+            tester:assert(first:equal(second),
+                          'deterministic indexAdd differs between runs on ' .. typename)
+         end
+      end
+      -- along the inner dimension
+      local dstT = dst:t():cuda()
+      dstT:indexAdd(2, indices:cudaLong(), src:t():cuda())
+      tester:assertlt((dstT:t():float() - expected):abs():max(), 1e-3,
+                      'indexAdd over the inner dimension diverges')
+   end
+   cutorch.setDeterministic(oldDeterministic)
+end
+
 function test.indexFill()
    local sz1 = chooseInt(minsize, maxsize)
    local sz2 = chooseInt(minsize, maxsize)
@@ -1855,6 +2250,72 @@ function test.indexSelect2()
    end
 end
 
+function test.indexSelectRows()
+   -- row widths that take every access width of the row-gather path,
+   -- from a narrow view that breaks the alignment
+   local widths = {1, 3, 4, 33, 64, 1000}
+   for _, width in ipairs(widths) do
+      local rows = chooseInt(10, 100)
+      local weight = torch.rand(rows, width + 1):mul(100):float()
+      local indices = torch.LongTensor(chooseInt(1, 300)):random(1, rows)
+      for _, typename in ipairs({'torch.CudaTensor', 'torch.CudaDoubleTensor', 'torch.CudaByteTensor'}) do
+         local w = weight:type(typename)
+         local expected = weight:type(t2cpu[typename]):index(1, indices)
+         tester:assertTensorEq(w:narrow(2, 1, width):contiguous():index(1, indices:cudaLong()):double(),
+                               expected:narrow(2, 1, width):double(), 0,
+                               string.format('indexSelect of %d wide rows diverges on %s', width, typename))
+         local unaligned = w:view(-1):narrow(1, 2, rows * width):view(rows, width)
+         tester:assertTensorEq(unaligned:index(1, indices:cudaLong()):double(),
+                               weight:type(t2cpu[typename]):view(-1):narrow(1, 2, rows * width)
+                                  :view(rows, width):index(1, indices):double(), 0,
+                               string.format('unaligned indexSelect of %d wide rows diverges on %s', width, typename))
+      end
+   end
+end
+
+function test.embeddingBag()
+   local rows, width = chooseInt(10, 50), chooseInt(1, 70)
+   local weight = torch.randn(rows, width):float()
+   local indices = torch.LongTensor(chooseInt(20, 200)):random(1, rows)
+   -- bag starts in increasing order, including empty bags
+   local numBags = chooseInt(1, 20)
+   local offsets = torch.LongTensor(numBags):random(1, indices:size(1)):sort()
+   offsets[1] = 1
+
+   for _, average in ipairs({false, true}) do
+      local expected = torch.FloatTensor(numBags, width):zero()
+      for b = 1, numBags do
+         local last = b < numBags and offsets[b + 1] - 1 or indices:size(1)
+         for i = offsets[b], last do
+            expected[b]:add(weight[indices[i]])
+         end
+         if average and last >= offsets[b] then
+            expected[b]:div(last - offsets[b] + 1)
+         end
+      end
+      for _, typename in ipairs({'torch.CudaTensor', 'torch.CudaDoubleTensor'}) do
+         local w = weight:type(typename)
+         local actual = w.new():embeddingBag(w, indices:cudaLong(), offsets:cudaLong(), average)
+         tester:assertTensorEq(actual:float(), expected, 1e-4,
+                               string.format('embeddingBag diverges on %s (average %s)',
+                                             typename, tostring(average)))
+      end
+   end
+
+   -- indices past the rows of weight and offsets out of order are errors
+   local w = weight:cuda()
+   local badIndices = indices:clone()
+   badIndices[chooseInt(1, badIndices:size(1))] = rows + 1
+   tester:assertError(function() w.new():embeddingBag(w, badIndices:cudaLong(), offsets:cudaLong()) end,
+                      'embeddingBag accepts an index out of range')
+   local badOffsets = torch.LongTensor({1, 3, 2})
+   tester:assertError(function() w.new():embeddingBag(w, indices:cudaLong(), badOffsets:cudaLong()) end,
+                      'embeddingBag accepts decreasing offsets')
+   badOffsets = torch.LongTensor({1, indices:size(1) + 2})
+   tester:assertError(function() w.new():embeddingBag(w, indices:cudaLong(), badOffsets:cudaLong()) end,
+                      'embeddingBag accepts an offset past the indices')
+end
+
 function test.cross()
    -- Test finding the first non-zero dimension
    local x = torch.FloatTensor():randn(4,3,2,3)
@@ -2223,6 +2684,248 @@ function test.bmmTransposed()
                  string.format("Divergent results between CPU and CUDA for function 'bmm'"))
 end
 
+function test.bmmManySmall()
+   -- Exercises the strided-batched GEMM paths: many tiny matrices, a size
+   -- just past the small-matrix kernel, and a zero beta over a NaN result.
+   local sizes = {
+      {1000, 4, 5, 3},
+      {300, 17, 32, 9},
+      {20, 33, 40, 35},
+   }
+   for _, size in pairs(sizes) do
+      local b, n, k, m = unpack(size)
+      local as = torch.randn(b, n, k)
+      local bs = torch.randn(b, k, m)
+      local cs = torch.randn(b, n, m)
+      compareFloatAndCudaTensorArgs(cs, 'baddbmm', 0.5, cs, 2, as, bs)
+
+      local ms = torch.randn(n, m)
+      local old_tt = test_tolerance
+      test_tolerance = 1e-2
+      compareFloatAndCudaTensorArgs(ms, 'addbmm', 0.5, ms, 2, as, bs)
+      test_tolerance = old_tt
+
+      local nanResult = torch.CudaTensor(n, m):fill(0/0)
+      local expected = torch.FloatTensor(n, m):zero()
+      expected:addbmm(0, expected, 1, as:float(), bs:float())
+      nanResult:addbmm(0, nanResult, 1, as:cuda(), bs:cuda())
+      tester:assert(isEqual(expected, nanResult, 1e-2),
+                    "addbmm with beta 0 must ignore the previous result")
+   end
+end
+
+function test.halfBlas()
+   if not cutorch.hasHalf then return end
+   local oldMode = cutorch.getBlasMathMode()
+   for _, mode in ipairs({'float', 'half'}) do
+      cutorch.setBlasMathMode(mode)
+      tester:asserteq(cutorch.getBlasMathMode(), mode, 'math mode not set')
+      -- half inputs, so the float reference sees exactly the same values
+      local a = torch.randn(19, 15):cudaHalf():float()
+      local v = torch.randn(15):cudaHalf():float()
+      local w = torch.randn(19):cudaHalf():float()
+      local b1 = torch.randn(7, 19, 15):cudaHalf():float()
+      local b2 = torch.randn(7, 15, 9):cudaHalf():float()
+      local checks = {
+         {torch.mv(a, v), torch.mv(a:cudaHalf(), v:cudaHalf())},
+         {torch.mv(a:t(), w), torch.mv(a:cudaHalf():t(), w:cudaHalf())},
+         {torch.ger(w, v), torch.ger(w:cudaHalf(), v:cudaHalf())},
+         {torch.mm(a, a:t()), torch.mm(a:cudaHalf(), a:cudaHalf():t())},
+         {torch.bmm(b1, b2), torch.bmm(b1:cudaHalf(), b2:cudaHalf())},
+         {torch.zeros(19, 9):addbmm(b1, b2),
+          torch.zeros(19, 9):cudaHalf():addbmm(b1:cudaHalf(), b2:cudaHalf())},
+      }
+      for i, c in ipairs(checks) do
+         local expected, actual = c[1], c[2]:float()
+         local err = (expected - actual):abs():max() / math.max(1, expected:abs():max())
+         tester:assertlt(err, 1e-2, string.format("half BLAS check %d diverges in '%s' mode", i, mode))
+      end
+   end
+   cutorch.setBlasMathMode(oldMode)
+end
+
+function test.mmShapeDispatch()
+   -- small, skinny and GEMV-like shapes run on THC's own kernels; they must
+   -- agree with the library path, transposed operands included
+   local shapes = {
+      {5, 7, 3}, {64, 64, 64}, {33, 1, 17},
+      {300, 40, 1}, {300, 40, 3}, {129, 513, 8}, {1000, 2, 6},
+   }
+   local oldForce = cutorch.getBlasForceLibrary()
+   for _, shape in ipairs(shapes) do
+      local m, k, n = unpack(shape)
+      local a = torch.randn(m, k)
+      local b = torch.randn(k, n)
+      local c = torch.randn(m, n)
+      local expected = c:clone():addmm(0.5, 2, a, b)
+      for _, transA in ipairs({false, true}) do
+         for _, transB in ipairs({false, true}) do
+            local ga = transA and a:t():contiguous():cuda():t() or a:cuda()
+            local gb = transB and b:t():contiguous():cuda():t() or b:cuda()
+            for _, force in ipairs({false, true}) do
+               cutorch.setBlasForceLibrary(force)
+               local gc = c:cuda():addmm(0.5, 2, ga, gb)
+               tester:assert(isEqual(expected, gc, 1e-3),
+                  string.format('addmm %dx%dx%d diverges (transA %s, transB %s, force %s)',
+                                m, k, n, tostring(transA), tostring(transB), tostring(force)))
+            end
+         end
+      end
+      local x = torch.randn(k)
+      local expectedMv = torch.mv(a, x)
+      cutorch.setBlasForceLibrary(false)
+      tester:assert(isEqual(expectedMv, torch.mv(a:cuda(), x:cuda()), 1e-3), 'mv diverges')
+      tester:assert(isEqual(expectedMv, torch.mv(a:t():contiguous():cuda():t(), x:cuda()), 1e-3),
+                    'mv on a transposed matrix diverges')
+   end
+   cutorch.setBlasForceLibrary(oldForce)
+end
+
+function test.addmmFused()
+   local activations = {
+      none = function(x) return x end,
+      sigmoid = function(x) return torch.sigmoid(x) end,
+      tanh = function(x) return torch.tanh(x) end,
+      relu = function(x) return torch.cmax(x, 0) end,
+   }
+   -- small shapes apply the epilogue in the built-in kernels, large ones in
+   -- a pass after the library GEMM
+   local shapes = {{5, 7, 3}, {40, 24, 56}, {300, 40, 4}, {129, 200, 97}}
+   local oldForce = cutorch.getBlasForceLibrary()
+   for _, shape in ipairs(shapes) do
+      local m, k, n = unpack(shape)
+      local a = torch.randn(m, k)
+      local b = torch.randn(k, n)
+      for _, biasDim in ipairs({1, 2}) do
+         local bias = torch.randn(biasDim == 1 and m or n)
+         local expandedBias = biasDim == 1 and bias:view(m, 1):expand(m, n)
+                                            or bias:view(1, n):expand(m, n)
+         local product = torch.mm(a, b):mul(0.5):add(expandedBias)
+         for name, f in pairs(activations) do
+            local expected = f(product)
+            for _, transA in ipairs({false, true}) do
+               local ga = transA and a:t():contiguous():cuda():t() or a:cuda()
+               for _, force in ipairs({false, true}) do
+                  cutorch.setBlasForceLibrary(force)
+                  local r = torch.CudaTensor()
+                  r:addmmFused(0.5, ga, b:cuda(), bias:cuda(), biasDim, name)
+                  tester:assert(isEqual(expected, r, 1e-3),
+                     string.format('addmmFused %dx%dx%d diverges (bias dim %d, %s, transA %s, force %s)',
+                                   m, k, n, biasDim, name, tostring(transA), tostring(force)))
+               end
+            end
+         end
+      end
+   end
+   cutorch.setBlasForceLibrary(oldForce)
+
+   local a, b, bias = torch.randn(6, 5), torch.randn(5, 4), torch.randn(4)
+   local expected = torch.mm(a, b):add(bias:view(1, 4):expand(6, 4))
+   tester:assert(isEqual(expected, torch.addmmFused(a:cuda(), b:cuda(), bias:cuda(), 2), 1e-3),
+                 'addmmFused with default alpha and activation diverges')
+   tester:assertError(function()
+      torch.CudaTensor():addmmFused(a:cuda(), b:cuda(), bias:cuda(), 1)
+   end, 'addmmFused must reject a bias of the wrong size')
+   tester:assert(isEqual(torch.mm(a, b):mul(2):cmax(0),
+                         torch.CudaTensor():addmmFused(2, a:cuda(), b:cuda(), 'relu'), 1e-3),
+                 'addmmFused without bias diverges')
+
+   if cutorch.hasHalf then
+      local ha = torch.randn(33, 17):cudaHalf():float()
+      local hb = torch.randn(17, 9):cudaHalf():float()
+      local hbias = torch.randn(33):cudaHalf():float()
+      local hexpected = torch.mm(ha, hb):add(hbias:view(33, 1):expand(33, 9)):tanh()
+      local hr = torch.CudaHalfTensor():addmmFused(ha:cudaHalf(), hb:cudaHalf(), hbias:cudaHalf(), 1, 'tanh')
+      tester:assertlt((hexpected - hr:float()):abs():max(), 1e-2, 'half addmmFused diverges')
+   end
+end
+
+function test.conv2Algorithms()
+   -- nbatch, input planes, rows, columns, output planes, kernel rows, columns
+   local shapes = {
+      {1, 3, 9, 11, 2, 3, 3}, {2, 8, 16, 13, 9, 3, 3},
+      {3, 4, 12, 12, 5, 5, 4}, {2, 2, 7, 9, 3, 1, 1},
+   }
+   local types = {{'torch.CudaTensor', 1e-3}, {'torch.CudaDoubleTensor', 1e-8}}
+   if cutorch.hasHalf then
+      table.insert(types, {'torch.CudaHalfTensor', 5e-2})
+   end
+   local oldAlgorithm = cutorch.getConvAlgorithm()
+   for _, shape in ipairs(shapes) do
+      local nbatch, nIn, h, w, nOut, kh, kw = unpack(shape)
+      local input = torch.randn(nbatch, nIn, h, w):double()
+      local kernel = torch.randn(nOut, nIn, kh, kw):double()
+      for _, name in ipairs({'conv2', 'xcorr2'}) do
+         for _, vf in ipairs({'V', 'F'}) do
+            local expected = {}
+            for b = 1, nbatch do
+               expected[b] = torch[name](input[b], kernel, vf)
+            end
+            for _, algorithm in ipairs({'auto', 'direct', 'im2col', 'winograd', 'fft'}) do
+               cutorch.setConvAlgorithm(algorithm)
+               for _, t in ipairs(types) do
+                  local typename, tolerance = unpack(t)
+                  local gpuInput, gpuKernel = input:type(typename), kernel:type(typename)
+                  local scale = math.max(1, expected[1]:abs():max())
+                  local msg = string.format('%s %s (%s) diverges for %s on %s',
+                                            name, vf, algorithm, table.concat(shape, 'x'), typename)
+                  local mv = torch[name](gpuInput[1], gpuKernel, vf):double()
+                  tester:assertlt((mv - expected[1]):abs():max() / scale, tolerance, msg)
+                  local mm = torch[name](gpuInput, gpuKernel, vf):double()
+                  for b = 1, nbatch do
+                     tester:assertlt((mm[b] - expected[b]):abs():max() / scale, tolerance, msg .. ' (batch)')
+                  end
+               end
+            end
+         end
+      end
+   end
+   tester:assertError(function() cutorch.setConvAlgorithm('bogus') end,
+                      'unknown convolution algorithms must be rejected')
+   cutorch.setConvAlgorithm(oldAlgorithm)
+end
+
+function test.conv2FFT()
+   -- long 1D and large 2D kernels through the FFT, for single images and for
+   -- whole batches
+   local shapes = {
+      {1, 1, 1, 300, 1, 1, 31}, {2, 3, 40, 37, 2, 15, 15}, {3, 2, 20, 70, 3, 17, 16},
+   }
+   local oldAlgorithm = cutorch.getConvAlgorithm()
+   cutorch.setConvAlgorithm('fft')
+   for _, shape in ipairs(shapes) do
+      local nbatch, nIn, h, w, nOut, kh, kw = unpack(shape)
+      local input = torch.randn(nbatch, nIn, h, w):double()
+      local kernel = torch.randn(nOut, nIn, kh, kw):double()
+      for _, name in ipairs({'conv2', 'xcorr2'}) do
+         for _, vf in ipairs({'V', 'F'}) do
+            local expected = {}
+            for b = 1, nbatch do
+               expected[b] = torch[name](input[b], kernel, vf)
+            end
+            local scale = 1
+            for b = 1, nbatch do
+               scale = math.max(scale, expected[b]:abs():max())
+            end
+            for _, t in ipairs({{'torch.CudaTensor', 1e-3}, {'torch.CudaDoubleTensor', 1e-8}}) do
+               local typename, tolerance = unpack(t)
+               local batched = torch[name](input:type(typename), kernel:type(typename), vf):double()
+               tester:asserteq(batched:size(1), nbatch, 'wrong batch size for ' .. name)
+               for b = 1, nbatch do
+                  local single = torch[name](input[b]:type(typename), kernel:type(typename), vf):double()
+                  local what = string.format('%s %s diverges for %s on %s, image %d', name, vf,
+                                             table.concat(shape, 'x'), typename, b)
+                  tester:assertlt((batched[b] - expected[b]):abs():max() / scale, tolerance,
+                                  'batched ' .. what)
+                  tester:assertlt((single - expected[b]):abs():max() / scale, tolerance, what)
+               end
+            end
+         end
+      end
+   end
+   cutorch.setConvAlgorithm(oldAlgorithm)
+end
+
 function test.ger()
    --[[ Size ]]--
    local sizes = {
@@ -2257,6 +2960,116 @@ function test.inverse()
    tester:assertle((i2 - i1:cuda()):abs():max(), 1e-5, "wrong inverse answer")
 end
 
+-- P L U from a packed LU factor and its 1-based row swaps, on the CPU
+local function btrifactReconstruct(lu, pivots)
+   local n = lu:size(1)
+   local a = (torch.tril(lu, -1) + torch.eye(n)) * torch.triu(lu)
+   for k = n, 1, -1 do
+      local p = pivots[k]
+      if p ~= k then
+         local row = a[k]:clone()
+         a[k]:copy(a[p])
+         a[p]:copy(row)
+      end
+   end
+   return a
+end
+
+function test.btrifact()
+   for _, typename in ipairs({'torch.CudaTensor', 'torch.CudaDoubleTensor'}) do
+      local tolerance = typename == 'torch.CudaTensor' and 1e-3 or 1e-9
+      for _, n in ipairs({1, 3, 8, 17, 64}) do
+         local batch = chooseInt(1, 12)
+         local a = torch.DoubleTensor(batch, n, n):uniform(-1, 1)
+         local lu, pivots, info = torch.btrifact(a:type(typename))
+         tester:assertTensorEq(info:double(), torch.zeros(batch), 0, "btrifact: wrong info")
+         for b = 1, batch do
+            local rebuilt = btrifactReconstruct(lu[b]:double(), pivots[b]:long())
+            tester:assertle((rebuilt - a[b]):abs():max(), tolerance,
+                            "btrifact: P L U does not match A for n = " .. n)
+         end
+
+         -- a matrix and a vector right-hand side
+         for _, bsize in ipairs({{batch, n, chooseInt(1, 40)}, {batch, n}}) do
+            local rhs = torch.DoubleTensor(torch.LongStorage(bsize)):uniform(-1, 1)
+            local x = torch.btrisolve(rhs:type(typename), lu, pivots):double()
+            local rhs3 = rhs:dim() == 3 and rhs or rhs:view(batch, n, 1)
+            local x3 = x:dim() == 3 and x or x:view(batch, n, 1)
+            local residual = torch.bmm(a, x3) - rhs3
+            tester:assertle(residual:abs():max() / (1 + x:abs():max()), tolerance,
+                            "btrisolve: wrong answer for n = " .. n)
+         end
+      end
+
+      -- singular matrices are flagged, the others are not
+      local a = torch.DoubleTensor(3, 4, 4):uniform(-1, 1)
+      a[2]:zero()
+      local _, _, info = torch.btrifact(a:type(typename))
+      tester:assert(info[1] == 0 and info[2] > 0 and info[3] == 0,
+                    "btrifact: singular matrix not flagged")
+   end
+end
+
+function test.bpotrf()
+   for _, typename in ipairs({'torch.CudaTensor', 'torch.CudaDoubleTensor'}) do
+      local tolerance = typename == 'torch.CudaTensor' and 1e-3 or 1e-9
+      for _, n in ipairs({1, 4, 16, 33, 64}) do
+         local batch = chooseInt(1, 12)
+         local m = torch.DoubleTensor(batch, n, n):uniform(-1, 1)
+         local a = torch.bmm(m, m:transpose(2, 3))
+         for b = 1, batch do
+            a[b]:add(torch.eye(n):mul(n))
+         end
+         local rhs = torch.DoubleTensor(batch, n, chooseInt(1, 20)):uniform(-1, 1)
+
+         for _, uplo in ipairs({'U', 'L'}) do
+            local r, info = torch.bpotrf(a:type(typename), uplo)
+            tester:assertTensorEq(info:double(), torch.zeros(batch), 0, "bpotrf: wrong info")
+            for b = 1, batch do
+               tester:assertle((r[b]:double() - torch.potrf(a[b], uplo)):abs():max(), tolerance,
+                               "bpotrf: wrong factor for n = " .. n .. ", uplo = " .. uplo)
+            end
+
+            local x = torch.bpotrs(rhs:type(typename), r, uplo):double()
+            tester:assertle((torch.bmm(a, x) - rhs):abs():max() / (1 + x:abs():max()), tolerance,
+                            "bpotrs: wrong answer for n = " .. n .. ", uplo = " .. uplo)
+         end
+      end
+
+      local a = torch.DoubleTensor(2, 3, 3):copy(torch.eye(3):view(1, 3, 3):expand(2, 3, 3))
+      a[2][2][2] = -1
+      local _, info = torch.bpotrf(a:type(typename))
+      tester:assert(info[1] == 0 and info[2] == 2, "bpotrf: wrong info for an indefinite matrix")
+   end
+end
+
+function test.btrtrs()
+   for _, typename in ipairs({'torch.CudaTensor', 'torch.CudaDoubleTensor'}) do
+      local tolerance = typename == 'torch.CudaTensor' and 1e-3 or 1e-9
+      for _, n in ipairs({1, 5, 32, 64}) do
+         local batch = chooseInt(1, 8)
+         local a = torch.DoubleTensor(batch, n, n):uniform(-1, 1)
+         for b = 1, batch do
+            a[b]:add(torch.eye(n):mul(n))
+         end
+         local rhs = torch.DoubleTensor(batch, n, chooseInt(1, 20)):uniform(-1, 1)
+         for _, uplo in ipairs({'U', 'L'}) do
+            for _, trans in ipairs({'N', 'T'}) do
+               for _, diag in ipairs({'N', 'U'}) do
+                  local x = torch.btrtrs(rhs:type(typename), a:type(typename), uplo, trans, diag)
+                  for b = 1, batch do
+                     local expected = torch.trtrs(rhs[b], a[b], uplo, trans, diag)
+                     tester:assertle((x[b]:double() - expected):abs():max(), tolerance,
+                                     string.format("btrtrs: wrong answer for n = %d, %s%s%s",
+                                                   n, uplo, trans, diag))
+                  end
+               end
+            end
+         end
+      end
+   end
+end
+
 if cutorch.magma then
    function test.gesv()
       local a = torch.Tensor(5, 5):uniform(-1, 1)
@@ -2573,6 +3386,81 @@ function test.restore_rng()
    tester:asserteq(cutorch.initialSeed(), seed, "seed was not restored")
 end
 
+function test.philox_random()
+   local rngType = cutorch.getRNGType()
+   local rs = cutorch.getRNGState()
+   cutorch.setRNGType('philox')
+
+   -- sizes that are not a multiple of the 4-element Philox block
+   local n1 = chooseInt(minsize, maxsize) * 4 + 1
+   local n2 = chooseInt(minsize, maxsize) * 4 + 3
+   local seed = 1234
+   cutorch.manualSeed(seed)
+   local t = torch.CudaTensor(n1):uniform():float()
+   local u = torch.CudaTensor(n2):normal():float()
+   local offset = math.ceil(n1 / 4)
+   tester:assertTensorEq(t, cutorch.philoxUniform(torch.FloatTensor(n1), seed, 0),
+                         1e-6, "uniform differs from the host reference")
+   tester:assertTensorEq(u, cutorch.philoxNormal(torch.FloatTensor(n2), seed, offset),
+                         1e-4, "normal differs from the host reference")
+
+   -- the state is just the seed and the offset
+   local state = cutorch.getRNGState()
+   local a = torch.CudaTensor(n1):normal():float()
+   cutorch.manualSeed(seed + 1)
+   cutorch.setRNGState(state)
+   local b = torch.CudaTensor(n1):normal():float()
+   tester:assertTensorEq(a, b, 1e-6, "values not equal after restoring the RNG state")
+   tester:asserteq(cutorch.initialSeed(), seed, "seed was not restored")
+
+   cutorch.setRNGType(rngType)
+   cutorch.setRNGState(rs)
+end
+
+function test.random_noncontiguous()
+   local rngType = cutorch.getRNGType()
+   local rs = cutorch.getRNGState()
+   local sz1 = chooseInt(minsize, maxsize)
+   local sz2 = chooseInt(minsize, maxsize)
+
+   for _, rng in ipairs({'mtgp32', 'philox'}) do
+      cutorch.setRNGType(rng)
+      for _, typename in ipairs(float_typenames) do
+         -- fill a column block of a transposed matrix, leave the rest alone
+         local x = torch.Tensor(sz2, sz1 + 2):fill(-1):type(typename)
+         local view = x:t():narrow(1, 2, sz1)
+         view:uniform(2, 3)
+         local v = view:float()
+         tester:assert(v:min() >= 2 and v:max() <= 3,
+                       "uniform out of range for " .. typename .. " with " .. rng)
+         tester:assertTensorEq(x:t():narrow(1, 1, 1):float(),
+                               torch.FloatTensor(1, sz2):fill(-1), 0,
+                               "wrote outside the view for " .. typename)
+         tester:assertTensorEq(x:t():narrow(1, sz1 + 2, 1):float(),
+                               torch.FloatTensor(1, sz2):fill(-1), 0,
+                               "wrote outside the view for " .. typename)
+
+         view:bernoulli(0.5)
+         v = view:float()
+         tester:assert(v:eq(0):add(v:eq(1)):min() == 1,
+                       "bernoulli is not 0/1 for " .. typename .. " with " .. rng)
+      end
+   end
+
+   -- Philox values follow the linear index, not the memory layout
+   cutorch.manualSeed(4321)
+   local a = torch.CudaTensor(sz1, sz2):normal():float()
+   cutorch.manualSeed(4321)
+   local b = torch.CudaTensor(sz2, sz1):t():normal():float()
+   tester:assertTensorEq(a, b, 1e-6, "strided normal differs from contiguous")
+   cutorch.manualSeed(4321)
+   local c = torch.CudaDoubleTensor(sz1, sz2):normal():float()
+   tester:assertTensorEq(a, c, 1e-6, "double normal differs from float")
+
+   cutorch.setRNGType(rngType)
+   cutorch.setRNGState(rs)
+end
+
 function test.multi_gpu_random()
    local rs = cutorch.getRNGState()
    cutorch.manualSeedAll(1) -- set all device seeds to be the same
@@ -2594,6 +3482,23 @@ function test.multi_gpu_random()
    cutorch.setDevice(1) -- reset device
 end
 
+function test.multi_gpu_get_set()
+   -- elements of a tensor on another device are read and written on its
+   -- device's stream
+   local device_count = cutorch.getDeviceCount()
+   if device_count < 2 then
+      return
+   end
+   cutorch.setDevice(2)
+   local x = torch.CudaTensor(10):fill(1)
+   cutorch.setDevice(1)
+   x[3] = 7
+   tester:asserteq(x[3], 7, 'wrong element written on another device')
+   tester:asserteq(x[4], 1, 'wrong element read on another device')
+   tester:asserteq(cutorch.getDevice(), 1, 'current device changed')
+   tester:asserteq(x:float():sum(), 16, 'wrong contents after set on another device')
+end
+
 function test.multinomial_with_replacement()
    for tries = 1, 10 do
       local n_row = torch.random(10)
@@ -2669,9 +3574,36 @@ function test.multinomial_without_replacement_gets_all()
       -- Sort, and we should have the original results, since without replacement
       -- sampling everything, we should have chosen every value uniquely
       result = result:sort(2)
-      tester:assertTensorEq(orig, result, 0, "error in multinomial_without_replacement_gets_all")
+      tester:assertTensorEq(orig:float(), result:float(), 0, "error in multinomial_without_replacement_gets_all")
+   end
+end
+
+function test.multinomial_alias_distribution()
+   -- frequencies of a with-replacement draw should match the distribution,
+   -- including for a light category that sits next to a heavy one
+   local probs = torch.FloatTensor({0.05, 0.4, 0.05, 0.3, 0, 0.2})
+   local n_row = 3
+   local n_sample = 200000
+   local prob_dist = probs:view(1, -1):expand(n_row, probs:size(1)):cuda()
+   local samples = torch.multinomial(prob_dist, n_sample, true):double()
+   for i = 1, n_row do
+      for c = 1, probs:size(1) do
+         local freq = samples[i]:eq(c):sum() / n_sample
+         tester:assertalmosteq(freq, probs[c], 0.01,
+                               "alias sampling frequency mismatch for category " .. c)
+      end
    end
+
+   -- many categories, most of the mass on one of them
+   local n_col = 100000
+   local big = torch.CudaTensor(n_col):fill(1)
+   big[n_col] = n_col
+   local s = torch.multinomial(big, 1000, true):double()
+   tester:assert(s:min() >= 1 and s:max() <= n_col, "sampled an invalid index")
+   local heavyFreq = s:eq(n_col):sum() / 1000
+   tester:assert(heavyFreq > 0.4 and heavyFreq < 0.6, "heavy category frequency is off")
 end
+
 function test.multinomial_vector()
    local n_col = torch.random(100)
    local prob_dist = torch.CudaTensor(n_col):uniform()
@@ -2965,6 +3897,119 @@ function test.maskedSelect()
    local y_cuda = x:t()[x:t():gt(0.5)]
    tester:assertTensorEq(y, y_cuda:float(), 0.00001,
           "Error in maskedSelect indexing non-contig x[x:gt(y)]")
+
+   -- non-contiguous result tensor of the right size
+   local x = torch.randn(n_row, n_col):float()
+   local mask = torch.ByteTensor(n_row, n_col):fill(1)
+   mask[1][1] = 0
+   local y = x:maskedSelect(mask)
+   local buffer = torch.CudaTensor(y:nElement(), 3):fill(-1)
+   local y_cuda = buffer:select(2, 2)
+   y_cuda:maskedSelect(x:cuda(), mask:cudaByte())
+   tester:assertTensorEq(y, y_cuda:float(), 0.00001,
+                         "Error in maskedSelect (non-contiguous result)")
+   tester:assert(buffer:select(2, 1):float():eq(-1):all() and
+                 buffer:select(2, 3):float():eq(-1):all(),
+                 "maskedSelect wrote outside a non-contiguous result")
+end
+
+function test.maskedSelectBounded()
+   local n_row = math.random(minsize,maxsize)
+   local n_col = math.random(minsize,maxsize)
+
+   for _, typename in ipairs(typenames) do
+      local x_cuda = torch.randn(n_row, n_col):type(typename)
+      local x = x_cuda:type(t2cpu[typename])
+      local mask = torch.ByteTensor(n_col,n_row):bernoulli()
+      local y = x:t():maskedSelect(mask)
+      local mask_cuda = mask:cudaByte()
+      local y_cuda, count = x_cuda.new():maskedSelectBounded(x_cuda:t(), mask_cuda)
+      tester:asserteq(y_cuda:nElement(), n_row * n_col,
+                      "maskedSelectBounded should keep the upper bound size")
+      tester:asserteq(count:nElement(), 1, "count should have one element")
+      tester:asserteq(count[1], y:nElement(),
+                      "wrong count in maskedSelectBounded for " .. typename)
+      if count[1] > 0 then
+         tester:assertTensorEq(y, y_cuda:narrow(1, 1, count[1]):type(t2cpu[typename]),
+                               0.00001, "Error in maskedSelectBounded for " .. typename)
+      end
+   end
+
+   -- non-contiguous result tensor of the upper bound size
+   local x = torch.randn(n_row, n_col):float()
+   local mask = torch.ByteTensor(n_row, n_col):bernoulli()
+   local y = x:maskedSelect(mask)
+   local buffer = torch.CudaTensor(n_row * n_col, 2):fill(-1)
+   local y_cuda = buffer:select(2, 1)
+   local _, count = y_cuda:maskedSelectBounded(x:cuda(), mask:cudaByte())
+   tester:asserteq(count[1], y:nElement(), "wrong count with a non-contiguous result")
+   if count[1] > 0 then
+      tester:assertTensorEq(y, y_cuda:narrow(1, 1, count[1]):float(), 0.00001,
+                            "Error in maskedSelectBounded (non-contiguous result)")
+   end
+   tester:assert(buffer:select(2, 2):float():eq(-1):all(),
+                 "maskedSelectBounded wrote outside a non-contiguous result")
+
+   -- a large, mostly empty mask spans many tiles
+   local x = torch.randn(100000):float()
+   local mask = x:gt(2.5)
+   local y = x:maskedSelect(mask)
+   local y_cuda = x:cuda():maskedSelect(mask:cudaByte())
+   tester:assertTensorEq(y, y_cuda:float(), 0.00001,
+                         "Error in maskedSelect over many tiles")
+end
+
+function test.nonzero()
+   for _, typename in ipairs(typenames) do
+      -- non-contiguous, with a mix of zero and non-zero values
+      local x = torch.ByteTensor(chooseInt(minsize, maxsize),
+                                 chooseInt(minsize, maxsize),
+                                 chooseInt(minsize, maxsize)):bernoulli(0.3)
+      x = x:type(t2cpu[typename]):transpose(1, 3)
+      local x_cuda = x:type(typename)
+      local idx = torch.nonzero(x)
+      local idx_cuda = torch.nonzero(x_cuda)
+      tester:assert(torch.type(idx_cuda) == 'torch.CudaLongTensor',
+                    "nonzero should return a CudaLongTensor")
+      tester:assertTensorEq(idx, idx_cuda:long(), 0,
+                            "Error in nonzero for " .. typename)
+
+      -- with result tensor
+      local res = torch.CudaLongTensor()
+      x_cuda.nonzero(res, x_cuda)
+      tester:assertTensorEq(idx, res:long(), 0,
+                            "Error in nonzero (with result) for " .. typename)
+   end
+
+   -- non-contiguous result tensor of the right size
+   local x = torch.FloatTensor(chooseInt(minsize, maxsize), 3):uniform(1, 2)
+   local idx = torch.nonzero(x)
+   local buffer = torch.CudaLongTensor(3, x:nElement()):fill(-1)
+   local res = buffer:narrow(1, 1, 2):t()
+   local x_cuda = x:cuda()
+   x_cuda.nonzero(res, x_cuda)
+   tester:assertTensorEq(idx, res:long(), 0, "Error in nonzero (non-contiguous result)")
+   tester:assert(buffer[3]:long():eq(-1):all(),
+                 "nonzero wrote outside a non-contiguous result")
+
+   -- the same with zeros in the input, so that the result is shorter than
+   -- the number of elements
+   x = torch.FloatTensor(chooseInt(minsize, maxsize), 2):bernoulli(0.5)
+   x[1][1] = 1
+   idx = torch.nonzero(x)
+   buffer = torch.CudaLongTensor(3, idx:size(1)):fill(-1)
+   res = buffer:narrow(1, 1, 2):t()
+   x_cuda = x:cuda()
+   x_cuda.nonzero(res, x_cuda)
+   tester:assertTensorEq(idx, res:long(), 0, "Error in nonzero (non-contiguous result, with zeros)")
+   tester:assert(buffer[3]:long():eq(-1):all(),
+                 "nonzero wrote outside a non-contiguous result (with zeros)")
+   tester:assert(torch.pointer(res:storage()) == torch.pointer(buffer:storage()),
+                 "nonzero reallocated a result of the right size")
+
+   -- all zeros
+   local idx_cuda = torch.CudaTensor(4, 5):zero():nonzero()
+   tester:asserteq(idx_cuda:nElement(), 0, "nonzero of zeros should be empty")
 end
 
 function test.maskedCopy()
@@ -3138,6 +4183,97 @@ function test.scatter()
    end
 end
 
+function test.scatterAdd()
+   local m, n, o = torch.random(10, 20), torch.random(10, 20), torch.random(10, 20)
+   local dim = torch.random(3)
+   local sizes = {m, n, o}
+   local idx_size = {m, n, o}
+   idx_size[dim] = torch.random(10, 30)
+   -- indices are drawn with replacement, so they repeat
+   local idx = torch.LongTensor():resize(unpack(idx_size)):random(1, sizes[dim])
+   local src = torch.FloatTensor():resize(unpack(idx_size)):normal()
+   local res = torch.FloatTensor(m, n, o):normal()
+
+   local oldDeterministic = cutorch.getDeterministic()
+   for _, deterministic in ipairs({false, true}) do
+      cutorch.setDeterministic(deterministic)
+      for _, typename in ipairs({'torch.CudaTensor', 'torch.CudaDoubleTensor', 'torch.CudaLongTensor'}) do
+         local ctype = t2cpu[typename]
+         local src, res = src:type(ctype), res:type(ctype)
+         local expected = res:clone()
+         for i = 1, idx_size[1] do
+            for j = 1, idx_size[2] do
+               for k = 1, idx_size[3] do
+                  local ii = {i, j, k}
+                  ii[dim] = idx[i][j][k]
+                  expected[ii] = expected[ii] + src[i][j][k]
+               end
+            end
+         end
+         local actual = res:type(typename):scatterAdd(dim, idx:cudaLong(), src:type(typename))
+         tester:assertlt((actual:double() - expected:double()):abs():max(), 1e-4,
+                         string.format('scatterAdd diverges on %s (deterministic %s)',
+                                       typename, tostring(deterministic)))
+      end
+   end
+   cutorch.setDeterministic(oldDeterministic)
+end
+
+function test.gatherScatterIntIndex()
+   local m, n, o = torch.random(10, 20), torch.random(10, 20), torch.random(10, 20)
+   local elems_per_row = torch.random(10)
+   local dim = torch.random(3)
+   local sizes = {m, n, o}
+   local idx_size = {m, n, o}
+   idx_size[dim] = elems_per_row
+   local idx = torch.LongTensor():resize(unpack(idx_size))
+   fillIdx(idx, dim, sizes[dim], elems_per_row, m, n, o)
+   local src = torch.randn(unpack(idx_size)):float()
+   local full = torch.randn(m, n, o):float()
+
+   for _, typename in ipairs({'torch.CudaTensor', 'torch.CudaDoubleTensor', 'torch.CudaLongTensor'}) do
+      local cfull, csrc = full:type(t2cpu[typename]), src:type(t2cpu[typename])
+      local gathered = cfull:type(typename):gather(dim, idx:cudaInt())
+      tester:assertTensorEq(gathered:double(), cfull:gather(dim, idx):double(), 0,
+                            'gather with int indices diverges on ' .. typename)
+      local scattered = cfull:type(typename):scatter(dim, idx:cudaInt(), csrc:type(typename))
+      tester:assertTensorEq(scattered:double(), cfull:clone():scatter(dim, idx, csrc):double(), 0,
+                            'scatter with int indices diverges on ' .. typename)
+      local filled = cfull:type(typename):scatter(dim, idx:cudaInt(), 7)
+      tester:assertTensorEq(filled:double(), cfull:clone():scatter(dim, idx, 7):double(), 0,
+                            'scatter of a value with int indices diverges on ' .. typename)
+   end
+end
+
+function test.gatherScatterRows()
+   -- an index that only varies along `dim`, over rows of every width class
+   for _, inner in ipairs({1, 3, 4, 17, 64}) do
+      local outer, rows, picked = torch.random(1, 5), torch.random(10, 20), torch.random(1, 10)
+      local perm = torch.randperm(rows):long():narrow(1, 1, picked)
+      local idx = perm:view(1, picked, 1):expand(outer, picked, inner)
+      local full = torch.randn(outer, rows, inner):float()
+      local src = torch.randn(outer, picked, inner):float()
+      for _, typename in ipairs({'torch.CudaTensor', 'torch.CudaHalfTensor', 'torch.CudaByteTensor'}) do
+         if typename ~= 'torch.CudaHalfTensor' or cutorch.hasHalf then
+            local ctype = typename == 'torch.CudaHalfTensor' and 'torch.FloatTensor' or t2cpu[typename]
+            -- values as the device type holds them
+            local cfull = full:type(typename):type(ctype)
+            local csrc = src:type(typename):type(ctype)
+            -- expanded on the device, so that the index keeps its zero strides
+            for _, cudaPerm in ipairs({perm:cudaLong(), perm:cudaInt()}) do
+               local cudaIdx = cudaPerm:view(1, picked, 1):expand(outer, picked, inner)
+               local gathered = cfull:type(typename):gather(2, cudaIdx)
+               tester:assertTensorEq(gathered:double(), cfull:gather(2, idx):double(), 0,
+                                     string.format('row gather of width %d diverges on %s', inner, typename))
+               local scattered = cfull:type(typename):scatter(2, cudaIdx, csrc:type(typename))
+               tester:assertTensorEq(scattered:double(), cfull:clone():scatter(2, idx, csrc):double(), 0,
+                                     string.format('row scatter of width %d diverges on %s', inner, typename))
+            end
+         end
+      end
+   end
+end
+
 function test.scatterFill()
    local m, n, o = torch.random(10, 20), torch.random(10, 20), torch.random(10, 20)
    local elems_per_row = torch.random(10)
@@ -3292,6 +4428,50 @@ function test.catArray()
    end
 end
 
+function test.catArrayMany()
+   for k, typename in ipairs(typenames) do
+      for dim = 1, 3 do
+         -- many small pieces, some of them transposed (not contiguous)
+         local pieces, cpuPieces = {}, {}
+         for i = 1, chooseInt(50, 200) do
+            local size = {4, 3, 5}
+            size[dim] = chooseInt(1, 4)
+            local t = torch.FloatTensor(torch.LongStorage(size)):uniform(-10, 10)
+            if i % 7 == 0 then
+               t = t:transpose(1, 3):contiguous():transpose(1, 3)
+            end
+            table.insert(cpuPieces, t)
+            table.insert(pieces, t:type(typename))
+         end
+         local expected = torch.cat(cpuPieces, dim):type(typename)
+         tester:assertTensorEq(torch.cat(pieces, dim), expected, 0, 'torch.cat of many pieces')
+      end
+   end
+end
+
+function test.splitCopy()
+   for k, typename in ipairs(typenames) do
+      local x = torch.FloatTensor(6, 11, 5):uniform(-10, 10):type(typename)
+      for dim = 1, 3 do
+         for _, size in ipairs({1, 2, 4, x:size(dim)}) do
+            local views = x:split(size, dim)
+            local copies = x:splitCopy(size, dim)
+            tester:asserteq(#copies, #views, 'splitCopy: wrong number of pieces')
+            for i = 1, #views do
+               tester:assert(copies[i]:isContiguous(), 'splitCopy: piece not contiguous')
+               tester:assertTensorEq(copies[i], views[i], 0, 'splitCopy: wrong piece')
+            end
+         end
+         local chunks = x:transpose(1, 3):chunkCopy(3, dim)
+         local views = x:transpose(1, 3):chunk(3, dim)
+         tester:asserteq(#chunks, #views, 'chunkCopy: wrong number of pieces')
+         for i = 1, #views do
+            tester:assertTensorEq(chunks[i], views[i], 0, 'chunkCopy: wrong piece')
+         end
+      end
+   end
+end
+
 function test.streamWaitFor()
    local size = 2000000
    local iter = 20 + torch.random(10)
@@ -239,7 +239,9 @@ static int torch_Storage_(write)(lua_State *L)
   THAssert(storage->size < LONG_MAX);
 #endif
   THFile_writeLongScalar(file, storage->size);
-  THFile_writeRealRaw(file, storage->data, storage->size);
+  /* cutorch.saveAsync: the data is snapshotted and written in the background */
+  if(!cutorch_writeStorageAsync(L, 2, storage->device, storage->data, storage->size * sizeof(real)))
+    THFile_writeRealRaw(file, storage->data, storage->size);
 
   return 0;
 }
@@ -249,9 +251,25 @@ static int torch_Storage_(read)(lua_State *L)
   THCStorage *storage = (THCStorage *)luaT_checkudata(L, 1, torch_Storage);
   THFile *file = (THFile*)luaT_checkudata(L, 2, "torch.File");
   long size = THFile_readLongScalar(file);
+  THCState *state = cutorch_getstate(L);
+  size_t mappedSize;
+  const char *mapped = cutorch_getFileMapping(L, 2, &mappedSize);
 
-  THCStorage_(resize)(cutorch_getstate(L), storage, size);
-  THFile_readRealRaw(file, storage->data, storage->size);
+  THCStorage_(resize)(state, storage, size);
+  if(mapped)
+  {
+    /* cutorch.loadMapped: no host copy of the whole storage */
+    size_t position = THFile_position(file);
+    size_t bytes = size * sizeof(real);
+    luaL_argcheck(L, position <= mappedSize && bytes <= mappedSize - position, 2,
+                  "storage data runs past the end of the file");
+    THCudaCopyFromHostStaged(state, storage->data, mapped + position, bytes);
+    THFile_seek(file, position + bytes);
+  }
+  else
+  {
+    THFile_readRealRaw(file, storage->data, storage->size);
+  }
 
   return 0;
 }
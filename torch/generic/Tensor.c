@@ -1187,6 +1187,129 @@ static int torch_Tensor_(__index__)(lua_State *L)
   }
 }
 
+/* Storage offsets of the elements of `tensor` at the 1-based coordinates
+   held by the rows of `coords` (n x nDimension, or n for a vector);
+   negative coordinates count from the end, as with __index__ */
+static ptrdiff_t *torch_Tensor_(c_readElementOffsets)(lua_State *L, THCTensor *tensor, int index, ptrdiff_t *n_)
+{
+  THLongTensor *coords = (THLongTensor *)luaT_checkudata(L, index, "torch.LongTensor");
+  int nDim = tensor->nDimension;
+  luaL_argcheck(L, nDim > 0, 1, "empty tensor");
+  luaL_argcheck(L, (coords->nDimension == 2 && coords->size[1] == nDim) ||
+                   (coords->nDimension == 1 && nDim == 1) || THLongTensor_nElement(coords) == 0,
+                index, "expected one row of coordinates per element");
+
+  ptrdiff_t n = THLongTensor_nElement(coords) / nDim;
+  ptrdiff_t *offsets = (ptrdiff_t *)THAlloc(THMax(n, (ptrdiff_t) 1) * sizeof(ptrdiff_t));
+  coords = THLongTensor_newContiguous(coords);
+  long *c = THLongTensor_data(coords);
+
+  for (ptrdiff_t i = 0; i < n; i++)
+  {
+    ptrdiff_t offset = tensor->storageOffset;
+    for (int dim = 0; dim < nDim; dim++)
+    {
+      long z = c[i * nDim + dim] - 1;
+      if (z < 0) z = tensor->size[dim] + z + 1;
+      if (z < 0 || z >= tensor->size[dim])
+      {
+        THLongTensor_free(coords);
+        THFree(offsets);
+        luaL_argcheck(L, 0, index, "index out of bound");
+      }
+      offset += z * tensor->stride[dim];
+    }
+    offsets[i] = offset;
+  }
+
+  THLongTensor_free(coords);
+  *n_ = n;
+  return offsets;
+}
+
+/* values = t:getElements(coords): the elements at `coords` in one transfer,
+   as a DoubleTensor of n values */
+static int torch_Tensor_(getElements)(lua_State *L)
+{
+  THCState *state = cutorch_getstate(L);
+  THCTensor *tensor = (THCTensor *)luaT_checkudata(L, 1, torch_Tensor);
+  ptrdiff_t n;
+  ptrdiff_t *offsets = torch_Tensor_(c_readElementOffsets)(L, tensor, 2, &n);
+
+  THDoubleTensor *result = THDoubleTensor_newWithSize1d(n);
+  real *values = (real *)THAlloc(THMax(n, (ptrdiff_t) 1) * sizeof(real));
+  THCStorage_(getMany)(state, tensor->storage, offsets, n, values);
+  double *r = THDoubleTensor_data(result);
+  for (ptrdiff_t i = 0; i < n; i++)
+  {
+#ifdef THC_REAL_IS_HALF
+    r[i] = THC_half2float(values[i]);
+#else
+    r[i] = (double) values[i];
+#endif
+  }
+
+  THFree(values);
+  THFree(offsets);
+  luaT_pushudata(L, result, "torch.DoubleTensor");
+  return 1;
+}
+
+/* t:setElements(coords, values): writes the elements at `coords` in one
+   transfer; values is a number or a DoubleTensor of n values */
+static int torch_Tensor_(setElements)(lua_State *L)
+{
+  THCState *state = cutorch_getstate(L);
+  THCTensor *tensor = (THCTensor *)luaT_checkudata(L, 1, torch_Tensor);
+  THDoubleTensor *src = NULL;
+  double value = 0;
+
+  if (lua_isnumber(L, 3))
+    value = lua_tonumber(L, 3);
+  else
+    src = (THDoubleTensor *)luaT_checkudata(L, 3, "torch.DoubleTensor");
+
+  ptrdiff_t n;
+  ptrdiff_t *offsets = torch_Tensor_(c_readElementOffsets)(L, tensor, 2, &n);
+  if (src && THDoubleTensor_nElement(src) != n)
+  {
+    THFree(offsets);
+    luaL_argcheck(L, 0, 3, "expected one value per element");
+  }
+
+  real *values = (real *)THAlloc(THMax(n, (ptrdiff_t) 1) * sizeof(real));
+  if (src)
+  {
+    src = THDoubleTensor_newContiguous(src);
+    double *s = THDoubleTensor_data(src);
+    for (ptrdiff_t i = 0; i < n; i++)
+    {
+#ifdef THC_REAL_IS_HALF
+      values[i] = THC_float2half((float) s[i]);
+#else
+      values[i] = (real) s[i];
+#endif
+    }
+    THDoubleTensor_free(src);
+  }
+  else
+  {
+#ifdef THC_REAL_IS_HALF
+    real v = THC_float2half((float) value);
+#else
+    real v = (real) value;
+#endif
+    for (ptrdiff_t i = 0; i < n; i++)
+      values[i] = v;
+  }
+
+  THCStorage_(setMany)(state, tensor->storage, offsets, n, values);
+  THFree(values);
+  THFree(offsets);
+  lua_settop(L, 1);
+  return 1;
+}
+
 static int torch_Tensor_(retain)(lua_State *L)
 {
   THCTensor *tensor = (THCTensor *) luaT_checkudata(L, 1, torch_Tensor);
@@ -1415,6 +1538,8 @@ static const struct luaL_Reg torch_Tensor_(_) [] = {
   {"copy", torch_Tensor_(copy)},
   {"read", torch_Tensor_(read)},
   {"write", torch_Tensor_(write)},
+  {"getElements", torch_Tensor_(getElements)},
+  {"setElements", torch_Tensor_(setElements)},
   {"__index__", torch_Tensor_(__index__)},
   {"__newindex__", torch_Tensor_(__newindex__)},
   {NULL, NULL}
@@ -1,5 +1,12 @@
 #include "utils.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 THLongStorage* cutorch_checklongargs(lua_State *L, int index)
 {
   THLongStorage *storage;
@@ -58,3 +65,125 @@ struct THCState* cutorch_getstate(lua_State* L)
   lua_pop(L, 2);
   return state;
 }
+
+typedef struct cutorch_FileMapping
+{
+  char *data;
+  size_t size;
+} cutorch_FileMapping;
+
+/* pushes the table of mappings, keyed (weakly) by file */
+static void cutorch_pushFileMappings(lua_State *L)
+{
+  lua_getfield(L, LUA_REGISTRYINDEX, "cutorch.fileMappings");
+  if(lua_isnil(L, -1))
+  {
+    lua_pop(L, 1);
+    lua_newtable(L);
+    lua_newtable(L);
+    lua_pushstring(L, "k");
+    lua_setfield(L, -2, "__mode");
+    lua_setmetatable(L, -2);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, "cutorch.fileMappings");
+  }
+}
+
+static int cutorch_FileMapping_free(lua_State *L)
+{
+  cutorch_FileMapping *mapping = (cutorch_FileMapping *)lua_touserdata(L, 1);
+#ifndef _WIN32
+  if(mapping->data)
+    munmap(mapping->data, mapping->size);
+#endif
+  mapping->data = NULL;
+  mapping->size = 0;
+  return 0;
+}
+
+int cutorch_mapFile(lua_State *L)
+{
+  luaT_checkudata(L, 1, "torch.DiskFile");
+  const char *name = luaL_checkstring(L, 2);
+#ifdef _WIN32
+  return luaL_error(L, "memory-mapped loading is not supported on this platform");
+#else
+  int fd = open(name, O_RDONLY);
+  if(fd < 0)
+    return luaL_error(L, "could not open file <%s>", name);
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return luaL_error(L, "could not stat file <%s>", name);
+  }
+
+  cutorch_pushFileMappings(L);
+  lua_pushvalue(L, 1);
+  cutorch_FileMapping *mapping =
+    (cutorch_FileMapping *)lua_newuserdata(L, sizeof(cutorch_FileMapping));
+  mapping->data = NULL;
+  mapping->size = 0;
+  lua_newtable(L);
+  lua_pushcfunction(L, cutorch_FileMapping_free);
+  lua_setfield(L, -2, "__gc");
+  lua_setmetatable(L, -2);
+
+  if(st.st_size > 0)
+  {
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED)
+    {
+      close(fd);
+      return luaL_error(L, "could not map file <%s>", name);
+    }
+    /* storages are read front to back: ask for aggressive read-ahead */
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    mapping->data = (char *)data;
+    mapping->size = st.st_size;
+  }
+  close(fd);
+
+  lua_settable(L, -3);
+  lua_pop(L, 1);
+  return 0;
+#endif
+}
+
+int cutorch_unmapFile(lua_State *L)
+{
+  luaT_checkudata(L, 1, "torch.DiskFile");
+  cutorch_pushFileMappings(L);
+  lua_pushvalue(L, 1);
+  lua_gettable(L, -2);
+  if(!lua_isnil(L, -1))
+  {
+    lua_pushcfunction(L, cutorch_FileMapping_free);
+    lua_insert(L, -2);
+    lua_call(L, 1, 0);
+  }
+  else
+    lua_pop(L, 1);
+  lua_pushvalue(L, 1);
+  lua_pushnil(L);
+  lua_settable(L, -3);
+  lua_pop(L, 1);
+  return 0;
+}
+
+const char* cutorch_getFileMapping(lua_State *L, int index, size_t *size)
+{
+  const char *data = NULL;
+  index = index < 0 && index > LUA_REGISTRYINDEX ? lua_gettop(L) + index + 1 : index;
+  cutorch_pushFileMappings(L);
+  lua_pushvalue(L, index);
+  lua_gettable(L, -2);
+  cutorch_FileMapping *mapping = (cutorch_FileMapping *)lua_touserdata(L, -1);
+  if(mapping && mapping->data)
+  {
+    data = mapping->data;
+    *size = mapping->size;
+  }
+  lua_pop(L, 2);
+  return data;
+}
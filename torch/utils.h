@@ -61,4 +61,25 @@ TORCH_API int cutorch_islongargs(lua_State *L, int index);
 struct THCState;
 TORCH_API struct THCState* cutorch_getstate(lua_State* L);
 
+/* Files memory-mapped for cutorch.loadMapped: cutorch._mapFile(file, name)
+   maps the file behind the torch.DiskFile `file` until
+   cutorch._unmapFile(file), and cutorch_getFileMapping returns the mapping
+   of the file at `index` (NULL if it has none), so that storages read
+   from it copy their data straight from the mapping. */
+TORCH_API int cutorch_mapFile(lua_State *L);
+TORCH_API int cutorch_unmapFile(lua_State *L);
+TORCH_API const char* cutorch_getFileMapping(lua_State *L, int index, size_t *size);
+
+/* Background writers for cutorch.saveAsync: cutorch._newCheckpointWriter(name)
+   returns a writer; cutorch._attachFileWriter(file, writer) makes the
+   torch.MemoryFile `file` a staging area for it, until
+   cutorch._detachFileWriter(file) hands the rest of its bytes over and
+   closes the writer. cutorch_writeStorageAsync queues `size` bytes of
+   memory of `device` to the writer of the file at `index` after the bytes
+   written to the file so far, and returns 0 if the file has no writer. */
+TORCH_API int cutorch_newCheckpointWriter(lua_State *L);
+TORCH_API int cutorch_attachFileWriter(lua_State *L);
+TORCH_API int cutorch_detachFileWriter(lua_State *L);
+TORCH_API int cutorch_writeStorageAsync(lua_State *L, int index, int device, const void *data, size_t size);
+
 #endif